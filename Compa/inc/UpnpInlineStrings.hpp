@@ -0,0 +1,51 @@
+#ifndef COMPA_UPNPINLINESTRINGS_HPP
+#define COMPA_UPNPINLINESTRINGS_HPP
+// Copyright (C) 2026+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
+/*!
+ * \file
+ * \brief Inline strings that are stored in the memory behind their owner.
+ */
+
+#include <UpnpString.hpp>
+/// \cond
+#include <cstddef>
+/// \endcond
+
+/*!
+ * \brief Layout of the inline strings behind an owning object.
+ *
+ * The owner and its strings are allocated together in one block of
+ * object_size() bytes. The strings are constructed with string() and set
+ * only with set_String() or set_StringN().
+ *
+ * \tparam T Structure of the owning object.
+ * \tparam Strings Number of strings behind the object.
+ * \tparam Capacity Size of the inline buffer of each string including the
+ * terminating null byte.
+ */
+template <typename T, size_t Strings, size_t Capacity = 64>
+struct UpnpInlineStrings {
+    /// \brief Returns the size of the object including its strings.
+    static size_t object_size() {
+        return sizeof(T) + Strings * UpnpString_inline_size(Capacity);
+    }
+
+    /// \brief Constructs the i-th string in the memory behind the object.
+    static UpnpString* string(T* p, size_t i) {
+        return UpnpString_inline_init(
+            (char*)(p + 1) + i * UpnpString_inline_size(Capacity), Capacity);
+    }
+
+    /// \brief Sets a string of the object from a pointer to char.
+    static int set_String(UpnpString* s, const char* q) {
+        return UpnpString_inline_set_String(s, Capacity, q);
+    }
+
+    /// \brief Sets a string of the object using a maximum of N chars.
+    static int set_StringN(UpnpString* s, const char* q, size_t n) {
+        return UpnpString_inline_set_StringN(s, Capacity, q, n);
+    }
+};
+
+#endif // COMPA_UPNPINLINESTRINGS_HPP
@@ -1,7 +1,7 @@
 #ifndef COMPA_UPNPSTRING_HPP
 #define COMPA_UPNPSTRING_HPP
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-08-13
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 // Last compare with pupnp original source file on 2023-04-26, ver 1.14.15
 /*!
@@ -147,6 +147,73 @@ UPNPLIB_API int UpnpString_casecmp(
     /*! [in] The \em \b the second string. */
     UpnpString* q);
 
+/*!
+ * \name Inline strings
+ * Strings that are embedded in the memory block of an owning object, e.g. of
+ * an UpnpDiscovery, so constructing the owner needs only one allocation. The
+ * characters are stored in an inline buffer behind the string as long as they
+ * fit, otherwise in one heap buffer. An inline string is never deleted with
+ * UpnpString_delete() and only set with the inline setters but can be read
+ * and cleared with all other functions.
+ * @{
+ */
+
+/*!
+ * \brief Returns the size of the memory needed for an inline string.
+ *
+ * The size keeps inline strings that are placed one after the other aligned.
+ *
+ * \return Number of bytes.
+ */
+UPNPLIB_API size_t UpnpString_inline_size(
+    /*! [in] Size of the inline buffer including the terminating null byte. */
+    size_t capacity);
+
+/*!
+ * \brief Constructs an empty inline string.
+ *
+ * \return Pointer to the string at \b mem.
+ */
+UPNPLIB_API UpnpString* UpnpString_inline_init(
+    /*! [in] Zeroed memory of UpnpString_inline_size() bytes. */
+    void* mem,
+    /*! [in] Size of the inline buffer including the terminating null byte. */
+    size_t capacity);
+
+/*!
+ * \brief Frees the heap buffer of an inline string, but not the string.
+ */
+UPNPLIB_API void UpnpString_inline_destroy(
+    /*! [in] The \em \b this pointer. */
+    UpnpString* p);
+
+/*!
+ * \brief Sets an inline string from a pointer to char.
+ */
+UPNPLIB_API int UpnpString_inline_set_String(
+    /*! [in] The \em \b this pointer. */
+    UpnpString* p,
+    /*! [in] Capacity given with UpnpString_inline_init(). */
+    size_t capacity,
+    /*! [in] (char *) to copy from. */
+    const char* s);
+
+/*!
+ * \brief Sets an inline string from a pointer to char using a maximum of N
+ * chars.
+ */
+UPNPLIB_API int UpnpString_inline_set_StringN(
+    /*! [in] The \em \b this pointer. */
+    UpnpString* p,
+    /*! [in] Capacity given with UpnpString_inline_init(). */
+    size_t capacity,
+    /*! [in] (char *) to copy from. */
+    const char* s,
+    /*! Maximum number of chars to copy.*/
+    size_t n);
+
+/// @} Inline strings
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
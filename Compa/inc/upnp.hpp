@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-08-13
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -309,6 +309,15 @@
  */
 #define UPNP_E_SOCKET_ACCEPT -211
 
+/*!
+ * \brief The host name of a URL is still looked up.
+ *
+ * The lookup goes on in the background, so the call may be tried again later.
+ * This can be returned by any function that takes a URL with a host name, such
+ * as \b UpnpSubscribe, \b UpnpSendAction or \b UpnpDownloadXmlDoc.
+ */
+#define UPNP_E_TRY_AGAIN -212
+
 #define UPNP_E_EVENT_PROTOCOL -300
 
 /*!
@@ -574,6 +583,20 @@ UPNPLIB_API int UpnpFinish();
  */
 UPNPLIB_API unsigned short UpnpGetServerPort();
 
+/*!
+ * \brief Returns the internal server IPv4 listening port for TLS connections.
+ *
+ * The port is chosen by the system. It is only opened if a server SSL context
+ * was set with UpnpSetSslServerContext() before \b UpnpInit2.
+ *
+ * \return
+ *  \li On success: The port on which an internal server accepts IPv4 TLS
+ *      connections.
+ *  \li On error: 0 is returned if \b UpnpInit2 has not succeeded or no
+ *      server SSL context is set.
+ */
+UPNPLIB_API unsigned short UpnpGetServerSslPort();
+
 /*!
  * \brief Returns the internal server IPv6 link-local (LLA) UPnP listening port.
  *
@@ -970,6 +993,51 @@ UPNPLIB_API int UpnpSetMaxContentLength(
      * actions, in bytes. */
     size_t contentLength);
 
+/*!
+ * \brief Gets latency percentiles of the SDK thread pools for monitoring.
+ *
+ * The time jobs wait in the queue and the time they run are written in the
+ * Prometheus text format as \c upnp_threadpool_wait_us and
+ * \c upnp_threadpool_run_us summaries with the quantiles 0.5, 0.9 and 0.99
+ * in microseconds, e.g.
+ * \code
+ * upnp_threadpool_wait_us{pool="recv",job="ssdp",quantile="0.99"} 812
+ * \endcode
+ * There is one series per thread pool (\c send, \c recv, \c miniserver) and
+ * priority and one per thread pool and kind of job (\c ssdp, \c soap,
+ * \c gena, \c http, \c other). Series without any job are omitted. The
+ * values are estimated from log-scale histograms that are kept since
+ * UpnpInit2().
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_FINISH: The SDK is not initialized.
+ *     \li \c UPNP_E_INVALID_PARAM: \b Buf is \c NULL or \b BufLen is 0.
+ *     \li \c UPNP_E_BUFFER_TOO_SMALL: The text does not fit into \b Buf.
+ */
+UPNPLIB_API int UpnpGetThreadPoolStats(
+    /*! [out] Buffer for the null terminated text. */
+    char* Buf,
+    /*! [in] Size of the buffer. */
+    size_t BufLen);
+
+/*!
+ * \brief Binds the dedicated I/O threads of the SDK to a CPU.
+ *
+ * The miniserver, the timer and the SOAP action loop run on their own threads
+ * outside of the thread pools. They are bound to \b Cpu when they are started.
+ * This must be called before UpnpInit2() and is kept until it is called
+ * again. Binding is only supported on Linux and silently ignored elsewhere.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_INVALID_PARAM: \b Cpu is less than -1.
+ *     \li \c UPNP_E_INIT: The SDK is already initialized.
+ */
+UPNPLIB_API int UpnpSetIoThreadCpu(
+    /*! [in] Number of the CPU, or -1 to not bind the threads. */
+    int Cpu);
+
 /// @} Step 0: Addressing
 
 /******************************************************************************
@@ -1079,6 +1147,54 @@ UPNPLIB_API int UpnpSendAdvertisementLowPower(
     /*! RegistrationState as defined by UPnP Low Power. */
     int RegistrationState);
 
+/*!
+ * \brief Sets additional network interfaces to listen for SSDP messages.
+ *
+ * Each interface with an IPv4 address gets its own multicast socket and its
+ * own HTTP listener on the port of \b UpnpGetServerPort, which are served by
+ * the miniserver together with the interface given to \b UpnpInit2. So one
+ * instance of the library serves several networks. IPv4 devices are
+ * advertised on every interface, and searches are answered on the interface
+ * they came in. The LOCATION on an interface is the description URL with the
+ * address of that interface, if the description URL has the address of the
+ * interface given to \b UpnpInit2. Descriptions should use relative URLs
+ * without URLBase so that they resolve on every interface. Control points
+ * send their searches on every interface. An interface without IPv4 address
+ * is logged and skipped.
+ *
+ * This must be called before \b UpnpInit2 and takes effect with it.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_INVALID_PARAM: \b NumIfs is negative, greater than
+ *             \c SSDP_MAX_INTERFACES, or \b IfNames is \c NULL.
+ *     \li \c UPNP_E_INVALID_INTERFACE: An interface name is empty or too
+ *             long.
+ *     \li \c UPNP_E_NOT_EXIST: Not supported on this platform.
+ */
+UPNPLIB_API int UpnpSetSsdpInterfaces(
+    /*! [in] Names of the interfaces, e.g. "eth1". */
+    const char* const* IfNames,
+    /*! [in] Number of interfaces, 0 removes all additional interfaces. */
+    int NumIfs);
+
+/*!
+ * \brief Enables a kernel socket filter on the SSDP sockets.
+ *
+ * The filter drops all datagrams that are neither M-SEARCH nor NOTIFY
+ * requests in the kernel, so they do not wake up the miniserver. It is only
+ * available on Linux.
+ *
+ * This must be called before \b UpnpInit2 and takes effect with it.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_NOT_EXIST: Not supported on this platform.
+ */
+UPNPLIB_API int UpnpSetSsdpFilter(
+    /*! [in] Enable the filter if not 0. */
+    int Enable);
+
 /// @} Step 1: Discovery
 
 /******************************************************************************
@@ -1335,6 +1451,197 @@ UPNPLIB_API int UpnpSendActionExAsync(
      * invoked. */
     const void* Cookie_const);
 
+/*!
+ * \brief Sends an action without using a thread while waiting for the device,
+ * generating a callback when the operation is complete.
+ *
+ * Unlike \b UpnpSendActionAsync the action does not occupy a thread of the
+ * thread pool. One event loop drives the connections of all actions, so many
+ * thousands of actions can be in flight. Per device (host and port of
+ * \b ActionURL) only a limited number of actions are in flight, set with
+ * \b UpnpSetActionWindow; others wait in the order they were sent. The
+ * callback is invoked with a \c UPNP_CONTROL_ACTION_COMPLETE event like from
+ * \b UpnpSendActionAsync. Actions to \c https URLs are sent with
+ * \b UpnpSendActionAsync.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The action is queued.
+ *     \li \c UPNP_E_FINISH: The SDK is not initialized.
+ *     \li \c UPNP_E_INVALID_HANDLE: The handle is not a valid control
+ *             point handle.
+ *     \li \c UPNP_E_INVALID_URL: \b ActionUrl is an invalid URL.
+ *     \li \c UPNP_E_INVALID_PARAM: Either \b Fun is not a valid
+ *             callback function or \b ServiceType, \b Act, or
+ *             \b ActionUrl is \c NULL.
+ *     \li \c UPNP_E_INVALID_ACTION: This action is not valid.
+ *     \li \c UPNP_E_OUTOF_MEMORY: Insufficient resources exist to
+ *             complete this operation.
+ *     \li \c UPNP_E_OUTOF_SOCKET: The event loop could not be started.
+ */
+UPNPLIB_API int UpnpSendActionNonBlocking(
+    /*! [in] The handle of the control point sending the action. */
+    UpnpClient_Handle Hnd,
+    /*! [in] The action URL of the service. */
+    const char* ActionURL,
+    /*! [in] The type of the service. */
+    const char* ServiceType,
+    /*! [in] This parameter is ignored and must be \c NULL. */
+    const char* DevUDN,
+    /*! [in] The DOM document for the action to perform on this device. */
+    IXML_Document* Act,
+    /*! [in] Pointer to a callback function to be invoked when the operation
+     * completes. */
+    Upnp_FunPtr Fun,
+    /*! [in] Pointer to user data that to be passed to the callback when
+     * invoked. */
+    const void* Cookie);
+
+/*!
+ * \brief Sets the number of actions sent with \b UpnpSendActionNonBlocking
+ * that may be in flight at the same time.
+ *
+ * The defaults are \c SOAP_ACTION_MAX_PER_DEVICE and
+ * \c SOAP_ACTION_MAX_IN_FLIGHT.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_INVALID_PARAM: A value is not positive.
+ */
+UPNPLIB_API int UpnpSetActionWindow(
+    /*! [in] Maximal number of actions in flight to one device. */
+    int MaxPerDevice,
+    /*! [in] Maximal number of actions in flight to all devices. */
+    int MaxInFlight);
+
+/*! \brief Pre-serialized request of an action, made with
+ * \b UpnpActionTemplate_new. */
+typedef struct s_UpnpActionTemplate UpnpActionTemplate;
+
+/*!
+ * \brief Makes a template for an action that is sent many times with different
+ * argument values.
+ *
+ * The request line, the headers and the SOAP envelope are made once. Sending
+ * with \b UpnpSendActionTemplate or \b UpnpSendActionTemplateNonBlocking only
+ * fills in the argument values, without building and printing a DOM document.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_INVALID_PARAM: A pointer is \c NULL or \b NumArgs is
+ *             negative.
+ *     \li \c UPNP_E_INVALID_URL: \b ActionURL is an invalid URL.
+ *     \li \c UPNP_E_OUTOF_MEMORY: Insufficient resources exist to
+ *             complete this operation.
+ */
+UPNPLIB_API int UpnpActionTemplate_new(
+    /*! [in] The action URL of the service. */
+    const char* ActionURL,
+    /*! [in] The type of the service. */
+    const char* ServiceType,
+    /*! [in] The name of the action. */
+    const char* ActionName,
+    /*! [in] Names of the arguments in the order of the service description.
+     * May be \c NULL if \b NumArgs is 0. */
+    const char* const* ArgNames,
+    /*! [in] Number of arguments. */
+    int NumArgs,
+    /*! [out] The new template. It must be freed with
+     * \b UpnpActionTemplate_delete. */
+    UpnpActionTemplate** Template);
+
+/*!
+ * \brief Frees an action template.
+ */
+UPNPLIB_API void UpnpActionTemplate_delete(
+    /*! [in] The template, may be \c NULL. */
+    UpnpActionTemplate* Template);
+
+/*!
+ * \brief Sends an action made from a template and waits for the response.
+ *
+ * This is like \b UpnpSendAction.
+ *
+ * \return An integer representing one of the following, or a value like
+ * from \b UpnpSendAction:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully.
+ *     \li \c UPNP_E_INVALID_HANDLE: The handle is not a valid control
+ *             point handle.
+ *     \li \c UPNP_E_INVALID_PARAM: A pointer or an argument value is
+ *             \c NULL.
+ */
+UPNPLIB_API int UpnpSendActionTemplate(
+    /*! [in] The handle of the control point sending the action. */
+    UpnpClient_Handle Hnd,
+    /*! [in] The action template. */
+    const UpnpActionTemplate* Template,
+    /*! [in] Values of the arguments, in the order of the argument names. */
+    const char* const* ArgValues,
+    /*! [out] The DOM document for the response to the action. The SDK
+     * allocates this document and the caller needs to free it. */
+    IXML_Document** RespNode);
+
+/*!
+ * \brief Sends an action made from a template and returns only the values of
+ * the given output arguments.
+ *
+ * The values are taken directly from the response without building a DOM
+ * document. Only if the response is not a plain action response, e.g. a SOAP
+ * fault, the DOM is used. Use \b UpnpSendActionTemplate to get the response
+ * document.
+ *
+ * \return An integer representing one of the following, or a value like
+ * from \b UpnpSendActionTemplate:
+ *     \li \c UPNP_E_SUCCESS: The operation completed successfully. The value
+ *             of an output argument that is not in the response is \c NULL.
+ *     \li \c UPNP_E_INVALID_HANDLE: The handle is not a valid control
+ *             point handle.
+ *     \li \c UPNP_E_INVALID_PARAM: A pointer or an argument value is
+ *             \c NULL.
+ */
+UPNPLIB_API int UpnpSendActionTemplateValues(
+    /*! [in] The handle of the control point sending the action. */
+    UpnpClient_Handle Hnd,
+    /*! [in] The action template. */
+    const UpnpActionTemplate* Template,
+    /*! [in] Values of the arguments, in the order of the argument names. */
+    const char* const* ArgValues,
+    /*! [in] Names of the wanted output arguments. */
+    const char* const* RespNames,
+    /*! [in] Number of wanted output arguments. */
+    int NumResp,
+    /*! [out] Array of \b NumResp values. The SDK allocates the values and
+     * the caller needs to free them with free(). */
+    char** RespValues);
+
+/*!
+ * \brief Sends an action made from a template like
+ * \b UpnpSendActionNonBlocking.
+ *
+ * The action request of the \c UPNP_CONTROL_ACTION_COMPLETE event is
+ * \c NULL.
+ *
+ * \return An integer representing one of the following, or a value like
+ * from \b UpnpSendActionNonBlocking:
+ *     \li \c UPNP_E_SUCCESS: The action is queued.
+ *     \li \c UPNP_E_INVALID_HANDLE: The handle is not a valid control
+ *             point handle.
+ *     \li \c UPNP_E_INVALID_PARAM: A pointer or an argument value is
+ *             \c NULL.
+ */
+UPNPLIB_API int UpnpSendActionTemplateNonBlocking(
+    /*! [in] The handle of the control point sending the action. */
+    UpnpClient_Handle Hnd,
+    /*! [in] The action template. */
+    const UpnpActionTemplate* Template,
+    /*! [in] Values of the arguments, in the order of the argument names. */
+    const char* const* ArgValues,
+    /*! [in] Pointer to a callback function to be invoked when the operation
+     * completes. */
+    Upnp_FunPtr Fun,
+    /*! [in] Pointer to user data that to be passed to the callback when
+     * invoked. */
+    const void* Cookie);
+
 /// @} Step 3: Control
 
 /******************************************************************************
@@ -2495,6 +2802,52 @@ UPNPLIB_API int UpnpDownloadXmlDoc(
     /*! [out] A pointer in which to store the XML document. */
     IXML_Document** xmlDoc);
 
+/*!
+ * \brief Callback of \b UpnpDownloadXmlDocs for each downloaded document.
+ */
+typedef void (*Upnp_XmlDocFunPtr)(
+    /*! [in] URL of the document. */
+    const char* url,
+    /*! [in] Result like from \b UpnpDownloadXmlDoc, or \c UPNP_E_FINISH if
+     * the SDK was finished before the document was downloaded. */
+    int errCode,
+    /*! [in] The parsed document on success, otherwise nullptr. The
+     * application is responsible for freeing it. */
+    IXML_Document* xmlDoc,
+    /*! [in] The cookie given to \b UpnpDownloadXmlDocs. */
+    void* cookie);
+
+/*!
+ * \brief Downloads XML documents from a list of URLs asynchronously.
+ *
+ * This is the batch version of \b UpnpDownloadXmlDoc for the descriptions of
+ * discovered devices. The documents are downloaded and parsed by up to
+ * \b maxParallel jobs of the send thread pool, so one document is parsed while
+ * others are received. Identical URLs are downloaded only once and \b Fun is
+ * called once for each unique URL, from one of the jobs. The calls are not in
+ * the order of the list.
+ *
+ * \return An integer representing one of the following:
+ *     \li \c UPNP_E_SUCCESS: The downloads are started.
+ *     \li \c UPNP_E_FINISH: The SDK is not initialized.
+ *     \li \c UPNP_E_INVALID_PARAM: \b urls, one of its entries or \b Fun is
+ *             not a valid pointer, or \b count or \b maxParallel is out of
+ *             range.
+ *     \li \c UPNP_E_OUTOF_MEMORY: No download could be started. \b Fun is
+ *             not called.
+ */
+UPNPLIB_API int UpnpDownloadXmlDocs(
+    /*! [in] List of URLs of the XML documents. */
+    const char* const* urls,
+    /*! [in] Number of entries in \b urls. */
+    int count,
+    /*! [in] Maximal number of documents that are downloaded in parallel. */
+    int maxParallel,
+    /*! [in] Function that is called with each document. */
+    Upnp_XmlDocFunPtr Fun,
+    /*! [in] Pointer that is given to \b Fun. */
+    const void* Cookie);
+
 /// @} Control Point HTTP API
 
 /******************************************************************************
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -7,6 +7,8 @@
  * \authors Marcelo Roberto Jimenez, Ingo Höft
  */
 #include <UpnpActionComplete.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <stdlib.h> /* for calloc(), free() */
 #include <string.h> /* for strlen(), strdup() */
@@ -19,15 +21,21 @@ struct s_UpnpActionComplete {
     IXML_Document* m_ActionResult;  ///< m_ActionResult
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpActionComplete, 1>;
+} // anonymous namespace
+
 UpnpActionComplete* UpnpActionComplete_new() {
     struct s_UpnpActionComplete* p =
-        (s_UpnpActionComplete*)calloc(1, sizeof(struct s_UpnpActionComplete));
+        (s_UpnpActionComplete*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
-    p->m_CtrlUrl = UpnpString_new();
+    p->m_CtrlUrl = inline_strings::string(p, 0);
     /*p->m_ActionRequest = 0;*/
     /*p->m_ActionResult = 0;*/
 
@@ -42,11 +50,11 @@ void UpnpActionComplete_delete(UpnpActionComplete* q) {
 
     p->m_ActionResult = 0;
     p->m_ActionRequest = 0;
-    UpnpString_delete(p->m_CtrlUrl);
+    UpnpString_inline_destroy(p->m_CtrlUrl);
     p->m_CtrlUrl = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpActionComplete_assign(UpnpActionComplete* p,
@@ -95,7 +103,7 @@ const UpnpString* UpnpActionComplete_get_CtrlUrl(const UpnpActionComplete* p) {
 int UpnpActionComplete_set_CtrlUrl(UpnpActionComplete* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_CtrlUrl, q);
+    return inline_strings::set_String(p->m_CtrlUrl, q);
 }
 
 size_t UpnpActionComplete_get_CtrlUrl_Length(const UpnpActionComplete* p) {
@@ -107,12 +115,12 @@ const char* UpnpActionComplete_get_CtrlUrl_cstr(const UpnpActionComplete* p) {
 }
 
 int UpnpActionComplete_strcpy_CtrlUrl(UpnpActionComplete* p, const char* s) {
-    return UpnpString_set_String(p->m_CtrlUrl, s);
+    return inline_strings::set_String(p->m_CtrlUrl, s);
 }
 
 int UpnpActionComplete_strncpy_CtrlUrl(UpnpActionComplete* p, const char* s,
                                        size_t n) {
-    return UpnpString_set_StringN(p->m_CtrlUrl, s, n);
+    return inline_strings::set_StringN(p->m_CtrlUrl, s, n);
 }
 
 void UpnpActionComplete_clear_CtrlUrl(UpnpActionComplete* p) {
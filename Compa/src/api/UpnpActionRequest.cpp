@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-07-31
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpActionRequest.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 #include <upnplib/port_sock.hpp>
 
 /// \cond
@@ -30,24 +32,30 @@ struct s_UpnpActionRequest {
     UpnpString* m_Os;                ///< m_Os
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpActionRequest, 5>;
+} // anonymous namespace
+
 UpnpActionRequest* UpnpActionRequest_new() {
     struct s_UpnpActionRequest* p =
-        (s_UpnpActionRequest*)calloc(1, sizeof(struct s_UpnpActionRequest));
+        (s_UpnpActionRequest*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
     /*p->m_Socket = 0;*/
-    p->m_ErrStr = UpnpString_new();
-    p->m_ActionName = UpnpString_new();
-    p->m_DevUDN = UpnpString_new();
-    p->m_ServiceID = UpnpString_new();
+    p->m_ErrStr = inline_strings::string(p, 0);
+    p->m_ActionName = inline_strings::string(p, 1);
+    p->m_DevUDN = inline_strings::string(p, 2);
+    p->m_ServiceID = inline_strings::string(p, 3);
     /*p->m_ActionRequest = 0;*/
     /*p->m_ActionResult = 0;*/
     /*p->m_SoapHeader = 0;*/
     /* memset(&p->m_CtrlPtIPAddr, 0, sizeof (struct sockaddr_storage)); */
-    p->m_Os = UpnpString_new();
+    p->m_Os = inline_strings::string(p, 4);
 
     return (UpnpActionRequest*)p;
 }
@@ -58,24 +66,24 @@ void UpnpActionRequest_delete(UpnpActionRequest* q) {
     if (!p)
         return;
 
-    UpnpString_delete(p->m_Os);
+    UpnpString_inline_destroy(p->m_Os);
     p->m_Os = 0;
     memset(&p->m_CtrlPtIPAddr, 0, sizeof(struct sockaddr_storage));
     p->m_SoapHeader = 0;
     p->m_ActionResult = 0;
     p->m_ActionRequest = 0;
-    UpnpString_delete(p->m_ServiceID);
+    UpnpString_inline_destroy(p->m_ServiceID);
     p->m_ServiceID = 0;
-    UpnpString_delete(p->m_DevUDN);
+    UpnpString_inline_destroy(p->m_DevUDN);
     p->m_DevUDN = 0;
-    UpnpString_delete(p->m_ActionName);
+    UpnpString_inline_destroy(p->m_ActionName);
     p->m_ActionName = 0;
-    UpnpString_delete(p->m_ErrStr);
+    UpnpString_inline_destroy(p->m_ErrStr);
     p->m_ErrStr = 0;
     p->m_Socket = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpActionRequest_assign(UpnpActionRequest* p, const UpnpActionRequest* q) {
@@ -146,7 +154,7 @@ const UpnpString* UpnpActionRequest_get_ErrStr(const UpnpActionRequest* p) {
 int UpnpActionRequest_set_ErrStr(UpnpActionRequest* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ErrStr, q);
+    return inline_strings::set_String(p->m_ErrStr, q);
 }
 
 size_t UpnpActionRequest_get_ErrStr_Length(const UpnpActionRequest* p) {
@@ -158,12 +166,12 @@ const char* UpnpActionRequest_get_ErrStr_cstr(const UpnpActionRequest* p) {
 }
 
 int UpnpActionRequest_strcpy_ErrStr(UpnpActionRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_ErrStr, s);
+    return inline_strings::set_String(p->m_ErrStr, s);
 }
 
 int UpnpActionRequest_strncpy_ErrStr(UpnpActionRequest* p, const char* s,
                                      size_t n) {
-    return UpnpString_set_StringN(p->m_ErrStr, s, n);
+    return inline_strings::set_StringN(p->m_ErrStr, s, n);
 }
 
 void UpnpActionRequest_clear_ErrStr(UpnpActionRequest* p) {
@@ -178,7 +186,7 @@ int UpnpActionRequest_set_ActionName(UpnpActionRequest* p,
                                      const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ActionName, q);
+    return inline_strings::set_String(p->m_ActionName, q);
 }
 
 size_t UpnpActionRequest_get_ActionName_Length(const UpnpActionRequest* p) {
@@ -190,12 +198,12 @@ const char* UpnpActionRequest_get_ActionName_cstr(const UpnpActionRequest* p) {
 }
 
 int UpnpActionRequest_strcpy_ActionName(UpnpActionRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_ActionName, s);
+    return inline_strings::set_String(p->m_ActionName, s);
 }
 
 int UpnpActionRequest_strncpy_ActionName(UpnpActionRequest* p, const char* s,
                                          size_t n) {
-    return UpnpString_set_StringN(p->m_ActionName, s, n);
+    return inline_strings::set_StringN(p->m_ActionName, s, n);
 }
 
 void UpnpActionRequest_clear_ActionName(UpnpActionRequest* p) {
@@ -209,7 +217,7 @@ const UpnpString* UpnpActionRequest_get_DevUDN(const UpnpActionRequest* p) {
 int UpnpActionRequest_set_DevUDN(UpnpActionRequest* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_DevUDN, q);
+    return inline_strings::set_String(p->m_DevUDN, q);
 }
 
 size_t UpnpActionRequest_get_DevUDN_Length(const UpnpActionRequest* p) {
@@ -221,12 +229,12 @@ const char* UpnpActionRequest_get_DevUDN_cstr(const UpnpActionRequest* p) {
 }
 
 int UpnpActionRequest_strcpy_DevUDN(UpnpActionRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_DevUDN, s);
+    return inline_strings::set_String(p->m_DevUDN, s);
 }
 
 int UpnpActionRequest_strncpy_DevUDN(UpnpActionRequest* p, const char* s,
                                      size_t n) {
-    return UpnpString_set_StringN(p->m_DevUDN, s, n);
+    return inline_strings::set_StringN(p->m_DevUDN, s, n);
 }
 
 void UpnpActionRequest_clear_DevUDN(UpnpActionRequest* p) {
@@ -240,7 +248,7 @@ const UpnpString* UpnpActionRequest_get_ServiceID(const UpnpActionRequest* p) {
 int UpnpActionRequest_set_ServiceID(UpnpActionRequest* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ServiceID, q);
+    return inline_strings::set_String(p->m_ServiceID, q);
 }
 
 size_t UpnpActionRequest_get_ServiceID_Length(const UpnpActionRequest* p) {
@@ -252,12 +260,12 @@ const char* UpnpActionRequest_get_ServiceID_cstr(const UpnpActionRequest* p) {
 }
 
 int UpnpActionRequest_strcpy_ServiceID(UpnpActionRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_ServiceID, s);
+    return inline_strings::set_String(p->m_ServiceID, s);
 }
 
 int UpnpActionRequest_strncpy_ServiceID(UpnpActionRequest* p, const char* s,
                                         size_t n) {
-    return UpnpString_set_StringN(p->m_ServiceID, s, n);
+    return inline_strings::set_StringN(p->m_ServiceID, s, n);
 }
 
 void UpnpActionRequest_clear_ServiceID(UpnpActionRequest* p) {
@@ -318,7 +326,7 @@ const UpnpString* UpnpActionRequest_get_Os(const UpnpActionRequest* p) {
 int UpnpActionRequest_set_Os(UpnpActionRequest* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Os, q);
+    return inline_strings::set_String(p->m_Os, q);
 }
 
 size_t UpnpActionRequest_get_Os_Length(const UpnpActionRequest* p) {
@@ -330,12 +338,12 @@ const char* UpnpActionRequest_get_Os_cstr(const UpnpActionRequest* p) {
 }
 
 int UpnpActionRequest_strcpy_Os(UpnpActionRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_Os, s);
+    return inline_strings::set_String(p->m_Os, s);
 }
 
 int UpnpActionRequest_strncpy_Os(UpnpActionRequest* p, const char* s,
                                  size_t n) {
-    return UpnpString_set_StringN(p->m_Os, s, n);
+    return inline_strings::set_StringN(p->m_Os, s, n);
 }
 
 void UpnpActionRequest_clear_Os(UpnpActionRequest* p) {
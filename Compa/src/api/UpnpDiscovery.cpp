@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-07-31
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpDiscovery.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 #include <upnplib/port_sock.hpp>
 
 /// \cond
@@ -33,23 +35,28 @@ struct s_UpnpDiscovery {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpDiscovery, 8, 96>;
+} // anonymous namespace
+
 UpnpDiscovery* UpnpDiscovery_new() {
-    struct s_UpnpDiscovery* p =
-        (s_UpnpDiscovery*)calloc(1, sizeof(struct s_UpnpDiscovery));
+    struct s_UpnpDiscovery* p = (s_UpnpDiscovery*)umock::stdlib_h.calloc(
+        1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
     /*p->m_Expires = 0;*/
-    p->m_DeviceID = UpnpString_new();
-    p->m_DeviceType = UpnpString_new();
-    p->m_ServiceType = UpnpString_new();
-    p->m_ServiceVer = UpnpString_new();
-    p->m_Location = UpnpString_new();
-    p->m_Os = UpnpString_new();
-    p->m_Date = UpnpString_new();
-    p->m_Ext = UpnpString_new();
+    p->m_DeviceID = inline_strings::string(p, 0);
+    p->m_DeviceType = inline_strings::string(p, 1);
+    p->m_ServiceType = inline_strings::string(p, 2);
+    p->m_ServiceVer = inline_strings::string(p, 3);
+    p->m_Location = inline_strings::string(p, 4);
+    p->m_Os = inline_strings::string(p, 5);
+    p->m_Date = inline_strings::string(p, 6);
+    p->m_Ext = inline_strings::string(p, 7);
     /* memset(&p->m_DestAddr, 0, sizeof (struct sockaddr_storage)); */
 
     return (UpnpDiscovery*)p;
@@ -62,26 +69,26 @@ void UpnpDiscovery_delete(UpnpDiscovery* q) {
         return;
 
     memset(&p->m_DestAddr, 0, sizeof(struct sockaddr_storage));
-    UpnpString_delete(p->m_Ext);
+    UpnpString_inline_destroy(p->m_Ext);
     p->m_Ext = 0;
-    UpnpString_delete(p->m_Date);
+    UpnpString_inline_destroy(p->m_Date);
     p->m_Date = 0;
-    UpnpString_delete(p->m_Os);
+    UpnpString_inline_destroy(p->m_Os);
     p->m_Os = 0;
-    UpnpString_delete(p->m_Location);
+    UpnpString_inline_destroy(p->m_Location);
     p->m_Location = 0;
-    UpnpString_delete(p->m_ServiceVer);
+    UpnpString_inline_destroy(p->m_ServiceVer);
     p->m_ServiceVer = 0;
-    UpnpString_delete(p->m_ServiceType);
+    UpnpString_inline_destroy(p->m_ServiceType);
     p->m_ServiceType = 0;
-    UpnpString_delete(p->m_DeviceType);
+    UpnpString_inline_destroy(p->m_DeviceType);
     p->m_DeviceType = 0;
-    UpnpString_delete(p->m_DeviceID);
+    UpnpString_inline_destroy(p->m_DeviceID);
     p->m_DeviceID = 0;
     p->m_Expires = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpDiscovery_assign(UpnpDiscovery* p, const UpnpDiscovery* q) {
@@ -141,7 +148,7 @@ const UpnpString* UpnpDiscovery_get_DeviceID(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_DeviceID(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_DeviceID, q);
+    return inline_strings::set_String(p->m_DeviceID, q);
 }
 
 size_t UpnpDiscovery_get_DeviceID_Length(const UpnpDiscovery* p) {
@@ -153,11 +160,11 @@ const char* UpnpDiscovery_get_DeviceID_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_DeviceID(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_DeviceID, s);
+    return inline_strings::set_String(p->m_DeviceID, s);
 }
 
 int UpnpDiscovery_strncpy_DeviceID(UpnpDiscovery* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_DeviceID, s, n);
+    return inline_strings::set_StringN(p->m_DeviceID, s, n);
 }
 
 void UpnpDiscovery_clear_DeviceID(UpnpDiscovery* p) {
@@ -171,7 +178,7 @@ const UpnpString* UpnpDiscovery_get_DeviceType(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_DeviceType(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_DeviceType, q);
+    return inline_strings::set_String(p->m_DeviceType, q);
 }
 
 size_t UpnpDiscovery_get_DeviceType_Length(const UpnpDiscovery* p) {
@@ -183,12 +190,12 @@ const char* UpnpDiscovery_get_DeviceType_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_DeviceType(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_DeviceType, s);
+    return inline_strings::set_String(p->m_DeviceType, s);
 }
 
 int UpnpDiscovery_strncpy_DeviceType(UpnpDiscovery* p, const char* s,
                                      size_t n) {
-    return UpnpString_set_StringN(p->m_DeviceType, s, n);
+    return inline_strings::set_StringN(p->m_DeviceType, s, n);
 }
 
 void UpnpDiscovery_clear_DeviceType(UpnpDiscovery* p) {
@@ -202,7 +209,7 @@ const UpnpString* UpnpDiscovery_get_ServiceType(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_ServiceType(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ServiceType, q);
+    return inline_strings::set_String(p->m_ServiceType, q);
 }
 
 size_t UpnpDiscovery_get_ServiceType_Length(const UpnpDiscovery* p) {
@@ -214,12 +221,12 @@ const char* UpnpDiscovery_get_ServiceType_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_ServiceType(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_ServiceType, s);
+    return inline_strings::set_String(p->m_ServiceType, s);
 }
 
 int UpnpDiscovery_strncpy_ServiceType(UpnpDiscovery* p, const char* s,
                                       size_t n) {
-    return UpnpString_set_StringN(p->m_ServiceType, s, n);
+    return inline_strings::set_StringN(p->m_ServiceType, s, n);
 }
 
 void UpnpDiscovery_clear_ServiceType(UpnpDiscovery* p) {
@@ -233,7 +240,7 @@ const UpnpString* UpnpDiscovery_get_ServiceVer(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_ServiceVer(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ServiceVer, q);
+    return inline_strings::set_String(p->m_ServiceVer, q);
 }
 
 size_t UpnpDiscovery_get_ServiceVer_Length(const UpnpDiscovery* p) {
@@ -245,12 +252,12 @@ const char* UpnpDiscovery_get_ServiceVer_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_ServiceVer(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_ServiceVer, s);
+    return inline_strings::set_String(p->m_ServiceVer, s);
 }
 
 int UpnpDiscovery_strncpy_ServiceVer(UpnpDiscovery* p, const char* s,
                                      size_t n) {
-    return UpnpString_set_StringN(p->m_ServiceVer, s, n);
+    return inline_strings::set_StringN(p->m_ServiceVer, s, n);
 }
 
 void UpnpDiscovery_clear_ServiceVer(UpnpDiscovery* p) {
@@ -264,7 +271,7 @@ const UpnpString* UpnpDiscovery_get_Location(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_Location(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Location, q);
+    return inline_strings::set_String(p->m_Location, q);
 }
 
 size_t UpnpDiscovery_get_Location_Length(const UpnpDiscovery* p) {
@@ -276,11 +283,11 @@ const char* UpnpDiscovery_get_Location_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_Location(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_Location, s);
+    return inline_strings::set_String(p->m_Location, s);
 }
 
 int UpnpDiscovery_strncpy_Location(UpnpDiscovery* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_Location, s, n);
+    return inline_strings::set_StringN(p->m_Location, s, n);
 }
 
 void UpnpDiscovery_clear_Location(UpnpDiscovery* p) {
@@ -294,7 +301,7 @@ const UpnpString* UpnpDiscovery_get_Os(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_Os(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Os, q);
+    return inline_strings::set_String(p->m_Os, q);
 }
 
 size_t UpnpDiscovery_get_Os_Length(const UpnpDiscovery* p) {
@@ -306,11 +313,11 @@ const char* UpnpDiscovery_get_Os_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_Os(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_Os, s);
+    return inline_strings::set_String(p->m_Os, s);
 }
 
 int UpnpDiscovery_strncpy_Os(UpnpDiscovery* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_Os, s, n);
+    return inline_strings::set_StringN(p->m_Os, s, n);
 }
 
 void UpnpDiscovery_clear_Os(UpnpDiscovery* p) { UpnpString_clear(p->m_Os); }
@@ -322,7 +329,7 @@ const UpnpString* UpnpDiscovery_get_Date(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_Date(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Date, q);
+    return inline_strings::set_String(p->m_Date, q);
 }
 
 size_t UpnpDiscovery_get_Date_Length(const UpnpDiscovery* p) {
@@ -334,11 +341,11 @@ const char* UpnpDiscovery_get_Date_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_Date(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_Date, s);
+    return inline_strings::set_String(p->m_Date, s);
 }
 
 int UpnpDiscovery_strncpy_Date(UpnpDiscovery* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_Date, s, n);
+    return inline_strings::set_StringN(p->m_Date, s, n);
 }
 
 void UpnpDiscovery_clear_Date(UpnpDiscovery* p) { UpnpString_clear(p->m_Date); }
@@ -350,7 +357,7 @@ const UpnpString* UpnpDiscovery_get_Ext(const UpnpDiscovery* p) {
 int UpnpDiscovery_set_Ext(UpnpDiscovery* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Ext, q);
+    return inline_strings::set_String(p->m_Ext, q);
 }
 
 size_t UpnpDiscovery_get_Ext_Length(const UpnpDiscovery* p) {
@@ -362,11 +369,11 @@ const char* UpnpDiscovery_get_Ext_cstr(const UpnpDiscovery* p) {
 }
 
 int UpnpDiscovery_strcpy_Ext(UpnpDiscovery* p, const char* s) {
-    return UpnpString_set_String(p->m_Ext, s);
+    return inline_strings::set_String(p->m_Ext, s);
 }
 
 int UpnpDiscovery_strncpy_Ext(UpnpDiscovery* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_Ext, s, n);
+    return inline_strings::set_StringN(p->m_Ext, s, n);
 }
 
 void UpnpDiscovery_clear_Ext(UpnpDiscovery* p) { UpnpString_clear(p->m_Ext); }
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpEvent.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <stdlib.h> /* for calloc(), free() */
 #include <string.h> /* for strlen(), strdup() */
@@ -22,15 +24,21 @@ struct s_UpnpEvent {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpEvent, 1>;
+} // anonymous namespace
+
 UpnpEvent* UpnpEvent_new() {
-    struct s_UpnpEvent* p = (s_UpnpEvent*)calloc(1, sizeof(struct s_UpnpEvent));
+    struct s_UpnpEvent* p = (s_UpnpEvent*)umock::stdlib_h.calloc(
+        1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_EventKey = 0;*/
     /*p->m_ChangedVariables = 0;*/
-    p->m_SID = UpnpString_new();
+    p->m_SID = inline_strings::string(p, 0);
 
     return (UpnpEvent*)p;
 }
@@ -41,12 +49,12 @@ void UpnpEvent_delete(UpnpEvent* q) {
     if (!p)
         return;
 
-    UpnpString_delete(p->m_SID);
+    UpnpString_inline_destroy(p->m_SID);
     p->m_SID = 0;
     p->m_ChangedVariables = 0;
     p->m_EventKey = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpEvent_assign(UpnpEvent* p, const UpnpEvent* q) {
@@ -96,7 +104,7 @@ const UpnpString* UpnpEvent_get_SID(const UpnpEvent* p) { return p->m_SID; }
 int UpnpEvent_set_SID(UpnpEvent* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_SID, q);
+    return inline_strings::set_String(p->m_SID, q);
 }
 
 size_t UpnpEvent_get_SID_Length(const UpnpEvent* p) {
@@ -108,11 +116,11 @@ const char* UpnpEvent_get_SID_cstr(const UpnpEvent* p) {
 }
 
 int UpnpEvent_strcpy_SID(UpnpEvent* p, const char* s) {
-    return UpnpString_set_String(p->m_SID, s);
+    return inline_strings::set_String(p->m_SID, s);
 }
 
 int UpnpEvent_strncpy_SID(UpnpEvent* p, const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_SID, s, n);
+    return inline_strings::set_StringN(p->m_SID, s, n);
 }
 
 void UpnpEvent_clear_SID(UpnpEvent* p) { UpnpString_clear(p->m_SID); }
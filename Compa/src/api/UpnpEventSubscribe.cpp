@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpEventSubscribe.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <stdlib.h> /* for calloc(), free() */
 #include <string.h> /* for strlen(), strdup() */
@@ -23,17 +25,23 @@ struct s_UpnpEventSubscribe {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpEventSubscribe, 2>;
+} // anonymous namespace
+
 UpnpEventSubscribe* UpnpEventSubscribe_new() {
     struct s_UpnpEventSubscribe* p =
-        (s_UpnpEventSubscribe*)calloc(1, sizeof(struct s_UpnpEventSubscribe));
+        (s_UpnpEventSubscribe*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
     /*p->m_TimeOut = 0;*/
-    p->m_SID = UpnpString_new();
-    p->m_PublisherUrl = UpnpString_new();
+    p->m_SID = inline_strings::string(p, 0);
+    p->m_PublisherUrl = inline_strings::string(p, 1);
 
     return (UpnpEventSubscribe*)p;
 }
@@ -44,14 +52,14 @@ void UpnpEventSubscribe_delete(UpnpEventSubscribe* q) {
     if (!p)
         return;
 
-    UpnpString_delete(p->m_PublisherUrl);
+    UpnpString_inline_destroy(p->m_PublisherUrl);
     p->m_PublisherUrl = 0;
-    UpnpString_delete(p->m_SID);
+    UpnpString_inline_destroy(p->m_SID);
     p->m_SID = 0;
     p->m_TimeOut = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpEventSubscribe_assign(UpnpEventSubscribe* p,
@@ -109,7 +117,7 @@ const UpnpString* UpnpEventSubscribe_get_SID(const UpnpEventSubscribe* p) {
 int UpnpEventSubscribe_set_SID(UpnpEventSubscribe* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_SID, q);
+    return inline_strings::set_String(p->m_SID, q);
 }
 
 size_t UpnpEventSubscribe_get_SID_Length(const UpnpEventSubscribe* p) {
@@ -121,12 +129,12 @@ const char* UpnpEventSubscribe_get_SID_cstr(const UpnpEventSubscribe* p) {
 }
 
 int UpnpEventSubscribe_strcpy_SID(UpnpEventSubscribe* p, const char* s) {
-    return UpnpString_set_String(p->m_SID, s);
+    return inline_strings::set_String(p->m_SID, s);
 }
 
 int UpnpEventSubscribe_strncpy_SID(UpnpEventSubscribe* p, const char* s,
                                    size_t n) {
-    return UpnpString_set_StringN(p->m_SID, s, n);
+    return inline_strings::set_StringN(p->m_SID, s, n);
 }
 
 void UpnpEventSubscribe_clear_SID(UpnpEventSubscribe* p) {
@@ -142,7 +150,7 @@ int UpnpEventSubscribe_set_PublisherUrl(UpnpEventSubscribe* p,
                                         const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_PublisherUrl, q);
+    return inline_strings::set_String(p->m_PublisherUrl, q);
 }
 
 size_t UpnpEventSubscribe_get_PublisherUrl_Length(const UpnpEventSubscribe* p) {
@@ -156,12 +164,12 @@ UpnpEventSubscribe_get_PublisherUrl_cstr(const UpnpEventSubscribe* p) {
 
 int UpnpEventSubscribe_strcpy_PublisherUrl(UpnpEventSubscribe* p,
                                            const char* s) {
-    return UpnpString_set_String(p->m_PublisherUrl, s);
+    return inline_strings::set_String(p->m_PublisherUrl, s);
 }
 
 int UpnpEventSubscribe_strncpy_PublisherUrl(UpnpEventSubscribe* p,
                                             const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_PublisherUrl, s, n);
+    return inline_strings::set_StringN(p->m_PublisherUrl, s, n);
 }
 
 void UpnpEventSubscribe_clear_PublisherUrl(UpnpEventSubscribe* p) {
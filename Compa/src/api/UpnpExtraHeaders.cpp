@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpExtraHeaders.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <cstdlib> /* for calloc(), free() */
 
@@ -22,16 +24,21 @@ struct s_UpnpExtraHeaders {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpExtraHeaders, 2>;
+} // anonymous namespace
+
 UpnpExtraHeaders* UpnpExtraHeaders_new() {
-    struct s_UpnpExtraHeaders* p =
-        (s_UpnpExtraHeaders*)calloc(1, sizeof(struct s_UpnpExtraHeaders));
+    struct s_UpnpExtraHeaders* p = (s_UpnpExtraHeaders*)umock::stdlib_h.calloc(
+        1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     UpnpListInit(&p->m_node);
-    p->m_name = UpnpString_new();
-    p->m_value = UpnpString_new();
+    p->m_name = inline_strings::string(p, 0);
+    p->m_value = inline_strings::string(p, 1);
     /*p->m_resp = 0;*/
 
     return (UpnpExtraHeaders*)p;
@@ -45,13 +52,13 @@ void UpnpExtraHeaders_delete(UpnpExtraHeaders* q) {
 
     ixmlFreeDOMString(p->m_resp);
     p->m_resp = 0;
-    UpnpString_delete(p->m_value);
+    UpnpString_inline_destroy(p->m_value);
     p->m_value = 0;
-    UpnpString_delete(p->m_name);
+    UpnpString_inline_destroy(p->m_name);
     p->m_name = 0;
     UpnpListInit(&p->m_node);
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpExtraHeaders_assign(UpnpExtraHeaders* p, const UpnpExtraHeaders* q) {
@@ -101,7 +108,7 @@ const UpnpString* UpnpExtraHeaders_get_name(const UpnpExtraHeaders* p) {
 int UpnpExtraHeaders_set_name(UpnpExtraHeaders* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_name, q);
+    return inline_strings::set_String(p->m_name, q);
 }
 
 size_t UpnpExtraHeaders_get_name_Length(const UpnpExtraHeaders* p) {
@@ -113,12 +120,12 @@ const char* UpnpExtraHeaders_get_name_cstr(const UpnpExtraHeaders* p) {
 }
 
 int UpnpExtraHeaders_strcpy_name(UpnpExtraHeaders* p, const char* s) {
-    return UpnpString_set_String(p->m_name, s);
+    return inline_strings::set_String(p->m_name, s);
 }
 
 int UpnpExtraHeaders_strncpy_name(UpnpExtraHeaders* p, const char* s,
                                   size_t n) {
-    return UpnpString_set_StringN(p->m_name, s, n);
+    return inline_strings::set_StringN(p->m_name, s, n);
 }
 
 void UpnpExtraHeaders_clear_name(UpnpExtraHeaders* p) {
@@ -132,7 +139,7 @@ const UpnpString* UpnpExtraHeaders_get_value(const UpnpExtraHeaders* p) {
 int UpnpExtraHeaders_set_value(UpnpExtraHeaders* p, const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_value, q);
+    return inline_strings::set_String(p->m_value, q);
 }
 
 size_t UpnpExtraHeaders_get_value_Length(const UpnpExtraHeaders* p) {
@@ -144,12 +151,12 @@ const char* UpnpExtraHeaders_get_value_cstr(const UpnpExtraHeaders* p) {
 }
 
 int UpnpExtraHeaders_strcpy_value(UpnpExtraHeaders* p, const char* s) {
-    return UpnpString_set_String(p->m_value, s);
+    return inline_strings::set_String(p->m_value, s);
 }
 
 int UpnpExtraHeaders_strncpy_value(UpnpExtraHeaders* p, const char* s,
                                    size_t n) {
-    return UpnpString_set_StringN(p->m_value, s, n);
+    return inline_strings::set_StringN(p->m_value, s, n);
 }
 
 void UpnpExtraHeaders_clear_value(UpnpExtraHeaders* p) {
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 // Last compare with pupnp original source file on 2023-04-25, ver 1.14.15
 /*!
@@ -9,6 +9,8 @@
  */
 
 #include <UpnpFileInfo.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 #ifndef COMPA_UPNPFILEINFO_HPP
 #error "Wrong UpnpFileInfo.hpp header file included."
 #endif
@@ -35,8 +37,14 @@ struct s_UpnpFileInfo {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpFileInfo, 1>;
+} // anonymous namespace
+
 UpnpFileInfo* UpnpFileInfo_new() {
-    UpnpFileInfo* p = (UpnpFileInfo*)calloc(1, sizeof(UpnpFileInfo));
+    UpnpFileInfo* p = (UpnpFileInfo*)umock::stdlib_h.calloc(
+        1, inline_strings::object_size());
 
     if (!p)
         return 0;
@@ -48,7 +56,7 @@ UpnpFileInfo* UpnpFileInfo_new() {
     /*p->m_ContentType = 0;*/
     UpnpListInit(&p->m_ExtraHeadersList);
     /* memset(&p->m_CtrlPtIPAddr, 0, sizeof (struct sockaddr_storage)); */
-    p->m_Os = UpnpString_new();
+    p->m_Os = inline_strings::string(p, 0);
 
     return (UpnpFileInfo*)p;
 }
@@ -60,7 +68,7 @@ void UpnpFileInfo_delete(UpnpFileInfo* q) {
     if (!p)
         return;
 
-    UpnpString_delete(p->m_Os);
+    UpnpString_inline_destroy(p->m_Os);
     p->m_Os = 0;
     memset(&p->m_CtrlPtIPAddr, 0, sizeof(struct sockaddr_storage));
     UpnpListInit(&p->m_ExtraHeadersList);
@@ -71,7 +79,7 @@ void UpnpFileInfo_delete(UpnpFileInfo* q) {
     p->m_LastModified = 0;
     p->m_FileLength = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpFileInfo_assign(UpnpFileInfo* p, const UpnpFileInfo* q) {
@@ -250,7 +258,7 @@ int UpnpFileInfo_set_Os(UpnpFileInfo* p, const UpnpString* s) {
 
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_Os, q);
+    return inline_strings::set_String(p->m_Os, q);
 }
 
 size_t UpnpFileInfo_get_Os_Length(const UpnpFileInfo* p) {
@@ -265,14 +273,14 @@ int UpnpFileInfo_strcpy_Os(UpnpFileInfo* p, const char* s) {
     if (!p)
         return 0;
 
-    return UpnpString_set_String(p->m_Os, s);
+    return inline_strings::set_String(p->m_Os, s);
 }
 
 int UpnpFileInfo_strncpy_Os(UpnpFileInfo* p, const char* s, size_t n) {
     if (!p)
         return 0;
 
-    return UpnpString_set_StringN(p->m_Os, s, n);
+    return inline_strings::set_StringN(p->m_Os, s, n);
 }
 
 void UpnpFileInfo_clear_Os(UpnpFileInfo* p) {
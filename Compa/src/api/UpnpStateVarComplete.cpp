@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-02
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpStateVarComplete.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <stdlib.h> /* for calloc(), free() */
 #include <string.h> /* for strlen(), strdup() */
@@ -23,16 +25,22 @@ struct s_UpnpStateVarComplete {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpStateVarComplete, 2>;
+} // anonymous namespace
+
 UpnpStateVarComplete* UpnpStateVarComplete_new() {
-    struct s_UpnpStateVarComplete* p = (s_UpnpStateVarComplete*)calloc(
-        1, sizeof(struct s_UpnpStateVarComplete));
+    struct s_UpnpStateVarComplete* p =
+        (s_UpnpStateVarComplete*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
-    p->m_CtrlUrl = UpnpString_new();
-    p->m_StateVarName = UpnpString_new();
+    p->m_CtrlUrl = inline_strings::string(p, 0);
+    p->m_StateVarName = inline_strings::string(p, 1);
     /*p->m_CurrentVal = 0;*/
 
     return (UpnpStateVarComplete*)p;
@@ -46,13 +54,13 @@ void UpnpStateVarComplete_delete(UpnpStateVarComplete* q) {
 
     ixmlFreeDOMString(p->m_CurrentVal);
     p->m_CurrentVal = 0;
-    UpnpString_delete(p->m_StateVarName);
+    UpnpString_inline_destroy(p->m_StateVarName);
     p->m_StateVarName = 0;
-    UpnpString_delete(p->m_CtrlUrl);
+    UpnpString_inline_destroy(p->m_CtrlUrl);
     p->m_CtrlUrl = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpStateVarComplete_assign(UpnpStateVarComplete* p,
@@ -103,7 +111,7 @@ int UpnpStateVarComplete_set_CtrlUrl(UpnpStateVarComplete* p,
                                      const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_CtrlUrl, q);
+    return inline_strings::set_String(p->m_CtrlUrl, q);
 }
 
 size_t UpnpStateVarComplete_get_CtrlUrl_Length(const UpnpStateVarComplete* p) {
@@ -117,12 +125,12 @@ UpnpStateVarComplete_get_CtrlUrl_cstr(const UpnpStateVarComplete* p) {
 
 int UpnpStateVarComplete_strcpy_CtrlUrl(UpnpStateVarComplete* p,
                                         const char* s) {
-    return UpnpString_set_String(p->m_CtrlUrl, s);
+    return inline_strings::set_String(p->m_CtrlUrl, s);
 }
 
 int UpnpStateVarComplete_strncpy_CtrlUrl(UpnpStateVarComplete* p, const char* s,
                                          size_t n) {
-    return UpnpString_set_StringN(p->m_CtrlUrl, s, n);
+    return inline_strings::set_StringN(p->m_CtrlUrl, s, n);
 }
 
 void UpnpStateVarComplete_clear_CtrlUrl(UpnpStateVarComplete* p) {
@@ -138,7 +146,7 @@ int UpnpStateVarComplete_set_StateVarName(UpnpStateVarComplete* p,
                                           const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_StateVarName, q);
+    return inline_strings::set_String(p->m_StateVarName, q);
 }
 
 size_t
@@ -153,12 +161,12 @@ UpnpStateVarComplete_get_StateVarName_cstr(const UpnpStateVarComplete* p) {
 
 int UpnpStateVarComplete_strcpy_StateVarName(UpnpStateVarComplete* p,
                                              const char* s) {
-    return UpnpString_set_String(p->m_StateVarName, s);
+    return inline_strings::set_String(p->m_StateVarName, s);
 }
 
 int UpnpStateVarComplete_strncpy_StateVarName(UpnpStateVarComplete* p,
                                               const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_StateVarName, s, n);
+    return inline_strings::set_StringN(p->m_StateVarName, s, n);
 }
 
 void UpnpStateVarComplete_clear_StateVarName(UpnpStateVarComplete* p) {
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-07-31
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpStateVarRequest.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 #include <upnplib/port_sock.hpp>
 
 /// \cond
@@ -30,19 +32,25 @@ struct s_UpnpStateVarRequest {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpStateVarRequest, 4>;
+} // anonymous namespace
+
 UpnpStateVarRequest* UpnpStateVarRequest_new() {
     struct s_UpnpStateVarRequest* p =
-        (s_UpnpStateVarRequest*)calloc(1, sizeof(struct s_UpnpStateVarRequest));
+        (s_UpnpStateVarRequest*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
     /*p->m_ErrCode = 0;*/
     /*p->m_Socket = 0;*/
-    p->m_ErrStr = UpnpString_new();
-    p->m_DevUDN = UpnpString_new();
-    p->m_ServiceID = UpnpString_new();
-    p->m_StateVarName = UpnpString_new();
+    p->m_ErrStr = inline_strings::string(p, 0);
+    p->m_DevUDN = inline_strings::string(p, 1);
+    p->m_ServiceID = inline_strings::string(p, 2);
+    p->m_StateVarName = inline_strings::string(p, 3);
     /* memset(&p->m_CtrlPtIPAddr, 0, sizeof (struct sockaddr_storage)); */
     /*p->m_CurrentVal = 0;*/
 
@@ -58,18 +66,18 @@ void UpnpStateVarRequest_delete(UpnpStateVarRequest* q) {
     ixmlFreeDOMString(p->m_CurrentVal);
     p->m_CurrentVal = 0;
     memset(&p->m_CtrlPtIPAddr, 0, sizeof(struct sockaddr_storage));
-    UpnpString_delete(p->m_StateVarName);
+    UpnpString_inline_destroy(p->m_StateVarName);
     p->m_StateVarName = 0;
-    UpnpString_delete(p->m_ServiceID);
+    UpnpString_inline_destroy(p->m_ServiceID);
     p->m_ServiceID = 0;
-    UpnpString_delete(p->m_DevUDN);
+    UpnpString_inline_destroy(p->m_DevUDN);
     p->m_DevUDN = 0;
-    UpnpString_delete(p->m_ErrStr);
+    UpnpString_inline_destroy(p->m_ErrStr);
     p->m_ErrStr = 0;
     p->m_Socket = 0;
     p->m_ErrCode = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpStateVarRequest_assign(UpnpStateVarRequest* p,
@@ -137,7 +145,7 @@ int UpnpStateVarRequest_set_ErrStr(UpnpStateVarRequest* p,
                                    const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ErrStr, q);
+    return inline_strings::set_String(p->m_ErrStr, q);
 }
 
 size_t UpnpStateVarRequest_get_ErrStr_Length(const UpnpStateVarRequest* p) {
@@ -149,12 +157,12 @@ const char* UpnpStateVarRequest_get_ErrStr_cstr(const UpnpStateVarRequest* p) {
 }
 
 int UpnpStateVarRequest_strcpy_ErrStr(UpnpStateVarRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_ErrStr, s);
+    return inline_strings::set_String(p->m_ErrStr, s);
 }
 
 int UpnpStateVarRequest_strncpy_ErrStr(UpnpStateVarRequest* p, const char* s,
                                        size_t n) {
-    return UpnpString_set_StringN(p->m_ErrStr, s, n);
+    return inline_strings::set_StringN(p->m_ErrStr, s, n);
 }
 
 void UpnpStateVarRequest_clear_ErrStr(UpnpStateVarRequest* p) {
@@ -169,7 +177,7 @@ int UpnpStateVarRequest_set_DevUDN(UpnpStateVarRequest* p,
                                    const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_DevUDN, q);
+    return inline_strings::set_String(p->m_DevUDN, q);
 }
 
 size_t UpnpStateVarRequest_get_DevUDN_Length(const UpnpStateVarRequest* p) {
@@ -181,12 +189,12 @@ const char* UpnpStateVarRequest_get_DevUDN_cstr(const UpnpStateVarRequest* p) {
 }
 
 int UpnpStateVarRequest_strcpy_DevUDN(UpnpStateVarRequest* p, const char* s) {
-    return UpnpString_set_String(p->m_DevUDN, s);
+    return inline_strings::set_String(p->m_DevUDN, s);
 }
 
 int UpnpStateVarRequest_strncpy_DevUDN(UpnpStateVarRequest* p, const char* s,
                                        size_t n) {
-    return UpnpString_set_StringN(p->m_DevUDN, s, n);
+    return inline_strings::set_StringN(p->m_DevUDN, s, n);
 }
 
 void UpnpStateVarRequest_clear_DevUDN(UpnpStateVarRequest* p) {
@@ -202,7 +210,7 @@ int UpnpStateVarRequest_set_ServiceID(UpnpStateVarRequest* p,
                                       const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ServiceID, q);
+    return inline_strings::set_String(p->m_ServiceID, q);
 }
 
 size_t UpnpStateVarRequest_get_ServiceID_Length(const UpnpStateVarRequest* p) {
@@ -216,12 +224,12 @@ UpnpStateVarRequest_get_ServiceID_cstr(const UpnpStateVarRequest* p) {
 
 int UpnpStateVarRequest_strcpy_ServiceID(UpnpStateVarRequest* p,
                                          const char* s) {
-    return UpnpString_set_String(p->m_ServiceID, s);
+    return inline_strings::set_String(p->m_ServiceID, s);
 }
 
 int UpnpStateVarRequest_strncpy_ServiceID(UpnpStateVarRequest* p, const char* s,
                                           size_t n) {
-    return UpnpString_set_StringN(p->m_ServiceID, s, n);
+    return inline_strings::set_StringN(p->m_ServiceID, s, n);
 }
 
 void UpnpStateVarRequest_clear_ServiceID(UpnpStateVarRequest* p) {
@@ -237,7 +245,7 @@ int UpnpStateVarRequest_set_StateVarName(UpnpStateVarRequest* p,
                                          const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_StateVarName, q);
+    return inline_strings::set_String(p->m_StateVarName, q);
 }
 
 size_t
@@ -252,12 +260,12 @@ UpnpStateVarRequest_get_StateVarName_cstr(const UpnpStateVarRequest* p) {
 
 int UpnpStateVarRequest_strcpy_StateVarName(UpnpStateVarRequest* p,
                                             const char* s) {
-    return UpnpString_set_String(p->m_StateVarName, s);
+    return inline_strings::set_String(p->m_StateVarName, s);
 }
 
 int UpnpStateVarRequest_strncpy_StateVarName(UpnpStateVarRequest* p,
                                              const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_StateVarName, s, n);
+    return inline_strings::set_StringN(p->m_StateVarName, s, n);
 }
 
 void UpnpStateVarRequest_clear_StateVarName(UpnpStateVarRequest* p) {
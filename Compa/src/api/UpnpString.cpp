@@ -1,5 +1,5 @@
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-07
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor who haven't made a note.
 // Last compare with pupnp original source file on 2023-04-26, ver 1.14.15
 /*!
@@ -218,4 +218,61 @@ int UpnpString_casecmp(UpnpString* p, UpnpString* q) {
     return strcasecmp(cp, cq);
 }
 
+size_t UpnpString_inline_size(size_t capacity) {
+    constexpr size_t align{alignof(UpnpString)};
+    return sizeof(UpnpString) + (capacity + align - 1) / align * align;
+}
+
+UpnpString* UpnpString_inline_init(void* mem, size_t capacity) {
+    if (!mem || capacity == 0)
+        return NULL;
+    UpnpString* p = (UpnpString*)mem;
+    p->m_length = (size_t)0;
+    /* The inline buffer directly follows the string. */
+    p->m_string = (char*)(p + 1);
+    p->m_string[0] = 0;
+
+    return p;
+}
+
+void UpnpString_inline_destroy(UpnpString* p) {
+    if (!p)
+        return;
+    if (p->m_string != (char*)(p + 1))
+        umock::stdlib_h.free(p->m_string);
+    p->m_length = (size_t)0;
+    p->m_string = (char*)(p + 1);
+    p->m_string[0] = 0;
+}
+
+int UpnpString_inline_set_StringN(UpnpString* p, size_t capacity,
+                                  const char* s, size_t n) {
+    if (!p || !s)
+        return 0;
+    char* inl = (char*)(p + 1);
+    size_t len = strnlen(s, n);
+    char* q = inl;
+    if (len >= capacity) {
+        q = (char*)umock::stdlib_h.malloc(len + 1);
+        if (!q)
+            return 0;
+    }
+    /* s may point into the current buffer of the string. */
+    memmove(q, s, len);
+    q[len] = 0;
+    if (p->m_string != inl)
+        umock::stdlib_h.free(p->m_string);
+    p->m_length = len;
+    p->m_string = q;
+
+    return 1;
+}
+
+int UpnpString_inline_set_String(UpnpString* p, size_t capacity,
+                                 const char* s) {
+    if (!s)
+        return 0;
+    return UpnpString_inline_set_StringN(p, capacity, s, strlen(s));
+}
+
 /*! @} UpnpString */
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-03
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 // Also Copyright by other contributor as noted below.
 /*!
  * \file
@@ -8,6 +8,8 @@
  */
 
 #include <UpnpSubscriptionRequest.hpp>
+#include <UpnpInlineStrings.hpp>
+#include <umock/stdlib.hpp>
 
 #include <stdlib.h> /* for calloc(), free() */
 #include <string.h> /* for strlen(), strdup() */
@@ -22,16 +24,22 @@ struct s_UpnpSubscriptionRequest {
     /// @}
 };
 
+namespace {
+/// Strings of the object that are stored behind it.
+using inline_strings = UpnpInlineStrings<s_UpnpSubscriptionRequest, 3>;
+} // anonymous namespace
+
 UpnpSubscriptionRequest* UpnpSubscriptionRequest_new() {
-    struct s_UpnpSubscriptionRequest* p = (s_UpnpSubscriptionRequest*)calloc(
-        1, sizeof(struct s_UpnpSubscriptionRequest));
+    struct s_UpnpSubscriptionRequest* p =
+        (s_UpnpSubscriptionRequest*)umock::stdlib_h.calloc(
+            1, inline_strings::object_size());
 
     if (!p)
         return 0;
 
-    p->m_ServiceId = UpnpString_new();
-    p->m_UDN = UpnpString_new();
-    p->m_SID = UpnpString_new();
+    p->m_ServiceId = inline_strings::string(p, 0);
+    p->m_UDN = inline_strings::string(p, 1);
+    p->m_SID = inline_strings::string(p, 2);
 
     return (UpnpSubscriptionRequest*)p;
 }
@@ -42,14 +50,14 @@ void UpnpSubscriptionRequest_delete(UpnpSubscriptionRequest* q) {
     if (!p)
         return;
 
-    UpnpString_delete(p->m_SID);
+    UpnpString_inline_destroy(p->m_SID);
     p->m_SID = 0;
-    UpnpString_delete(p->m_UDN);
+    UpnpString_inline_destroy(p->m_UDN);
     p->m_UDN = 0;
-    UpnpString_delete(p->m_ServiceId);
+    UpnpString_inline_destroy(p->m_ServiceId);
     p->m_ServiceId = 0;
 
-    free(p);
+    umock::stdlib_h.free(p);
 }
 
 int UpnpSubscriptionRequest_assign(UpnpSubscriptionRequest* p,
@@ -89,7 +97,7 @@ int UpnpSubscriptionRequest_set_ServiceId(UpnpSubscriptionRequest* p,
                                           const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_ServiceId, q);
+    return inline_strings::set_String(p->m_ServiceId, q);
 }
 
 size_t
@@ -104,12 +112,12 @@ UpnpSubscriptionRequest_get_ServiceId_cstr(const UpnpSubscriptionRequest* p) {
 
 int UpnpSubscriptionRequest_strcpy_ServiceId(UpnpSubscriptionRequest* p,
                                              const char* s) {
-    return UpnpString_set_String(p->m_ServiceId, s);
+    return inline_strings::set_String(p->m_ServiceId, s);
 }
 
 int UpnpSubscriptionRequest_strncpy_ServiceId(UpnpSubscriptionRequest* p,
                                               const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_ServiceId, s, n);
+    return inline_strings::set_StringN(p->m_ServiceId, s, n);
 }
 
 void UpnpSubscriptionRequest_clear_ServiceId(UpnpSubscriptionRequest* p) {
@@ -125,7 +133,7 @@ int UpnpSubscriptionRequest_set_UDN(UpnpSubscriptionRequest* p,
                                     const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_UDN, q);
+    return inline_strings::set_String(p->m_UDN, q);
 }
 
 size_t
@@ -140,12 +148,12 @@ UpnpSubscriptionRequest_get_UDN_cstr(const UpnpSubscriptionRequest* p) {
 
 int UpnpSubscriptionRequest_strcpy_UDN(UpnpSubscriptionRequest* p,
                                        const char* s) {
-    return UpnpString_set_String(p->m_UDN, s);
+    return inline_strings::set_String(p->m_UDN, s);
 }
 
 int UpnpSubscriptionRequest_strncpy_UDN(UpnpSubscriptionRequest* p,
                                         const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_UDN, s, n);
+    return inline_strings::set_StringN(p->m_UDN, s, n);
 }
 
 void UpnpSubscriptionRequest_clear_UDN(UpnpSubscriptionRequest* p) {
@@ -161,7 +169,7 @@ int UpnpSubscriptionRequest_set_SID(UpnpSubscriptionRequest* p,
                                     const UpnpString* s) {
     const char* q = UpnpString_get_String(s);
 
-    return UpnpString_set_String(p->m_SID, q);
+    return inline_strings::set_String(p->m_SID, q);
 }
 
 size_t
@@ -176,12 +184,12 @@ UpnpSubscriptionRequest_get_SID_cstr(const UpnpSubscriptionRequest* p) {
 
 int UpnpSubscriptionRequest_strcpy_SID(UpnpSubscriptionRequest* p,
                                        const char* s) {
-    return UpnpString_set_String(p->m_SID, s);
+    return inline_strings::set_String(p->m_SID, s);
 }
 
 int UpnpSubscriptionRequest_strncpy_SID(UpnpSubscriptionRequest* p,
                                         const char* s, size_t n) {
-    return UpnpString_set_StringN(p->m_SID, s, n);
+    return inline_strings::set_StringN(p->m_SID, s, n);
 }
 
 void UpnpSubscriptionRequest_clear_SID(UpnpSubscriptionRequest* p) {
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-08-01
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -73,7 +73,13 @@
 #include <cassert>
 #include <csignal>
 #include <cstdlib>
+#include <algorithm>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #ifdef _WIN32
 /* Do not include these files */
@@ -136,6 +142,9 @@ ThreadPool gRecvThreadPool;
 /*! \brief Mini server thread pool. */
 ThreadPool gMiniServerThreadPool;
 
+/*! \brief CPU the dedicated I/O threads are bound to, -1 for none. */
+int gIoThreadCpu{IO_THREAD_CPU};
+
 /*! \brief Flag to indicate the state of web server */
 WebServerState bWebServerState = WEB_SERVER_DISABLED;
 
@@ -179,6 +188,8 @@ char gIF_IPV6_ULA_GUA[INET6_ADDRSTRLEN] = {'\0'};
 /*! \brief IPv6 ULA or GUA prefix length. (extern'ed in upnp.h) */
 unsigned gIF_IPV6_ULA_GUA_PREFIX_LENGTH = 0;
 
+std::shared_mutex gIfAddrMutex;
+
 /*! \brief local IPv4 port for the mini-server */
 in_port_t LOCAL_PORT_V4;
 
@@ -188,6 +199,9 @@ in_port_t LOCAL_PORT_V6;
 /*! \brief IPv6 ULA or GUA port for the mini-server */
 in_port_t LOCAL_PORT_V6_ULA_GUA;
 
+/*! \brief local IPv4 TLS port for the mini-server, 0 without TLS */
+in_port_t LOCAL_PORT_TLS_V4;
+
 /*! \brief UPnP Device and control point handle table  */
 static Handle_Info* HandleTable[NUM_HANDLE];
 
@@ -368,17 +382,23 @@ static int UpnpInitThreadPools() {
     TPAttrSetJobsPerThread(&attr, JOBS_PER_THREAD);
     TPAttrSetIdleTime(&attr, THREAD_IDLE_TIME);
     TPAttrSetMaxJobsTotal(&attr, MAX_JOBS_TOTAL);
+    TPAttrSetMaxOverflowJobs(&attr, MAX_OVERFLOW_JOBS);
+    TPAttrSetAdmitTimeout(&attr, ADMIT_TIMEOUT);
+    TPAttrSetTargetQueueWait(&attr, TARGET_QUEUE_WAIT);
 
+    TPAttrSetAdmissionPolicy(&attr, SEND_ADMISSION_POLICY);
     if (ThreadPoolInit(&gSendThreadPool, &attr) != UPNP_E_SUCCESS) {
         ret = UPNP_E_INIT_FAILED;
         goto exit_function;
     }
 
+    TPAttrSetAdmissionPolicy(&attr, RECV_ADMISSION_POLICY);
     if (ThreadPoolInit(&gRecvThreadPool, &attr) != UPNP_E_SUCCESS) {
         ret = UPNP_E_INIT_FAILED;
         goto exit_function;
     }
 
+    TPAttrSetAdmissionPolicy(&attr, MSERV_ADMISSION_POLICY);
     if (ThreadPoolInit(&gMiniServerThreadPool, &attr) != UPNP_E_SUCCESS) {
         ret = UPNP_E_INIT_FAILED;
         goto exit_function;
@@ -444,6 +464,9 @@ static int UpnpInitPreamble() {
     }
     HandleUnlock();
 
+    /* The SERVER header is the same for all messages. */
+    http_InitSdkInfo();
+
     /* Initialize SDK global thread pools. */
     retVal = UpnpInitThreadPools();
     if (retVal != UPNP_E_SUCCESS) {
@@ -459,13 +482,23 @@ static int UpnpInitPreamble() {
 #endif
 
     /* Initialize the SDK timer thread. */
-    retVal = TimerThreadInit(&gTimerThread, &gSendThreadPool);
+    retVal = TimerThreadInit(&gTimerThread, &gSendThreadPool, gIoThreadCpu);
     if (retVal != UPNP_E_SUCCESS) {
         UpnpFinish();
 
         return retVal;
     }
 
+#if defined(COMPA_HAVE_WEBSERVER) || defined(UPNP_HAVE_TOOLS)
+    /* Host names in URLs are looked up without blocking the workers. */
+    retVal = resolver_start(gIoThreadCpu);
+    if (retVal != UPNP_E_SUCCESS) {
+        UpnpFinish();
+
+        return retVal;
+    }
+#endif
+
     return UPNP_E_SUCCESS;
 }
 
@@ -486,8 +519,9 @@ static int UpnpInitStartServers(
     LOCAL_PORT_V4 = DestPort;
     LOCAL_PORT_V6 = DestPort;
     LOCAL_PORT_V6_ULA_GUA = DestPort;
-    int retVal =
-        StartMiniServer(&LOCAL_PORT_V4, &LOCAL_PORT_V6, &LOCAL_PORT_V6_ULA_GUA);
+    LOCAL_PORT_TLS_V4 = 0;
+    int retVal = StartMiniServer(&LOCAL_PORT_V4, &LOCAL_PORT_V6,
+                                 &LOCAL_PORT_V6_ULA_GUA, &LOCAL_PORT_TLS_V4);
     if (retVal != UPNP_E_SUCCESS) {
         UpnpPrintf(UPNP_CRITICAL, API, __FILE__, __LINE__,
                    "Miniserver failed to start\n");
@@ -641,6 +675,12 @@ int UpnpFinish() {
     }
 #endif
     TimerThreadShutdown(&gTimerThread);
+#ifdef COMPA_HAVE_CTRLPT_SOAP
+    SoapActionLoopShutdown();
+#endif
+#if defined(COMPA_HAVE_WEBSERVER) || defined(UPNP_HAVE_TOOLS)
+    resolver_stop();
+#endif
 #ifdef COMPA_HAVE_MINISERVER
     StopMiniServer();
 #endif
@@ -656,7 +696,16 @@ int UpnpFinish() {
     ThreadPoolShutdown(&gSendThreadPool);
     PrintThreadPoolStats(&gRecvThreadPool, __FILE__, __LINE__,
                          "Recv Thread Pool");
+    // No more requests after the thread pools are down.
+    http_ClearConnPool();
+    http_ClearSdkInfo();
+    // The finished worker threads have given back their cached blocks.
+    SlabTrim();
+#ifdef COMPA_HAVE_DEVICE_SSDP
+    SsdpSearchLimitClear();
+#endif
 #ifdef COMPA_HAVE_CTRLPT_SSDP
+    SsdpCacheClear();
     ithread_mutex_destroy(&GlobalClientSubscribeMutex);
 #endif
     ithread_rwlock_destroy(&GlobalHndRWLock);
@@ -680,6 +729,13 @@ unsigned short UpnpGetServerPort() {
     return LOCAL_PORT_V4;
 }
 
+unsigned short UpnpGetServerSslPort() {
+    if (UpnpSdkInit != 1)
+        return 0u;
+
+    return LOCAL_PORT_TLS_V4;
+}
+
 unsigned short UpnpGetServerPort6() {
 #ifdef UPNP_ENABLE_IPV6
     if (UpnpSdkInit != 1)
@@ -1443,6 +1499,7 @@ static void get_server_addr(
     memset(serverAddr, 0, sizeof(struct sockaddr_storage));
 
     sa4->sin_family = AF_INET;
+    std::shared_lock if_lock(gIfAddrMutex);
     inet_pton(AF_INET, gIF_IPV4, &sa4->sin_addr);
     sa4->sin_port = htons(LOCAL_PORT_V4);
 }
@@ -1458,6 +1515,7 @@ static void get_server_addr6(
     memset(serverAddr, 0, sizeof(struct sockaddr_storage));
 
     sa6->sin6_family = AF_INET6;
+    std::shared_lock if_lock(gIfAddrMutex);
     inet_pton(AF_INET6, gIF_IPV6, &sa6->sin6_addr);
     sa6->sin6_port = htons(LOCAL_PORT_V6);
 }
@@ -1684,6 +1742,7 @@ int UpnpSendAdvertisementLowPower(UpnpDevice_Handle Hnd, int Exp,
     }
 #ifdef SSDP_PACKET_DISTRIBUTE
     TPJobInit(&job, (start_routine)AutoAdvertise, adEvent);
+    TPJobSetLabel(&job, JOB_LABEL_SSDP);
     TPJobSetFreeFunction(&job, (free_routine)free_advertise_arg);
     TPJobSetPriority(&job, MED_PRIORITY);
     if ((retVal = TimerThreadSchedule(
@@ -1696,6 +1755,7 @@ int UpnpSendAdvertisementLowPower(UpnpDevice_Handle Hnd, int Exp,
     }
 #else
     TPJobInit(&job, (start_routine)AutoAdvertise, adEvent);
+    TPJobSetLabel(&job, JOB_LABEL_SSDP);
     TPJobSetFreeFunction(&job, (free_routine)free_advertise_arg);
     TPJobSetPriority(&job, MED_PRIORITY);
     if ((retVal = TimerThreadSchedule(
@@ -1755,6 +1815,23 @@ int UpnpSearchAsync(UpnpClient_Handle Hnd, int Mx, const char* Target_const,
 }
 #endif /* COMPA_HAVE_CTRLPT_SSDP */
 
+int UpnpSetSsdpInterfaces([[maybe_unused]] const char* const* IfNames,
+                          [[maybe_unused]] int NumIfs) {
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+    return SsdpSetInterfaces(IfNames, NumIfs);
+#else
+    return UPNP_E_NOT_EXIST;
+#endif
+}
+
+int UpnpSetSsdpFilter([[maybe_unused]] int Enable) {
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+    return SsdpSetFilter(Enable != 0);
+#else
+    return UPNP_E_NOT_EXIST;
+#endif
+}
+
 /*******************************************************************************
  *
  *                                  GENA interface
@@ -1884,6 +1961,7 @@ int UpnpSubscribeAsync(UpnpClient_Handle Hnd, const char* EvtUrl_const,
     Param->Cookie = (char*)Cookie_const;
 
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_GENA);
     TPJobSetFreeFunction(&job, (free_routine)free);
     TPJobSetPriority(&job, MED_PRIORITY);
     if (ThreadPoolAdd(&gSendThreadPool, &job, NULL) != 0) {
@@ -2060,6 +2138,7 @@ int UpnpUnSubscribeAsync(UpnpClient_Handle Hnd, Upnp_SID SubsId,
     Param->Fun = Fun;
     Param->Cookie = (char*)Cookie_const;
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_GENA);
     TPJobSetFreeFunction(&job, (free_routine)free);
     TPJobSetPriority(&job, MED_PRIORITY);
     if (ThreadPoolAdd(&gSendThreadPool, &job, NULL) != 0) {
@@ -2179,6 +2258,7 @@ int UpnpRenewSubscriptionAsync(UpnpClient_Handle Hnd, int TimeOut,
     Param->TimeOut = TimeOut;
 
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_GENA);
     TPJobSetFreeFunction(&job, (free_routine)free);
     TPJobSetPriority(&job, MED_PRIORITY);
     if (ThreadPoolAdd(&gSendThreadPool, &job, NULL) != 0) {
@@ -2600,6 +2680,7 @@ int UpnpSendActionAsync(UpnpClient_Handle Hnd, const char* ActionURL_const,
     Param->Fun = Fun;
 
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_SOAP);
     TPJobSetFreeFunction(&job, (free_routine)free_action_arg);
 
     TPJobSetPriority(&job, MED_PRIORITY);
@@ -2711,6 +2792,7 @@ int UpnpSendActionExAsync(UpnpClient_Handle Hnd, const char* ActionURL_const,
     Param->Fun = Fun;
 
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_SOAP);
     TPJobSetFreeFunction(&job, (free_routine)free_action_arg);
 
     TPJobSetPriority(&job, MED_PRIORITY);
@@ -2724,6 +2806,154 @@ int UpnpSendActionExAsync(UpnpClient_Handle Hnd, const char* ActionURL_const,
     return UPNP_E_SUCCESS;
 }
 
+int UpnpSendActionNonBlocking(UpnpClient_Handle Hnd, const char* ActionURL,
+                              const char* ServiceType, const char* DevUDN,
+                              IXML_Document* Act, Upnp_FunPtr Fun,
+                              const void* Cookie) {
+    struct Handle_Info* SInfo = NULL;
+
+    if (UpnpSdkInit != 1) {
+        return UPNP_E_FINISH;
+    }
+
+    UpnpPrintf(UPNP_ALL, API, __FILE__, __LINE__,
+               "Inside UpnpSendActionNonBlocking\n");
+
+    HandleReadLock();
+    switch (GetHandleInfo(Hnd, &SInfo)) {
+    case HND_CLIENT:
+        break;
+    default:
+        HandleUnlock();
+        return UPNP_E_INVALID_HANDLE;
+    }
+    HandleUnlock();
+
+    if (ActionURL == NULL || ServiceType == NULL || Act == NULL ||
+        Fun == NULL) {
+        return UPNP_E_INVALID_PARAM;
+    }
+    if (strncasecmp(ActionURL, "https:", strlen("https:")) == 0) {
+        /* The event loop does not handle TLS. */
+        return UpnpSendActionAsync(Hnd, ActionURL, ServiceType, DevUDN, Act,
+                                   Fun, Cookie);
+    }
+
+    return SoapSendActionNonBlocking(ActionURL, ServiceType, Act, Fun, Cookie);
+}
+
+int UpnpSetActionWindow(int MaxPerDevice, int MaxInFlight) {
+    return SoapSetActionWindow(MaxPerDevice, MaxInFlight);
+}
+
+int UpnpActionTemplate_new(const char* ActionURL, const char* ServiceType,
+                           const char* ActionName, const char* const* ArgNames,
+                           int NumArgs, UpnpActionTemplate** Template) {
+    if (ActionURL == NULL || ServiceType == NULL || ActionName == NULL ||
+        Template == NULL || NumArgs < 0 || (NumArgs > 0 && ArgNames == NULL)) {
+        return UPNP_E_INVALID_PARAM;
+    }
+    for (int i{0}; i < NumArgs; i++) {
+        if (ArgNames[i] == NULL)
+            return UPNP_E_INVALID_PARAM;
+    }
+
+    return SoapMakeActionTemplate(ActionURL, ServiceType, ActionName, ArgNames,
+                                  NumArgs, Template);
+}
+
+void UpnpActionTemplate_delete(UpnpActionTemplate* Template) {
+    SoapFreeActionTemplate(Template);
+}
+
+int UpnpSendActionTemplate(UpnpClient_Handle Hnd,
+                           const UpnpActionTemplate* Template,
+                           const char* const* ArgValues,
+                           IXML_Document** RespNode) {
+    struct Handle_Info* SInfo = NULL;
+
+    if (UpnpSdkInit != 1) {
+        return UPNP_E_FINISH;
+    }
+
+    HandleReadLock();
+    switch (GetHandleInfo(Hnd, &SInfo)) {
+    case HND_CLIENT:
+        break;
+    default:
+        HandleUnlock();
+        return UPNP_E_INVALID_HANDLE;
+    }
+    HandleUnlock();
+
+    if (Template == NULL || RespNode == NULL) {
+        return UPNP_E_INVALID_PARAM;
+    }
+
+    return SoapSendActionTemplate(Template, ArgValues, RespNode);
+}
+
+int UpnpSendActionTemplateValues(UpnpClient_Handle Hnd,
+                                 const UpnpActionTemplate* Template,
+                                 const char* const* ArgValues,
+                                 const char* const* RespNames, int NumResp,
+                                 char** RespValues) {
+    struct Handle_Info* SInfo = NULL;
+
+    if (UpnpSdkInit != 1) {
+        return UPNP_E_FINISH;
+    }
+
+    HandleReadLock();
+    switch (GetHandleInfo(Hnd, &SInfo)) {
+    case HND_CLIENT:
+        break;
+    default:
+        HandleUnlock();
+        return UPNP_E_INVALID_HANDLE;
+    }
+    HandleUnlock();
+
+    if (Template == NULL || NumResp < 0 ||
+        (NumResp > 0 && (RespNames == NULL || RespValues == NULL))) {
+        return UPNP_E_INVALID_PARAM;
+    }
+    for (int i{0}; i < NumResp; i++) {
+        if (RespNames[i] == NULL)
+            return UPNP_E_INVALID_PARAM;
+    }
+
+    return SoapSendActionTemplateValues(Template, ArgValues, RespNames, NumResp,
+                                        RespValues);
+}
+
+int UpnpSendActionTemplateNonBlocking(UpnpClient_Handle Hnd,
+                                      const UpnpActionTemplate* Template,
+                                      const char* const* ArgValues,
+                                      Upnp_FunPtr Fun, const void* Cookie) {
+    struct Handle_Info* SInfo = NULL;
+
+    if (UpnpSdkInit != 1) {
+        return UPNP_E_FINISH;
+    }
+
+    HandleReadLock();
+    switch (GetHandleInfo(Hnd, &SInfo)) {
+    case HND_CLIENT:
+        break;
+    default:
+        HandleUnlock();
+        return UPNP_E_INVALID_HANDLE;
+    }
+    HandleUnlock();
+
+    if (Template == NULL || Fun == NULL) {
+        return UPNP_E_INVALID_PARAM;
+    }
+
+    return SoapSendActionTemplateNonBlocking(Template, ArgValues, Fun, Cookie);
+}
+
 int UpnpGetServiceVarStatusAsync(UpnpClient_Handle Hnd,
                                  const char* ActionURL_const,
                                  const char* VarName_const, Upnp_FunPtr Fun,
@@ -2773,6 +3003,7 @@ int UpnpGetServiceVarStatusAsync(UpnpClient_Handle Hnd,
     Param->Cookie = (char*)Cookie_const;
 
     TPJobInit(&job, (start_routine)UpnpThreadDistribution, Param);
+    TPJobSetLabel(&job, JOB_LABEL_SOAP);
     TPJobSetFreeFunction(&job, (free_routine)free);
 
     TPJobSetPriority(&job, MED_PRIORITY);
@@ -3030,6 +3261,127 @@ int UpnpDownloadXmlDoc(const char* url, IXML_Document** xmlDoc) {
     }
 }
 
+namespace {
+/*! \brief Batch of description documents to download with
+ * UpnpDownloadXmlDocs().
+ *
+ * It is shared by all download jobs of the batch and destroyed with the last
+ * one. */
+struct XmlDocBatch {
+    /// Protects next.
+    std::mutex mutex;
+    /// Unique URLs of the batch.
+    std::vector<std::string> urls;
+    /// Index of the next URL to download.
+    size_t next{};
+    /// Callback of the application.
+    Upnp_XmlDocFunPtr fun{nullptr};
+    /// Cookie of the application.
+    void* cookie{nullptr};
+
+    ~XmlDocBatch() {
+        // Jobs may be dropped on shutdown of the thread pool. Every URL gets
+        // its callback anyway.
+        for (; this->next < this->urls.size(); this->next++)
+            this->fun(this->urls[this->next].c_str(), UPNP_E_FINISH, nullptr,
+                      this->cookie);
+    }
+};
+
+/// \brief Argument of a download job of UpnpDownloadXmlDocs().
+struct XmlDocJobArg {
+    /// The batch the job works on.
+    std::shared_ptr<XmlDocBatch> batch;
+};
+
+/// \brief Free the argument of a download job.
+void free_xml_doc_job_arg(void* arg) { delete static_cast<XmlDocJobArg*>(arg); }
+
+/*!
+ * \brief Download and parse documents of a batch until no one is left.
+ *
+ * Several of these jobs run in parallel so one of them parses while the others
+ * are receiving.
+ */
+void download_xml_docs(void* arg) {
+    XmlDocJobArg* job_arg = static_cast<XmlDocJobArg*>(arg);
+    XmlDocBatch& batch = *job_arg->batch;
+    for (;;) {
+        std::string url;
+        {
+            std::scoped_lock lock(batch.mutex);
+            if (batch.next >= batch.urls.size())
+                break;
+            url = batch.urls[batch.next++];
+        }
+        IXML_Document* xmlDoc{nullptr};
+        const int ret_code = UpnpDownloadXmlDoc(url.c_str(), &xmlDoc);
+        batch.fun(url.c_str(), ret_code,
+                  ret_code == UPNP_E_SUCCESS ? xmlDoc : nullptr, batch.cookie);
+    }
+    free_xml_doc_job_arg(job_arg);
+}
+} // anonymous namespace
+
+int UpnpDownloadXmlDocs(const char* const* urls, int count, int maxParallel,
+                        Upnp_XmlDocFunPtr Fun, const void* Cookie) {
+    if (UpnpSdkInit != 1)
+        return UPNP_E_FINISH;
+    if (urls == nullptr || count < 0 || maxParallel <= 0 || Fun == nullptr)
+        return UPNP_E_INVALID_PARAM;
+    for (int i{0}; i < count; i++) {
+        if (urls[i] == nullptr)
+            return UPNP_E_INVALID_PARAM;
+    }
+
+    std::shared_ptr<XmlDocBatch> batch;
+    try {
+        batch = std::make_shared<XmlDocBatch>();
+        std::unordered_set<std::string> seen;
+        batch->urls.reserve(static_cast<size_t>(count));
+        for (int i{0}; i < count; i++) {
+            // Devices announce the same description with each of their
+            // services. It is only downloaded once.
+            if (seen.emplace(urls[i]).second)
+                batch->urls.emplace_back(urls[i]);
+        }
+    } catch (const std::bad_alloc&) {
+        return UPNP_E_OUTOF_MEMORY;
+    }
+    batch->fun = Fun;
+    batch->cookie = const_cast<void*>(Cookie);
+
+    const size_t unique{batch->urls.size()};
+    const size_t jobs{std::min(unique, static_cast<size_t>(maxParallel))};
+    size_t started{0};
+    for (; started < jobs; started++) {
+        XmlDocJobArg* job_arg = new (std::nothrow) XmlDocJobArg{batch};
+        if (job_arg == nullptr)
+            break;
+        ThreadPoolJob job;
+        memset(&job, 0, sizeof(job));
+        TPJobInit(&job, (start_routine)download_xml_docs, job_arg);
+        TPJobSetLabel(&job, JOB_LABEL_HTTP);
+        TPJobSetFreeFunction(&job, (free_routine)free_xml_doc_job_arg);
+        TPJobSetPriority(&job, MED_PRIORITY);
+        if (ThreadPoolAdd(&gSendThreadPool, &job, NULL) != 0) {
+            free_xml_doc_job_arg(job_arg);
+            break;
+        }
+    }
+    if (started == 0 && jobs > 0) {
+        // There is no job that uses the batch. Nothing to call back.
+        batch->next = unique;
+        return UPNP_E_OUTOF_MEMORY;
+    }
+
+    UpnpPrintf(UPNP_ALL, API, __FILE__, __LINE__,
+               "Exiting UpnpDownloadXmlDocs, %zu unique of %d URLs\n", unique,
+               count);
+
+    return UPNP_E_SUCCESS;
+}
+
 /*!
  * \brief Computes prefix length from IPv6 netmask.
  *
@@ -3610,6 +3962,109 @@ void AutoAdvertise(void* input) {
     UpnpSendAdvertisement(arg->advertise.handle, *((int*)arg->advertise.Event));
     free_advertise_arg(arg);
 }
+
+/*!
+ * \brief Advertise a device again without touching its advertisement timer.
+ */
+static void readvertise_device(void* input) {
+    UpnpDevice_Handle Hnd =
+        static_cast<UpnpDevice_Handle>(reinterpret_cast<intptr_t>(input));
+    Handle_Info* SInfo;
+    int Exp;
+
+    HandleReadLock();
+    if (GetHandleInfo(Hnd, &SInfo) != HND_DEVICE) {
+        HandleUnlock();
+        return;
+    }
+    Exp = SInfo->MaxAge;
+    HandleUnlock();
+    AdvertiseAndReply(1, Hnd, (enum SsdpSearchType)0, (struct sockaddr*)NULL,
+                      (char*)NULL, (char*)NULL, (char*)NULL, Exp);
+}
+
+/*!
+ * \brief Replace the host of an URL if it is a given address.
+ *
+ * \returns true if the host has been replaced, false otherwise.
+ */
+static bool replace_url_host(
+    /*! [in,out] URL, e.g. "http://[2001:db8::1]:50001/desc.xml". */
+    char* a_url,
+    /*! [in] Size of the URL buffer. */
+    size_t a_size,
+    /*! [in] Address that is replaced, without brackets. */
+    const char* a_old,
+    /*! [in] New address, without brackets. */
+    const char* a_new) {
+    if (a_old[0] == '\0' || a_new[0] == '\0' || std::strcmp(a_old, a_new) == 0)
+        return false;
+    const std::string url{a_url};
+    const size_t scheme_end{url.find("://")};
+    if (scheme_end == std::string::npos)
+        return false;
+    size_t host_begin{scheme_end + 3};
+    size_t host_end;
+    if (url[host_begin] == '[') {
+        host_begin++;
+        host_end = url.find(']', host_begin);
+    } else {
+        host_end = url.find_first_of(":/", host_begin);
+    }
+    if (host_end == std::string::npos)
+        host_end = url.size();
+    if (url.compare(host_begin, host_end - host_begin, a_old) != 0)
+        return false;
+
+    const std::string new_url{url.substr(0, host_begin) + a_new +
+                              url.substr(host_end)};
+    if (new_url.size() >= a_size)
+        return false;
+    std::memcpy(a_url, new_url.c_str(), new_url.size() + 1);
+    return true;
+}
+
+void UpdateDescURLs(const char* a_old_ipv4, const char* a_old_ipv6,
+                    const char* a_old_ipv6_ula_gua) {
+    TRACE("Executing UpdateDescURLs()")
+    std::shared_lock if_lock(gIfAddrMutex);
+    HandleLock();
+    for (int Hnd{1}; Hnd < NUM_HANDLE; Hnd++) {
+        Handle_Info* HInfo{HandleTable[Hnd]};
+        if (HInfo == nullptr || HInfo->HType != HND_DEVICE)
+            continue;
+        for (char* url : {HInfo->DescURL, HInfo->LowerDescURL}) {
+            if (replace_url_host(url, LINE_SIZE, a_old_ipv4, gIF_IPV4) ||
+                replace_url_host(url, LINE_SIZE, a_old_ipv6, gIF_IPV6) ||
+                replace_url_host(url, LINE_SIZE, a_old_ipv6_ula_gua,
+                                 gIF_IPV6_ULA_GUA))
+                UPNPLIB_LOGINFO "MSG1137: Device handle "
+                    << Hnd << " is now described by \"" << url << "\".\n";
+        }
+    }
+    HandleUnlock();
+}
+
+void ReadvertiseDevices() {
+    Handle_Info* SInfo;
+    ThreadPoolJob job;
+
+    for (UpnpDevice_Handle Hnd = 1; Hnd < NUM_HANDLE; Hnd++) {
+        HandleReadLock();
+        Upnp_Handle_Type type = GetHandleInfo(Hnd, &SInfo);
+        HandleUnlock();
+        if (type != HND_DEVICE)
+            continue;
+        memset(&job, 0, sizeof(job));
+        TPJobInit(&job, (start_routine)readvertise_device,
+                  reinterpret_cast<void*>(static_cast<intptr_t>(Hnd)));
+        TPJobSetLabel(&job, JOB_LABEL_SSDP);
+        TPJobSetPriority(&job, MED_PRIORITY);
+        // A readvertisement of the device that is still queued does it.
+        TPJobSetMergeKey(&job, job.arg);
+        ThreadPoolAdd(&gSendThreadPool, &job, NULL);
+    }
+}
 #endif
 
 #ifdef COMPA_HAVE_WEBSERVER
@@ -3627,12 +4082,32 @@ int UpnpSetWebServerRootDir(const char* rootDir) {
 }
 #endif /* COMPA_HAVE_WEBSERVER */
 
+namespace {
+/*!
+ * \brief Publish pVirtualDirList to the web server, if there is one.
+ *
+ * Must be called with gWebMutex held since before the list was changed.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_MEMORY, the list should be restored then.
+ */
+int publish_virtual_dirs() {
+#ifdef COMPA_HAVE_WEBSERVER
+    return web_server_update_virtual_dirs();
+#else
+    return UPNP_E_SUCCESS;
+#endif
+}
+} // anonymous namespace
+
 int UpnpAddVirtualDir(const char* newDirName, const void* cookie,
                       const void** oldcookie) {
     virtualDirList* pNewVirtualDir;
-    virtualDirList* pLast;
+    virtualDirList* pLast{nullptr};
     virtualDirList* pCurVirtualDir;
     char dirName[NAME_SIZE];
+    int ret;
 
     memset(dirName, 0, sizeof(dirName));
     if (UpnpSdkInit != 1) {
@@ -3655,16 +4130,26 @@ int UpnpAddVirtualDir(const char* newDirName, const void* cookie,
         strncpy(dirName, newDirName, sizeof(dirName) - 1);
     }
 
+#ifdef COMPA_HAVE_WEBSERVER
+    std::scoped_lock lock(gWebMutex);
+#endif
     pCurVirtualDir = pVirtualDirList;
     while (pCurVirtualDir != NULL) {
         /* already has this entry */
         if (strcmp(pCurVirtualDir->dirName, dirName) == 0) {
-            if (oldcookie != NULL)
-                *oldcookie = pCurVirtualDir->cookie;
+            const void* prevcookie = pCurVirtualDir->cookie;
             pCurVirtualDir->cookie = cookie;
+            ret = publish_virtual_dirs();
+            if (ret != UPNP_E_SUCCESS) {
+                pCurVirtualDir->cookie = prevcookie;
+                return ret;
+            }
+            if (oldcookie != NULL)
+                *oldcookie = prevcookie;
             return UPNP_E_SUCCESS;
         }
 
+        pLast = pCurVirtualDir;
         pCurVirtualDir = pCurVirtualDir->next;
     }
 
@@ -3673,8 +4158,6 @@ int UpnpAddVirtualDir(const char* newDirName, const void* cookie,
         return UPNP_E_OUTOF_MEMORY;
     }
     pNewVirtualDir->next = NULL;
-    if (oldcookie != NULL)
-        *oldcookie = NULL;
     pNewVirtualDir->cookie = cookie;
     memset(pNewVirtualDir->dirName, 0, sizeof(pNewVirtualDir->dirName));
 #ifdef UPNPLIB_PUPNP_BUG
@@ -3689,23 +4172,31 @@ int UpnpAddVirtualDir(const char* newDirName, const void* cookie,
 #endif
     *(pNewVirtualDir->dirName + strlen(dirName)) = 0;
 
-    if (pVirtualDirList == NULL) { /* first virtual dir */
+    if (pLast == NULL) { /* first virtual dir */
         pVirtualDirList = pNewVirtualDir;
     } else {
-        pLast = pVirtualDirList;
-        while (pLast->next != NULL) {
-            pLast = pLast->next;
-        }
         pLast->next = pNewVirtualDir;
     }
 
+    ret = publish_virtual_dirs();
+    if (ret != UPNP_E_SUCCESS) {
+        if (pLast == NULL)
+            pVirtualDirList = NULL;
+        else
+            pLast->next = NULL;
+        free(pNewVirtualDir);
+        return ret;
+    }
+    if (oldcookie != NULL)
+        *oldcookie = NULL;
+
     return UPNP_E_SUCCESS;
 }
 
 int UpnpRemoveVirtualDir(const char* dirName) {
     virtualDirList* pPrev;
     virtualDirList* pCur;
-    int found = 0;
+    int ret;
 
     if (UpnpSdkInit != 1) {
         return UPNP_E_FINISH;
@@ -3715,37 +4206,35 @@ int UpnpRemoveVirtualDir(const char* dirName) {
         return UPNP_E_INVALID_PARAM;
     }
 
-    if (pVirtualDirList == NULL) {
-        return UPNP_E_INVALID_PARAM;
-    }
-    /* Handle the special case where the directory that we are */
-    /* removing is the first in the list. */
-    if (strcmp(pVirtualDirList->dirName, dirName) == 0) {
-        pPrev = pVirtualDirList;
-        pVirtualDirList = pVirtualDirList->next;
-        free(pPrev);
-        return UPNP_E_SUCCESS;
+#ifdef COMPA_HAVE_WEBSERVER
+    std::scoped_lock lock(gWebMutex);
+#endif
+    pPrev = NULL;
+    pCur = pVirtualDirList;
+    while (pCur != NULL && strcmp(pCur->dirName, dirName) != 0) {
+        pPrev = pCur;
+        pCur = pCur->next;
     }
+    if (pCur == NULL)
+        return UPNP_E_INVALID_PARAM;
 
-    pCur = pVirtualDirList->next;
-    pPrev = pVirtualDirList;
-
-    while (pCur != NULL) {
-        if (strcmp(pCur->dirName, dirName) == 0) {
-            pPrev->next = pCur->next;
-            free(pCur);
-            found = 1;
-            break;
-        } else {
-            pPrev = pCur;
-            pCur = pCur->next;
-        }
+    /* Unlink the directory but free it only when the web server does not
+     * serve it anymore. */
+    if (pPrev == NULL)
+        pVirtualDirList = pCur->next;
+    else
+        pPrev->next = pCur->next;
+    ret = publish_virtual_dirs();
+    if (ret != UPNP_E_SUCCESS) {
+        if (pPrev == NULL)
+            pVirtualDirList = pCur;
+        else
+            pPrev->next = pCur;
+        return ret;
     }
+    free(pCur);
 
-    if (found == 1)
-        return UPNP_E_SUCCESS;
-    else
-        return UPNP_E_INVALID_PARAM;
+    return UPNP_E_SUCCESS;
 }
 
 void UpnpRemoveAllVirtualDirs() {
@@ -3756,7 +4245,13 @@ void UpnpRemoveAllVirtualDirs() {
         return;
     }
 
+#ifdef COMPA_HAVE_WEBSERVER
+    std::scoped_lock lock(gWebMutex);
+#endif
     pCur = pVirtualDirList;
+    pVirtualDirList = NULL;
+    /* Publishing no directories does not allocate, so it cannot fail. */
+    publish_virtual_dirs();
 
     while (pCur != NULL) {
         pNext = pCur->next;
@@ -3764,8 +4259,6 @@ void UpnpRemoveAllVirtualDirs() {
 
         pCur = pNext;
     }
-
-    pVirtualDirList = NULL;
 }
 
 int UpnpEnableWebserver([[maybe_unused]] int enable) {
@@ -3925,3 +4418,81 @@ int UpnpSetMaxContentLength(size_t contentLength) {
 
     return errCode;
 }
+
+int UpnpSetIoThreadCpu(int Cpu) {
+    if (Cpu < -1)
+        return UPNP_E_INVALID_PARAM;
+    if (UpnpSdkInit == 1)
+        return UPNP_E_INIT;
+    gIoThreadCpu = Cpu;
+
+    return UPNP_E_SUCCESS;
+}
+
+namespace {
+/*! \brief Appends percentiles, sum and count of a thread pool histogram in
+ * the Prometheus text format.
+ *
+ * Nothing is appended for an empty histogram. */
+void append_histogram(std::string& out, const char* metric, const char* pool,
+                      const char* key, const char* value,
+                      const ThreadPoolHistogram& hist) {
+    if (hist.count == 0)
+        return;
+    char line[256];
+    for (const char* quantile : {"0.5", "0.9", "0.99"}) {
+        snprintf(line, sizeof(line),
+                 "%s{pool=\"%s\",%s=\"%s\",quantile=\"%s\"} %.0f\n", metric,
+                 pool, key, value, quantile,
+                 ThreadPoolHistogramPercentile(&hist, atof(quantile)));
+        out += line;
+    }
+    snprintf(line, sizeof(line), "%s_sum{pool=\"%s\",%s=\"%s\"} %.0f\n",
+             metric, pool, key, value, hist.sum);
+    out += line;
+    snprintf(line, sizeof(line), "%s_count{pool=\"%s\",%s=\"%s\"} %lu\n",
+             metric, pool, key, value, hist.count);
+    out += line;
+}
+} // anonymous namespace
+
+int UpnpGetThreadPoolStats(char* Buf, size_t BufLen) {
+    if (UpnpSdkInit != 1)
+        return UPNP_E_FINISH;
+    if (Buf == nullptr || BufLen == 0)
+        return UPNP_E_INVALID_PARAM;
+
+    const struct {
+        const char* name;
+        ThreadPool* tp;
+    } pools[]{{"send", &gSendThreadPool},
+              {"recv", &gRecvThreadPool},
+              {"miniserver", &gMiniServerThreadPool}};
+    const char* priorities[]{"low", "med", "high"};
+    const char* labels[]{"other", "ssdp", "soap", "gena", "http"};
+    static_assert(sizeof(labels) / sizeof(labels[0]) == JOB_LABEL_COUNT);
+
+    std::string out;
+    ThreadPoolHistograms hists;
+    for (const auto& pool : pools) {
+        if (ThreadPoolGetHistograms(pool.tp, &hists) != 0)
+            continue;
+        for (int i{0}; i <= HIGH_PRIORITY; i++) {
+            append_histogram(out, "upnp_threadpool_wait_us", pool.name,
+                             "priority", priorities[i], hists.waitPriority[i]);
+            append_histogram(out, "upnp_threadpool_run_us", pool.name,
+                             "priority", priorities[i], hists.runPriority[i]);
+        }
+        for (int i{0}; i < JOB_LABEL_COUNT; i++) {
+            append_histogram(out, "upnp_threadpool_wait_us", pool.name, "job",
+                             labels[i], hists.waitLabel[i]);
+            append_histogram(out, "upnp_threadpool_run_us", pool.name, "job",
+                             labels[i], hists.runLabel[i]);
+        }
+    }
+    if (out.size() >= BufLen)
+        return UPNP_E_BUFFER_TOO_SMALL;
+    memcpy(Buf, out.c_str(), out.size() + 1);
+
+    return UPNP_E_SUCCESS;
+}
@@ -97,6 +97,7 @@ struct ErrorString ErrorMessages[] = {
     {UPNP_E_SOCKET_ERROR, "UPNP_E_SOCKET_ERROR"},
     {UPNP_E_FILE_WRITE_ERROR, "UPNP_E_FILE_WRITE_ERROR"},
     {UPNP_E_CANCELED, "UPNP_E_CANCELED"},
+    {UPNP_E_TRY_AGAIN, "UPNP_E_TRY_AGAIN"},
     {UPNP_E_EVENT_PROTOCOL, "UPNP_E_EVENT_PROTOCOL"},
     {UPNP_E_SUBSCRIBE_UNACCEPTED, "UPNP_E_SUBSCRIBE_UNACCEPTED"},
     {UPNP_E_UNSUBSCRIBE_UNACCEPTED, "UPNP_E_UNSUBSCRIBE_UNACCEPTED"},
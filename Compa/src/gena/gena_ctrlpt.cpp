@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -44,6 +44,14 @@
 #include <upnpapi.hpp>
 #include <uuid.hpp>
 
+/// \cond
+#include <deque>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+/// \endcond
+
 /// \brief Provide global Client subscribe mutex.
 extern ithread_mutex_t GlobalClientSubscribeMutex;
 
@@ -51,6 +59,8 @@ struct job_arg {
     int handle;
     int eventId;
     void* Event;
+    /// Absolute time in seconds the renewal is scheduled for.
+    time_t renewAt;
 };
 
 namespace {
@@ -67,14 +77,76 @@ void free_subscribe_arg(job_arg* arg) {
     }
 }
 
+/*! \name Batched renewals
+ * Renewals of subscriptions to one host that are due in the same
+ * AUTO_RENEW_BATCH_WINDOW are scheduled for the same time. Each of them has
+ * its own timer event so it can be cancelled alone. The first job of a host
+ * that runs sends the renewals of the host one after the other, so they reuse
+ * one pooled connection of http_RequestAndResponse(). The other jobs only
+ * hand over their renewal and return.
+ * @{
+ */
+/// \brief Renewals waiting for the job that sends them, per host.
+struct renew_queues_t {
+    /// Mutex to protect the queues.
+    std::mutex mutex;
+    /// A host is only in the map while a job sends its renewals.
+    std::unordered_map<std::string, std::deque<job_arg*>> hosts;
+} gRenewQueues;
+
 /*!
- * \brief This is a thread function to send the renewal just before the
- * subscription times out.
+ * \brief Get the host part of a publisher URL, e.g. "192.168.1.2:49152" from
+ * "http://192.168.1.2:49152/event".
  */
-void GenaAutoRenewSubscription(
-    /*! [in] Thread data(job_arg *) needed to send the renewal. */
-    void* input) {
-    job_arg* arg = (job_arg*)input;
+std::string renew_host(const char* a_url) {
+    std::string host{a_url != nullptr ? a_url : ""};
+    const size_t start{host.find("://")};
+    if (start != std::string::npos)
+        host.erase(0, start + 3);
+    return host.substr(0, host.find('/'));
+}
+
+/*!
+ * \brief Get the absolute time for the automatic renewal of a subscription.
+ *
+ * The time is made earlier by a jitter that is the same for all subscriptions
+ * of a host, and aligned to AUTO_RENEW_BATCH_WINDOW. So renewals to one host
+ * are due at the same time and the hosts are spread.
+ */
+time_t renew_time(
+    /*! [in] Publisher URL of the subscription. */
+    const char* a_url,
+    /*! [in] The time out value of the subscription. */
+    int a_timeout,
+    /*! [in] Current time in seconds. */
+    time_t now) {
+    // Different for each process so that control points started together
+    // do not renew at the same time.
+    static const size_t seed{std::random_device{}()};
+    // The device sets the time out, it may be shorter than AUTO_RENEW_TIME.
+    const time_t delay{std::max<time_t>(a_timeout - AUTO_RENEW_TIME, 0)};
+    if constexpr (AUTO_RENEW_TIME == 0) {
+        // Only the expiration is reported. That must not be made earlier.
+        return now + delay;
+    }
+    const time_t jitter_range{std::max<time_t>(
+        std::min<time_t>(AUTO_RENEW_JITTER, delay / 4) + 1, 1)};
+    const time_t jitter{static_cast<time_t>(
+        (std::hash<std::string>{}(renew_host(a_url)) ^ seed) %
+        static_cast<size_t>(jitter_range))};
+    time_t renew_at{now + delay - jitter};
+    renew_at -= renew_at % AUTO_RENEW_BATCH_WINDOW;
+    return std::max(renew_at, now + 1);
+}
+/// @}
+
+/*!
+ * \brief Send the renewal of one subscription and inform the control point
+ * on failure.
+ */
+void renew_subscription(
+    /*! [in] Data of the renewal, freed by this function. */
+    job_arg* arg) {
     UpnpEventSubscribe* sub_struct = (UpnpEventSubscribe*)arg->Event;
     void* cookie;
     Upnp_FunPtr callback_fun;
@@ -125,6 +197,42 @@ end_function:
     return;
 }
 
+/*!
+ * \brief This is a thread function to send the renewal just before the
+ * subscription times out.
+ *
+ * If another job already sends renewals to the same host the renewal is
+ * queued for it. Otherwise this job sends it and all renewals that are
+ * queued meanwhile.
+ */
+void GenaAutoRenewSubscription(
+    /*! [in] Thread data(job_arg *) needed to send the renewal. */
+    void* input) {
+    job_arg* arg = (job_arg*)input;
+    const std::string host{renew_host(UpnpEventSubscribe_get_PublisherUrl_cstr(
+        (UpnpEventSubscribe*)arg->Event))};
+    {
+        std::scoped_lock lock(gRenewQueues.mutex);
+        auto [it, sender] = gRenewQueues.hosts.try_emplace(host);
+        if (!sender) {
+            it->second.push_back(arg);
+            return;
+        }
+    }
+    while (arg != nullptr) {
+        renew_subscription(arg);
+        std::scoped_lock lock(gRenewQueues.mutex);
+        auto it = gRenewQueues.hosts.find(host);
+        if (it->second.empty()) {
+            gRenewQueues.hosts.erase(it);
+            arg = nullptr;
+        } else {
+            arg = it->second.front();
+            it->second.pop_front();
+        }
+    }
+}
+
 /*!
  * \brief Schedules a job to renew the subscription just before time out.
  *
@@ -174,15 +282,17 @@ int ScheduleGenaAutoRenew(
 
     arg->handle = client_handle;
     arg->Event = RenewEvent;
+    arg->renewAt = renew_time(GenlibClientSubscription_get_EventURL_cstr(sub),
+                              TimeOut, time(nullptr));
 
     TPJobInit(&job, (start_routine)GenaAutoRenewSubscription, arg);
+    TPJobSetLabel(&job, JOB_LABEL_GENA);
     TPJobSetFreeFunction(&job, (free_routine)free_subscribe_arg);
     TPJobSetPriority(&job, MED_PRIORITY);
 
     /* Schedule the job */
-    return_code =
-        TimerThreadSchedule(&gTimerThread, TimeOut - AUTO_RENEW_TIME, REL_SEC,
-                            &job, SHORT_TERM, &(arg->eventId));
+    return_code = TimerThreadSchedule(&gTimerThread, arg->renewAt, ABS_SEC,
+                                      &job, SHORT_TERM, &(arg->eventId));
     if (return_code != UPNP_E_SUCCESS) {
         free_subscribe_arg(arg);
         goto end_function;
@@ -321,6 +431,7 @@ int gena_subscribe(
                              "TIMEOUT: Second-", timeout_str);
     } else {
         /* subscribe */
+        std::shared_lock if_lock(gIfAddrMutex);
         if (dest_url.hostport.IPaddress.ss_family == AF_INET6) {
             struct sockaddr_in6* DestAddr6 =
                 (struct sockaddr_in6*)&dest_url.hostport.IPaddress;
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -501,8 +501,11 @@ int genaInitNotifyCommon(UpnpDevice_Handle device_handle, char* UDN,
         thread_struct->device_handle = device_handle;
 
         TPJobInit(job, (start_routine)genaNotifyThread, thread_struct);
+        TPJobSetLabel(job, JOB_LABEL_GENA);
         TPJobSetFreeFunction(job, (free_routine)free_notify_struct);
         TPJobSetPriority(job, MED_PRIORITY);
+        // Events go before low priority housekeeping if the queues are full.
+        TPJobSetAdmissionPolicy(job, ADMIT_SHED_LOW);
 
         ret = ThreadPoolAdd(&gSendThreadPool, job, NULL);
         if (ret != 0) {
@@ -670,8 +673,10 @@ int genaNotifyAllCommon(UpnpDevice_Handle device_handle, char* UDN,
                 }
                 memset(job, 0, sizeof(ThreadPoolJob));
                 TPJobInit(job, (start_routine)genaNotifyThread, thread_s);
+                TPJobSetLabel(job, JOB_LABEL_GENA);
                 TPJobSetFreeFunction(job, (free_routine)free_notify_struct);
                 TPJobSetPriority(job, MED_PRIORITY);
+                TPJobSetAdmissionPolicy(job, ADMIT_SHED_LOW);
                 node = ListAddTail(&finger->outgoing, job);
 
                 /* If there is only one element on the list
@@ -793,7 +798,8 @@ int respond_ok(
  * name).
  *
  * \return The number of URLs parsed if successful, otherwise
- * UPNP_E_OUTOF_MEMORY.
+ * UPNP_E_OUTOF_MEMORY, or UPNP_E_TRY_AGAIN if no URL is parsed because a host
+ * name is still looked up.
  */
 int create_url_list(
     /*! [in] . */
@@ -806,6 +812,7 @@ int create_url_list(
     uri_type temp;
     token urls;
     token* URLS;
+    bool pending{false};
 
     urls.buff = url_list->buf;
     urls.size = url_list->length;
@@ -826,9 +833,13 @@ int create_url_list(
                 if (return_code == UPNP_E_OUTOF_MEMORY) {
                     return return_code;
                 }
+                if (return_code == UPNP_E_TRY_AGAIN)
+                    pending = true;
             }
         }
     }
+    if (URLcount == 0 && pending)
+        return UPNP_E_TRY_AGAIN;
 
     if (URLcount > 0) {
         out->URLs = (char*)malloc(URLS->size + 1);
@@ -1074,6 +1085,7 @@ int gena_validate_delivery_urls(
         return 0;
     }
 
+    std::shared_lock if_lock(gIfAddrMutex);
     switch (info->foreign_sockaddr.ss_family) {
     case AF_INET:
         if (!inet_pton(AF_INET, gIF_IPV4, &genaAddr4)) {
@@ -1256,6 +1268,13 @@ void gena_process_subscription_request(SOCKINFO* info,
         HandleUnlock();
         goto exit_function;
     }
+    if (return_code == UPNP_E_TRY_AGAIN) {
+        // The subscriber may try again when the callback host is known.
+        error_respond(info, HTTP_SERVICE_UNAVAILABLE, request);
+        freeSubscriptionList(sub);
+        HandleUnlock();
+        goto exit_function;
+    }
     if (return_code == UPNP_E_OUTOF_MEMORY) {
         error_respond(info, HTTP_INTERNAL_SERVER_ERROR, request);
         freeSubscriptionList(sub);
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (C) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-30
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  * Cloned from pupnp ver 1.14.15.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -64,8 +64,14 @@
 
 
 /// \cond
+#include <atomic>
 #include <cstring>
 #include <random>
+#include <vector>
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#endif
 /// \endcond
 
 namespace {
@@ -86,8 +92,34 @@ struct mserv_request_t {
     SOCKET connfd;
     /// \brief Socket address of the remote control point.
     sockaddr_storage foreign_sockaddr;
+#ifdef UPNP_ENABLE_OPEN_SSL
+    /// \brief TLS connection, only set for a TLS listener.
+    SSL* ssl;
+#endif
+};
+
+#if defined(COMPA_HAVE_WEBSERVER) && defined(UPNP_ENABLE_OPEN_SSL)
+/*! \brief Maximal number of TLS handshakes in progress.
+ * \details Further connections are refused until handshakes are finished. */
+constexpr size_t MAX_TLS_HANDSHAKES{128};
+
+/*! \brief Accepted connection with a TLS handshake in progress.
+ * \details The handshake is driven by the miniserver thread without blocking
+ * so slow remote nodes do not occupy a worker thread. */
+struct tls_handshake_t {
+    /// \brief Socket Information Object with the SSL connection.
+    SOCKINFO info;
+    /// \brief Result of the last handshake step.
+    int state;
+    /// \brief Time when the handshake is aborted.
+    time_t deadline;
 };
 
+/*! \brief TLS handshakes in progress.
+ * \details Only used by the miniserver thread. */
+std::vector<tls_handshake_t> gTlsHandshakes;
+#endif
+
 /// \brief miniserver state
 enum MiniServerState {
     MSERV_IDLE,    ///< miniserver is idle.
@@ -104,6 +136,16 @@ in_port_t miniStopSockPort;
 
 /// \brief miniserver state
 MiniServerState gMServState{MSERV_IDLE};
+
+/*! \brief Set while the job queues of the miniserver thread pool are full.
+ * \details The miniserver then leaves new connections in the listen backlog
+ * instead of accepting them and dropping the request job. */
+std::atomic<bool> gMServSaturated{false};
+
+/*! \brief Thread that runs the miniserver loop.
+ * \details It is not taken from a thread pool so the loop never competes with
+ * request jobs for a worker. */
+DedicatedThread gMServThread{};
 #ifdef COMPA_HAVE_WEBSERVER
 /// \brief SOAP callback
 MiniServerCallback gSoapCallback{nullptr};
@@ -283,7 +325,7 @@ void free_handle_request_arg(
         return;
 
     sock_close(static_cast<mserv_request_t*>(args)->connfd);
-    free(args);
+    SlabFree(args);
 }
 
 /*!
@@ -310,10 +352,18 @@ void handle_request(
     ret_code = sock_init_with_ip(&info, connfd,
                                  (sockaddr*)&request_in->foreign_sockaddr);
     if (ret_code != UPNP_E_SUCCESS) {
-        free(request_in);
+#ifdef UPNP_ENABLE_OPEN_SSL
+        // Not yet owned by info.
+        SSL_free(request_in->ssl);
+#endif
+        SlabFree(request_in);
         httpmsg_destroy(hmsg);
         return;
     }
+#ifdef UPNP_ENABLE_OPEN_SSL
+    // The connection is released by sock_destroy().
+    info.ssl = request_in->ssl;
+#endif
 
     /* read */
     ret_code = http_RecvMessage(&info, &parser, HTTPMETHOD_UNKNOWN, &timeout,
@@ -344,12 +394,28 @@ error_handler:
     }
     sock_destroy(&info, SD_BOTH);
     httpmsg_destroy(hmsg);
-    free(request_in);
+    SlabFree(request_in);
 
     UpnpPrintf(UPNP_INFO, MSERV, __FILE__, __LINE__,
                "miniserver %d: COMPLETE\n", connfd);
 }
 
+#ifdef UPNP_ENABLE_OPEN_SSL
+/*!
+ * \brief Free memory assigned for handling a request with a TLS connection.
+ */
+void free_handle_tls_request_arg(
+    /*! [in] Request Message to be freed. */
+    void* args) {
+    TRACE("Executing free_handle_tls_request_arg()")
+    if (args == nullptr)
+        return;
+
+    SSL_free(static_cast<mserv_request_t*>(args)->ssl);
+    free_handle_request_arg(args);
+}
+#endif
+
 /*!
  * \brief Initilize the thread pool to handle a request, sets priority for the
  * job and adds the job to the thread pool.
@@ -358,7 +424,14 @@ UPNP_INLINE void schedule_request_job(
     /*! [in] Socket Descriptor on which connection is accepted. */
     SOCKET connfd,
     /*! [in] Clients Address information. */
-    sockaddr* clientAddr) {
+    sockaddr* clientAddr
+#ifdef UPNP_ENABLE_OPEN_SSL
+    ,
+    /*! [in] Established TLS connection on the socket, taken over by the job.
+     */
+    SSL* ssl = nullptr
+#endif
+) {
     TRACE("Executing schedule_request_job()")
     UPNPLIB_LOGINFO "MSG1042: Schedule request job to host "
         << upnplib::to_netaddrp(
@@ -367,10 +440,13 @@ UPNP_INLINE void schedule_request_job(
 
     ThreadPoolJob job{};
     mserv_request_t* request{
-        static_cast<mserv_request_t*>(std::malloc(sizeof(mserv_request_t)))};
+        static_cast<mserv_request_t*>(SlabAlloc(sizeof(mserv_request_t)))};
 
     if (request == nullptr) {
         UPNPLIB_LOGCRIT "MSG1024: Socket " << connfd << ": out of memory.\n";
+#ifdef UPNP_ENABLE_OPEN_SSL
+        SSL_free(ssl);
+#endif
         sock_close(connfd);
         return;
     }
@@ -379,16 +455,150 @@ UPNP_INLINE void schedule_request_job(
     memcpy(&request->foreign_sockaddr, clientAddr,
            sizeof(request->foreign_sockaddr));
     TPJobInit(&job, (start_routine)handle_request, request);
+    TPJobSetLabel(&job, JOB_LABEL_HTTP);
+#ifdef UPNP_ENABLE_OPEN_SSL
+    request->ssl = ssl;
+    TPJobSetFreeFunction(&job, ssl == nullptr ? free_handle_request_arg
+                                              : free_handle_tls_request_arg);
+#else
     TPJobSetFreeFunction(&job, free_handle_request_arg);
+#endif
     TPJobSetPriority(&job, MED_PRIORITY);
+    // The connection is already accepted, so queue it beyond the limit
+    // instead of dropping it. This runs on the select thread that also serves
+    // SSDP, so it must never wait for a slot. Accepting is paused anyway
+    // while the job queues are full.
+    TPJobSetAdmissionPolicy(&job, ADMIT_OVERFLOW);
     if (ThreadPoolAdd(&gMiniServerThreadPool, &job, NULL) != 0) {
         UPNPLIB_LOGERR "MSG1025: Socket " << connfd
                                           << ": cannot schedule request.\n";
-        free(request);
+#ifdef UPNP_ENABLE_OPEN_SSL
+        SSL_free(ssl);
+#endif
+        SlabFree(request);
         sock_close(connfd);
         return;
     }
 }
+
+#ifdef UPNP_ENABLE_OPEN_SSL
+/*!
+ * \brief Continue a TLS handshake and finish it if possible.
+ *
+ * A completed handshake schedules the request job. A failed handshake closes
+ * the connection.
+ *
+ * \returns
+ *  - true - the handshake is finished, successful or not
+ *  - false - the handshake is still in progress
+ */
+bool tls_handshake_step(
+    /*! [in,out] TLS handshake in progress. */
+    tls_handshake_t& a_hs) {
+    TRACE("Executing tls_handshake_step()")
+    a_hs.state = sock_ssl_accept(&a_hs.info);
+    if (a_hs.state == SOCK_SSL_WANT_READ || a_hs.state == SOCK_SSL_WANT_WRITE)
+        return false;
+
+    if (a_hs.state == SOCK_SSL_DONE &&
+        sock_make_blocking(a_hs.info.socket) == 0) {
+        schedule_request_job(a_hs.info.socket,
+                             reinterpret_cast<sockaddr*>(
+                                 &a_hs.info.foreign_sockaddr),
+                             a_hs.info.ssl);
+    } else {
+        UPNPLIB_LOGINFO "MSG1119: Close socket "
+            << a_hs.info.socket << " with failed TLS handshake.\n";
+        sock_destroy(&a_hs.info, SD_BOTH);
+    }
+    return true;
+}
+
+/*!
+ * \brief Start the TLS handshake on an accepted connection.
+ *
+ * The handshake is continued by tls_handshakes_continue() from the miniserver
+ * loop.
+ */
+void tls_handshake_start(
+    /*! [in] Socket Descriptor on which connection is accepted. */
+    SOCKET connfd,
+    /*! [in] Clients Address information. */
+    sockaddr* clientAddr) {
+    TRACE("Executing tls_handshake_start()")
+    if (gTlsHandshakes.size() >= MAX_TLS_HANDSHAKES) {
+        UPNPLIB_LOGERR "MSG1120: Socket "
+            << connfd << ": too many TLS handshakes in progress.\n";
+        sock_close(connfd);
+        return;
+    }
+    tls_handshake_t hs{};
+    if (sock_init_with_ip(&hs.info, connfd, clientAddr) != UPNP_E_SUCCESS ||
+        sock_make_no_blocking(connfd) != 0) {
+        sock_close(connfd);
+        return;
+    }
+    hs.deadline = time(nullptr) + HTTP_DEFAULT_TIMEOUT;
+    // The ClientHello may already be there.
+    if (!tls_handshake_step(hs))
+        gTlsHandshakes.push_back(hs);
+}
+
+/*!
+ * \brief Add the sockets of TLS handshakes in progress to the file descriptor
+ * sets as needed for \::select().
+ */
+void fdset_tls_handshakes(
+    /*! [in,out] Set of sockets to monitor for reading. */
+    fd_set* a_rdSet,
+    /*! [in,out] Set of sockets to monitor for writing. */
+    fd_set* a_wrSet,
+    /*! [in,out] Highest socket file descriptor + 1. */
+    SOCKET& a_nfds) {
+    for (const tls_handshake_t& hs : gTlsHandshakes) {
+        if (hs.info.socket >= FD_SETSIZE)
+            continue;
+        FD_SET(hs.info.socket,
+               hs.state == SOCK_SSL_WANT_WRITE ? a_wrSet : a_rdSet);
+        a_nfds = std::max(a_nfds, hs.info.socket + 1);
+    }
+}
+
+/*!
+ * \brief Continue TLS handshakes with ready sockets and abort expired ones.
+ */
+void tls_handshakes_continue(
+    /*! [in] Set of sockets that are ready for reading. */
+    fd_set* a_rdSet,
+    /*! [in] Set of sockets that are ready for writing. */
+    fd_set* a_wrSet) {
+    const time_t now{time(nullptr)};
+    auto it = gTlsHandshakes.begin();
+    while (it != gTlsHandshakes.end()) {
+        bool finished{false};
+        if (it->info.socket < FD_SETSIZE &&
+            (FD_ISSET(it->info.socket, a_rdSet) ||
+             FD_ISSET(it->info.socket, a_wrSet))) {
+            finished = tls_handshake_step(*it);
+        } else if (now >= it->deadline) {
+            UPNPLIB_LOGINFO "MSG1121: Socket "
+                << it->info.socket << ": TLS handshake timed out.\n";
+            sock_destroy(&it->info, SD_BOTH);
+            finished = true;
+        }
+        it = finished ? gTlsHandshakes.erase(it) : it + 1;
+    }
+}
+
+/*!
+ * \brief Abort all TLS handshakes in progress.
+ */
+void tls_handshakes_abort() {
+    for (tls_handshake_t& hs : gTlsHandshakes)
+        sock_destroy(&hs.info, SD_BOTH);
+    gTlsHandshakes.clear();
+}
+#endif // UPNP_ENABLE_OPEN_SSL
 #endif // COMPA_HAVE_WEBSERVER
 
 /*!
@@ -461,7 +671,9 @@ int web_server_accept(
     /// [in] Socket file descriptor.
     [[maybe_unused]] SOCKET lsock,
     /// [out] Reference to a file descriptor set as needed for \::select().
-    [[maybe_unused]] fd_set& set) {
+    [[maybe_unused]] fd_set& set,
+    /// [in] The socket listens for TLS connections.
+    [[maybe_unused]] bool a_tls = false) {
 #ifndef COMPA_HAVE_WEBSERVER
     return UPNP_E_NO_WEB_SERVER;
 #else
@@ -490,25 +702,46 @@ int web_server_accept(
     UPNPLIB_LOGINFO "MSG1023: Connected to host "
         << buf_ntop << ":" << ntohs(clientAddr.sin.sin_port) << " with socket "
         << asock << ".\n";
+#ifdef UPNP_ENABLE_OPEN_SSL
+    if (a_tls) {
+        // The request job is scheduled when the handshake is done.
+        tls_handshake_start(asock, &clientAddr.sa);
+        return UPNP_E_SUCCESS;
+    }
+#endif
     schedule_request_job(asock, &clientAddr.sa);
 
     return UPNP_E_SUCCESS;
 #endif /* COMPA_HAVE_WEBSERVER */
 }
 
+/*!
+ * \brief Notifies the miniserver of a saturated or drained request thread
+ * pool.
+ *
+ * This is the saturation function of gMiniServerThreadPool.
+ */
+void mserv_saturation([[maybe_unused]] ThreadPool* tp, int saturated,
+                      [[maybe_unused]] void* cookie) {
+    gMServSaturated = saturated != 0;
+}
+
 /*!
  * \brief Read data from the SSDP socket.
  */
 void ssdp_read( //
-    SOCKET* rsock,     ///< [in] Pointer to a Socket file descriptor.
-    fd_set* set        /*!< [in] Pointer to a file descriptor set as needed for
-                                 \::select(). */) {
+    SOCKET* rsock, ///< [in] Pointer to a Socket file descriptor.
+    fd_set* set,   /*!< [in] Pointer to a file descriptor set as needed for
+                             \::select(). */
+    /*! [in] IPv4 address of the additional interface of the socket, nullptr
+     * for the interface given to UpnpInit2(). */
+    [[maybe_unused]] const char* if_ipv4 = nullptr) {
     TRACE("Executing ssdp_read()")
     if (*rsock == INVALID_SOCKET || !FD_ISSET(*rsock, set))
         return;
 
 #if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
-    if (readFromSSDPSocket(*rsock) != 0) {
+    if (readFromSSDPSocket(*rsock, if_ipv4) != 0) {
         UpnpPrintf(UPNP_ERROR, MSERV, __FILE__, __LINE__,
                    "miniserver: Error in readFromSSDPSocket(%d): "
                    "closing socket\n",
@@ -587,27 +820,250 @@ int receive_from_stopSock(
     return 1;
 }
 
+#ifdef __linux__
 /*!
- * \brief Run the miniserver.
+ * \brief Open a netlink socket to get notified about link and address changes
+ * of the local interfaces.
  *
- * The MiniServer accepts a new request and schedules a thread to handle the
- * new request. It checks for socket state and invokes appropriate read and
- * shutdown actions for the Miniserver and SSDP sockets. This function itself
- * runs in its own thread.
+ * Monitoring is optional. Without the socket the interface addresses are only
+ * taken on initialization. Netlink is Linux specific and not mocked.
  *
- * \attention The miniSock parameter must be allocated on the heap before
- * calling the function because it is freed by it.
+ * \returns
+ *  On success: Socket file descriptor\n
+ *  On error: INVALID_SOCKET
  */
-void RunMiniServer(
-    /*! [in] Pointer to an Array containing valid sockets associated with
-       different tasks like listen on a local interface for requests from
-       control points or handle ssdp communication to a remote UPnP node. */
-    MiniServerSockArray* miniSock) {
-    UPNPLIB_LOGINFO "MSG1085: Executing...\n";
-    fd_set expSet;
-    fd_set rdSet;
-    int stopSock = 0;
+SOCKET open_netlink_sock() {
+    SOCKET sock = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                           NETLINK_ROUTE);
+    if (sock == INVALID_SOCKET) {
+        UPNPLIB_LOGINFO "MSG1133: Interface monitoring not available: "
+            << std::strerror(errno) << ".\n";
+        return INVALID_SOCKET;
+    }
+    sockaddr_nl addr{};
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(sock, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        UPNPLIB_LOGINFO "MSG1134: Interface monitoring not available: "
+            << std::strerror(errno) << ".\n";
+        ::close(sock);
+        return INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/*!
+ * \brief Check if netlink messages report a change of an interface.
+ *
+ * \returns
+ *  - true - if one of the messages is a link or address message of the
+ *           interface,
+ *  - false - otherwise.
+ */
+bool netlink_concerns_if(
+    const void* buf, ///< [in] Pointer to the received netlink messages.
+    size_t len,      ///< [in] Number of received bytes.
+    unsigned ifindex ///< [in] Index of the interface.
+) {
+    const char* msg = static_cast<const char*>(buf);
+    constexpr size_t hdrlen{NLMSG_ALIGN(sizeof(nlmsghdr))};
+
+    while (len >= sizeof(nlmsghdr)) {
+        nlmsghdr nh;
+        std::memcpy(&nh, msg, sizeof(nh));
+        if (nh.nlmsg_len < hdrlen || nh.nlmsg_len > len)
+            break;
+        const size_t data_len{nh.nlmsg_len - hdrlen};
+        switch (nh.nlmsg_type) {
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+            if (data_len >= sizeof(ifaddrmsg)) {
+                ifaddrmsg ifa;
+                std::memcpy(&ifa, msg + hdrlen, sizeof(ifa));
+                if (ifa.ifa_index == ifindex)
+                    return true;
+            }
+            break;
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+            if (data_len >= sizeof(ifinfomsg)) {
+                ifinfomsg ifi;
+                std::memcpy(&ifi, msg + hdrlen, sizeof(ifi));
+                if (static_cast<unsigned>(ifi.ifi_index) == ifindex)
+                    return true;
+            }
+            break;
+        default:
+            break;
+        }
+        const size_t next{NLMSG_ALIGN(nh.nlmsg_len)};
+        if (next >= len)
+            break;
+        msg += next;
+        len -= next;
+    }
+    return false;
+}
 
+#ifdef COMPA_HAVE_WEBSERVER
+/*!
+ * \brief Bind a listening miniserver socket to a changed address.
+ *
+ * The port is kept so the URLs of the devices only change their host. If the
+ * new socket cannot be bound, the old one is kept.
+ */
+void rebind_miniserver_socket(
+    upnplib::CSocket* a_sockObj, ///< [in,out] Socket object of the listener.
+    SOCKET& a_sock,              ///< [in,out] Socket of the listener.
+    const std::string& a_node,   ///< [in] New address to bind to.
+    in_port_t a_port             ///< [in] Port the listener is bound to.
+) {
+    if (a_sockObj == nullptr || a_sock == INVALID_SOCKET)
+        return;
+    try {
+        upnplib::CSocket sockObj(a_sockObj->get_family(), SOCK_STREAM);
+        sockObj.load();
+        sockObj.bind(a_node, std::to_string(a_port));
+        sockObj.listen();
+        // The old socket is closed with the moved object.
+        *a_sockObj = std::move(sockObj);
+        a_sock = *a_sockObj;
+        UPNPLIB_LOGINFO "MSG1138: Listening on \"" << a_node << ":" << a_port
+                                                   << "\" now.\n";
+    } catch (const std::exception& e) {
+        UPNPLIB_LOGCATCH "MSG1139: catched next line...\n" << e.what();
+    }
+}
+#endif
+
+/*!
+ * \brief Take the addresses of the local interface again after it has
+ * changed.
+ *
+ * The address globals are filled again by UpnpGetIfInfo() while other threads
+ * are locked out from reading them. If they have changed, the listening
+ * sockets are bound to the new addresses, the SSDP sockets join the multicast
+ * groups on them, the description URLs of the devices get the new host and
+ * all devices are advertised again. If the interface has no valid address at
+ * the moment, the old addresses are kept until it has one again.
+ */
+void refresh_if_addrs(
+    MiniServerSockArray* miniSock ///< [in,out] Pointer to the socket array.
+) {
+    char if_name[LINE_SIZE];
+    char ipv4[INET_ADDRSTRLEN];
+    char ipv6[INET6_ADDRSTRLEN];
+    char ipv6_ula_gua[INET6_ADDRSTRLEN];
+    {
+        // Only this thread modifies the globals, so it reads them without
+        // lock.
+        std::unique_lock if_lock(gIfAddrMutex);
+        const unsigned if_index{gIF_INDEX};
+
+        std::memcpy(if_name, gIF_NAME, sizeof(if_name));
+        std::memcpy(ipv4, gIF_IPV4, sizeof(ipv4));
+        std::memcpy(ipv6, gIF_IPV6, sizeof(ipv6));
+        std::memcpy(ipv6_ula_gua, gIF_IPV6_ULA_GUA, sizeof(ipv6_ula_gua));
+        gIF_IPV4[0] = '\0';
+        gIF_IPV6[0] = '\0';
+        gIF_IPV6_ULA_GUA[0] = '\0';
+        if (UpnpGetIfInfo(if_name) != UPNP_E_SUCCESS) {
+            std::memcpy(gIF_IPV4, ipv4, sizeof(ipv4));
+            std::memcpy(gIF_IPV6, ipv6, sizeof(ipv6));
+            std::memcpy(gIF_IPV6_ULA_GUA, ipv6_ula_gua, sizeof(ipv6_ula_gua));
+            gIF_INDEX = if_index;
+            return;
+        }
+        if (gIF_INDEX == if_index && std::strcmp(gIF_IPV4, ipv4) == 0 &&
+            std::strcmp(gIF_IPV6, ipv6) == 0 &&
+            std::strcmp(gIF_IPV6_ULA_GUA, ipv6_ula_gua) == 0)
+            return;
+    }
+
+    UPNPLIB_LOGINFO "MSG1131: Addresses of interface \""
+        << gIF_NAME << "\" changed to IPv4=\"" << gIF_IPV4 << "\", IPv6=\"["
+        << gIF_IPV6 << "]\", ULA or GUA IPv6=\"[" << gIF_IPV6_ULA_GUA
+        << "]\".\n";
+#ifdef COMPA_HAVE_WEBSERVER
+    if (gIF_IPV4[0] != '\0' && std::strcmp(gIF_IPV4, ipv4) != 0)
+        rebind_miniserver_socket(miniSock->MiniSvrSock4Obj,
+                                 miniSock->miniServerSock4, gIF_IPV4,
+                                 miniSock->miniServerPort4);
+    if (gIF_IPV6[0] != '\0' && std::strcmp(gIF_IPV6, ipv6) != 0)
+        rebind_miniserver_socket(miniSock->MiniSvrSock6LlaObj,
+                                 miniSock->miniServerSock6,
+                                 '[' + std::string(gIF_IPV6) + ']',
+                                 miniSock->miniServerPort6);
+    if (gIF_IPV6_ULA_GUA[0] != '\0' &&
+        std::strcmp(gIF_IPV6_ULA_GUA, ipv6_ula_gua) != 0)
+        rebind_miniserver_socket(miniSock->MiniSvrSock6UadObj,
+                                 miniSock->miniServerSock6UlaGua,
+                                 '[' + std::string(gIF_IPV6_ULA_GUA) + ']',
+                                 miniSock->miniServerPort6UlaGua);
+#endif
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+    if (ssdp_renew_sockets(miniSock) != UPNP_E_SUCCESS)
+        UPNPLIB_LOGERR "MSG1135: Not all SSDP sockets could be renewed.\n";
+#else
+    (void)miniSock;
+#endif
+#ifdef COMPA_HAVE_DEVICE_SSDP
+    UpdateDescURLs(ipv4, ipv6, ipv6_ula_gua);
+    ReadvertiseDevices();
+#endif
+}
+
+/*!
+ * \brief Read the netlink socket and take changed interface addresses.
+ *
+ * \returns
+ *  - true - if the addresses have been checked again,
+ *  - false - otherwise.
+ */
+bool netlink_read(
+    MiniServerSockArray* miniSock, ///< [in,out] Pointer to the socket array.
+    fd_set* set /*!< [in] Pointer to a file descriptor set as needed for
+                          \::select(). */
+) {
+    SOCKET& nlsock = miniSock->netlinkSock;
+    if (nlsock == INVALID_SOCKET || !FD_ISSET(nlsock, set))
+        return false;
+
+    alignas(nlmsghdr) char buf[8192];
+    bool changed{false};
+    ssize_t len;
+    // Read all pending messages so the addresses are checked only once.
+    for (;;) {
+        len = ::recv(nlsock, buf, sizeof(buf), 0);
+        if (len > 0) {
+            if (netlink_concerns_if(buf, static_cast<size_t>(len), gIF_INDEX))
+                changed = true;
+        } else if (len == -1 && errno == ENOBUFS) {
+            // Messages were lost, so check the addresses anyway.
+            changed = true;
+        } else if (!(len == -1 && errno == EINTR)) {
+            break;
+        }
+    }
+    if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        UPNPLIB_LOGERR "MSG1136: Error reading netlink socket: "
+            << std::strerror(errno) << ". Stop interface monitoring.\n";
+        sock_close(nlsock);
+        nlsock = INVALID_SOCKET;
+    }
+    if (changed)
+        refresh_if_addrs(miniSock);
+    return changed;
+}
+#endif // __linux__
+
+/*!
+ * \brief Get the number of file descriptors needed for \::select() on the
+ * socket array.
+ */
+SOCKET get_select_nfds(
+    const MiniServerSockArray* miniSock ///< [in] Pointer to the socket array.
+) {
     // On MS Windows INVALID_SOCKET is unsigned -1 = 18446744073709551615 so we
     // get maxMiniSock with this big number even if there is only one
     // INVALID_SOCKET. Incrementing it at the end results in 0. To be portable
@@ -625,6 +1081,10 @@ void RunMiniServer(
         std::max(maxMiniSock, miniSock->miniServerSock6UlaGua == INVALID_SOCKET
                                   ? 0
                                   : miniSock->miniServerSock6UlaGua);
+    maxMiniSock = //
+        std::max(maxMiniSock, miniSock->miniServerSockTls4 == INVALID_SOCKET
+                                  ? 0
+                                  : miniSock->miniServerSockTls4);
     maxMiniSock = //
         std::max(maxMiniSock, miniSock->miniServerStopSock == INVALID_SOCKET
                                   ? 0
@@ -641,6 +1101,12 @@ void RunMiniServer(
         std::max(maxMiniSock, miniSock->ssdpSock6UlaGua == INVALID_SOCKET
                                   ? 0
                                   : miniSock->ssdpSock6UlaGua);
+    for (SOCKET sock : miniSock->ssdpSockIf4)
+        maxMiniSock =
+            std::max(maxMiniSock, sock == INVALID_SOCKET ? 0 : sock);
+    for (SOCKET sock : miniSock->miniServerSockIf4)
+        maxMiniSock =
+            std::max(maxMiniSock, sock == INVALID_SOCKET ? 0 : sock);
 #ifdef COMPA_HAVE_CTRLPT_SSDP
     maxMiniSock = //
         std::max(maxMiniSock, miniSock->ssdpReqSock4 == INVALID_SOCKET
@@ -651,7 +1117,39 @@ void RunMiniServer(
                                   ? 0
                                   : miniSock->ssdpReqSock6);
 #endif
-    ++maxMiniSock;
+#ifdef __linux__
+    maxMiniSock = //
+        std::max(maxMiniSock, miniSock->netlinkSock == INVALID_SOCKET
+                                  ? 0
+                                  : miniSock->netlinkSock);
+#endif
+
+    return ++maxMiniSock;
+}
+
+/*!
+ * \brief Run the miniserver.
+ *
+ * The MiniServer accepts a new request and schedules a thread to handle the
+ * new request. It checks for socket state and invokes appropriate read and
+ * shutdown actions for the Miniserver and SSDP sockets. This function itself
+ * runs in its own thread.
+ *
+ * \attention The miniSock parameter must be allocated on the heap before
+ * calling the function because it is freed by it.
+ */
+void RunMiniServer(
+    /*! [in] Pointer to an Array containing valid sockets associated with
+       different tasks like listen on a local interface for requests from
+       control points or handle ssdp communication to a remote UPnP node. */
+    MiniServerSockArray* miniSock) {
+    UPNPLIB_LOGINFO "MSG1085: Executing...\n";
+    fd_set expSet;
+    fd_set rdSet;
+    int stopSock = 0;
+    bool accepting{true};
+
+    SOCKET maxMiniSock = get_select_nfds(miniSock);
 
     gMServState = MSERV_RUNNING;
     while (!stopSock) {
@@ -660,20 +1158,58 @@ void RunMiniServer(
         /* FD_SET()'s */
         FD_SET(miniSock->miniServerStopSock, &expSet);
         FD_SET(miniSock->miniServerStopSock, &rdSet);
-        fdset_if_valid(miniSock->miniServerSock4, &rdSet);
-        fdset_if_valid(miniSock->miniServerSock6, &rdSet);
-        fdset_if_valid(miniSock->miniServerSock6UlaGua, &rdSet);
+        if (accepting == gMServSaturated) {
+            accepting = !accepting;
+            UPNPLIB_LOGINFO "MSG1130: Request thread pool "
+                << (accepting ? "drained, accepting" : "saturated, pausing")
+                << " connections.\n";
+        }
+        if (accepting) {
+            fdset_if_valid(miniSock->miniServerSock4, &rdSet);
+            fdset_if_valid(miniSock->miniServerSock6, &rdSet);
+            fdset_if_valid(miniSock->miniServerSock6UlaGua, &rdSet);
+            fdset_if_valid(miniSock->miniServerSockTls4, &rdSet);
+            for (SOCKET sock : miniSock->miniServerSockIf4)
+                fdset_if_valid(sock, &rdSet);
+        }
         fdset_if_valid(miniSock->ssdpSock4, &rdSet);
         fdset_if_valid(miniSock->ssdpSock6, &rdSet);
         fdset_if_valid(miniSock->ssdpSock6UlaGua, &rdSet);
+        for (SOCKET sock : miniSock->ssdpSockIf4)
+            fdset_if_valid(sock, &rdSet);
 #ifdef COMPA_HAVE_CTRLPT_SSDP
         fdset_if_valid(miniSock->ssdpReqSock4, &rdSet);
         fdset_if_valid(miniSock->ssdpReqSock6, &rdSet);
 #endif
+#ifdef __linux__
+        // Not a bound IP socket, so it is not checked with fdset_if_valid().
+        if (miniSock->netlinkSock != INVALID_SOCKET &&
+            miniSock->netlinkSock < FD_SETSIZE)
+            FD_SET(miniSock->netlinkSock, &rdSet);
+#endif
+
+        SOCKET select_nfds{maxMiniSock};
+        fd_set* wrSetp{nullptr};
+        ::timeval* timeoutp{nullptr};
+#if defined(COMPA_HAVE_WEBSERVER) && defined(UPNP_ENABLE_OPEN_SSL)
+        // Wake up at least every second to abort expired handshakes.
+        fd_set wrSet;
+        ::timeval timeout{1, 0};
+        if (!gTlsHandshakes.empty()) {
+            FD_ZERO(&wrSet);
+            fdset_tls_handshakes(&rdSet, &wrSet, select_nfds);
+            wrSetp = &wrSet;
+            timeoutp = &timeout;
+        }
+#endif
+        // Look again for a drained thread pool while not accepting.
+        ::timeval saturated_timeout{0, 100000};
+        if (!accepting)
+            timeoutp = &saturated_timeout;
 
         /* select() */
-        int ret = umock::sys_socket_h.select(static_cast<int>(maxMiniSock),
-                                             &rdSet, NULL, &expSet, NULL);
+        int ret = umock::sys_socket_h.select(static_cast<int>(select_nfds),
+                                             &rdSet, wrSetp, &expSet, timeoutp);
 
         if (ret == SOCKET_ERROR) {
             if (errno == EINTR) {
@@ -697,6 +1233,10 @@ void RunMiniServer(
             break;
         }
 
+#if defined(COMPA_HAVE_WEBSERVER) && defined(UPNP_ENABLE_OPEN_SSL)
+        if (wrSetp != nullptr)
+            tls_handshakes_continue(&rdSet, wrSetp);
+#endif
         // Accept requested connection from a remote control point and run the
         // connection in a new thread. Due to side effects with threading we
         // need to avoid lazy evaluation with chained || because all
@@ -709,6 +1249,11 @@ void RunMiniServer(
             web_server_accept(miniSock->miniServerSock6, rdSet);
         [[maybe_unused]] int ret3 =
             web_server_accept(miniSock->miniServerSock6UlaGua, rdSet);
+        if (miniSock->miniServerSockTls4 != INVALID_SOCKET)
+            web_server_accept(miniSock->miniServerSockTls4, rdSet, true);
+        for (SOCKET sock : miniSock->miniServerSockIf4)
+            if (sock != INVALID_SOCKET)
+                web_server_accept(sock, rdSet);
 #ifdef COMPA_HAVE_CTRLPT_SSDP
         ssdp_read(&miniSock->ssdpReqSock4, &rdSet);
         ssdp_read(&miniSock->ssdpReqSock6, &rdSet);
@@ -716,7 +1261,15 @@ void RunMiniServer(
         ssdp_read(&miniSock->ssdpSock4, &rdSet);
         ssdp_read(&miniSock->ssdpSock6, &rdSet);
         ssdp_read(&miniSock->ssdpSock6UlaGua, &rdSet);
+        for (size_t i{0}; i < SSDP_MAX_INTERFACES; i++)
+            ssdp_read(&miniSock->ssdpSockIf4[i], &rdSet,
+                      miniSock->ssdpIfIpv4[i]);
         // }
+#ifdef __linux__
+        // Renewed SSDP sockets may have got higher file descriptors.
+        if (netlink_read(miniSock, &rdSet))
+            maxMiniSock = get_select_nfds(miniSock);
+#endif
 
         // Check if we have received a packet from
         // localhost(127.0.0.1) that will stop the miniserver.
@@ -724,16 +1277,30 @@ void RunMiniServer(
     } // while (!stopsock)
 
     /* Close all sockets. */
+#if defined(COMPA_HAVE_WEBSERVER) && defined(UPNP_ENABLE_OPEN_SSL)
+    tls_handshakes_abort();
+#endif
     sock_close(miniSock->miniServerSock4);
+    sock_close(miniSock->miniServerSockTls4);
     sock_close(miniSock->miniServerSock6);
     sock_close(miniSock->miniServerSock6UlaGua);
     sock_close(miniSock->miniServerStopSock);
     sock_close(miniSock->ssdpSock4);
     sock_close(miniSock->ssdpSock6);
     sock_close(miniSock->ssdpSock6UlaGua);
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+    SsdpSetIfAddrs4({});
+#endif
+    for (SOCKET sock : miniSock->ssdpSockIf4)
+        sock_close(sock);
+    for (SOCKET sock : miniSock->miniServerSockIf4)
+        sock_close(sock);
 #ifdef COMPA_HAVE_CTRLPT_SSDP
     sock_close(miniSock->ssdpReqSock4);
     sock_close(miniSock->ssdpReqSock6);
+#endif
+#ifdef __linux__
+    sock_close(miniSock->netlinkSock);
 #endif
     /* Free minisock. */
     umock::stdlib_h.free(miniSock);
@@ -873,6 +1440,23 @@ int get_miniserver_sockets(
         }
     }
 
+#ifdef UPNP_ENABLE_OPEN_SSL
+    // TLS has its own listener so plain HTTP keeps working on the advertised
+    // http:// URLs. The port is chosen by the system.
+    if (sock_ssl_server_enabled() && out->MiniSvrSockTls4Obj != nullptr &&
+        out->miniServerSock4 != INVALID_SOCKET) {
+        try {
+            out->MiniSvrSockTls4Obj->load();
+            out->MiniSvrSockTls4Obj->bind(std::string(gIF_IPV4), "0");
+            out->MiniSvrSockTls4Obj->listen();
+            out->miniServerSockTls4 = *out->MiniSvrSockTls4Obj;
+            out->miniServerPortTls4 = out->MiniSvrSockTls4Obj->get_port();
+        } catch (const std::exception& e) {
+            UPNPLIB_LOGCATCH "MSG1141: catched next line...\n" << e.what();
+        }
+    }
+#endif
+
     UPNPLIB_LOGINFO "MSG1065: Finished.\n";
     return retval;
 }
@@ -938,6 +1522,57 @@ int get_miniserver_stopsock(
     return UPNP_E_SUCCESS;
 }
 
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+/*!
+ * \brief Creates the miniserver sockets on the additional SSDP interfaces.
+ *
+ * Each additional interface with an SSDP socket gets a listening socket on its
+ * IPv4 address with the port of miniServerSock4, so the location URL on the
+ * interface can be served. An interface whose socket cannot be created is not
+ * served at all, its SSDP socket is closed. The addresses of the served
+ * interfaces are set with SsdpSetIfAddrs4().
+ */
+void get_miniserver_sockets_if4(
+    /*! [in,out] Socket array with the SSDP sockets of the interfaces. */
+    MiniServerSockArray* out) {
+    TRACE("Executing get_miniserver_sockets_if4()");
+    std::vector<std::string> if_addrs;
+
+    for (size_t i{0}; i < SSDP_MAX_INTERFACES; i++) {
+        if (out->ssdpSockIf4[i] == INVALID_SOCKET)
+            continue;
+#ifdef COMPA_HAVE_WEBSERVER
+        if (out->miniServerSock4 != INVALID_SOCKET) {
+            upnplib::CSocketErr sockerrObj;
+            sockaddr_in saddr{};
+            saddr.sin_family = AF_INET;
+            saddr.sin_port = htons(out->miniServerPort4);
+            inet_pton(AF_INET, out->ssdpIfIpv4[i], &saddr.sin_addr);
+            SOCKET sock = umock::sys_socket_h.socket(AF_INET, SOCK_STREAM, 0);
+            if (sock == INVALID_SOCKET ||
+                umock::sys_socket_h.bind(sock,
+                                         reinterpret_cast<sockaddr*>(&saddr),
+                                         sizeof(saddr)) == SOCKET_ERROR ||
+                umock::sys_socket_h.listen(sock, SOMAXCONN) == SOCKET_ERROR) {
+                sockerrObj.catch_error();
+                UPNPLIB_LOGERR "MSG1142: Cannot listen on \""
+                    << out->ssdpIfIpv4[i] << ':' << out->miniServerPort4
+                    << "\", not serving the interface: "
+                    << sockerrObj.error_str() << ".\n";
+                sock_close(sock);
+                sock_close(out->ssdpSockIf4[i]);
+                out->ssdpSockIf4[i] = INVALID_SOCKET;
+                continue;
+            }
+            out->miniServerSockIf4[i] = sock;
+        }
+#endif
+        if_addrs.emplace_back(out->ssdpIfIpv4[i]);
+    }
+    SsdpSetIfAddrs4(if_addrs);
+}
+#endif
+
 /*!
  * \brief Initialize a miniserver Socket Array.
  */
@@ -948,18 +1583,28 @@ void InitMiniServerSockArray(
     miniSocket->miniServerSock4 = INVALID_SOCKET;
     miniSocket->miniServerSock6 = INVALID_SOCKET;
     miniSocket->miniServerSock6UlaGua = INVALID_SOCKET;
+    miniSocket->miniServerSockTls4 = INVALID_SOCKET;
     miniSocket->miniServerStopSock = INVALID_SOCKET;
     miniSocket->ssdpSock4 = INVALID_SOCKET;
     miniSocket->ssdpSock6 = INVALID_SOCKET;
     miniSocket->ssdpSock6UlaGua = INVALID_SOCKET;
+    for (SOCKET& sock : miniSocket->ssdpSockIf4)
+        sock = INVALID_SOCKET;
+    for (SOCKET& sock : miniSocket->miniServerSockIf4)
+        sock = INVALID_SOCKET;
+    memset(miniSocket->ssdpIfIpv4, 0, sizeof(miniSocket->ssdpIfIpv4));
     miniSocket->stopPort = 0u;
     miniSocket->miniServerPort4 = 0u;
     miniSocket->miniServerPort6 = 0u;
     miniSocket->miniServerPort6UlaGua = 0u;
+    miniSocket->miniServerPortTls4 = 0u;
 #ifdef COMPA_HAVE_CTRLPT_SSDP
     miniSocket->ssdpReqSock4 = INVALID_SOCKET;
     miniSocket->ssdpReqSock6 = INVALID_SOCKET;
 #endif
+#ifdef __linux__
+    miniSocket->netlinkSock = INVALID_SOCKET;
+#endif
 }
 
 /// @} // Functions (scope restricted to file)
@@ -982,15 +1627,13 @@ void SetGenaCallback(MiniServerCallback callback) {
 
 int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
                     [[maybe_unused]] in_port_t* listen_port6,
-                    [[maybe_unused]] in_port_t* listen_port6UlaGua) {
+                    [[maybe_unused]] in_port_t* listen_port6UlaGua,
+                    in_port_t* listen_portTls4) {
     UPNPLIB_LOGINFO "MSG1068: Executing...\n";
     constexpr int max_count{10000};
     MiniServerSockArray* miniSocket;
-    ThreadPoolJob job;
     int ret_code{UPNP_E_INTERNAL_ERROR};
 
-    memset(&job, 0, sizeof(job));
-
     if (gMServState != MSERV_IDLE) {
         /* miniserver running. */
         UPNPLIB_LOGERR "MSG1087: Cannot start. Miniserver is running.\n";
@@ -1009,6 +1652,8 @@ int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
     miniSocket->MiniSvrSock6UadObj = &Sock6UadObj;
     static upnplib::CSocket Sock4Obj(AF_INET, SOCK_STREAM);
     miniSocket->MiniSvrSock4Obj = &Sock4Obj;
+    static upnplib::CSocket SockTls4Obj(AF_INET, SOCK_STREAM);
+    miniSocket->MiniSvrSockTls4Obj = &SockTls4Obj;
 
 #ifdef COMPA_HAVE_WEBSERVER
     if (*listen_port4 == 0 || *listen_port6 == 0 || *listen_port6UlaGua == 0) {
@@ -1045,6 +1690,7 @@ int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
         sock_close(miniSocket->miniServerSock4);
         sock_close(miniSocket->miniServerSock6);
         sock_close(miniSocket->miniServerSock6UlaGua);
+        sock_close(miniSocket->miniServerSockTls4);
         free(miniSocket);
         return ret_code;
     }
@@ -1055,27 +1701,49 @@ int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
         sock_close(miniSocket->miniServerSock4);
         sock_close(miniSocket->miniServerSock6);
         sock_close(miniSocket->miniServerSock6UlaGua);
+        sock_close(miniSocket->miniServerSockTls4);
         sock_close(miniSocket->miniServerStopSock);
         free(miniSocket);
         return ret_code;
     }
+    /* Http listeners on the additional SSDP interfaces. */
+    get_miniserver_sockets_if4(miniSocket);
 #endif
-    // Run miniserver in a new thread.
-    TPJobInit(&job, (start_routine)RunMiniServer_f, (void*)miniSocket);
-    TPJobSetPriority(&job, MED_PRIORITY);
-    TPJobSetFreeFunction(&job, (free_routine)free);
-    ret_code = ThreadPoolAddPersistent(&gMiniServerThreadPool, &job, NULL);
+#ifdef __linux__
+    // Follow address changes of the local interface.
+    miniSocket->netlinkSock = open_netlink_sock();
+#endif
+    // Stop accepting connections while request jobs cannot be queued.
+    gMServSaturated = false;
+    ThreadPoolSetSaturationFunction(&gMiniServerThreadPool, mserv_saturation,
+                                    nullptr);
+    // Run miniserver in its own thread. A previous one has already finished.
+    DedicatedThreadJoin(&gMServThread);
+    ret_code = DedicatedThreadStart(&gMServThread,
+                                    (start_routine)RunMiniServer_f,
+                                    (void*)miniSocket, gIoThreadCpu);
     if (ret_code != 0) {
         sock_close(miniSocket->miniServerSock4);
         sock_close(miniSocket->miniServerSock6);
         sock_close(miniSocket->miniServerSock6UlaGua);
+        sock_close(miniSocket->miniServerSockTls4);
         sock_close(miniSocket->miniServerStopSock);
         sock_close(miniSocket->ssdpSock4);
         sock_close(miniSocket->ssdpSock6);
         sock_close(miniSocket->ssdpSock6UlaGua);
+        for (SOCKET sock : miniSocket->ssdpSockIf4)
+            sock_close(sock);
+        for (SOCKET sock : miniSocket->miniServerSockIf4)
+            sock_close(sock);
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+        SsdpSetIfAddrs4({});
+#endif
 #ifdef COMPA_HAVE_CTRLPT_SSDP
         sock_close(miniSocket->ssdpReqSock4);
         sock_close(miniSocket->ssdpReqSock6);
+#endif
+#ifdef __linux__
+        sock_close(miniSocket->netlinkSock);
 #endif
         free(miniSocket);
         return UPNP_E_OUTOF_MEMORY;
@@ -1092,13 +1760,24 @@ int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
         sock_close(miniSocket->miniServerSock4);
         sock_close(miniSocket->miniServerSock6);
         sock_close(miniSocket->miniServerSock6UlaGua);
+        sock_close(miniSocket->miniServerSockTls4);
         sock_close(miniSocket->miniServerStopSock);
         sock_close(miniSocket->ssdpSock4);
         sock_close(miniSocket->ssdpSock6);
         sock_close(miniSocket->ssdpSock6UlaGua);
+        for (SOCKET sock : miniSocket->ssdpSockIf4)
+            sock_close(sock);
+        for (SOCKET sock : miniSocket->miniServerSockIf4)
+            sock_close(sock);
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+        SsdpSetIfAddrs4({});
+#endif
 #ifdef COMPA_HAVE_CTRLPT_SSDP
         sock_close(miniSocket->ssdpReqSock4);
         sock_close(miniSocket->ssdpReqSock6);
+#endif
+#ifdef __linux__
+        sock_close(miniSocket->netlinkSock);
 #endif
         return UPNP_E_INTERNAL_ERROR;
     }
@@ -1107,6 +1786,8 @@ int StartMiniServer([[maybe_unused]] in_port_t* listen_port4,
     *listen_port6 = miniSocket->miniServerPort6;
     *listen_port6UlaGua = miniSocket->miniServerPort6UlaGua;
 #endif
+    if (listen_portTls4 != nullptr)
+        *listen_portTls4 = miniSocket->miniServerPortTls4;
 
     return UPNP_E_SUCCESS;
 }
@@ -1149,6 +1830,7 @@ int StopMiniServer() {
         isleep(1u);
     }
     sock_close(sock);
+    DedicatedThreadJoin(&gMServThread);
 
     return 0;
 }
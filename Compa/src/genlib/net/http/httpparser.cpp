@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-08-01
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -50,9 +50,22 @@
 #include <upnplib/synclog.hpp>
 
 /// \cond
+#include <bit>
 #include <cassert>
 #include <cstdarg>
+#include <cstdint>
+#include <cstring>
 #include <limits.h>
+#include <string_view>
+
+#if defined(__SSE2__) || defined(_M_X64) ||                                    \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define COMPA_SCANNER_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define COMPA_SCANNER_NEON
+#endif
 /// \endcond
 
 /* entity positions */
@@ -96,6 +109,190 @@ constexpr char TOKCHAR_CR{0xD};
 constexpr char TOKCHAR_LF{0xA};
 /// \endcond
 
+/*! \name Character classes used by the scanner.
+ * @{ */
+/// \brief The character is a HTTP separator.
+constexpr unsigned char CHARCLASS_SEPARATOR{0x01};
+/// \brief The character is permissible in a token (identifier).
+constexpr unsigned char CHARCLASS_IDENTIFIER{0x02};
+/// @}
+
+/*!
+ * \brief Create the lookup table for the character classes.
+ *
+ * The null character is classified as separator because the former
+ * implementation with strchr() also found the terminating null of the
+ * separator list.
+ */
+consteval std::array<unsigned char, 256> make_char_class_table() {
+    constexpr std::string_view separators{" \t()<>@,;:\\\"/[]?={}"};
+    std::array<unsigned char, 256> table{};
+
+    table[0] = CHARCLASS_SEPARATOR;
+    for (const char c : separators)
+        table[static_cast<unsigned char>(c)] = CHARCLASS_SEPARATOR;
+    for (size_t c{32}; c <= 126; c++) {
+        if (table[c] == 0)
+            table[c] = CHARCLASS_IDENTIFIER;
+    }
+    return table;
+}
+
+/// \brief Lookup table with the character class of every octet.
+constexpr std::array<unsigned char, 256> Char_Class{make_char_class_table()};
+
+/// \brief Number of octets that are checked at once by the vectorized scanner.
+constexpr size_t SCAN_BLOCK_SIZE{16};
+
+#if defined(COMPA_SCANNER_SSE2) || defined(COMPA_SCANNER_NEON)
+/*!
+ * \brief Get offset of the first octet in a block that is not a plain token
+ * character.
+ *
+ * Plain token characters are letters, digits, '-', '.' and '_'. They make up
+ * nearly all HTTP methods, header names and most header values. Other
+ * identifier characters are rare and left to the scalar scanner.
+ *
+ * \returns Offset of the first other octet, SCAN_BLOCK_SIZE if there is none.
+ */
+inline size_t block_find_non_plain_token( //
+    const char* a_block ///< [in] Pointer to SCAN_BLOCK_SIZE readable octets.
+) {
+#ifdef COMPA_SCANNER_SSE2
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_block));
+    // Signed compares: octets >= 0x80 are negative and never in a range.
+    const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+    const __m128i alpha =
+        _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                      _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+    const __m128i digit =
+        _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)),
+                      _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+    const __m128i punct =
+        _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')),
+                                  _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    const unsigned int mask =
+        ~static_cast<unsigned int>(_mm_movemask_epi8(
+            _mm_or_si128(_mm_or_si128(alpha, digit), punct))) &
+        0xFFFFu;
+    return mask == 0 ? SCAN_BLOCK_SIZE
+                     : static_cast<size_t>(std::countr_zero(mask));
+#else
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(a_block));
+    const uint8x16_t lower = vorrq_u8(v, vdupq_n_u8(0x20));
+    const uint8x16_t alpha = vandq_u8(vcgeq_u8(lower, vdupq_n_u8('a')),
+                                      vcleq_u8(lower, vdupq_n_u8('z')));
+    const uint8x16_t digit =
+        vandq_u8(vcgeq_u8(v, vdupq_n_u8('0')), vcleq_u8(v, vdupq_n_u8('9')));
+    const uint8x16_t punct = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('-')),
+                                               vceqq_u8(v, vdupq_n_u8('.'))),
+                                      vceqq_u8(v, vdupq_n_u8('_')));
+    const uint8x16_t other =
+        vmvnq_u8(vorrq_u8(vorrq_u8(alpha, digit), punct));
+    // Narrow to 4 bits per octet because NEON has no movemask.
+    const uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(other), 4)), 0);
+    return mask == 0 ? SCAN_BLOCK_SIZE
+                     : static_cast<size_t>(std::countr_zero(mask)) / 4;
+#endif
+}
+
+/*!
+ * \brief Get offset of the first octet in a block that may end or disturb a
+ * line.
+ *
+ * These are CR, LF, the double quote that starts a quoted string and octets
+ * >= 0x80 that are only valid within a quoted string. Every other octet is a
+ * complete and valid token on its own or part of one.
+ *
+ * \returns Offset of the first such octet, SCAN_BLOCK_SIZE if there is none.
+ */
+inline size_t block_find_line_special( //
+    const char* a_block ///< [in] Pointer to SCAN_BLOCK_SIZE readable octets.
+) {
+#ifdef COMPA_SCANNER_SSE2
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(a_block));
+    const __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(TOKCHAR_CR)),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8(TOKCHAR_LF))),
+        _mm_cmpeq_epi8(v, _mm_set1_epi8('"')));
+    // movemask of the plain input flags the octets with the high bit set.
+    const unsigned int mask =
+        static_cast<unsigned int>(_mm_movemask_epi8(special) |
+                                  _mm_movemask_epi8(v)) &
+        0xFFFFu;
+    return mask == 0 ? SCAN_BLOCK_SIZE
+                     : static_cast<size_t>(std::countr_zero(mask));
+#else
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(a_block));
+    const uint8x16_t special =
+        vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(TOKCHAR_CR)),
+                          vceqq_u8(v, vdupq_n_u8(TOKCHAR_LF))),
+                 vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')),
+                          vcgeq_u8(v, vdupq_n_u8(0x80))));
+    const uint64_t mask = vget_lane_u64(
+        vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+    return mask == 0 ? SCAN_BLOCK_SIZE
+                     : static_cast<size_t>(std::countr_zero(mask)) / 4;
+#endif
+}
+#endif // COMPA_SCANNER_SSE2 || COMPA_SCANNER_NEON
+
+/*!
+ * \brief Skip plain token characters block by block.
+ *
+ * Only complete blocks are examined. The remaining octets are left to the
+ * scalar scanner, also if there is no vector unit available.
+ *
+ * \returns Pointer to the first octet that must be checked by the scalar
+ * scanner.
+ */
+inline char* skip_plain_token_chars(
+    char* a_cursor,   ///< [in] Start of the octets to skip.
+    const char* a_end ///< [in] End of the readable octets.
+) {
+#if defined(COMPA_SCANNER_SSE2) || defined(COMPA_SCANNER_NEON)
+    while (static_cast<size_t>(a_end - a_cursor) >= SCAN_BLOCK_SIZE) {
+        const size_t offset{block_find_non_plain_token(a_cursor)};
+        a_cursor += offset;
+        if (offset < SCAN_BLOCK_SIZE)
+            break;
+    }
+#else
+    (void)a_end;
+#endif
+    return a_cursor;
+}
+
+/*!
+ * \brief Skip octets that cannot end a line, block by block.
+ *
+ * Same as skip_plain_token_chars() but skips all octets that
+ * block_find_line_special() does not stop at.
+ *
+ * \returns Pointer to the first octet that must be checked by the scalar
+ * scanner.
+ */
+inline char* skip_line_chars(
+    char* a_cursor,   ///< [in] Start of the octets to skip.
+    const char* a_end ///< [in] End of the readable octets.
+) {
+#if defined(COMPA_SCANNER_SSE2) || defined(COMPA_SCANNER_NEON)
+    while (static_cast<size_t>(a_end - a_cursor) >= SCAN_BLOCK_SIZE) {
+        const size_t offset{block_find_line_special(a_cursor)};
+        a_cursor += offset;
+        if (offset < SCAN_BLOCK_SIZE)
+            break;
+    }
+#else
+    (void)a_end;
+#endif
+    return a_cursor;
+}
+
 /*!
  * \brief Initialize scanner
  */
@@ -114,7 +311,8 @@ UPNP_INLINE void scanner_init( //
 UPNP_INLINE int is_separator_char(
     int c ///< [in] Character to be tested against used separator values
 ) {
-    return strchr(" \t()<>@,;:\\\"/[]?={}", c) != 0;
+    return (Char_Class[static_cast<unsigned char>(c)] &
+            CHARCLASS_SEPARATOR) != 0;
 }
 
 /*!
@@ -123,7 +321,8 @@ UPNP_INLINE int is_separator_char(
 UPNP_INLINE int is_identifier_char( //
     int c ///< [in] Character to be tested for separator values
 ) {
-    return c >= 32 && c <= 126 && !is_separator_char(c);
+    return (Char_Class[static_cast<unsigned char>(c)] &
+            CHARCLASS_IDENTIFIER) != 0;
 }
 
 /*!
@@ -185,8 +384,12 @@ parse_status_t scanner_get_token( //
         /* scan identifier */
         token->buf = cursor++;
         token_type = TT_IDENTIFIER;
-        while (cursor < null_terminator && is_identifier_char(*cursor))
+        while (cursor < null_terminator) {
+            cursor = skip_plain_token_chars(cursor, null_terminator);
+            if (cursor == null_terminator || !is_identifier_char(*cursor))
+                break;
             cursor++;
+        }
         if (!scanner->entire_msg_loaded && cursor == null_terminator)
             /* possibly more valid chars */
             return PARSE_INCOMPLETE;
@@ -309,10 +512,69 @@ void httpheader_free( //
     http_header_t* hdr = (http_header_t*)msg;
 
     membuffer_destroy(&hdr->name_buf);
-    membuffer_destroy(&hdr->value);
+    /* a slice does not own its value */
+    if (!hdr->is_slice)
+        membuffer_destroy(&hdr->value);
     free(hdr);
 }
 
+/*!
+ * \brief Copy the name and value of a header that is a slice into the raw
+ * message to own buffers.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_MEMORY
+ */
+int httpheader_copy_slice( //
+    http_header_t* hdr     ///< [in,out] Pointer to HTTP header.
+) {
+    membuffer value;
+    membuffer_init(&value);
+
+    if (!hdr->is_slice)
+        return UPNP_E_SUCCESS;
+
+    if (membuffer_assign(&hdr->name_buf, hdr->name.buf, hdr->name.length) ||
+        membuffer_assign(&value, hdr->value.buf, hdr->value.length)) {
+        membuffer_destroy(&hdr->name_buf);
+        membuffer_destroy(&value);
+        return UPNP_E_OUTOF_MEMORY;
+    }
+    hdr->name.buf = hdr->name_buf.buf;
+    hdr->value = value;
+    hdr->is_slice = 0;
+
+    return UPNP_E_SUCCESS;
+}
+
+/*!
+ * \brief Move the header slices of a message to a new location of the raw
+ * message buffer.
+ *
+ * The raw message buffer may be reallocated when data is appended.
+ */
+void httpmsg_rebase_header_slices(
+    http_message_t* msg, ///< [in,out] HTTP Message Object.
+    uintptr_t old_base   ///< [in] Former address of the raw message buffer.
+) {
+    ListNode* node;
+    http_header_t* hdr;
+
+    for (node = ListHead(&msg->headers); node != nullptr;
+         node = ListNext(&msg->headers, node)) {
+        hdr = (http_header_t*)node->item;
+        if (!hdr->is_slice)
+            continue;
+        hdr->name.buf =
+            msg->msg.buf + (reinterpret_cast<uintptr_t>(hdr->name.buf) -
+                            old_base);
+        hdr->value.buf =
+            msg->msg.buf + (reinterpret_cast<uintptr_t>(hdr->value.buf) -
+                            old_base);
+    }
+}
+
 /*!
  * \brief Skips blank lines at the start of a msg.
  *
@@ -473,6 +735,7 @@ UPNP_INLINE parse_status_t match_raw_value(
     int saw_crlf = 0;
     size_t pos_at_crlf = (size_t)0;
     size_t save_pos;
+    size_t skip_pos;
     char c;
 
     save_pos = scanner->cursor;
@@ -482,6 +745,15 @@ UPNP_INLINE parse_status_t match_raw_value(
     raw_value->length = (size_t)0;
 
     while (!done) {
+        if (!saw_crlf) {
+            /* fast forward over octets that cannot end the value */
+            skip_pos = static_cast<size_t>(
+                skip_line_chars(scanner_get_str(scanner),
+                                scanner->msg->buf + scanner->msg->length) -
+                scanner->msg->buf);
+            raw_value->length += skip_pos - scanner->cursor;
+            scanner->cursor = skip_pos;
+        }
         status = scanner_get_token(scanner, &token, &tok_type);
         if (status == (parse_status_t)PARSE_OK) {
             if (!saw_crlf) {
@@ -614,6 +886,11 @@ UPNP_INLINE parse_status_t read_until_crlf(
 
     /* read until we hit a crlf */
     do {
+        /* fast forward over octets that cannot end the line */
+        scanner->cursor = static_cast<size_t>(
+            skip_line_chars(scanner_get_str(scanner),
+                            scanner->msg->buf + scanner->msg->length) -
+            scanner->msg->buf);
         status = scanner_get_token(scanner, &token, &tok_type);
     } while (status == (parse_status_t)PARSE_OK &&
              tok_type != (token_type_t)TT_CRLF);
@@ -1261,6 +1538,70 @@ UPNP_INLINE parse_status_t parser_parse_entity_until_close(
     return PARSE_INCOMPLETE_ENTITY; /* add anything */
 }
 
+/*!
+ * \brief Check if the parser still waits for the end of a line.
+ *
+ * Start line, headers and chunk sizes can only be parsed when their line is
+ * complete. After incomplete parsing, only newly appended data is searched for
+ * a line feed instead of scanning the line again on every received segment.
+ *
+ * \returns
+ *  - true - no new line end, parsing would be incomplete again
+ *  - false - the message must be parsed
+ */
+UPNP_INLINE bool parser_waits_for_line(
+    http_parser_t* parser, ///< [in,out] HTTP Parser Object.
+    size_t old_length      ///< [in] Message length before appending data.
+) {
+    membuffer* msg = &parser->msg.msg;
+    size_t scan_pos = parser->line_scan_pos;
+
+    switch (parser->position) {
+    case POS_REQUEST_LINE:
+    case POS_RESPONSE_LINE:
+    case POS_HEADERS:
+        break;
+    case POS_ENTITY:
+        if (parser->ent_position == ENTREAD_USING_CHUNKED ||
+            parser->ent_position == ENTREAD_CHUNKY_HEADERS)
+            break;
+        return false;
+    default:
+        return false;
+    }
+    /* the message may have been modified without the parser */
+    if (scan_pos == (size_t)0 || scan_pos < parser->scanner.cursor ||
+        scan_pos > old_length)
+        return false;
+    if (memchr(msg->buf + scan_pos, TOKCHAR_LF, msg->length - scan_pos) !=
+        nullptr)
+        return false;
+    parser->line_scan_pos = msg->length;
+
+    return true;
+}
+
+/*!
+ * \brief Parse data that has been appended to the raw message.
+ *
+ * \returns The status of parser_parse().
+ */
+UPNP_INLINE parse_status_t parser_parse_appended(
+    http_parser_t* parser, ///< [in,out] HTTP Parser Object.
+    size_t old_length      ///< [in] Message length before appending data.
+) {
+    parse_status_t status;
+
+    if (parser_waits_for_line(parser, old_length))
+        return PARSE_INCOMPLETE;
+
+    status = parser_parse(parser);
+    parser->line_scan_pos =
+        status == PARSE_INCOMPLETE ? parser->msg.msg.length : (size_t)0;
+
+    return status;
+}
+
 } // anonymous namespace
 
 
@@ -1319,6 +1660,20 @@ http_header_t* httpmsg_find_hdr(http_message_t* msg, int header_name_id,
 }
 
 
+int httpmsg_copy_header_slices(http_message_t* msg) {
+    ListNode* node;
+
+    for (node = ListHead(&msg->headers); node != nullptr;
+         node = ListNext(&msg->headers, node)) {
+        if (httpheader_copy_slice((http_header_t*)node->item) !=
+            UPNP_E_SUCCESS)
+            return UPNP_E_OUTOF_MEMORY;
+    }
+
+    return UPNP_E_SUCCESS;
+}
+
+
 parse_status_t matchstr(char* str, size_t slen, const char* fmt, ...) {
     parse_status_t ret_code;
     char save_char;
@@ -1504,6 +1859,23 @@ parse_status_t parser_parse_headers(http_parser_t* parser) {
             }
             membuffer_init(&header->name_buf);
             membuffer_init(&header->value);
+            header->is_slice = 0;
+            /* chunky trailer headers are deleted from the raw message */
+            if (parser->header_slices && hdr_value.length > (size_t)0 &&
+                parser->ent_position != ENTREAD_CHUNKY_HEADERS) {
+                /* refer to name and value in the raw message */
+                header->name = token;
+                header->value.buf = hdr_value.buf;
+                header->value.length = hdr_value.length;
+                header->name_id = header_id;
+                header->is_slice = 1;
+                if (!ListAddTail(&parser->msg.headers, header)) {
+                    free(header);
+                    parser->http_error_code = HTTP_INTERNAL_SERVER_ERROR;
+                    return PARSE_FAILURE;
+                }
+                continue;
+            }
             /* value can be 0 length */
             if (hdr_value.length == (size_t)0) {
                 hdr_value.buf = &zero;
@@ -1531,6 +1903,11 @@ parse_status_t parser_parse_headers(http_parser_t* parser) {
                 return PARSE_FAILURE;
             }
         } else if (hdr_value.length > (size_t)0) {
+            /* a slice cannot be extended, copy it first */
+            if (httpheader_copy_slice(orig_header) != UPNP_E_SUCCESS) {
+                parser->http_error_code = HTTP_INTERNAL_SERVER_ERROR;
+                return PARSE_FAILURE;
+            }
             /* append value to existing header */
             /* append space */
             ret = membuffer_append_str(&orig_header->value, ", ");
@@ -1734,10 +2111,15 @@ parse_status_t parser_parse(http_parser_t* parser) {
 parse_status_t parser_append(http_parser_t* parser, const char* buf,
                              size_t buf_length) {
     int ret_code;
+    uintptr_t old_base;
+    size_t old_length;
 
     assert(parser != NULL);
     assert(buf != NULL);
 
+    old_base = reinterpret_cast<uintptr_t>(parser->msg.msg.buf);
+    old_length = parser->msg.msg.length;
+
     /* append data to buffer */
     ret_code = membuffer_append(&parser->msg.msg, buf, buf_length);
     if (ret_code != 0) {
@@ -1745,8 +2127,58 @@ parse_status_t parser_append(http_parser_t* parser, const char* buf,
         parser->http_error_code = HTTP_INTERNAL_SERVER_ERROR;
         return PARSE_FAILURE;
     }
+    if (parser->header_slices &&
+        reinterpret_cast<uintptr_t>(parser->msg.msg.buf) != old_base) {
+        /* raw message has moved */
+        httpmsg_rebase_header_slices(&parser->msg, old_base);
+    }
+
+    return parser_parse_appended(parser, old_length);
+}
+
+
+char* parser_append_reserve(http_parser_t* parser, size_t a_size) {
+    membuffer* msg;
+    uintptr_t old_base;
+
+    assert(parser != NULL);
+
+    msg = &parser->msg.msg;
+    old_base = reinterpret_cast<uintptr_t>(msg->buf);
+    if (parser->position == POS_ENTITY &&
+        parser->ent_position == ENTREAD_USING_CLEN) {
+        /* the size of the message is known; don't allocate more */
+        if (membuffer_reserve(msg, msg->length + a_size) != 0)
+            return nullptr;
+    } else if (membuffer_set_size(msg, msg->length + a_size) != 0)
+        return nullptr;
+    if (parser->header_slices &&
+        reinterpret_cast<uintptr_t>(msg->buf) != old_base) {
+        /* raw message has moved */
+        httpmsg_rebase_header_slices(&parser->msg, old_base);
+    }
+
+    return msg->buf + msg->length;
+}
+
+
+parse_status_t parser_append_commit(http_parser_t* parser, size_t buf_length) {
+    membuffer* msg;
+    size_t old_length;
+
+    assert(parser != NULL);
+
+    msg = &parser->msg.msg;
+    if (msg->buf == nullptr || buf_length > msg->capacity - msg->length) {
+        /* nothing reserved */
+        parser->http_error_code = HTTP_INTERNAL_SERVER_ERROR;
+        return PARSE_FAILURE;
+    }
+    old_length = msg->length;
+    msg->length += buf_length;
+    msg->buf[msg->length] = '\0'; /* null-terminate */
 
-    return parser_parse(parser);
+    return parser_parse_appended(parser, old_length);
 }
 
 
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-08-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -44,6 +44,7 @@
 #include <upnplib/global.hpp>
 #include <upnplib/synclog.hpp>
 #include <upnplib/sockaddr.hpp>
+#include <upnplib/socket.hpp>
 
 #include <UpnpExtraHeaders.hpp>
 #include <UpnpIntTypes.hpp>
@@ -52,9 +53,15 @@
 #include <webserver.hpp>
 
 /// \cond
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <charconv>
 #include <cstdarg>
 #include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
 /// \endcond
 
 #ifdef _WIN32
@@ -64,6 +71,7 @@
 #define fseeko fseek
 #else /* _WIN32 */
 /// \cond
+#include <poll.h>
 #include <sys/utsname.h>
 #if defined(__ANDROID__) &&                                                    \
     (!defined(__USE_FILE_OFFSET64) || __ANDROID_API__ < 24)
@@ -92,6 +100,12 @@ constexpr size_t CHUNK_TAIL_SIZE{10};
  */
 constexpr time_t DEFAULT_TCP_CONNECT_TIMEOUT{5};
 
+/*! \brief Initial size of a socket read by http_RecvMessage().
+ * \details It is doubled each time a read fills it. */
+constexpr size_t RECV_MESSAGE_MIN_READ{1024};
+/// \brief Maximal size of a socket read by http_RecvMessage().
+constexpr size_t RECV_MESSAGE_MAX_READ{64 * 1024};
+
 
 /*! \name Scope restricted to file
  * @{
@@ -485,6 +499,220 @@ int MakeGetMessageEx(const char* url_str, membuffer* request, uri_type* url,
     return ret_code;
 }
 
+/*! \name Client connection pool
+ * Idle keep-alive connections of http_RequestAndResponse(), keyed by scheme
+ * and remote address.
+ * @{
+ */
+/// \brief Seconds an idle pooled connection is kept before it is evicted.
+constexpr time_t CONN_POOL_IDLE_TIMEOUT{30};
+/// \brief Maximal number of idle connections to one remote address.
+constexpr size_t CONN_POOL_MAX_IDLE_PER_KEY{4};
+/// \brief Maximal number of idle connections over all remote addresses.
+constexpr size_t CONN_POOL_MAX_IDLE{32};
+
+/// \brief Idle connection in the pool.
+struct pooled_conn_t {
+    std::string key;  ///< Scheme and remote address of the connection.
+    SOCKET sock;      ///< Connected socket.
+    time_t idle_since; ///< Time the connection was put back into the pool.
+};
+
+/// \brief Idle connections, the most recently used at the end.
+std::vector<pooled_conn_t> gConnPool;
+/// \brief Counters of the connection pool.
+HttpConnPoolStats gConnPoolStats{};
+/// \brief Mutex to protect the connection pool and its counters.
+std::mutex gConnPoolMutex;
+
+/*!
+ * \brief Close a socket that is no longer used by the pool.
+ */
+void conn_pool_close(SOCKET a_sock) {
+    SOCKINFO info;
+    if (sock_init(&info, a_sock) == UPNP_E_SUCCESS)
+        sock_destroy(&info, SD_BOTH);
+}
+
+/*!
+ * \brief Get the pool key of a destination.
+ *
+ * \returns Scheme and remote address, e.g. "http://[2001:db8::1]:80".
+ */
+std::string conn_pool_key(
+    /*! [in] Destination with resolved IP address. */
+    uri_type* a_destination) {
+    std::string key(a_destination->scheme.buff, a_destination->scheme.size);
+    std::transform(key.begin(), key.end(), key.begin(),
+                   [](unsigned char c) { return (char)std::tolower(c); });
+    return key + "://" + upnplib::to_netaddrp(&a_destination->hostport.IPaddress);
+}
+
+/*!
+ * \brief Check if an idle connection was closed or written to by the remote
+ * node.
+ *
+ * A keep-alive connection never gets data while it is idle, so any readable
+ * event is a close or garbage.
+ *
+ * \returns true if the connection must not be reused.
+ */
+bool conn_pool_is_stale(SOCKET a_sock) {
+    // poll() is used because the descriptor may exceed FD_SETSIZE.
+    pollfd fds{a_sock, POLLIN, 0};
+#ifdef _WIN32
+    return WSAPoll(&fds, 1, 0) != 0;
+#else
+    return poll(&fds, 1, 0) != 0;
+#endif
+}
+
+/*!
+ * \brief Check if a request method can be repeated without side effects.
+ */
+bool method_is_idempotent(http_method_t a_method) {
+    return a_method == HTTPMETHOD_GET || a_method == HTTPMETHOD_HEAD ||
+           a_method == HTTPMETHOD_SIMPLEGET;
+}
+
+/*!
+ * \brief Take an idle connection to a remote address out of the pool.
+ *
+ * Expired and stale connections found on the way are closed.
+ *
+ * \returns Connected socket or INVALID_SOCKET if there is none.
+ */
+SOCKET conn_pool_get(const std::string& a_key) {
+    std::vector<SOCKET> expired;
+    SOCKET sock{INVALID_SOCKET};
+    {
+        const time_t now{time(nullptr)};
+        std::scoped_lock lock(gConnPoolMutex);
+        for (auto it = gConnPool.begin(); it != gConnPool.end();) {
+            if (now - it->idle_since > CONN_POOL_IDLE_TIMEOUT) {
+                expired.push_back(it->sock);
+                it = gConnPool.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        // Prefer the most recently used connection.
+        for (auto it = gConnPool.rbegin(); it != gConnPool.rend(); ++it) {
+            if (it->key == a_key) {
+                sock = it->sock;
+                gConnPool.erase(std::next(it).base());
+                break;
+            }
+        }
+        gConnPoolStats.evicted += expired.size();
+        gConnPoolStats.idle = gConnPool.size();
+    }
+    for (SOCKET s : expired)
+        conn_pool_close(s);
+
+    if (sock != INVALID_SOCKET && conn_pool_is_stale(sock)) {
+        UPNPLIB_LOGINFO "MSG1122: discard stale pooled connection to \""
+            << a_key << "\".\n";
+        conn_pool_close(sock);
+        std::scoped_lock lock(gConnPoolMutex);
+        gConnPoolStats.evicted++;
+        return INVALID_SOCKET;
+    }
+    return sock;
+}
+
+/*!
+ * \brief Put a connection that is idle now back into the pool.
+ *
+ * If the pool is full the least recently used connection is closed.
+ */
+void conn_pool_put(const std::string& a_key, SOCKET a_sock) {
+    std::vector<SOCKET> evicted;
+    {
+        std::scoped_lock lock(gConnPoolMutex);
+        size_t num_key{};
+        for (const pooled_conn_t& conn : gConnPool) {
+            if (conn.key == a_key)
+                num_key++;
+        }
+        // Make room by closing the least recently used connections.
+        while (true) {
+            auto it = gConnPool.end();
+            if (num_key >= CONN_POOL_MAX_IDLE_PER_KEY) {
+                it = std::find_if(gConnPool.begin(), gConnPool.end(),
+                                  [&a_key](const pooled_conn_t& conn) {
+                                      return conn.key == a_key;
+                                  });
+                num_key--;
+            } else if (gConnPool.size() >= CONN_POOL_MAX_IDLE) {
+                it = gConnPool.begin();
+                if (it->key == a_key)
+                    num_key--;
+            } else {
+                break;
+            }
+            evicted.push_back(it->sock);
+            gConnPool.erase(it);
+        }
+        gConnPool.push_back({a_key, a_sock, time(nullptr)});
+        gConnPoolStats.evicted += evicted.size();
+        gConnPoolStats.idle = gConnPool.size();
+    }
+    for (SOCKET s : evicted)
+        conn_pool_close(s);
+}
+
+/*!
+ * \brief Check if a header value contains the token "close".
+ */
+bool has_close_token(const char* a_value, size_t a_length) {
+    constexpr char close_token[]{"close"};
+    const char* end = a_value + a_length;
+    return std::search(a_value, end, close_token,
+                       close_token + sizeof(close_token) - 1,
+                       [](char c1, char c2) {
+                           return std::tolower((unsigned char)c1) == c2;
+                       }) != end;
+}
+
+/*!
+ * \brief Check if a connection can be used for another request after a
+ * response.
+ *
+ * This is the case for HTTP/1.1 without "Connection: close" from either side
+ * and a response that is not delimited by closing the connection.
+ */
+bool conn_is_reusable(
+    /*! [in] Request that was sent. */
+    const char* a_request,
+    /*! [in] Length of the request. */
+    size_t a_request_length,
+    /*! [in] Response received on the connection. */
+    http_parser_t* a_response) {
+    http_message_t* msg = &a_response->msg;
+    if (msg->major_version != 1 || msg->minor_version < 1 ||
+        a_response->ent_position == ENTREAD_UNTIL_CLOSE)
+        return false;
+    const http_header_t* hdr = httpmsg_find_hdr_str(msg, "CONNECTION");
+    if (hdr != nullptr && has_close_token(hdr->value.buf, hdr->value.length))
+        return false;
+
+    // Only the header of the request is searched.
+    constexpr char hdr_end[]{"\r\n\r\n"};
+    const char* req_end = a_request + a_request_length;
+    req_end = std::search(a_request, req_end, hdr_end,
+                          hdr_end + sizeof(hdr_end) - 1);
+    constexpr char conn_hdr[]{"\nconnection:"};
+    const char* req_conn = std::search(
+        a_request, req_end, conn_hdr, conn_hdr + sizeof(conn_hdr) - 1,
+        [](char c1, char c2) { return std::tolower((unsigned char)c1) == c2; });
+    if (req_conn == req_end)
+        return true;
+    const char* eol = std::find(req_conn + 1, req_end, '\n');
+    return !has_close_token(req_conn, (size_t)(eol - req_conn));
+}
+/// @}
+
 /// @} // Functions (scope restricted to file)
 } // anonymous namespace
 
@@ -586,7 +814,10 @@ int http_FixUrl(uri_type* url, uri_type* fixed_url) {
 int http_FixStrUrl(const char* urlstr, size_t urlstrlen, uri_type* fixed_url) {
     uri_type url;
 
-    if (parse_uri(urlstr, urlstrlen, &url) != HTTP_SUCCESS) {
+    int ret_code = parse_uri(urlstr, urlstrlen, &url);
+    if (ret_code == UPNP_E_TRY_AGAIN) {
+        return ret_code;
+    } else if (ret_code != HTTP_SUCCESS) {
         return UPNP_E_INVALID_URL;
     }
 
@@ -637,14 +868,9 @@ int http_RecvMessage(SOCKINFO* info, http_parser_t* parser,
     int num_read{};
     int ok_on_close{};
     char* buf{nullptr};
-    size_t buf_len{1024};
+    size_t buf_len{RECV_MESSAGE_MIN_READ};
 
     *http_error_code = HTTP_INTERNAL_SERVER_ERROR;
-    buf = (char*)malloc(buf_len);
-    if (!buf) {
-        ret = UPNP_E_OUTOF_MEMORY;
-        goto ExitFunction;
-    }
     if (request_method == (http_method_t)HTTPMETHOD_UNKNOWN) {
         parser_request_init(parser);
     } else {
@@ -652,22 +878,32 @@ int http_RecvMessage(SOCKINFO* info, http_parser_t* parser,
     }
 
     while (1) {
-        /* Double the bet if needed */
-        /* We should have already exited the loop if the value was <= 0
-         * so the cast is safe */
+        /* Double the bet if the last read filled the buffer. We should have
+         * already exited the loop if the value was <= 0 so the cast is safe */
         if ((size_t)num_read >= buf_len) {
-            free(buf);
-            buf_len = 2 * buf_len;
-            buf = (char*)malloc(buf_len);
-            if (!buf) {
-                ret = UPNP_E_OUTOF_MEMORY;
-                goto ExitFunction;
-            }
+            buf_len = std::min(2 * buf_len, RECV_MESSAGE_MAX_READ);
+        }
+        /* Read the rest of a known entity at once. buf_len never exceeds
+         * RECV_MESSAGE_MAX_READ so it is the lower bound. */
+        if (parser->position == POS_ENTITY &&
+            parser->ent_position == ENTREAD_USING_CLEN &&
+            parser->entity_start_position + parser->content_length >
+                parser->msg.msg.length) {
+            const size_t rest{parser->entity_start_position +
+                              parser->content_length - parser->msg.msg.length};
+            buf_len = std::max(buf_len, std::min(rest, RECV_MESSAGE_MAX_READ));
+        }
+        /* Read directly into the message buffer of the parser. */
+        buf = parser_append_reserve(parser, buf_len);
+        if (!buf) {
+            line = __LINE__;
+            ret = UPNP_E_OUTOF_MEMORY;
+            goto ExitFunction;
         }
         num_read = sock_read(info, buf, buf_len, timeout_secs);
         if (num_read > 0) {
             /* got data */
-            status = parser_append(parser, buf, (size_t)num_read);
+            status = parser_append_commit(parser, (size_t)num_read);
             switch (status) {
             case PARSE_SUCCESS:
                 UPNPLIB_LOGINFO "MSG1031: <<< (RECVD) <<<\n"
@@ -725,7 +961,6 @@ int http_RecvMessage(SOCKINFO* info, http_parser_t* parser,
     }
 
 ExitFunction:
-    free(buf);
     if (ret != UPNP_E_SUCCESS) {
         UPNPLIB_LOGERR << "MSG1048: " << ret << " on line " << line
                        << ", http_error_code = " << *http_error_code << ".\n";
@@ -951,40 +1186,88 @@ int http_RequestAndResponse(uri_type* destination, const char* request,
     socklen_t sockaddr_len;
     int http_error_code;
     SOCKINFO info;
+    int timeout{timeout_secs};
+    upnplib::CSocketErr sockerrObj;
+    const std::string pool_key{conn_pool_key(destination)};
 
-    tcp_connection = umock::sys_socket_h.socket(
-        (int)destination->hostport.IPaddress.ss_family, SOCK_STREAM, 0);
-    if (tcp_connection == INVALID_SOCKET) {
-        parser_response_init(response, req_method);
-        return UPNP_E_SOCKET_ERROR;
+    tcp_connection = conn_pool_get(pool_key);
+    bool reused{tcp_connection != INVALID_SOCKET};
+
+new_connection:
+    if (!reused) {
+        tcp_connection = umock::sys_socket_h.socket(
+            (int)destination->hostport.IPaddress.ss_family, SOCK_STREAM, 0);
+        if (tcp_connection == INVALID_SOCKET) {
+            parser_response_init(response, req_method);
+            return UPNP_E_SOCKET_ERROR;
+        }
     }
     if (sock_init(&info, tcp_connection) != UPNP_E_SUCCESS) {
         parser_response_init(response, req_method);
         ret_code = UPNP_E_SOCKET_ERROR;
         goto end_function;
     }
-    /* connect */
-    sockaddr_len = destination->hostport.IPaddress.ss_family == AF_INET6
-                       ? sizeof(sockaddr_in6)
-                       : sizeof(sockaddr_in);
-    ret_code = umock::pupnp_httprw.private_connect(
-        info.socket, (sockaddr*)&(destination->hostport.IPaddress),
-        sockaddr_len);
-    if (ret_code == -1) {
-        parser_response_init(response, req_method);
-        ret_code = UPNP_E_SOCKET_CONNECT;
-        goto end_function;
+    if (!reused) {
+        /* connect */
+        sockaddr_len = destination->hostport.IPaddress.ss_family == AF_INET6
+                           ? sizeof(sockaddr_in6)
+                           : sizeof(sockaddr_in);
+        ret_code = umock::pupnp_httprw.private_connect(
+            info.socket, (sockaddr*)&(destination->hostport.IPaddress),
+            sockaddr_len);
+        if (ret_code == -1) {
+            parser_response_init(response, req_method);
+            ret_code = UPNP_E_SOCKET_CONNECT;
+            goto end_function;
+        }
     }
-    /* send request */
-    ret_code =
-        http_SendMessage(&info, &timeout_secs, "b", request, request_length);
-    if (ret_code != 0) {
+    {
+        std::scoped_lock lock(gConnPoolMutex);
+        if (reused)
+            gConnPoolStats.reused++;
+        else
+            gConnPoolStats.opened++;
+    }
+    /* send request, the error of the socket is needed for a retry */
+    ret_code = sock_write(&info, request, request_length, &timeout);
+    if (ret_code == UPNP_E_SOCKET_WRITE)
+        sockerrObj.catch_error();
+    else if (ret_code >= 0)
+        ret_code = (size_t)ret_code == request_length ? UPNP_E_SUCCESS
+                                                      : UPNP_E_SOCKET_WRITE;
+    if (ret_code != UPNP_E_SUCCESS) {
         parser_response_init(response, req_method);
-        goto end_function;
+    } else {
+        /* recv response */
+        ret_code = http_RecvMessage(&info, response, req_method, &timeout,
+                                    &http_error_code);
+    }
+    /* A pooled connection may have been closed by the remote node while it
+     * was idle. The request is only repeated if the remote node cannot have
+     * processed it: sending failed because the connection was already reset,
+     * or an idempotent request got the close before any response byte.
+     * A timeout is never retried. */
+    if (reused &&
+        (sockerrObj == ECONNRESETP || sockerrObj == EPIPEP ||
+         (ret_code == UPNP_E_BAD_HTTPMSG && response->msg.msg.length == 0 &&
+          method_is_idempotent(req_method)))) {
+        UPNPLIB_LOGINFO "MSG1123: pooled connection to \""
+            << pool_key << "\" failed, retry with a new connection.\n";
+        sock_destroy(&info, SD_BOTH);
+        httpmsg_destroy(&response->msg);
+        {
+            std::scoped_lock lock(gConnPoolMutex);
+            gConnPoolStats.retried++;
+        }
+        reused = false;
+        timeout = timeout_secs;
+        goto new_connection;
+    }
+    if (ret_code == UPNP_E_SUCCESS &&
+        conn_is_reusable(request, request_length, response)) {
+        conn_pool_put(pool_key, info.socket);
+        return ret_code;
     }
-    /* recv response */
-    ret_code = http_RecvMessage(&info, response, req_method, &timeout_secs,
-                                &http_error_code);
 
 end_function:
     /* should shutdown completely */
@@ -993,6 +1276,23 @@ end_function:
     return ret_code;
 }
 
+void http_GetConnPoolStats(HttpConnPoolStats* stats) {
+    std::scoped_lock lock(gConnPoolMutex);
+    *stats = gConnPoolStats;
+}
+
+void http_ClearConnPool() {
+    std::vector<pooled_conn_t> pool;
+    {
+        std::scoped_lock lock(gConnPoolMutex);
+        pool.swap(gConnPool);
+        gConnPoolStats.evicted += pool.size();
+        gConnPoolStats.idle = 0;
+    }
+    for (const pooled_conn_t& conn : pool)
+        conn_pool_close(conn.sock);
+}
+
 
 int http_Download(const char* url_str, int timeout_secs, char** document,
                   size_t* doc_length, char* content_type) {
@@ -1028,7 +1328,7 @@ int http_Download(const char* url_str, int timeout_secs, char** document,
     ret_code = http_MakeMessage(&request, 1, 1,
                                 "Q"
                                 "s"
-                                "bcDCUc",
+                                "bcDUc",
                                 HTTPMETHOD_GET, url.pathquery.buff,
                                 url.pathquery.size, "HOST: ", hoststr, hostlen);
     if (ret_code != 0) {
@@ -1175,7 +1475,9 @@ int http_OpenHttpConnection(const char* url_str, void** Handle,
 #ifdef UPNP_ENABLE_OPEN_SSL
     /* For HTTPS connections start the TLS/SSL handshake. */
     if (token_string_casecmp(&url.scheme, "https") == 0) {
-        ret_code = sock_ssl_connect(&handle->sock_info);
+        const std::string hostport(url.hostport.text.buff,
+                                   url.hostport.text.size);
+        ret_code = sock_ssl_connect(&handle->sock_info, hostport.c_str());
         if (ret_code != UPNP_E_SUCCESS) {
             sock_destroy(&handle->sock_info, SD_BOTH);
             goto errorHandler;
@@ -1470,266 +1772,411 @@ int http_SendStatusResponse(SOCKINFO* info, int http_status_code,
 std::string web_server_content_language{WEB_SERVER_CONTENT_LANGUAGE};
 /// \endcond
 
-int http_MakeMessage(membuffer* buf, int http_major_version,
-                     int http_minor_version, const char* fmt, ...) {
-    // For format types look at the declaration of http_MakeMessage() in the
-    // header file httpreadwrite.hpp.
-    TRACE("Executing http_MakeMessage()")
+namespace {
+
+/*! \name Message builder of http_MakeMessage()
+ * @{
+ */
+/// \brief Server information for the SERVER and USER-AGENT header.
+std::string gSdkInfo;
+
+/// \brief Date formatted for the last second used on a thread.
+struct date_cache_t {
+    time_t time{};   ///< Time of the formatted date.
+    char str[40]{};  ///< Date in RFC 1123 format.
+    size_t length{}; ///< Length of the date, 0 if not formatted.
+};
+/// \brief Date cache of the calling thread.
+thread_local date_cache_t tDateCache;
+
+/*!
+ * \brief Get a date in RFC 1123 format, e.g. "Sun, 05 Feb 2023 20:16:21 GMT".
+ *
+ * The date is only formatted if the second differs from the last call on
+ * this thread.
+ *
+ * \returns
+ *  On success: Pointer to the date, its length is returned in a_length.\n
+ *  On error: nullptr
+ */
+const char* get_date_str(
+    /// [in] Seconds since the Epoch.
+    const time_t a_time,
+    /// [out] Length of the date.
+    size_t& a_length) {
+    const char* weekday_str = "Sun\0Mon\0Tue\0Wed\0Thu\0Fri\0Sat";
+    const char* month_str = "Jan\0Feb\0Mar\0Apr\0May\0Jun\0"
+                            "Jul\0Aug\0Sep\0Oct\0Nov\0Dec";
+    date_cache_t& cache = tDateCache;
+
+    if (cache.length == 0 || cache.time != a_time) {
+        struct tm date_storage;
+        const struct tm* date = http_gmtime_r(&a_time, &date_storage);
+        if (date == nullptr)
+            return nullptr;
+        int rc = snprintf(cache.str, sizeof(cache.str),
+                          "%s, %02d %s %d %02d:%02d:%02d GMT",
+                          &weekday_str[date->tm_wday * 4], date->tm_mday,
+                          &month_str[date->tm_mon * 4], date->tm_year + 1900,
+                          date->tm_hour, date->tm_min, date->tm_sec);
+        if (rc < 0 || (size_t)rc >= sizeof(cache.str)) {
+            cache.length = 0;
+            return nullptr;
+        }
+        cache.time = a_time;
+        cache.length = (size_t)rc;
+    }
+    a_length = cache.length;
+    return cache.str;
+}
+
+/// \brief Values that are the same for all parts of one message.
+struct message_context_t {
+    int major;            ///< HTTP major version.
+    int minor;            ///< HTTP minor version.
+    time_t now;           ///< Time for the DATE header.
+    const char* sdk_info; ///< Server information, terminated with CRLF.
+};
+
+/*!
+ * \brief Writes the parts of a message into one block of memory.
+ *
+ * Without destination only the sizes of the parts are summed up. So the
+ * format can be walked twice, first to allocate the exact size and then to
+ * write the message.
+ */
+class CMessageBuilder {
+  public:
+    CMessageBuilder() = default;
+    /// \brief Write up to a_capacity bytes to a_dest.
+    CMessageBuilder(char* a_dest, size_t a_capacity)
+        : m_dest(a_dest), m_capacity(a_capacity) {}
+
+    /// \brief Returns true if the parts are written, false if only counted.
+    bool writing() const { return m_dest != nullptr; }
+
+    /// \brief Size of all parts added so far.
+    size_t size() const { return m_size; }
+
+    /// \brief Add a part with given length.
+    void add(const char* a_str, size_t a_length) {
+        // Never write beyond the destination, size() shows the mismatch.
+        if (m_dest != nullptr && m_size + a_length <= m_capacity)
+            memcpy(m_dest + m_size, a_str, a_length);
+        m_size += a_length;
+    }
+
+    /// \brief Add a null terminated part.
+    void add(const char* a_str) { add(a_str, strlen(a_str)); }
+
+    /// \brief Add a line end.
+    void add_crlf() { add("\r\n", (size_t)2); }
+
+    /// \brief Add a decimal number.
+    template <typename T> void add_num(T a_num) {
+        char numbuf[24];
+        std::to_chars_result res =
+            std::to_chars(numbuf, numbuf + sizeof(numbuf), a_num);
+        add(numbuf, (size_t)(res.ptr - numbuf));
+    }
+
+  private:
+    char* m_dest{nullptr};
+    size_t m_capacity{};
+    size_t m_size{};
+};
+
+/*!
+ * \brief Adds a request start line, e.g. "GET /foo/bar.html HTTP/1.1\r\n".
+ */
+void add_request_line(CMessageBuilder& a_out, const message_context_t& a_ctx,
+                      http_method_t a_method, const char* a_url,
+                      size_t a_url_len) {
+    a_out.add(method_to_str(a_method));
+    a_out.add(" ", (size_t)1);
+    a_out.add(a_url, a_url_len);
+    a_out.add(" HTTP/");
+    a_out.add_num(a_ctx.major);
+    a_out.add(".", (size_t)1);
+    a_out.add_num(a_ctx.minor);
+    a_out.add_crlf();
+}
+
+/*!
+ * \brief Adds the parts of a message as given by the format of
+ * http_MakeMessage().
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_MEMORY or UPNP_E_INVALID_URL
+ */
+int make_message_parts(
+    /// [in,out] Builder that gets the parts.
+    CMessageBuilder& a_out,
+    /// [in] Values shared by all parts.
+    const message_context_t& a_ctx,
+    /// [in] Pattern format.
+    const char* fmt,
+    /// [in] Arguments of the format.
+    va_list argp) {
     char c;
-    char* s = NULL;
-    size_t num;
-    off_t bignum;
+    const char* s;
     size_t length;
-    time_t* loc_time;
-    time_t curr_time;
-    struct tm date_storage;
-    struct tm* date;
-    const char* start_str;
-    const char* end_str;
+    off_t bignum;
     int status_code;
     const char* status_msg;
-    http_method_t method;
-    const char* method_str;
-    const char* url_str;
-    const char* temp_str;
+    const char* date;
     uri_type url;
     uri_type* uri_ptr;
-    int error_code = 0;
-    va_list argp;
-    char tempbuf[200];
-    const char* weekday_str = "Sun\0Mon\0Tue\0Wed\0Thu\0Fri\0Sat";
-    const char* month_str = "Jan\0Feb\0Mar\0Apr\0May\0Jun\0"
-                            "Jul\0Aug\0Sep\0Oct\0Nov\0Dec";
-    int rc = 0;
 
-    memset(tempbuf, 0, sizeof(tempbuf));
-    va_start(argp, fmt);
     while ((c = *fmt++) != 0) {
         if (c == 'E') {
             /* list of extra headers */
-            UpnpListIter pos;
-            UpnpListHead* head;
-            UpnpExtraHeaders* extra;
-            const DOMString resp;
-            head = (UpnpListHead*)va_arg(argp, UpnpListHead*);
+            UpnpListHead* head = (UpnpListHead*)va_arg(argp, UpnpListHead*);
             if (head) {
-                for (pos = UpnpListBegin(head); pos != UpnpListEnd(head);
-                     pos = UpnpListNext(head, pos)) {
-                    extra = (UpnpExtraHeaders*)pos;
-                    resp = UpnpExtraHeaders_get_resp(extra);
+                for (UpnpListIter pos = UpnpListBegin(head);
+                     pos != UpnpListEnd(head); pos = UpnpListNext(head, pos)) {
+                    const DOMString resp =
+                        UpnpExtraHeaders_get_resp((UpnpExtraHeaders*)pos);
                     if (resp) {
-                        if (membuffer_append(buf, resp, strlen(resp)))
-                            goto error_handler;
-                        if (membuffer_append(buf, "\r\n", (size_t)2))
-                            goto error_handler;
+                        a_out.add(resp);
+                        a_out.add_crlf();
                     }
                 }
             }
         } else if (c == 's') {
             /* C string */
-            s = (char*)va_arg(argp, char*);
+            s = (const char*)va_arg(argp, const char*);
             assert(s);
-            UpnpPrintf(UPNP_ALL, HTTP, __FILE__, __LINE__,
-                       "Adding a string : %s\n", s);
-            if (membuffer_append(buf, s, strlen(s)))
-                goto error_handler;
+            if (a_out.writing())
+                UpnpPrintf(UPNP_ALL, HTTP, __FILE__, __LINE__,
+                           "Adding a string : %s\n", s);
+            a_out.add(s);
         } else if (c == 'K') {
             /* Add Chunky header */
-            if (membuffer_append(buf, "TRANSFER-ENCODING: chunked\r\n",
-                                 strlen("Transfer-Encoding: chunked\r\n")))
-                goto error_handler;
+            a_out.add("TRANSFER-ENCODING: chunked\r\n");
         } else if (c == 'G') {
             /* Add Range header */
-            struct SendInstruction* RespInstr;
-            RespInstr =
-                (struct SendInstruction*)va_arg(argp, struct SendInstruction*);
+            SendInstruction* RespInstr =
+                (SendInstruction*)va_arg(argp, SendInstruction*);
             assert(RespInstr);
-            /* connection header */
-            if (membuffer_append(buf, RespInstr->RangeHeader,
-                                 strlen(RespInstr->RangeHeader)))
-                goto error_handler;
+            a_out.add(RespInstr->RangeHeader);
         } else if (c == 'b') {
             /* mem buffer */
-            s = (char*)va_arg(argp, char*);
-            UpnpPrintf(UPNP_ALL, HTTP, __FILE__, __LINE__,
-                       "Adding a char Buffer starting with: %c\n", (int)s[0]);
+            s = (const char*)va_arg(argp, const char*);
             assert(s);
             length = (size_t)va_arg(argp, size_t);
-            if (membuffer_append(buf, s, length))
-                goto error_handler;
+            if (a_out.writing())
+                UpnpPrintf(UPNP_ALL, HTTP, __FILE__, __LINE__,
+                           "Adding a char Buffer starting with: %c\n",
+                           (int)s[0]);
+            a_out.add(s, length);
         } else if (c == 'c') {
             /* crlf */
-            if (membuffer_append(buf, "\r\n", (size_t)2))
-                goto error_handler;
+            a_out.add_crlf();
         } else if (c == 'd') {
             /* integer */
-            num = (size_t)va_arg(argp, int);
-            rc = snprintf(tempbuf, sizeof(tempbuf), "%" PRIzu,
-                          (unsigned long)num);
-            if (rc < 0 || (unsigned int)rc >= sizeof(tempbuf) ||
-                membuffer_append(buf, tempbuf, strlen(tempbuf)))
-                goto error_handler;
+            a_out.add_num((size_t)va_arg(argp, int));
         } else if (c == 'h') {
             /* off_t */
-            bignum = (off_t)va_arg(argp, off_t);
-            rc =
-                snprintf(tempbuf, sizeof(tempbuf), "%" PRId64, (int64_t)bignum);
-            if (rc < 0 || (unsigned int)rc >= sizeof(tempbuf) ||
-                membuffer_append(buf, tempbuf, strlen(tempbuf)))
-                goto error_handler;
+            a_out.add_num((int64_t)va_arg(argp, off_t));
         } else if (c == 't' || c == 'D') {
             /* date */
+            time_t loc_time;
             if (c == 'D') {
-                /* header */
-                start_str = "DATE: ";
-                end_str = "\r\n";
-                curr_time = umock::sysinfo.time(NULL);
-                loc_time = &curr_time;
+                loc_time = a_ctx.now;
             } else {
-                /* date value only */
-                start_str = end_str = "";
-                loc_time = (time_t*)va_arg(argp, time_t*);
+                const time_t* time_ptr = (const time_t*)va_arg(argp, time_t*);
+                assert(time_ptr);
+                loc_time = *time_ptr;
             }
-            assert(loc_time);
-            date = http_gmtime_r(loc_time, &date_storage);
-            if (date == NULL)
-                goto error_handler;
-            rc = snprintf(tempbuf, sizeof(tempbuf),
-                          "%s%s, %02d %s %d %02d:%02d:%02d GMT%s", start_str,
-                          &weekday_str[date->tm_wday * 4], date->tm_mday,
-                          &month_str[date->tm_mon * 4], date->tm_year + 1900,
-                          date->tm_hour, date->tm_min, date->tm_sec, end_str);
-            if (rc < 0 || (unsigned int)rc >= sizeof(tempbuf) ||
-                membuffer_append(buf, tempbuf, strlen(tempbuf)))
-                goto error_handler;
+            date = get_date_str(loc_time, length);
+            if (date == nullptr)
+                return UPNP_E_OUTOF_MEMORY;
+            if (c == 'D')
+                a_out.add("DATE: ");
+            a_out.add(date, length);
+            if (c == 'D')
+                a_out.add_crlf();
         } else if (c == 'L') {
             // Add CONTENT-LANGUAGE header only
             // if Accept-Language header is not empty
             // and
             // if web_server_content_language (aka WEB_SERVER_CONTENT_LANGUAGE)
             //    is not empty
-            SendInstruction* RespInstr;
-            RespInstr = (SendInstruction*)va_arg(argp, SendInstruction*);
+            SendInstruction* RespInstr =
+                (SendInstruction*)va_arg(argp, SendInstruction*);
             assert(RespInstr);
-            if ((bool)strcmp(RespInstr->AcceptLanguageHeader, "") &&
-                !web_server_content_language.empty() &&
-                (bool)http_MakeMessage(
-                    buf, http_major_version, http_minor_version, "ssc",
-                    "CONTENT-LANGUAGE: ",
-                    web_server_content_language.c_str()) != 0)
-                goto error_handler;
+            if (RespInstr->AcceptLanguageHeader[0] != '\0' &&
+                !web_server_content_language.empty()) {
+                a_out.add("CONTENT-LANGUAGE: ");
+                a_out.add(web_server_content_language.data(),
+                          web_server_content_language.size());
+                a_out.add_crlf();
+            }
         } else if (c == 'C') {
-            if ((http_major_version > 1) ||
-                (http_major_version == 1 && http_minor_version == 1)) {
+            if ((a_ctx.major > 1) || (a_ctx.major == 1 && a_ctx.minor == 1)) {
                 /* connection header */
-                if (membuffer_append_str(buf, "CONNECTION: close\r\n"))
-                    goto error_handler;
+                a_out.add("CONNECTION: close\r\n");
             }
         } else if (c == 'N') {
             /* content-length header */
             bignum = (off_t)va_arg(argp, off_t);
             assert(bignum >= 0);
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "shc", "CONTENT-LENGTH: ", bignum) != 0)
-                goto error_handler;
+            a_out.add("CONTENT-LENGTH: ");
+            a_out.add_num((int64_t)bignum);
             /* Add accept ranges */
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "sc", "Accept-Ranges: bytes") != 0)
-                goto error_handler;
+            a_out.add("\r\nAccept-Ranges: bytes\r\n");
         } else if (c == 'S' || c == 'U') {
             /* SERVER or USER-AGENT header */
-            temp_str = (c == 'S') ? "SERVER: " : "USER-AGENT: ";
-            get_sdk_info(tempbuf, sizeof(tempbuf));
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "ss", temp_str, tempbuf) != 0)
-                goto error_handler;
+            a_out.add((c == 'S') ? "SERVER: " : "USER-AGENT: ");
+            a_out.add(a_ctx.sdk_info);
         } else if (c == 'X') {
             /* C string */
-            s = (char*)va_arg(argp, char*);
+            s = (const char*)va_arg(argp, const char*);
             assert(s);
-            if (membuffer_append_str(buf, "X-User-Agent: ") != 0)
-                goto error_handler;
-            if (membuffer_append(buf, s, strlen(s)) != 0)
-                goto error_handler;
+            a_out.add("X-User-Agent: ");
+            a_out.add(s);
         } else if (c == 'R') {
             /* response start line */
             /*   e.g.: 'HTTP/1.1 200 OK' code */
             status_code = (int)va_arg(argp, int);
             assert(status_code > 0);
-            rc = snprintf(tempbuf, sizeof(tempbuf), "HTTP/%d.%d %d ",
-                          http_major_version, http_minor_version, status_code);
-            /* str */
             status_msg = http_get_code_text(status_code);
-            if (rc < 0 || (unsigned int)rc >= sizeof(tempbuf) ||
-                http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "ssc", tempbuf, status_msg) != 0)
-                goto error_handler;
+            assert(status_msg);
+            a_out.add("HTTP/");
+            a_out.add_num(a_ctx.major);
+            a_out.add(".", (size_t)1);
+            a_out.add_num(a_ctx.minor);
+            a_out.add(" ", (size_t)1);
+            a_out.add_num(status_code);
+            a_out.add(" ", (size_t)1);
+            a_out.add(status_msg);
+            a_out.add_crlf();
         } else if (c == 'B') {
             /* body of a simple reply */
+            constexpr char body_start[]{"<html><body><h1>"};
+            constexpr char body_end[]{"</h1></body></html>"};
+            char codebuf[12];
             status_code = (int)va_arg(argp, int);
-            rc = snprintf(tempbuf, sizeof(tempbuf), "%s%d %s%s",
-                          "<html><body><h1>", status_code,
-                          http_get_code_text(status_code),
-                          "</h1></body></html>");
-            if (rc < 0 || (unsigned int)rc >= sizeof(tempbuf))
-                goto error_handler;
-            bignum = (off_t)strlen(tempbuf);
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "NTcs", bignum, /* content-length */
-                                 "text/html",    /* content-type */
-                                 tempbuf) != 0   /* body */
-            )
-                goto error_handler;
+            status_msg = http_get_code_text(status_code);
+            if (status_msg == nullptr)
+                status_msg = "";
+            const size_t code_len = (size_t)(
+                std::to_chars(codebuf, codebuf + sizeof(codebuf), status_code)
+                    .ptr -
+                codebuf);
+            /* content-length */
+            a_out.add("CONTENT-LENGTH: ");
+            a_out.add_num(sizeof(body_start) - 1 + code_len + 1 +
+                          strlen(status_msg) + sizeof(body_end) - 1);
+            a_out.add("\r\nAccept-Ranges: bytes\r\n");
+            /* content-type */
+            a_out.add("CONTENT-TYPE: text/html\r\n\r\n");
+            /* body */
+            a_out.add(body_start, sizeof(body_start) - 1);
+            a_out.add(codebuf, code_len);
+            a_out.add(" ", (size_t)1);
+            a_out.add(status_msg);
+            a_out.add(body_end, sizeof(body_end) - 1);
         } else if (c == 'Q') {
             /* request start line */
             /* GET /foo/bar.html HTTP/1.1\r\n */
-            method = (http_method_t)va_arg(argp, int);
-            method_str = method_to_str(method);
-            url_str = (const char*)va_arg(argp, const char*);
-            num = (size_t)va_arg(argp, size_t); /* length of url_str */
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "ssbsdsdc", method_str, /* method */
-                                 " ", url_str, num,      /* url */
-                                 " HTTP/", http_major_version, ".",
-                                 http_minor_version) != 0)
-                goto error_handler;
+            http_method_t method = (http_method_t)va_arg(argp, int);
+            s = (const char*)va_arg(argp, const char*);
+            length = (size_t)va_arg(argp, size_t); /* length of url_str */
+            add_request_line(a_out, a_ctx, method, s, length);
         } else if (c == 'q') {
             /* request start line and HOST header */
-            method = (http_method_t)va_arg(argp, int);
+            http_method_t method = (http_method_t)va_arg(argp, int);
             uri_ptr = (uri_type*)va_arg(argp, uri_type*);
             assert(uri_ptr);
-            if (http_FixUrl(uri_ptr, &url) != 0) {
-                error_code = UPNP_E_INVALID_URL;
-                goto error_handler;
-            }
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "Q"
-                                 "sbc",
-                                 method, url.pathquery.buff, url.pathquery.size,
-                                 "HOST: ", url.hostport.text.buff,
-                                 url.hostport.text.size) != 0)
-                goto error_handler;
+            if (http_FixUrl(uri_ptr, &url) != 0)
+                return UPNP_E_INVALID_URL;
+            add_request_line(a_out, a_ctx, method, url.pathquery.buff,
+                             url.pathquery.size);
+            a_out.add("HOST: ");
+            a_out.add(url.hostport.text.buff, url.hostport.text.size);
+            a_out.add_crlf();
         } else if (c == 'T') {
             /* content type header */
-            temp_str = (const char*)va_arg(
-                argp, const char*); /* type/subtype format */
-            if (http_MakeMessage(buf, http_major_version, http_minor_version,
-                                 "ssc", "CONTENT-TYPE: ", temp_str) != 0)
-                goto error_handler;
+            s = (const char*)va_arg(argp,
+                                    const char*); /* type/subtype format */
+            a_out.add("CONTENT-TYPE: ");
+            a_out.add(s);
+            a_out.add_crlf();
         } else {
             assert(0);
         }
     }
-    goto ExitFunction;
 
-error_handler:
-    /* Default is out of memory error. */
-    if (!error_code)
-        error_code = UPNP_E_OUTOF_MEMORY;
-    membuffer_destroy(buf);
+    return UPNP_E_SUCCESS;
+}
+/// @}
 
-ExitFunction:
+} // anonymous namespace
+
+void http_InitSdkInfo() {
+    char info[200];
+
+    get_sdk_info(info, sizeof(info));
+    gSdkInfo = info;
+}
+
+void http_ClearSdkInfo() { gSdkInfo.clear(); }
+
+int http_MakeMessage(membuffer* buf, int http_major_version,
+                     int http_minor_version, const char* fmt, ...) {
+    // For format types look at the declaration of http_MakeMessage() in the
+    // header file httpreadwrite.hpp.
+    TRACE("Executing http_MakeMessage()")
+    message_context_t ctx{http_major_version, http_minor_version, 0, ""};
+    char sdk_info[200];
+    CMessageBuilder sizer;
+    int error_code;
+    va_list argp;
+    va_list argp_write;
+
+    // Values that may change between both walks of the format are taken
+    // only once.
+    if (strchr(fmt, 'D') != nullptr)
+        ctx.now = umock::sysinfo.time(nullptr);
+    if (strpbrk(fmt, "SU") != nullptr) {
+        if (gSdkInfo.empty()) {
+            // Not initialized by UpnpInit2().
+            get_sdk_info(sdk_info, sizeof(sdk_info));
+            ctx.sdk_info = sdk_info;
+        } else {
+            ctx.sdk_info = gSdkInfo.c_str();
+        }
+    }
+
+    va_start(argp, fmt);
+    va_copy(argp_write, argp);
+    error_code = make_message_parts(sizer, ctx, fmt, argp);
+    if (error_code == UPNP_E_SUCCESS && sizer.size() > 0) {
+        /* Allocate a new message exactly, an appended one geometrically. */
+        if ((buf->length == 0)
+                ? membuffer_reserve(buf, sizer.size()) != 0
+                : membuffer_set_size(buf, buf->length + sizer.size()) != 0) {
+            error_code = UPNP_E_OUTOF_MEMORY;
+        } else {
+            CMessageBuilder writer(buf->buf + buf->length, sizer.size());
+            error_code = make_message_parts(writer, ctx, fmt, argp_write);
+            if (error_code == UPNP_E_SUCCESS && writer.size() != sizer.size())
+                error_code = UPNP_E_INTERNAL_ERROR;
+            if (error_code == UPNP_E_SUCCESS) {
+                buf->length += sizer.size();
+                buf->buf[buf->length] = '\0';
+            }
+        }
+    }
+    va_end(argp_write);
     va_end(argp);
+
+    if (error_code != UPNP_E_SUCCESS)
+        membuffer_destroy(buf);
+
     return error_code;
 }
 
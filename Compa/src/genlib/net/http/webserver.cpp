@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-04-17
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -62,7 +62,14 @@
 #endif
 
 /// \cond
+#include <atomic>
 #include <cassert>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <string_view>
 #include <sys/stat.h>
 #include <iostream>
 /// \endcond
@@ -96,175 +103,87 @@ constexpr size_t APPLICATION_INDEX{4};
 constexpr size_t ASCTIME_R_BUFFER_SIZE{26};
 
 
-/// \brief Mutex to protect managing an XML document.
-pthread_mutex_t gWebMutex;
-
-/*! \brief Alias directory structure on the webserver for an XML document. */
-struct xml_alias_t {
-  public:
-    /*! name of DOC from root; e.g.: /foo/bar/mydesc.xml */
-    membuffer name{};
-    /*! the XML document contents. */
-    membuffer doc{};
-    /*! Last modified time. */
-    time_t last_modified{};
-    /*! pointer to ct, only for downstream compatibility. */
-    int* ct{nullptr}; // to be compatible; will be initialized with this->set()
-                      // int* ct{&m_ct};
-  private:
-    int m_ct{};
-
+/*!
+ * \brief Pointer to an immutable object that is only replaced as a whole.
+ *
+ * Requests take a reference to the current object without waiting for a
+ * writer. A replaced object lives until the last request has dropped it.
+ */
+template <typename T> class CSnapshot {
   public:
-    // Constructor
-    xml_alias_t() {
-        TRACE2(this, " Construct xml_alias_t()");
-        this->name.size_inc = 5;
-        this->doc.size_inc = 5;
-    }
-
-    // Destructor
-    ~xml_alias_t() {
-        TRACE2(this, " Destruct xml_alias_t()");
-        /// \todo Free possible allocated membuffer will segfault. Fix it.
-        // this->clear();
-    }
-
-    /// \brief Copy constructor.
-    xml_alias_t(const xml_alias_t& that) {
-        TRACE2(this, " Executing xml_alias_t copy constructor()");
-        int mutex_err = pthread_mutex_trylock(&gWebMutex);
-        this->name = that.name;
-        this->doc = that.doc;
-        this->last_modified = that.last_modified;
-        this->m_ct = that.m_ct;
-        this->ct = (that.ct == nullptr) ? nullptr : &m_ct;
-        if (mutex_err == 0)
-            pthread_mutex_unlock(&gWebMutex);
+    /// \brief Get the current object, nullptr if there is none.
+    std::shared_ptr<const T> load() const {
+#ifdef __cpp_lib_atomic_shared_ptr
+        return m_ptr.load(std::memory_order_acquire);
+#else
+        std::scoped_lock lock(m_mutex);
+        return m_ptr;
+#endif
     }
 
-    /// \brief Copy assignment operator.
-    xml_alias_t& operator=(xml_alias_t that) {
-        TRACE2(this, " Executing xml_alias_t assignment operator=");
-        // No need to protect with a mutex. This swapping from the stack is
-        // thread safe.
-        std::swap(this->name, that.name);
-        std::swap(this->doc, that.doc);
-        std::swap(this->last_modified, that.last_modified);
-        std::swap(this->m_ct, that.m_ct);
-        this->ct = (that.ct == nullptr) ? nullptr : &m_ct;
-
-        // by convention, always return *this
-        return *this;
+    /// \brief Replace the current object.
+    void store(std::shared_ptr<const T> a_obj) {
+#ifdef __cpp_lib_atomic_shared_ptr
+        m_ptr.store(std::move(a_obj), std::memory_order_release);
+#else
+        std::scoped_lock lock(m_mutex);
+        m_ptr.swap(a_obj);
+#endif
     }
 
-    /// \brief Set an XML Document.
-    int set(const char* a_alias_name, const char* a_alias_content,
-            size_t a_alias_content_length,
-            time_t a_last_modified = time(nullptr)) {
-        TRACE2(this, " Executing xml_alias_t::set()");
-
-        if (a_alias_content == nullptr ||
-            (a_alias_name != nullptr && a_alias_content == this->doc.buf)) {
-            TRACE2(this, " Return xml_alias_t::set() with "
-                         "UPNP_E_INVALID_ARGUMENT");
-            return UPNP_E_INVALID_ARGUMENT;
-        }
-
-        this->release();
-
-        if (a_alias_name == nullptr) {
-            /* don't serve aliased doc anymore */
-            return UPNP_E_SUCCESS;
-        }
+  private:
+#ifdef __cpp_lib_atomic_shared_ptr
+    std::atomic<std::shared_ptr<const T>> m_ptr;
+#else
+    // Only held to copy the pointer.
+    mutable std::mutex m_mutex;
+    std::shared_ptr<const T> m_ptr;
+#endif
+};
 
-        membuffer tmp_name{};
-        tmp_name.size_inc = MEMBUF_DEF_SIZE_INC;
-        membuffer tmp_doc{};
-        tmp_doc.size_inc = MEMBUF_DEF_SIZE_INC;
-
-        do {
-            /* insert leading /, if missing */
-            if (*a_alias_name != '/')
-                if (membuffer_assign_str(&tmp_name, "/") != 0)
-                    break; /* error; out of mem */
-            if (membuffer_append_str(&tmp_name, a_alias_name) != 0)
-                break; /* error */
-            // a_alias_content_length must never exceed length of
-            // a_alias_content.
-            size_t content_len = strlen(a_alias_content);
-            size_t doc_len = a_alias_content_length < content_len
-                                 ? a_alias_content_length
-                                 : content_len;
-            membuffer_attach(&tmp_doc, (char*)a_alias_content, doc_len);
-            tmp_doc.buf[doc_len] = '\0';
-            // No errors, set properties
-            TRACE("  set: allocate membuffer name");
-            this->name = tmp_name;
-            TRACE("  set: allocate membuffer doc");
-            this->doc = tmp_doc;
-            this->last_modified = a_last_modified;
-            m_ct = 1;
-            this->ct = &m_ct;
-
-            return UPNP_E_SUCCESS;
-        } while (0); // Seems the "loop" is only used to have breaks.
-        /* error handler */
-        /* free temp vars */
-        TRACE("  set: already allocated membuffer name freed due to error");
-        membuffer_destroy(&tmp_name);
-        TRACE("  set: already allocated membuffer doc freed due to error");
-        membuffer_destroy(&tmp_doc);
-
-        TRACE2(this, " Return xml_alias_t::set() with "
-                     "UPNP_E_OUTOF_MEMORY");
-        return UPNP_E_OUTOF_MEMORY;
-    }
+/*!
+ * \brief XML document that is served to requests.
+ *
+ * It takes over the buffer of the registered document and frees it when the
+ * last request has dropped it.
+ */
+struct alias_snapshot_t {
+    /*! name of DOC from root; e.g.: /foo/bar/mydesc.xml */
+    std::string name;
+    /*! the XML document contents, points into the taken over buffer. */
+    std::string_view doc;
+    /*! Last modified time. */
+    time_t last_modified{};
 
-    /// \brief Returns if the XML object contains a valid XML document.
-    bool is_valid() const { return m_ct > 0; }
-
-    /// \brief Release an XML document from the XML object.
-    void release() {
-        TRACE2(this, " Executing xml_alias_t::release()");
-        int mutex_err = pthread_mutex_trylock(&gWebMutex);
-        /* ignore invalid alias */
-        if (m_ct > 0) {
-            m_ct--;
-            if (m_ct <= 0) {
-                this->clear();
-            } else {
-                TRACE("  release: nothing released, more than one time "
-                      "requested");
-            }
-        } else {
-            TRACE("  release: nothing to release");
-        }
-        if (mutex_err == 0)
-            pthread_mutex_unlock(&gWebMutex);
+    alias_snapshot_t() = default;
+    alias_snapshot_t(const alias_snapshot_t&) = delete;
+    alias_snapshot_t& operator=(const alias_snapshot_t&) = delete;
+    ~alias_snapshot_t() {
+        TRACE2(this, " Destruct alias_snapshot_t()");
+        umock::stdlib_h.free(const_cast<char*>(this->doc.data()));
     }
+};
 
-    /// \brief Clear the XML object.
-    void clear() {
-        TRACE2(this, " Executing xml_alias_t::clear()");
-        int mutex_err = pthread_mutex_trylock(&gWebMutex);
-        if (this->name.buf != nullptr) {
-            TRACE("  clear: destroy membuffer name");
-            membuffer_destroy(&this->name);
-        }
-        if (this->doc.buf != nullptr) {
-            TRACE("  clear: destroy membuffer doc");
-            membuffer_destroy(&this->doc);
-        }
-        this->last_modified = 0;
-        this->ct = nullptr;
-        m_ct = 0;
-        if (mutex_err == 0)
-            pthread_mutex_unlock(&gWebMutex);
-    }
+/*! \brief The XML document as served, nullptr if there is none. */
+CSnapshot<alias_snapshot_t> gAliasSnapshot;
+
+/*! \brief Node of the prefix tree of virtual directory names. */
+struct vdir_node_t {
+    /*! Nodes of the next character of directory names. */
+    std::map<char, std::unique_ptr<vdir_node_t>> children;
+    /*! A virtual directory name ends here. */
+    bool is_dir{false};
+    /*! The directory name ends with '/'. */
+    bool slash_end{false};
+    /*! Position in pVirtualDirList; the first directory that matches wins.
+     */
+    size_t order{};
+    /*! Cookie registered with the virtual directory. */
+    const void* cookie{nullptr};
 };
 
-/*! \brief XML document object. */
-xml_alias_t gAliasDoc;
+/*! \brief Virtual directories as served, nullptr if there are none. */
+CSnapshot<vdir_node_t> gVirtualDirs;
 
 
 /*! \name Scope restricted to file
@@ -383,46 +302,11 @@ UPNP_INLINE int get_content_type(
 }
 
 /*!
- * \brief Initialize the global XML document. Allocate buffers for the XML
- * document.
+ * \brief Initialize the global XML document. No document is served then.
  */
 UPNP_INLINE void glob_alias_init() {
     TRACE("Executing glob_alias_init()")
-    gAliasDoc.clear();
-}
-
-/*!
- * \brief Copy the contents of the global XML document into the local output
- * parameter.
- */
-void alias_grab(
-    /*! [out] XML alias object. */
-    xml_alias_t* a_alias) {
-    TRACE("Executing alias_grab()")
-    int mutex_err = pthread_mutex_trylock(&gWebMutex);
-    if (a_alias != nullptr) {
-        TRACE("  alias_grab: copy struct gAliasDoc");
-        *a_alias = gAliasDoc;
-        if (a_alias->ct != nullptr)
-            *a_alias->ct = *a_alias->ct + 1;
-    } else {
-        TRACE("  alias_grab: nothing copied to nullptr");
-    }
-    if (mutex_err == 0)
-        pthread_mutex_unlock(&gWebMutex);
-}
-
-/*!
- * \brief Release the XML document referred to by the input parameter.
- *
- * Free the allocated buffers associated with this object.
- */
-void alias_release(
-    /*! [in] XML alias object. */
-    xml_alias_t* a_alias) {
-    TRACE("Executing alias_release()");
-    if (a_alias != nullptr)
-        a_alias->release();
+    gAliasSnapshot.store(nullptr);
 }
 
 /*!
@@ -508,14 +392,14 @@ exit_function:
 UPNP_INLINE int get_alias(
     /*! [in] request file passed in to be compared with. */
     const char* request_file,
-    /*! [out] xml alias object which has a file name stored. */
-    struct xml_alias_t* alias,
+    /*! [in] xml alias object which has a file name stored. */
+    const alias_snapshot_t* alias,
     /*! [out] File information object which will be filled up if the file
      * comparison succeeds. */
     UpnpFileInfo* info) {
-    int cmp = strcmp(alias->name.buf, request_file);
+    int cmp = strcmp(alias->name.c_str(), request_file);
     if (cmp == 0) {
-        UpnpFileInfo_set_FileLength(info, (off_t)alias->doc.length);
+        UpnpFileInfo_set_FileLength(info, (off_t)alias->doc.size());
         UpnpFileInfo_set_IsDirectory(info, 0);
         UpnpFileInfo_set_IsReadable(info, 1);
         UpnpFileInfo_set_LastModified(info, alias->last_modified);
@@ -528,6 +412,9 @@ UPNP_INLINE int get_alias(
  * \brief Compares filePath with paths from the list of virtual directory
  * lists.
  *
+ * The directory names are looked up in the prefix tree that is published by
+ * web_server_update_virtual_dirs(), so the path is read only once.
+ *
  * \return int.
  */
 int isFileInVirtualDir(
@@ -536,36 +423,27 @@ int isFileInVirtualDir(
     /*! [out] The cookie registered with this virtual directory, if matched.
      */
     const void** cookie) {
-    virtualDirList* pCurVirtualDir;
-    size_t webDirLen;
-
-    pCurVirtualDir = pVirtualDirList;
-    while (pCurVirtualDir != NULL) {
-        webDirLen = strlen(pCurVirtualDir->dirName);
-        if (webDirLen) {
-            if (pCurVirtualDir->dirName[webDirLen - 1] == '/') {
-                if (strncmp(pCurVirtualDir->dirName, filePath, webDirLen) ==
-                    0) {
-                    if (cookie != NULL)
-                        *cookie = pCurVirtualDir->cookie;
-                    return 1;
-                }
-            } else {
-                if (strncmp(pCurVirtualDir->dirName, filePath, webDirLen) ==
-                        0 &&
-                    (filePath[webDirLen] == '/' ||
-                     filePath[webDirLen] == '\0' ||
-                     filePath[webDirLen] == '?')) {
-                    if (cookie != NULL)
-                        *cookie = pCurVirtualDir->cookie;
-                    return 1;
-                }
-            }
-        }
-        pCurVirtualDir = pCurVirtualDir->next;
+    std::shared_ptr<const vdir_node_t> root = gVirtualDirs.load();
+    const vdir_node_t* node = root.get();
+    const vdir_node_t* found{nullptr};
+    const char* cursor = filePath;
+
+    while (node != nullptr) {
+        if (node->is_dir && (found == nullptr || node->order < found->order) &&
+            (node->slash_end || *cursor == '/' || *cursor == '\0' ||
+             *cursor == '?'))
+            found = node;
+        if (*cursor == '\0')
+            break;
+        auto child = node->children.find(*cursor++);
+        node = (child == node->children.end()) ? nullptr : child->second.get();
     }
+    if (found == nullptr)
+        return 0;
 
-    return 0;
+    if (cookie != NULL)
+        *cookie = found->cookie;
+    return 1;
 }
 
 /*!
@@ -1027,7 +905,7 @@ int process_request(
     /*! [out] Get filename from request document. */
     membuffer* filename,
     /*! [out] Xml alias document from the request document. */
-    struct xml_alias_t* alias,
+    std::shared_ptr<const alias_snapshot_t>& alias,
     /*! [out] Send Instruction object where the response is set up. */
     struct SendInstruction* RespInstr) {
     int code;
@@ -1042,7 +920,6 @@ int process_request(
     const char* temp_str;
     int resp_major;
     int resp_minor;
-    int alias_grabbed;
     size_t dummy;
     memptr hdr_value;
 
@@ -1055,7 +932,6 @@ int process_request(
     memset(&finfo, 0, sizeof(finfo));
     request_doc = NULL;
     finfo = UpnpFileInfo_new();
-    alias_grabbed = 0;
     err_code = HTTP_INTERNAL_SERVER_ERROR; /* default error */
     using_virtual_dir = 0;
     using_alias = 0;
@@ -1091,10 +967,9 @@ int process_request(
         }
     } else {
         /* try using alias */
-        if (gAliasDoc.is_valid()) {
-            alias_grab(alias);
-            alias_grabbed = 1;
-            using_alias = get_alias(request_doc, alias, finfo);
+        alias = gAliasSnapshot.load();
+        if (alias) {
+            using_alias = get_alias(request_doc, alias.get(), finfo);
             if (using_alias == 1) {
                 UpnpFileInfo_set_ContentType(finfo,
                                              "text/xml; charset=\"utf-8\"");
@@ -1360,8 +1235,8 @@ error_handler:
     FreeExtraHTTPHeaders(
         (UpnpListHead*)UpnpFileInfo_get_ExtraHeadersList(finfo));
     UpnpFileInfo_delete(finfo);
-    if (err_code != HTTP_OK && alias_grabbed) {
-        alias_release(alias);
+    if (err_code != HTTP_OK) {
+        alias.reset();
     }
 
     return err_code;
@@ -1510,9 +1385,11 @@ int web_server_init() {
     int ret = UPNP_E_SUCCESS;
 
     if (bWebServerState == WEB_SERVER_DISABLED) {
+        std::scoped_lock lock(gWebMutex);
         membuffer_init(&gDocumentRootDir);
         glob_alias_init();
         pVirtualDirList = NULL;
+        gVirtualDirs.store(nullptr);
 
         /* Initialize callbacks */
         virtualDirCallback.get_info = NULL;
@@ -1522,10 +1399,7 @@ int web_server_init() {
         virtualDirCallback.seek = NULL;
         virtualDirCallback.close = NULL;
 
-        if (pthread_mutex_init(&gWebMutex, NULL) == -1)
-            ret = UPNP_E_OUTOF_MEMORY;
-        else
-            bWebServerState = WEB_SERVER_ENABLED;
+        bWebServerState = WEB_SERVER_ENABLED;
     }
 
     return ret;
@@ -1534,8 +1408,73 @@ int web_server_init() {
 int web_server_set_alias(const char* alias_name, const char* alias_content,
                          size_t alias_content_length, time_t last_modified) {
     TRACE("Executing web_server_set_alias()")
-    return gAliasDoc.set(alias_name, alias_content, alias_content_length,
-                         last_modified);
+    std::scoped_lock lock(gWebMutex);
+
+    std::shared_ptr<const alias_snapshot_t> current = gAliasSnapshot.load();
+    if (alias_content == nullptr ||
+        (alias_name != nullptr && current != nullptr &&
+         alias_content == current->doc.data()))
+        return UPNP_E_INVALID_ARGUMENT;
+
+    /* the old document is released in any case */
+    gAliasSnapshot.store(nullptr);
+    if (alias_name == nullptr) {
+        /* don't serve aliased doc anymore */
+        return UPNP_E_SUCCESS;
+    }
+
+    try {
+        auto snapshot = std::make_shared<alias_snapshot_t>();
+        /* insert leading /, if missing */
+        if (*alias_name != '/')
+            snapshot->name = '/';
+        snapshot->name += alias_name;
+        snapshot->last_modified = last_modified;
+        // alias_content_length must never exceed length of alias_content.
+        size_t doc_len = strnlen(alias_content, alias_content_length);
+        const_cast<char*>(alias_content)[doc_len] = '\0';
+        // Takes over the buffer, so nothing may throw after this.
+        snapshot->doc = std::string_view(alias_content, doc_len);
+        gAliasSnapshot.store(std::move(snapshot));
+    } catch (const std::bad_alloc&) {
+        return UPNP_E_OUTOF_MEMORY;
+    }
+
+    return UPNP_E_SUCCESS;
+}
+
+int web_server_update_virtual_dirs() {
+    TRACE("Executing web_server_update_virtual_dirs()")
+    int ret = UPNP_E_SUCCESS;
+
+    try {
+        std::shared_ptr<vdir_node_t> root;
+        size_t order{0};
+        for (virtualDirList* pCur = pVirtualDirList; pCur != NULL;
+             pCur = pCur->next, order++) {
+            const char* dirName = pCur->dirName;
+            if (*dirName == '\0')
+                continue;
+            if (!root)
+                root = std::make_shared<vdir_node_t>();
+            vdir_node_t* node = root.get();
+            for (; *dirName != '\0'; dirName++) {
+                std::unique_ptr<vdir_node_t>& child = node->children[*dirName];
+                if (!child)
+                    child = std::make_unique<vdir_node_t>();
+                node = child.get();
+            }
+            node->is_dir = true;
+            node->slash_end = *(dirName - 1) == '/';
+            node->order = order;
+            node->cookie = pCur->cookie;
+        }
+        gVirtualDirs.store(std::move(root));
+    } catch (const std::bad_alloc&) {
+        ret = UPNP_E_OUTOF_MEMORY;
+    }
+
+    return ret;
 }
 
 int web_server_set_root_dir(const char* root_dir) {
@@ -1563,7 +1502,7 @@ void web_server_callback(http_parser_t* parser, /* INOUT */ http_message_t* req,
     enum resp_type rtype {};
     membuffer headers;
     membuffer filename;
-    struct xml_alias_t xmldoc;
+    std::shared_ptr<const alias_snapshot_t> xmldoc;
     struct SendInstruction RespInstr;
 
     /* init */
@@ -1573,7 +1512,7 @@ void web_server_callback(http_parser_t* parser, /* INOUT */ http_message_t* req,
 
     /* Process request should create the different kind of header depending
      * on the type of request. */
-    ret = process_request(info, req, &rtype, &headers, &filename, &xmldoc,
+    ret = process_request(info, req, &rtype, &headers, &filename, xmldoc,
                           &RespInstr);
     if (ret != HTTP_OK) {
         /* send error code */
@@ -1588,8 +1527,8 @@ void web_server_callback(http_parser_t* parser, /* INOUT */ http_message_t* req,
             break;
         case RESP_XMLDOC:
             http_SendMessage(info, &timeout, "Ibb", &RespInstr, headers.buf,
-                             headers.length, xmldoc.doc.buf, xmldoc.doc.length);
-            alias_release(&xmldoc);
+                             headers.length, xmldoc->doc.data(),
+                             xmldoc->doc.size());
             break;
         case RESP_WEBDOC:
             /*http_SendVirtualDirDoc(info, &timeout, "Ibf",
@@ -1631,13 +1570,10 @@ void SetHTTPGetCallback(MiniServerCallback callback) {
 void web_server_destroy() {
     if (bWebServerState == WEB_SERVER_ENABLED) {
         membuffer_destroy(&gDocumentRootDir);
-        alias_release(&gAliasDoc);
-
-        pthread_mutex_lock(&gWebMutex);
-        gAliasDoc.clear();
-        pthread_mutex_unlock(&gWebMutex);
 
-        pthread_mutex_destroy(&gWebMutex);
+        std::scoped_lock lock(gWebMutex);
+        gAliasSnapshot.store(nullptr);
+        gVirtualDirs.store(nullptr);
         bWebServerState = WEB_SERVER_DISABLED;
     }
 }
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-06-03
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -52,6 +52,10 @@
 /// \cond
 #include <fcntl.h> /* for F_GETFL, F_SETFL, O_NONBLOCK */
 #include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 /// \endcond
 
 
@@ -63,6 +67,33 @@ namespace {
  * Only this one is supported. With the given functions there is no way to use
  * more than this SSL Context. */
 SSL_CTX* gSslCtx{nullptr};
+
+/*! \brief Pointer to the SSL Context for incoming connections.
+ * \details If set, the miniserver only accepts TLS connections. */
+SSL_CTX* gSslServerCtx{nullptr};
+
+/*! \brief Maximal number of TLS client sessions that are cached.
+ * \details One session per requested host is cached. */
+constexpr size_t SSL_SESSION_CACHE_MAX{64};
+
+/// \brief Cached TLS client session with the host:port it was requested for.
+using ssl_session_entry = std::pair<std::string, SSL_SESSION*>;
+
+/*! \brief Cache of TLS client sessions to resume handshakes.
+ * \details The most recently used session is in front. The cache owns one
+ * reference of each session. */
+std::list<ssl_session_entry> gSslSessions;
+/*! \brief Index to the sessions of the cache.
+ * \details The key is the host with port as given in the requested URL, e.g.
+ * "example.com:443" or "[192.168.1.2]:443". */
+std::unordered_map<std::string, std::list<ssl_session_entry>::iterator>
+    gSslSessionIdx;
+/// \brief Index of the session cache key in the ex data of a connection.
+int gSslSessionKeyIdx{-1};
+/// \brief Statistic of the TLS client session cache.
+UpnpSslSessionStats gSslSessionStats{};
+/// \brief Protects the TLS client session cache and its statistic.
+std::mutex gSslSessionMutex;
 #endif
 
 /*! \name Scope restricted to file
@@ -433,6 +464,74 @@ int sock_write_ssl(
 
     return bytes_sent;
 }
+
+/*!
+ * \brief Callback from OpenSSL to free the session cache key of a connection.
+ */
+void ssl_session_key_free(void*, void* a_key, CRYPTO_EX_DATA*, int, long,
+                          void*) {
+    delete static_cast<std::string*>(a_key);
+}
+
+/*!
+ * \brief Get the cached session for a host:port and mark it as most recently
+ * used.
+ *
+ * The session cache mutex must be locked.
+ *
+ * \returns
+ *  On success: Pointer to the session, still owned by the cache.\n
+ *  On error: nullptr if no session is cached for the host:port.
+ */
+SSL_SESSION* ssl_session_get(
+    /*! [in] Host with port of the requested URL. */
+    const std::string& a_key) {
+    auto it = gSslSessionIdx.find(a_key);
+    if (it == gSslSessionIdx.end())
+        return nullptr;
+    gSslSessions.splice(gSslSessions.begin(), gSslSessions, it->second);
+    return it->second->second;
+}
+
+/*!
+ * \brief Callback from OpenSSL when a new client session is established.
+ *
+ * With TLS 1.3 this may be called more than once and after the handshake when
+ * the remote node sends session tickets. The last session is cached.
+ *
+ * \returns
+ *  - 1 - the cache has taken the reference of the session
+ *  - 0 - the session isn't cached
+ */
+int ssl_session_new_cb(
+    /*! [in] Connection that got the session. */
+    SSL* a_ssl,
+    /*! [in] New session. */
+    SSL_SESSION* a_session) {
+    TRACE("Executing ssl_session_new_cb()")
+    const auto key{static_cast<const std::string*>(
+        SSL_get_ex_data(a_ssl, gSslSessionKeyIdx))};
+    if (key == nullptr || !SSL_SESSION_is_resumable(a_session))
+        return 0;
+
+    std::scoped_lock lock(gSslSessionMutex);
+    auto it = gSslSessionIdx.find(*key);
+    if (it != gSslSessionIdx.end()) {
+        SSL_SESSION_free(it->second->second);
+        it->second->second = a_session;
+        gSslSessions.splice(gSslSessions.begin(), gSslSessions, it->second);
+        return 1;
+    }
+    if (gSslSessions.size() >= SSL_SESSION_CACHE_MAX) {
+        // Make room by dropping the least recently used session.
+        SSL_SESSION_free(gSslSessions.back().second);
+        gSslSessionIdx.erase(gSslSessions.back().first);
+        gSslSessions.pop_back();
+    }
+    gSslSessions.emplace_front(*key, a_session);
+    gSslSessionIdx.emplace(*key, gSslSessions.begin());
+    return 1;
+}
 #endif
 
 /// @} // Functions (scope restricted to file)
@@ -468,7 +567,7 @@ int sock_init_with_ip(SOCKINFO* info, SOCKET sockfd,
 }
 
 #ifdef UPNP_ENABLE_OPEN_SSL
-int sock_ssl_connect(SOCKINFO* info) {
+int sock_ssl_connect(SOCKINFO* info, const char* a_hostport) {
     TRACE("Executing sock_ssl_connect()");
     info->ssl = SSL_new(gSslCtx);
     if (!info->ssl) {
@@ -479,15 +578,70 @@ int sock_ssl_connect(SOCKINFO* info) {
     if (status == 0)
         return UPNP_E_SOCKET_ERROR;
 
+    // Try to resume a previous session with the requested host. The key is
+    // kept with the connection for the new session callback.
+    if (a_hostport != nullptr && *a_hostport != '\0') {
+        auto key = new std::string(a_hostport);
+        if (SSL_set_ex_data(info->ssl, gSslSessionKeyIdx, key) != 1) {
+            delete key;
+            return UPNP_E_SOCKET_ERROR;
+        }
+        std::scoped_lock lock(gSslSessionMutex);
+        SSL_SESSION* session = ssl_session_get(*key);
+        if (session != nullptr)
+            SSL_set_session(info->ssl, session);
+    }
+
     UPNPLIB_SCOPED_NO_SIGPIPE;
     status = SSL_connect(info->ssl);
     if (status != 1)
         return UPNP_E_SOCKET_ERROR;
 
+    std::scoped_lock lock(gSslSessionMutex);
+    if (SSL_session_reused(info->ssl))
+        gSslSessionStats.hits++;
+    else
+        gSslSessionStats.misses++;
+
     return UPNP_E_SUCCESS;
 }
 #endif
 
+#ifdef UPNP_ENABLE_OPEN_SSL
+bool sock_ssl_server_enabled() { return gSslServerCtx != nullptr; }
+
+int sock_ssl_accept(SOCKINFO* info) {
+    TRACE("Executing sock_ssl_accept()");
+    if (info->ssl == nullptr) {
+        if (gSslServerCtx == nullptr)
+            return UPNP_E_SOCKET_ERROR;
+        info->ssl = SSL_new(gSslServerCtx);
+        if (!info->ssl)
+            return UPNP_E_SOCKET_ERROR;
+        // Due to man page there is no problem with type cast (int)
+        if (SSL_set_fd(info->ssl, static_cast<int>(info->socket)) == 0)
+            return UPNP_E_SOCKET_ERROR;
+        SSL_set_accept_state(info->ssl);
+    }
+
+    UPNPLIB_SCOPED_NO_SIGPIPE;
+    int status = SSL_do_handshake(info->ssl);
+    if (status == 1)
+        return SOCK_SSL_DONE;
+
+    switch (SSL_get_error(info->ssl, status)) {
+    case SSL_ERROR_WANT_READ:
+        return SOCK_SSL_WANT_READ;
+    case SSL_ERROR_WANT_WRITE:
+        return SOCK_SSL_WANT_WRITE;
+    default:
+        UPNPLIB_LOGINFO "MSG1118: TLS handshake on socket "
+            << info->socket << " failed.\n";
+        return UPNP_E_SOCKET_ERROR;
+    }
+}
+#endif
+
 int sock_destroy(SOCKINFO* info, int ShutdownMethod) {
     TRACE("Executing sock_destroy()")
     int ret{UPNP_E_SUCCESS};
@@ -603,6 +757,29 @@ int UpnpInitSslContext([[maybe_unused]] int initOpenSslLib,
     if (!gSslCtx) {
         return UPNP_E_INIT_FAILED;
     }
+    // Sessions of outgoing connections are cached by the new session callback
+    // instead of the internal cache that cannot look them up by remote node.
+    SSL_CTX_set_session_cache_mode(gSslCtx, SSL_SESS_CACHE_CLIENT |
+                                                SSL_SESS_CACHE_NO_INTERNAL);
+    SSL_CTX_sess_set_new_cb(gSslCtx, ssl_session_new_cb);
+    if (gSslSessionKeyIdx < 0)
+        gSslSessionKeyIdx = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr,
+                                                 ssl_session_key_free);
+    return UPNP_E_SUCCESS;
+}
+
+int UpnpSetSslServerContext(SSL_CTX* sslCtx) {
+    if (sslCtx != nullptr) {
+        if (SSL_CTX_check_private_key(sslCtx) != 1)
+            return UPNP_E_INVALID_PARAM;
+        // Stateless session tickets, so resumption needs no server cache.
+        SSL_CTX_clear_options(sslCtx, SSL_OP_NO_TICKET);
+        SSL_CTX_set_num_tickets(sslCtx, 1);
+        SSL_CTX_up_ref(sslCtx);
+    }
+    if (gSslServerCtx)
+        SSL_CTX_free(gSslServerCtx);
+    gSslServerCtx = sslCtx;
     return UPNP_E_SUCCESS;
 }
 
@@ -611,5 +788,23 @@ void freeSslCtx() {
         SSL_CTX_free(gSslCtx);
         gSslCtx = nullptr;
     }
+    if (gSslServerCtx) {
+        SSL_CTX_free(gSslServerCtx);
+        gSslServerCtx = nullptr;
+    }
+    std::scoped_lock lock(gSslSessionMutex);
+    for (auto& session : gSslSessions)
+        SSL_SESSION_free(session.second);
+    gSslSessions.clear();
+    gSslSessionIdx.clear();
+    gSslSessionStats = {};
+}
+
+void UpnpGetSslSessionStats(UpnpSslSessionStats* stats) {
+    if (stats == nullptr)
+        return;
+    std::scoped_lock lock(gSslSessionMutex);
+    *stats = gSslSessionStats;
+    stats->entries = gSslSessions.size();
 }
 #endif
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021 GPL 3 and higher by Ingo Höft,  <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-31
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -38,13 +38,21 @@
 
 #include <upnp.hpp>
 #include <uri.hpp>
+#include <config.hpp>
+#include <ThreadPool.hpp>
 
 #include <upnplib/port_sock.hpp>
 #include <umock/netdb.hpp>
 
 /// \cond
 #include <cassert>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio> // Needed if OpenSSL isn't compiled in.
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 /// \endcond
 
 UPNPLIB_EXTERN unsigned gIF_INDEX;
@@ -148,7 +156,8 @@ size_t parse_uric(
     size_t i = (size_t)0;
 
     while (i < max &&
-           (is_unreserved(in[i]) || is_reserved(in[i]) ||
+           (is_unreserved(static_cast<unsigned char>(in[i])) ||
+            is_reserved(static_cast<unsigned char>(in[i])) ||
             ((i + (size_t)2 < max) &&
              is_escaped(reinterpret_cast<const unsigned char*>(&in[i]))))) {
         i++;
@@ -179,13 +188,142 @@ void copy_token(
     out->buff = out_base + (in->buff - in_base);
 }
 
+/*!
+ * \brief Resolves a host name with getaddrinfo().
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS with the first IPv4 or IPv6 address\n
+ *  On error: UPNP_E_INVALID_URL
+ */
+int resolve_host(
+    /*! [in] Host name. */
+    const char* host,
+    /*! [out] Address of the host without port. */
+    sockaddr_storage* addr) {
+    struct addrinfo hints, *res, *res0;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (umock::netdb_h.getaddrinfo(host, NULL, &hints, &res0) != 0)
+        return UPNP_E_INVALID_URL;
+    for (res = res0; res; res = res->ai_next) {
+        if (res->ai_family == AF_INET || res->ai_family == AF_INET6) {
+            memset(addr, 0, sizeof(*addr));
+            memcpy(addr, res->ai_addr, res->ai_addrlen);
+            break;
+        }
+    }
+    umock::netdb_h.freeaddrinfo(res0);
+
+    return res ? UPNP_E_SUCCESS : UPNP_E_INVALID_URL;
+}
+
+/// \brief Cached result of a host name lookup.
+struct resolver_entry {
+    /// Address of the host, valid if found is set.
+    sockaddr_storage addr{};
+    /// Set if the host was found.
+    bool found{false};
+    /// Set while the host is queued or looked up.
+    bool pending{false};
+    /// The result must be looked up again after this time.
+    std::chrono::steady_clock::time_point expires{};
+};
+
+/// \brief Shared data of the resolver threads.
+struct resolver_t {
+    /// Protects all members.
+    std::mutex mutex;
+    /// Signaled when a host is queued or the resolver should stop.
+    std::condition_variable work;
+    /// Signaled when a lookup has finished.
+    std::condition_variable done;
+    /// Results of lookups by host name.
+    std::unordered_map<std::string, resolver_entry> cache;
+    /// Host names waiting for a resolver thread.
+    std::deque<std::string> queue;
+    /// Set while the resolver threads are running.
+    bool running{false};
+    /// Set to stop the resolver threads.
+    bool stop{false};
+    /// Threads that do the blocking lookups, each one host at a time.
+    DedicatedThread threads[RESOLVER_THREADS]{};
+
+    /// Joins the threads if the program exits without resolver_stop(), so
+    /// the condition variables are not destroyed while they are waited on.
+    ~resolver_t() { resolver_stop(); }
+} gResolver;
+
+/*!
+ * \brief Makes room for a new cache entry.
+ *
+ * Must be called with gResolver.mutex locked.
+ */
+void resolver_trim(std::chrono::steady_clock::time_point now) {
+    if (gResolver.cache.size() < RESOLVER_CACHE_SIZE)
+        return;
+    for (auto it = gResolver.cache.begin(); it != gResolver.cache.end();) {
+        if (!it->second.pending && it->second.expires <= now)
+            it = gResolver.cache.erase(it);
+        else
+            ++it;
+    }
+    for (auto it = gResolver.cache.begin();
+         it != gResolver.cache.end() &&
+         gResolver.cache.size() >= RESOLVER_CACHE_SIZE;) {
+        if (!it->second.pending)
+            it = gResolver.cache.erase(it);
+        else
+            ++it;
+    }
+}
+
+/*!
+ * \brief Looks up queued host names until the resolver is stopped.
+ */
+void resolver_loop([[maybe_unused]] void* arg) {
+    std::unique_lock lock(gResolver.mutex);
+    while (true) {
+        gResolver.work.wait(lock, [] {
+            return gResolver.stop || !gResolver.queue.empty();
+        });
+        if (gResolver.stop)
+            break;
+        std::string host = std::move(gResolver.queue.front());
+        gResolver.queue.pop_front();
+
+        lock.unlock();
+        sockaddr_storage addr{};
+        const bool found = resolve_host(host.c_str(), &addr) == UPNP_E_SUCCESS;
+        lock.lock();
+
+        resolver_entry& entry = gResolver.cache[host];
+        entry.addr = addr;
+        entry.found = found;
+        entry.pending = false;
+        entry.expires = std::chrono::steady_clock::now() +
+                        std::chrono::seconds(found ? RESOLVER_TTL
+                                                   : RESOLVER_NEGATIVE_TTL);
+        gResolver.done.notify_all();
+    }
+}
+
 /*!
  * \brief Parses a string with host and port and fills a hostport structure.
  *
  * Parses a string representing a host and port (e.g. "127.127.0.1:80" or
  * "localhost") and fills out a hostport_type struct with internet address and a
- * token representing the full host and port. Uses getaddrinfo() to resolve DNS
- * names. This may result in a longer delay until response from the internet.
+ * token representing the full host and port. DNS names are resolved with
+ * resolver_lookup() that waits at most RESOLVER_WAIT milliseconds while the
+ * resolver is started.
+ *
+ * \returns
+ *  On success: size of the host and port string\n
+ *  On error:
+ *  - UPNP_E_INVALID_URL - the string is invalid or the host is unknown
+ *  - UPNP_E_TRY_AGAIN - the host is still looked up, try again later
  */
 int parse_hostport(
     /*! [in] String of characters representing host and port. */
@@ -247,33 +385,9 @@ int parse_hostport(
             af = AF_INET;
         else {
             /* Must be a host name. */
-            struct addrinfo hints, *res, *res0;
-
-            memset(&hints, 0, sizeof(hints));
-            hints.ai_family = AF_UNSPEC;
-            hints.ai_socktype = SOCK_STREAM;
-
-            ret = umock::netdb_h.getaddrinfo(srvname, NULL, &hints, &res0);
-            if (ret == 0) {
-                for (res = res0; res; res = res->ai_next) {
-                    switch (res->ai_family) {
-                    case AF_INET:
-                    case AF_INET6:
-                        /* Found a valid IPv4 or IPv6
-                         * address. */
-                        memcpy(&out->IPaddress, res->ai_addr, res->ai_addrlen);
-                        goto found;
-                    }
-                }
-            found:
-                umock::netdb_h.freeaddrinfo(res0);
-                if (res == NULL)
-                    /* Didn't find an AF_INET or AF_INET6
-                     * address. */
-                    return UPNP_E_INVALID_URL;
-            } else
-                /* getaddrinfo failed. */
-                return UPNP_E_INVALID_URL;
+            ret = resolver_lookup(srvname, RESOLVER_WAIT, &out->IPaddress);
+            if (ret != UPNP_E_SUCCESS)
+                return ret;
         }
     }
     /* Check if a port is specified. */
@@ -771,3 +885,98 @@ int parse_uri(const char* in, size_t max, uri_type* out) {
 
     return HTTP_SUCCESS;
 }
+
+int resolver_start(int cpu) {
+    std::unique_lock lock(gResolver.mutex);
+    if (gResolver.running)
+        return UPNP_E_SUCCESS;
+    gResolver.stop = false;
+    for (auto& thread : gResolver.threads) {
+        if (DedicatedThreadStart(&thread, resolver_loop, nullptr, cpu) != 0) {
+            // Join the threads that are already started.
+            gResolver.stop = true;
+            gResolver.work.notify_all();
+            lock.unlock();
+            for (auto& started : gResolver.threads)
+                DedicatedThreadJoin(&started);
+            return UPNP_E_INIT_FAILED;
+        }
+    }
+    gResolver.running = true;
+
+    return UPNP_E_SUCCESS;
+}
+
+void resolver_stop() {
+    {
+        std::scoped_lock lock(gResolver.mutex);
+        if (!gResolver.running)
+            return;
+        gResolver.stop = true;
+        gResolver.work.notify_all();
+    }
+    for (auto& thread : gResolver.threads)
+        DedicatedThreadJoin(&thread);
+    std::scoped_lock lock(gResolver.mutex);
+    gResolver.running = false;
+    gResolver.queue.clear();
+    gResolver.cache.clear();
+    // Wake up lookups that wait for a host that will never be resolved.
+    gResolver.done.notify_all();
+}
+
+int resolver_lookup(const char* host, int wait_ms, sockaddr_storage* addr) {
+    if (host == nullptr || addr == nullptr)
+        return UPNP_E_INVALID_PARAM;
+
+    std::unique_lock lock(gResolver.mutex);
+    if (!gResolver.running) {
+        lock.unlock();
+        return resolve_host(host, addr);
+    }
+    const auto now = std::chrono::steady_clock::now();
+    auto it = gResolver.cache.find(host);
+    if (it != gResolver.cache.end() && !it->second.pending) {
+        if (it->second.expires > now) {
+            if (!it->second.found)
+                return UPNP_E_INVALID_URL;
+            *addr = it->second.addr;
+            return UPNP_E_SUCCESS;
+        }
+        if (it->second.found) {
+            // Use the expired address while it is looked up again.
+            *addr = it->second.addr;
+            it->second.pending = true;
+            gResolver.queue.emplace_back(host);
+            gResolver.work.notify_one();
+            return UPNP_E_SUCCESS;
+        }
+    }
+    if (it == gResolver.cache.end()) {
+        resolver_trim(now);
+        it = gResolver.cache.emplace(host, resolver_entry{}).first;
+    }
+    if (!it->second.pending) {
+        it->second.pending = true;
+        gResolver.queue.emplace_back(host);
+        gResolver.work.notify_one();
+    }
+
+    // Entries may be erased while waiting, so look the host up again.
+    const std::string key{host};
+    const resolver_entry* entry{nullptr};
+    gResolver.done.wait_for(
+        lock, std::chrono::milliseconds(wait_ms < 0 ? 0 : wait_ms), [&] {
+            auto found = gResolver.cache.find(key);
+            entry = found == gResolver.cache.end() ? nullptr : &found->second;
+            return !gResolver.running || entry == nullptr || !entry->pending;
+        });
+    if (entry == nullptr || entry->pending)
+        // Not known yet, the caller may try again.
+        return UPNP_E_TRY_AGAIN;
+    if (!entry->found)
+        return UPNP_E_INVALID_URL;
+    *addr = entry->addr;
+
+    return UPNP_E_SUCCESS;
+}
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-06-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -47,6 +47,7 @@
 #include <umock/stdlib.hpp>
 
 /// \cond
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -107,6 +108,87 @@ UPNP_INLINE void membuffer_initialize(
     m->buf = NULL;
     m->length = (size_t)0;
     m->capacity = (size_t)0;
+    m->small = false;
+}
+
+/*!
+ * \brief Small blocks that are free for reuse by the calling thread.
+ *
+ * The blocks are allocated with malloc() so a detached small buffer can be
+ * freed or reallocated by the caller like any other one.
+ */
+struct small_cache_t {
+    /// Free blocks of MEMBUF_SMALL_SIZE bytes.
+    char* blocks[MEMBUF_SMALL_CACHE_SIZE];
+    /// Number of free blocks.
+    size_t count{0};
+
+    ~small_cache_t() {
+        while (count > 0)
+            umock::stdlib_h.free(blocks[--count]);
+    }
+};
+/// \brief Small block cache of the thread.
+thread_local small_cache_t tSmallCache;
+
+/*!
+ * \brief Get a small block, preferably from the cache of the thread.
+ */
+char* small_alloc() {
+    small_cache_t& cache{tSmallCache};
+    if (cache.count > 0)
+        return cache.blocks[--cache.count];
+    return static_cast<char*>(umock::stdlib_h.malloc(MEMBUF_SMALL_SIZE));
+}
+
+/*!
+ * \brief Return a small block to the cache of the thread.
+ */
+void small_free(
+    /*! [in] Block from small_alloc(). */
+    char* a_block) {
+    small_cache_t& cache{tSmallCache};
+    if (cache.count < MEMBUF_SMALL_CACHE_SIZE)
+        cache.blocks[cache.count++] = a_block;
+    else
+        umock::stdlib_h.free(a_block);
+}
+
+/*!
+ * \brief Reallocates the buffer to hold 'alloc_len' bytes and the terminating
+ * null byte.
+ *
+ * Small sizes are served from a cached small block. The block is kept while
+ * the contents fit into it, so growing within it costs nothing.
+ * \returns
+ *  On success: Pointer to the buffer, maybe the old one\n
+ *  On error: nullptr, the old buffer is unchanged
+ */
+char* membuffer_realloc(
+    /*! [in] Buffer whose memory is to be reallocated. */
+    membuffer* m,
+    /*! [in] New size without terminating null byte. */
+    size_t alloc_len) {
+    char* temp_buf;
+
+    if (alloc_len < MEMBUF_SMALL_SIZE) {
+        if (m->small)
+            return m->buf;
+        if (m->buf == nullptr) {
+            temp_buf = small_alloc();
+            if (temp_buf != nullptr)
+                m->small = true;
+            return temp_buf;
+        }
+        // Don't move a heap buffer that shrinks.
+    }
+
+    // A small block is an ordinary heap block that leaves the cache.
+    temp_buf = static_cast<char*>(
+        umock::stdlib_h.realloc(m->buf, alloc_len + (size_t)1));
+    if (temp_buf != nullptr)
+        m->small = false;
+    return temp_buf;
 }
 
 /// @}
@@ -124,13 +206,16 @@ int membuffer_set_size(membuffer* m, size_t new_length) {
         }
 
         diff = new_length - m->length;
-        alloc_len = std::max(m->size_inc, diff) + m->capacity;
+        /* grow at least by the current capacity */
+        alloc_len = std::max({m->size_inc, diff, m->capacity}) + m->capacity;
     } else { /* decrease length */
 
         assert(new_length <= m->length);
 
-        /* if diff is 0..m->size_inc, don't free */
-        if ((m->capacity - new_length) <= m->size_inc) {
+        /* if diff is 0..m->size_inc or half of the buffer is used, don't
+         * free. Otherwise alternating appends and deletes would reallocate
+         * every time. */
+        if ((m->capacity - new_length) <= std::max(m->size_inc, new_length)) {
             return 0;
         }
 
@@ -139,18 +224,12 @@ int membuffer_set_size(membuffer* m, size_t new_length) {
 
     assert(alloc_len >= new_length);
 
-    temp_buf = (char*)umock::stdlib_h.realloc(
-        m->buf, alloc_len + (size_t)1); /*LEAK_FIX_MK */
-
-    /*temp_buf = Realloc( m->buf,m->length, alloc_len + 1 );LEAK_FIX_MK */
+    temp_buf = membuffer_realloc(m, alloc_len);
 
     if (temp_buf == NULL) {
         /* try smaller size */
         alloc_len = new_length;
-        temp_buf = (char*)umock::stdlib_h.realloc(
-            m->buf, alloc_len + (size_t)1); /*LEAK_FIX_MK */
-        /*temp_buf = Realloc( m->buf,m->length, alloc_len + 1
-         * );LEAK_FIX_MK */
+        temp_buf = membuffer_realloc(m, alloc_len);
 
         if (temp_buf == NULL) {
             return UPNP_E_OUTOF_MEMORY;
@@ -162,6 +241,23 @@ int membuffer_set_size(membuffer* m, size_t new_length) {
     return 0;
 }
 
+int membuffer_reserve(membuffer* m, size_t capacity) {
+    char* temp_buf;
+
+    assert(m != NULL);
+
+    if (capacity <= m->capacity)
+        return 0;
+
+    temp_buf = membuffer_realloc(m, capacity);
+    if (temp_buf == NULL)
+        return UPNP_E_OUTOF_MEMORY;
+
+    m->buf = temp_buf;
+    m->capacity = capacity;
+    return 0;
+}
+
 void membuffer_init(membuffer* m) {
     TRACE("Executing membuffer_init()")
     assert(m != NULL);
@@ -176,7 +272,9 @@ void membuffer_destroy(membuffer* m) {
         return;
     }
 
-    if (m->buf != nullptr) {
+    if (m->small) {
+        small_free(m->buf);
+    } else if (m->buf != nullptr) {
         umock::stdlib_h.free(m->buf);
     }
     membuffer_init(m);
@@ -284,6 +382,8 @@ char* membuffer_detach(membuffer* m) {
 
     assert(m != NULL);
 
+    /* a small block is also freed with free(), so pointers into it stay
+     * valid */
     buf = m->buf;
 
     /* free all */
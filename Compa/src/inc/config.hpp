@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-03
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -106,6 +106,84 @@
  */
 #define MAX_JOBS_TOTAL 100
 
+/*!
+ * \brief The `SEND_ADMISSION_POLICY`, `RECV_ADMISSION_POLICY` and
+ * `MSERV_ADMISSION_POLICY` constants select what happens to a new job of the
+ * send (timer and callbacks), receive (SSDP) and miniserver (HTTP requests)
+ * thread pool if `MAX_JOBS_TOTAL` jobs are already queued. Possible values are
+ * `ADMIT_REJECT`, `ADMIT_SHED_LOW`, `ADMIT_OVERFLOW` and `ADMIT_BLOCK` as
+ * described with ThreadPoolAdd(). Some sources of jobs set their own policy
+ * with TPJobSetAdmissionPolicy(): the miniserver lets an accepted connection
+ * overflow and GENA events shed low priority jobs. The miniserver
+ * additionally stops accepting connections while its job queues are full. The
+ * default lets SSDP bursts overflow and rejects everything else.
+ */
+#define SEND_ADMISSION_POLICY ADMIT_REJECT
+#define RECV_ADMISSION_POLICY ADMIT_OVERFLOW
+#define MSERV_ADMISSION_POLICY ADMIT_REJECT
+
+/*!
+ * \brief The `MAX_OVERFLOW_JOBS` constant determines how many jobs a thread
+ * pool with `ADMIT_OVERFLOW` queues beyond `MAX_JOBS_TOTAL`. The default value
+ * is 50.
+ */
+#define MAX_OVERFLOW_JOBS 50
+
+/*!
+ * \brief The `ADMIT_TIMEOUT` constant determines how long (in milliseconds) a
+ * caller waits for a free job slot of a thread pool with `ADMIT_BLOCK`. The
+ * default value is 100.
+ */
+#define ADMIT_TIMEOUT 100
+
+/*!
+ * \brief The `TARGET_QUEUE_WAIT` constant determines how long (in
+ * milliseconds) the oldest queued job of a thread pool may wait before the
+ * pool starts another worker thread. With 0 the pool grows by the
+ * `JOBS_PER_THREAD` ratio instead. The default value is 10.
+ */
+#define TARGET_QUEUE_WAIT 10
+
+/*!
+ * \brief The `IO_THREAD_CPU` constant determines the CPU the dedicated
+ * miniserver, timer and SOAP action threads are bound to. With -1 they are
+ * not bound. It can be changed with UpnpSetIoThreadCpu() before the SDK is
+ * initialized. The default value is -1.
+ */
+#define IO_THREAD_CPU -1
+
+/*!
+ * \brief The `RESOLVER_TTL` and `RESOLVER_NEGATIVE_TTL` constants determine
+ * how long (in seconds) the address of a host name in a URL, or the failure to
+ * find one, is cached. getaddrinfo() does not report the TTL of the name
+ * server so these are fixed. The default values are 300 and 30.
+ */
+#define RESOLVER_TTL 300
+#define RESOLVER_NEGATIVE_TTL 30
+
+/*!
+ * \brief The `RESOLVER_CACHE_SIZE` constant determines the maximal number of
+ * cached host names. The default value is 256.
+ */
+#define RESOLVER_CACHE_SIZE 256
+
+/*!
+ * \brief The `RESOLVER_WAIT` constant determines how long (in milliseconds)
+ * parsing a URL waits for the lookup of a host name that is not cached. The
+ * lookup goes on in the background so a later parse finds it in the cache,
+ * the parse itself fails with UPNP_E_TRY_AGAIN and may be retried.
+ * The default value is 200.
+ */
+#define RESOLVER_WAIT 200
+
+/*!
+ * \brief The `RESOLVER_THREADS` constant determines how many host names are
+ * looked up at the same time, so a slow name does not hold up the others. A
+ * host name is never looked up by more than one thread. The default value
+ * is 4.
+ */
+#define RESOLVER_THREADS 4
+
 /*!
  * \brief The `MAX_SUBSCRIPTION_QUEUED_EVENTS` determines the maximum number of
  * events which can be queued for a given subscription before events begin to
@@ -148,6 +226,38 @@
  */
 #define SSDP_PAUSE 100u
 
+/*!
+ * \brief This configuration parameter sets the maximum number of additional
+ * interfaces that can be set with `UpnpSetSsdpInterfaces` to listen for SSDP
+ * multicast messages.
+ */
+#define SSDP_MAX_INTERFACES 8
+
+/*!
+ * \brief This configuration parameter sets how many search requests per
+ * second from one control point are answered by the device. More are dropped.
+ */
+#define SSDP_SEARCH_RATE 10
+
+/*!
+ * \brief This configuration parameter sets how many search requests from one
+ * control point are answered at once before `SSDP_SEARCH_RATE` applies.
+ */
+#define SSDP_SEARCH_BURST 20
+
+/*!
+ * \brief This configuration parameter sets the maximum number of search replies
+ * that are scheduled at the same time. Further search requests are dropped.
+ */
+#define SSDP_MAX_PENDING_REPLIES 100
+
+/*!
+ * \brief This configuration parameter sets the maximum number of unique
+ * service names kept in the discovery cache of a control point. If it is full
+ * the entry that expires first makes room for a new one.
+ */
+#define SSDP_CACHE_MAX_ENTRIES 512
+
 /*!
  * \brief This configuration parameter sets the maximum buffer size for the
  * webserver. The default value is 1MB.
@@ -182,6 +292,38 @@
  */
 #define CP_MINIMUM_SUBSCRIPTION_TIME (AUTO_RENEW_TIME + 5)
 
+/*!
+ * \brief The `AUTO_RENEW_BATCH_WINDOW` is the time window, in seconds, in
+ * which automatic renewals of subscriptions to the same host are sent together,
+ * one after the other over one pooled connection. Renewals are made up
+ * to this time earlier to align them to the window. The default value is 5
+ * seconds.
+ */
+#define AUTO_RENEW_BATCH_WINDOW 5
+
+/*!
+ * \brief The `AUTO_RENEW_JITTER` is the maximal time, in seconds, that an
+ * automatic renewal is made earlier to spread the renewals of different hosts,
+ * e.g. of all subscriptions made after a restart. It is limited to a quarter
+ * of the subscription time. The default value is 30 seconds.
+ */
+#define AUTO_RENEW_JITTER 30
+
+/*!
+ * \brief The `SOAP_ACTION_MAX_PER_DEVICE` is the default maximal number of
+ * actions sent with \b UpnpSendActionNonBlocking that are in flight to one
+ * device. Many devices handle only few connections at a time. The default
+ * value is 4.
+ */
+#define SOAP_ACTION_MAX_PER_DEVICE 4
+
+/*!
+ * \brief The `SOAP_ACTION_MAX_IN_FLIGHT` is the default maximal number of
+ * actions sent with \b UpnpSendActionNonBlocking that are in flight. Each of
+ * them uses a socket. The default value is 1024.
+ */
+#define SOAP_ACTION_MAX_IN_FLIGHT 1024
+
 /*!
  * \brief The `MAX_SEARCH_TIME` is the maximum time allowed for an SSDP search
  * by a control point. Searching for greater than this time automatically
@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-02-14
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -216,10 +216,15 @@ struct http_header_t {
     memptr name;
     /*! \brief Header name id (for a selective group of headers only). */
     int name_id;
-    /*! \brief Raw-value; could be multi-lined; min-length = 0. */
+    /*! \brief Raw-value; could be multi-lined; min-length = 0.
+     * \warning With http_header_t::is_slice set the value is not null
+     * terminated and must be used with its length. */
     membuffer value;
     /*! \brief (Private use -- don't touch.) */
     membuffer name_buf;
+    /*! \brief (Private use -- don't touch.) Set to 1 if name and value point
+     * into the raw message instead of own buffers. */
+    int is_slice;
 };
 
 /// \brief Structure of an HTTP message.
@@ -284,12 +289,23 @@ struct http_parser_t {
     /*! \brief read-only; this is set to 1 if a NOTIFY request has no
      * content-length. used to read valid sspd notify msg. */
     int valid_ssdp_notify_hack;
+    /*! \brief read/write; if set to 1, header names and values are stored
+     * as slices into the raw message instead of copying them.
+     * \details This is meant for messages that are completely received
+     * before parsing like SSDP datagrams. The raw message must only be
+     * modified by parser_append() while the headers are in use, otherwise
+     * call httpmsg_copy_header_slices() before. Empty values and values of
+     * repeated headers are always copied. Default is 0. */
+    int header_slices;
     /// @{
     /// \brief Private data -- don't touch.
     parser_pos_t position;
     int ent_position;
     unsigned int content_length;
     size_t chunk_size;
+    /*! Offset in the raw message up to which parsing was incomplete for
+     * lack of a line end, 0 if unknown. */
+    size_t line_scan_pos;
     /// @}
     /*! \brief Offset in the raw message buffer, which contains the message
      * body. preceding this are the headers of the message. */
@@ -331,6 +347,21 @@ UPNPLIB_API http_header_t* httpmsg_find_hdr(
     memptr* value        ///< [out] Buffer to get the ouput to.
 );
 
+/*!
+ * \brief Copies header names and values that are slices into the raw message
+ * to own buffers.
+ *
+ * After this the headers are independent from the raw message. Headers that
+ * already have own buffers are not touched.
+ *
+ * \returns
+ *  - UPNP_E_SUCCESS
+ *  - UPNP_E_OUTOF_MEMORY
+ */
+UPNPLIB_API int httpmsg_copy_header_slices( //
+    http_message_t* msg ///< [in,out] HTTP Message Object.
+);
+
 /*!
  * \brief Initializes parser object for a request.
  */
@@ -483,6 +514,41 @@ UPNPLIB_API parse_status_t parser_append(
     size_t buf_length      ///< [in] Size of the buffer.
 );
 
+/*!
+ * \brief Reserve free space behind the raw message of the parser.
+ *
+ * This is used to read data directly into the message buffer without copying
+ * it. After writing, parser_append_commit() must be called with the number of
+ * bytes written. Any other modification of the message invalidates the
+ * returned pointer. While reading an entity with known content length the
+ * space is allocated exactly, otherwise the buffer grows geometrically.
+ *
+ * \returns
+ *  On success: Pointer to at least **a_size** bytes of free space.\n
+ *  On error: nullptr - not enough memory.
+ */
+UPNPLIB_API char* parser_append_reserve(
+    http_parser_t* parser, ///< [in,out] HTTP Parser object.
+    size_t a_size          ///< [in] Number of bytes to reserve.
+);
+
+/*!
+ * \brief Append data that was written into space from
+ * parser_append_reserve(), and do the parsing.
+ *
+ * \returns
+ *  On success: PARSE_SUCCESS\n
+ *  On error:
+ *  - PARSE_FAILURE
+ *  - PARSE_INCOMPLETE
+ *  - PARSE_INCOMPLETE_ENTITY
+ *  - PARSE_NO_MATCH
+ */
+UPNPLIB_API parse_status_t parser_append_commit(
+    http_parser_t* parser, ///< [in,out] HTTP Parser object.
+    size_t buf_length      ///< [in] Number of bytes written behind the message.
+);
+
 /*!
  * \brief Matches a variable parameter list with a string and takes actions
  * based on the data type specified.
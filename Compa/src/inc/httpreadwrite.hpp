@@ -8,7 +8,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-04-13
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -82,6 +82,7 @@ int http_FixUrl(        //
  *
  * \returns
  *  - UPNP_E_INVALID_URL
+ *  - UPNP_E_TRY_AGAIN - the host name is still looked up
  *  - UPNP_E_SUCCESS
  */
 int http_FixStrUrl(     //
@@ -171,6 +172,11 @@ UPNPLIB_API int http_SendMessage(
  * \brief Initiates socket, connects to the remote host, sends a request and
  * waits for the response from the remote end.
  *
+ * Connections are kept alive in a pool if both sides use HTTP/1.1 without
+ * "Connection: close" and are reused by the next request to the same scheme
+ * and remote address. If a pooled connection fails before any byte of the
+ * response is received, the request is repeated once on a new connection.
+ *
  * \returns
  * On success: UPNP_E_SUCCESS\n
  * On error:
@@ -192,6 +198,46 @@ int http_RequestAndResponse(  //
     http_parser_t* response   ///< [in] Parser object to receive the repsonse.
 );
 
+/// \brief Statistic of the client connection pool.
+struct HttpConnPoolStats {
+    /// Number of connections opened by http_RequestAndResponse().
+    size_t opened;
+    /// Number of requests sent on a pooled connection.
+    size_t reused;
+    /// Number of requests repeated after a pooled connection failed.
+    size_t retried;
+    /// Number of idle connections closed due to age, limits or remote close.
+    size_t evicted;
+    /// Number of idle connections currently in the pool.
+    size_t idle;
+};
+
+/*!
+ * \brief Get the statistic of the client connection pool.
+ */
+UPNPLIB_API void http_GetConnPoolStats(
+    /*! [out] Pointer to the structure that gets the statistic. */
+    HttpConnPoolStats* stats);
+
+/*!
+ * \brief Close all idle connections of the client connection pool.
+ */
+UPNPLIB_API void http_ClearConnPool();
+
+/*!
+ * \brief Read the server information once for all messages.
+ *
+ * http_MakeMessage() takes it for the SERVER and USER-AGENT header instead of
+ * asking the operating system with every message. Must be called before
+ * messages are made on other threads.
+ */
+UPNPLIB_API void http_InitSdkInfo();
+
+/*!
+ * \brief Forget the server information read by http_InitSdkInfo().
+ */
+UPNPLIB_API void http_ClearSdkInfo();
+
 /************************************************************************
  * return codes:
  *      0 -- success
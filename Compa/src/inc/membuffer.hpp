@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft,  Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-02-27
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -57,7 +57,14 @@ struct memptr {
 /*! \brief Maintains a block of dynamically allocated memory.
  * \note Total length/capacity should not exceed MAX_INT. It is always a
  * terminating null byte ('\0') appended but not reflected in length and
- * capacity */
+ * capacity.
+ *
+ * Capacity grows geometrically so that appending in pieces needs only a
+ * logarithmic number of reallocations. Contents up to MEMBUF_SMALL_SIZE bytes
+ * are kept in a small block that is reused from a cache of the thread. A
+ * small block is not bound to the membuffer structure, so copying the
+ * structure still shares the buffer as before. It is allocated with malloc()
+ * so membuffer_detach() returns it as it is. */
 struct membuffer {
     /// \brief mem buffer; must not write beyond buf[length-1] (read/write).
     char* buf;
@@ -67,11 +74,17 @@ struct membuffer {
     size_t capacity;
     /*! \brief used to increase size; MUST be > 0; (read/write). */
     size_t size_inc;
-    /*! \brief default value of size_inc. */
+    /*! \brief buf is a small block from the thread cache (private). */
+    bool small;
 };
 /// \cond
+/*! \brief default value of size_inc. */
 inline constexpr size_t MEMBUF_DEF_SIZE_INC{5};
 /// \endcond
+/*! \brief Size of a small buffer including the terminating null byte. */
+inline constexpr size_t MEMBUF_SMALL_SIZE{64};
+/*! \brief Number of free small buffers cached per thread. */
+inline constexpr size_t MEMBUF_SMALL_CACHE_SIZE{32};
 
 /*!
  * \brief Allocate memory and copy information from the input string to the
@@ -138,6 +151,23 @@ int membuffer_set_size(
     /*! [in] new size to which the buffer will be modified. */
     size_t new_length);
 
+/*!
+ * \brief Reserves memory for at least 'capacity' bytes without changing the
+ * contents.
+ *
+ * Other than membuffer_set_size() the memory is allocated with exactly the
+ * requested size. Use it if the final size is known in advance.
+ * \return
+ * \li UPNP_E_SUCCESS - On Success
+ * \li UPNP_E_OUTOF_MEMORY - On failure to allocate memory.
+ */
+// Don't export function symbol; only used library intern.
+int membuffer_reserve(
+    /*! [in,out] buffer whose capacity is to be increased. */
+    membuffer* m,
+    /*! [in] Needed capacity without terminating null byte. */
+    size_t capacity);
+
 /*!
  * \brief Wrapper to membuffer_initialize().
  *
@@ -7,7 +7,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-05-24
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  * Copied from pupnp ver 1.14.15.
  *
  * Redistribution and use in source and binary forms, with or without
@@ -41,6 +41,7 @@
  * \brief Manage "Step 0: Addressing" of the UPnP+™ specification.
  */
 
+#include <config.hpp>
 #include <httpparser.hpp>
 #include <sock.hpp>
 #include <upnplib/socket.hpp>
@@ -57,6 +58,12 @@ struct MiniServerSockArray {
     SOCKET miniServerSock6;
     /*! \brief IPv6 ULA or GUA Socket for listening for miniserver requests. */
     SOCKET miniServerSock6UlaGua;
+    /*! \brief IPv4 socket for listening for TLS connections, only with a
+     * server SSL context, see UpnpSetSslServerContext(). */
+    SOCKET miniServerSockTls4;
+    /*! \brief IPv4 Sockets for listening for miniserver requests on the
+     * additional interfaces, index like ssdpSockIf4. */
+    SOCKET miniServerSockIf4[SSDP_MAX_INTERFACES];
     /*! \brief Datagram Socket for stopping miniserver. */
     SOCKET miniServerStopSock;
     /*! \brief IPv4 SSDP datagram Socket for incoming advertisments and search
@@ -68,6 +75,12 @@ struct MiniServerSockArray {
     /*! \brief IPv6 ULA or GUA SSDP Socket for incoming advertisments and search
      * requests. */
     SOCKET ssdpSock6UlaGua;
+    /*! \brief IPv4 SSDP datagram Sockets on additional interfaces, set with
+     * SsdpSetInterfaces(). */
+    SOCKET ssdpSockIf4[SSDP_MAX_INTERFACES];
+    /*! \brief IPv4 addresses of the additional interfaces, index like
+     * ssdpSockIf4. */
+    char ssdpIfIpv4[SSDP_MAX_INTERFACES][INET_ADDRSTRLEN];
     /*! \brief Corresponding port to miniServerStopSock. This is set with
      * miniStopSockPort but never used. */
     in_port_t stopPort;
@@ -77,6 +90,8 @@ struct MiniServerSockArray {
     in_port_t miniServerPort6;
     /*! \brief Corresponding port to miniServerSock6UlaGua */
     in_port_t miniServerPort6UlaGua;
+    /*! \brief Corresponding port to miniServerSockTls4 */
+    in_port_t miniServerPortTls4;
 #ifdef COMPA_HAVE_CTRLPT_SSDP
     /*! \name Only with Client (control point) Module.
      * \todo Move this to control point SSDP
@@ -88,10 +103,16 @@ struct MiniServerSockArray {
      * replies */
     SOCKET ssdpReqSock6;
     /// @}
+#endif
+#ifdef __linux__
+    /*! \brief Netlink socket for link and address changes of the local
+     * interfaces. */
+    SOCKET netlinkSock;
 #endif
     upnplib::CSocket* MiniSvrSock6LlaObj{nullptr};
     upnplib::CSocket* MiniSvrSock6UadObj{nullptr};
     upnplib::CSocket* MiniSvrSock4Obj{nullptr};
+    upnplib::CSocket* MiniSvrSockTls4Obj{nullptr};
 };
 
 /*! \brief For a miniserver callback function. */
@@ -149,7 +170,10 @@ int StartMiniServer(
     in_port_t* listen_port6,
     /*! [in,out] Port on which the server listens for incoming IPv6 ULA or GUA
        connections. */
-    in_port_t* listen_port6UlaGua);
+    in_port_t* listen_port6UlaGua,
+    /*! [out] Port on which the server listens for incoming IPv4 TLS
+       connections, 0 without a server SSL context. May be nullptr. */
+    in_port_t* listen_portTls4 = nullptr);
 
 /*!
  * \brief Stop and Shutdown the MiniServer and free socket resources.
@@ -7,7 +7,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-03
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -40,7 +40,7 @@
  * \brief SOAP declarations for Control Points using SOAP.
  */
 
-#include <ixml.hpp>
+#include <upnp.hpp>
 
 
 /*!
@@ -70,6 +70,132 @@ int SoapSendAction(               //
     IXML_Document** response_node ///< [out] SOAP response node.
 );
 
+/*!
+ * \brief This function is called by UPnP API to send the SOAP action request
+ * without blocking.
+ *
+ * The request is queued to an event loop that drives the connections of all
+ * actions with one thread. The callback is called with a
+ * \c UPNP_CONTROL_ACTION_COMPLETE event from the send thread pool.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_OUTOF_MEMORY
+ *  - UPNP_E_OUTOF_SOCKET
+ *  - UPNP_E_INVALID_ACTION
+ *  - UPNP_E_INVALID_URL
+ */
+int SoapSendActionNonBlocking(  //
+    const char* action_url,     ///< [in] device contrl URL.
+    const char* service_type,   ///< [in] device service type.
+    IXML_Document* action_node, ///< [in] SOAP action node.
+    Upnp_FunPtr fun,            ///< [in] Callback function.
+    const void* cookie          ///< [in] Pointer given to the callback.
+);
+
+/*!
+ * \brief Make a template with the pre-serialized request of an action.
+ *
+ * Request line, headers and the SOAP envelope are made once. Sending the
+ * action only fills in the argument values.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_OUTOF_MEMORY
+ *  - UPNP_E_INVALID_URL
+ */
+int SoapMakeActionTemplate(       //
+    const char* action_url,       ///< [in] device contrl URL.
+    const char* service_type,     ///< [in] device service type.
+    const char* action_name,      ///< [in] Name of the action.
+    const char* const* arg_names, ///< [in] Names of the arguments.
+    int num_args,                 ///< [in] Number of arguments.
+    UpnpActionTemplate** tmpl     ///< [out] The new template.
+);
+
+/*!
+ * \brief Free a template made with SoapMakeActionTemplate().
+ */
+void SoapFreeActionTemplate( //
+    UpnpActionTemplate* tmpl ///< [in] The template.
+);
+
+/*!
+ * \brief Send an action from a template and wait for the response, like
+ * SoapSendAction().
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_INVALID_PARAM if an argument value is missing, or an
+ *  error code like from SoapSendAction().
+ */
+int SoapSendActionTemplate(         //
+    const UpnpActionTemplate* tmpl, ///< [in] The action template.
+    const char* const* arg_values,  ///< [in] Values of the arguments.
+    IXML_Document** response_node   ///< [out] SOAP response node.
+);
+
+/*!
+ * \brief Send an action from a template without blocking, like
+ * SoapSendActionNonBlocking().
+ *
+ * The completion event has no action request document.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_INVALID_PARAM if an argument value is missing, or an
+ *  error code like from SoapSendActionNonBlocking().
+ */
+int SoapSendActionTemplateNonBlocking( //
+    const UpnpActionTemplate* tmpl,    ///< [in] The action template.
+    const char* const* arg_values,     ///< [in] Values of the arguments.
+    Upnp_FunPtr fun,                   ///< [in] Callback function.
+    const void* cookie                 ///< [in] Pointer given to the callback.
+);
+
+/*!
+ * \brief Send an action made from a template and get only the values of some
+ * output arguments.
+ *
+ * The values are taken from the response without building a DOM document if
+ * the response is a plain action response.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS, missing arguments have a NULL value\n
+ *  On error: UPnP error code of a fault, or an error code like from
+ *  SoapSendActionTemplate().
+ */
+int SoapSendActionTemplateValues(   //
+    const UpnpActionTemplate* tmpl, ///< [in] The action template.
+    const char* const* arg_values,  ///< [in] Values of the arguments.
+    const char* const* resp_names,  ///< [in] Names of output arguments.
+    int num_resp,                   ///< [in] Number of output arguments.
+    char** resp_values              ///< [out] Values, to be freed with free().
+);
+
+/*!
+ * \brief Set the maximal number of non-blocking actions in flight.
+ *
+ * More actions wait in the queue of their device.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_INVALID_PARAM
+ */
+int SoapSetActionWindow( //
+    int max_per_device, ///< [in] Maximum per device, i.e. host and port.
+    int max_in_flight   ///< [in] Maximum of all devices.
+);
+
+/*!
+ * \brief Stop the event loop of the non-blocking actions.
+ *
+ * Pending actions are completed with UPNP_E_FINISH.
+ */
+void SoapActionLoopShutdown();
+
 /*!
  * \brief This extended function is called by UPnP API to send the SOAP action
  * request.
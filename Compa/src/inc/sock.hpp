@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-30
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -128,6 +128,9 @@ int sock_init_with_ip(
  * \brief Associates an SSL object with the socket and begins
  * the client-side SSL/TLS handshake.
  *
+ * If a host with port is given, a cached session for it is resumed and the
+ * new session of the connection is cached for it.
+ *
  * \return Integer:
  * \li \c UPNP_E_SUCCESS
  * \li \c UPNP_E_SOCKET_ERROR
@@ -136,6 +139,46 @@ int sock_init_with_ip(
 #ifdef UPNP_ENABLE_OPEN_SSL
 int sock_ssl_connect(
     /*! [out] Socket Information Object. */
+    SOCKINFO* info,
+    /*! [in] Host with port of the requested URL, e.g. "example.com:443".
+     * The session isn't cached without it. */
+    const char* a_hostport = nullptr);
+#endif
+
+#ifdef UPNP_ENABLE_OPEN_SSL
+/// \brief Progress of a non-blocking TLS handshake, see sock_ssl_accept().
+enum SockSslState {
+    SOCK_SSL_DONE,       ///< Handshake completed.
+    SOCK_SSL_WANT_READ,  ///< Wait until the socket is readable.
+    SOCK_SSL_WANT_WRITE, ///< Wait until the socket is writable.
+};
+
+/*!
+ * \brief Check if incoming connections are secured with TLS.
+ *
+ * This is the case if a server SSL context was set with
+ * UpnpSetSslServerContext().
+ */
+// Don't export function symbol; only used library intern.
+bool sock_ssl_server_enabled();
+
+/*!
+ * \brief Associates an SSL object with an accepted socket and continues the
+ * server-side TLS handshake.
+ *
+ * The socket is expected to be non-blocking. The function is called again with
+ * the same Socket Information Object when the socket is ready as requested by
+ * the return value, until the handshake is done.
+ *
+ * \return Integer:
+ * \li \c SOCK_SSL_DONE
+ * \li \c SOCK_SSL_WANT_READ
+ * \li \c SOCK_SSL_WANT_WRITE
+ * \li \c UPNP_E_SOCKET_ERROR
+ */
+// Don't export function symbol; only used library intern.
+int sock_ssl_accept(
+    /*! [in,out] Socket Information Object. */
     SOCKINFO* info);
 #endif
 
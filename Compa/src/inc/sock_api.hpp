@@ -1,7 +1,7 @@
 #ifndef COMPA_SOCK_API_HPP
 #define COMPA_SOCK_API_HPP
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-10
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 /*!
  * \file
  * \ingroup compaAPI
@@ -11,6 +11,10 @@
 
 #include <upnplib/visibility.hpp>
 
+/// \cond
+#include <cstddef>
+/// \endcond
+
 #ifdef UPNP_ENABLE_OPEN_SSL
 #include <openssl/ssl.h>
 #endif
@@ -38,12 +42,60 @@ UPNPLIB_API int UpnpInitSslContext(
     const SSL_METHOD* sslMethod);
 
 /*!
- * \brief Free the OpenSSL context.
+ * \brief Free the OpenSSL contexts.
  *
  * \note This method is only available if the library is compiled with OpenSSL
  * support.
  */
 UPNPLIB_API void freeSslCtx();
+
+/*!
+ * \brief Set the OpenSSL context to secure incoming connections.
+ *
+ * With a context set, the miniserver also accepts TLS connections for
+ * description, control and eventing on a separate IPv4 port that is returned
+ * by UpnpGetServerSslPort(). The regular ports stay plain HTTP so the
+ * advertised http:// URLs keep working. The application must have loaded the
+ * certificate and private key into the context. The library takes its own
+ * reference of the context and enables session tickets so that clients can
+ * resume sessions. It must be called before starting the library. A nullptr
+ * disables TLS for incoming connections.
+ *
+ * \note This method is only available if the library is compiled with OpenSSL
+ * support.
+ *
+ * \returns An integer representing one of the following:
+ *   - UPNP_E_SUCCESS: The operation completed successfully.
+ *   - UPNP_E_INVALID_PARAM: The context has no certificate or private key.
+ */
+UPNPLIB_API int UpnpSetSslServerContext(
+    /*! Server SSL context, e.g. created with TLS_server_method(). */
+    SSL_CTX* sslCtx);
+
+/// \brief Statistic of the TLS client session cache.
+struct UpnpSslSessionStats {
+    /// Number of outgoing handshakes that resumed a cached session.
+    size_t hits;
+    /// Number of outgoing handshakes that needed a full handshake.
+    size_t misses;
+    /// Number of currently cached sessions.
+    size_t entries;
+};
+
+/*!
+ * \brief Get the statistic of the TLS client session cache.
+ *
+ * Sessions of outgoing HTTPS connections are cached per host with port of
+ * the requested URL and are resumed on the next connection to it. If the
+ * cache is full, the least recently used session is dropped. The cache is
+ * cleared with freeSslCtx().
+ *
+ * \note This method is only available if the library is compiled with OpenSSL
+ * support.
+ */
+UPNPLIB_API void UpnpGetSslSessionStats(
+    /*! [out] Pointer to the structure that gets the statistic. */
+    UpnpSslSessionStats* stats);
 #endif
 
 #endif // COMPA_SOCK_API_HPP
@@ -8,7 +8,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-21
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -44,6 +44,11 @@
 
 #include <miniserver.hpp>
 
+/// \cond
+#include <string>
+#include <vector>
+/// \endcond
+
 
 /*! \name SSDP constants.
  * @{ */
@@ -137,6 +142,9 @@ struct SsdpSearchReply {
     UpnpDevice_Handle handle;
     struct sockaddr_storage dest_addr;
     SsdpEvent event;
+    /*! IPv4 address of the additional interface that got the search, empty
+     * for the interface given to UpnpInit2(). */
+    char if_ipv4[INET_ADDRSTRLEN];
     /// @}
 };
 
@@ -150,6 +158,9 @@ struct SsdpSearchExpArg {
 struct ssdp_thread_data {
     http_parser_t parser;       ///< parser
     sockaddr_storage dest_addr; ///< destination socket address
+    /// IPv4 address of the additional interface that got the datagram, empty
+    /// for the interface given to UpnpInit2().
+    char if_ipv4[INET_ADDRSTRLEN];
 };
 
 /* globals */
@@ -218,7 +229,11 @@ int ssdp_request_type(
  */
 UPNPLIB_API int readFromSSDPSocket(
     /*! [in] SSDP socket. */
-    SOCKET socket);
+    SOCKET socket,
+    /*! [in] IPv4 address of the additional interface of the socket, nullptr
+     * for the interface given to UpnpInit2(). M-SEARCH requests are answered
+     * with the location on this interface. */
+    const char* if_ipv4 = nullptr);
 
 /*!
  * \brief Creates the IPv4 and IPv6 ssdp sockets required by the
@@ -236,6 +251,88 @@ int get_ssdp_sockets(
     /*! [out] Array of SSDP sockets. */
     MiniServerSockArray* out);
 
+/*!
+ * \brief Creates the SSDP multicast sockets again after the addresses of the
+ * local interface have changed.
+ *
+ * The IPv4 and IPv6 SSDP sockets are closed and created with the current
+ * interface addresses so they join the multicast groups on the right
+ * interface. Sockets of addresses that are gone stay INVALID_SOCKET. The
+ * request sockets and the sockets on additional interfaces are not touched.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: Like get_ssdp_sockets(). The other sockets are still renewed.
+ */
+int ssdp_renew_sockets(
+    /*! [in,out] Array of SSDP sockets. */
+    MiniServerSockArray* out);
+
+/*!
+ * \brief Set additional interfaces to listen for SSDP multicast messages.
+ *
+ * For each interface with an IPv4 address, get_ssdp_sockets() creates its own
+ * IPv4 SSDP socket and the miniserver its own HTTP listener. It takes effect
+ * with the next start of the miniserver.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_INVALID_PARAM
+ *  - UPNP_E_INVALID_INTERFACE
+ *  - UPNP_E_NOT_EXIST on Microsoft Windows
+ */
+int SsdpSetInterfaces(
+    /*! [in] Names of the interfaces. */
+    const char* const* if_names,
+    /*! [in] Number of interfaces, at most SSDP_MAX_INTERFACES. */
+    int num_ifs);
+
+/*!
+ * \brief Set the IPv4 addresses of the additional interfaces that are served.
+ *
+ * The miniserver sets them when it has its sockets on the interfaces and
+ * clears them when it stops. Advertisements and searches are sent on each of
+ * them.
+ */
+void SsdpSetIfAddrs4(
+    /*! [in] IPv4 addresses. */
+    const std::vector<std::string>& addrs);
+
+/*!
+ * \brief Get the IPv4 addresses of the additional interfaces that are served.
+ */
+std::vector<std::string> SsdpGetIfAddrs4();
+
+/*!
+ * \brief Enable or disable the socket filter on the SSDP sockets.
+ *
+ * It takes effect with the next start of the miniserver.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_NOT_EXIST if not supported by the platform.
+ */
+int SsdpSetFilter(
+    /*! [in] Attach the filter. */
+    bool enable);
+
+/*!
+ * \brief Attach a classic BPF filter to an SSDP socket.
+ *
+ * The kernel drops all datagrams that are neither M-SEARCH nor NOTIFY
+ * requests before they wake up the miniserver. Only available on Linux.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_SOCKET_ERROR
+ *  - UPNP_E_NOT_EXIST if not supported by the platform.
+ */
+int SsdpAttachFilter(
+    /*! [in] SSDP socket. */
+    SOCKET sock);
+
 /// @} SSDP Common Functions
 
 #endif /* COMPA_SSDP_COMMON_HPP */
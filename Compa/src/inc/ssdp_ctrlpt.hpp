@@ -8,7 +8,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2024+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-06
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -45,6 +45,7 @@
  */
 
 #include <ssdp_common.hpp>
+#include <UpnpDiscovery.hpp>
 
 
 /// \brief SSDP search argument.
@@ -91,10 +92,15 @@ UPNPLIB_API void ssdp_handle_ctrlpt_msg(
  *     - "urn:<domain-name>:device:<deviceType:v>"
  *     - "urn:<domain-name>:service:<serviceType:v>"
  *
+ * The function does not wait for the network. It sends the first copy of the
+ * request and schedules the other NUM_SSDP_COPY - 1 copies on the timer
+ * thread, each SSDP_PAUSE milliseconds after the previous one.
+ *
  * \returns
  *  On success: **1**\n
  *  On error:
  *  - UPNP_E_INVALID_PARAM
+ *  - UPNP_E_OUTOF_MEMORY
  *  - UPNP_E_INTERNAL_ERROR
  *  - UPNP_E_INVALID_ARGUMENT
  *  - UPNP_E_BUFFER_TOO_SMALL
@@ -134,6 +140,55 @@ int create_ssdp_sock_reqv6(
     /*! [out] SSDP IPv6 request socket to be created. */
     SOCKET* ssdpReqSock);
 
+/// \brief Statistic of the control point discovery cache.
+struct SsdpCacheStats {
+    /// Number of cached unique service names (USN).
+    size_t entries;
+    /// Number of duplicate messages that were not passed to the control point.
+    size_t hits;
+    /// Number of messages that were passed to the control point.
+    size_t misses;
+    /// Number of entries removed after their max-age.
+    size_t expired;
+    /// Number of entries removed to make room, see SSDP_CACHE_MAX_ENTRIES.
+    size_t evicted;
+};
+
+/*!
+ * \brief Get the statistic of the control point discovery cache.
+ *
+ * ssdp_handle_ctrlpt_msg() keeps each received advertisement and search reply
+ * in a cache keyed by its USN until its max-age is over. A copy of a message
+ * that is already cached only refreshes the entry and does not call the
+ * control point again. This is the case for the copies that every device
+ * sends of each message. A search reply is passed on once per search.
+ * Messages without a valid USN are always passed on and not cached.
+ */
+UPNPLIB_API void SsdpCacheGetStats(
+    /*! [out] Pointer to the structure that gets the statistic. */
+    SsdpCacheStats* stats);
+
+/*!
+ * \brief Visit all devices and services of the discovery cache that are
+ * currently alive, without network traffic.
+ *
+ * \note The cache is locked while visiting. The visit function must not call
+ * other SsdpCache* functions.
+ *
+ * \returns Number of visited entries.
+ */
+UPNPLIB_API int SsdpCacheGetAlive(
+    /*! [in] Function that is called with the last discovery information of
+     * each entry. */
+    void (*visit)(const UpnpDiscovery* disc, void* cookie),
+    /*! [in] Pointer that is given to the visit function. */
+    void* cookie);
+
+/*!
+ * \brief Remove all entries from the discovery cache and reset its statistic.
+ */
+UPNPLIB_API void SsdpCacheClear();
+
 /// @} // SSDP Control Point Functions
 
 #endif // COMPA_SSDP_CTRLPT_HPP
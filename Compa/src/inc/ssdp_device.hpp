@@ -8,7 +8,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2024+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-03
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -61,7 +61,10 @@ void ssdp_handle_device_request(
     /*! [in] */
     http_message_t* hmsg,
     /*! [in] */
-    struct sockaddr_storage* dest_addr);
+    struct sockaddr_storage* dest_addr,
+    /*! [in] IPv4 address of the additional interface that got the request,
+     * nullptr for the interface given to UpnpInit2(). */
+    const char* if_ipv4 = nullptr);
 
 
 /*! @{
@@ -70,6 +73,10 @@ void ssdp_handle_device_request(
 /*!
  * \brief Sends SSDP advertisements, replies and shutdown messages.
  *
+ * An IPv4 device is advertised on each additional interface too, see
+ * SsdpSetIfAddrs4(). The location URL on an interface has the address of the
+ * interface instead of the address of the interface given to UpnpInit2().
+ *
  * \note This function is only available when the Device option was enabled on
  * compiling the library.
  *
@@ -95,7 +102,11 @@ UPNPLIB_API int AdvertiseAndReply(
     /*! [in] Service type. */
     char* ServiceType,
     /*! [in] Advertisement age. */
-    int Exp);
+    int Exp,
+    /*! [in] IPv4 address of the additional interface that got the search,
+     * nullptr for the interface given to UpnpInit2(). Only used for replies,
+     * advertisements and shutdown messages are sent on every interface. */
+    const char* IfIpv4 = nullptr);
 
 /*!
  * \brief Wrapper function to reply the search request coming from the
@@ -136,7 +147,10 @@ int DeviceAdvertisement(
     /* [in] SleepPeriod as defined by UPnP Low Power. */
     int SleepPeriod,
     /* [in] RegistrationState as defined by UPnP Low Power. */
-    int RegistrationState);
+    int RegistrationState,
+    /* [in] IPv4 address of an additional interface to send on, nullptr
+     * for the interface given to UpnpInit2(). */
+    const char* IfIpv4 = nullptr);
 
 /*!
  * \brief Creates the reply packet and send it to the Control Point addesss.
@@ -237,7 +251,10 @@ int ServiceAdvertisement(
     /*! [in] SleepPeriod as defined by UPnP Low Power. */
     int SleepPeriod,
     /*! [in] RegistrationState as defined by UPnP Low Power. */
-    int RegistrationState);
+    int RegistrationState,
+    /*! [in] IPv4 address of an additional interface to send on, nullptr
+     * for the interface given to UpnpInit2(). */
+    const char* IfIpv4 = nullptr);
 
 /*!
  * \brief Creates the advertisement packet and send it to the multicast channel.
@@ -298,7 +315,10 @@ int ServiceShutdown(
     /* [in] SleepPeriod as defined by UPnP Low Power. */
     int SleepPeriod,
     /* [in] RegistrationState as defined by UPnP Low Power. */
-    int RegistrationState);
+    int RegistrationState,
+    /* [in] IPv4 address of an additional interface to send on, nullptr
+     * for the interface given to UpnpInit2(). */
+    const char* IfIpv4 = nullptr);
 
 /*!
  * \brief Creates a HTTP device shutdown request packet and send it to the
@@ -331,7 +351,59 @@ int DeviceShutdown(
     /*! [in] SleepPeriod as defined by UPnP Low Power. */
     int SleepPeriod,
     /*! [in] RegistrationState as defined by UPnP Low Power. */
-    int RegistrationState);
+    int RegistrationState,
+    /*! [in] IPv4 address of an additional interface to send on, nullptr
+     * for the interface given to UpnpInit2(). */
+    const char* IfIpv4 = nullptr);
+
+/// \brief Statistic of the limits for search replies.
+struct SsdpSearchStats {
+    /// Number of received valid searches.
+    size_t received;
+    /// Number of searches dropped because their source sent too many.
+    size_t dropped_rate;
+    /// Number of replies dropped because too many were scheduled.
+    size_t dropped_queue;
+    /// Number of replies merged into an equal scheduled reply.
+    size_t merged;
+    /// Number of replies scheduled now.
+    size_t pending;
+};
+
+/*!
+ * \brief Get the statistic of the limits for search replies.
+ *
+ * ssdp_handle_device_request() answers the searches from one source with a
+ * token bucket, i.e. not more than a burst at once and then a fixed rate.
+ * An equal search from the same source is merged into a scheduled reply, and
+ * the number of scheduled replies is limited.
+ */
+UPNPLIB_API void SsdpGetSearchStats(
+    /*! [out] Pointer to the structure that gets the statistic. */
+    SsdpSearchStats* stats);
+
+/*!
+ * \brief Set the limits for search replies.
+ *
+ * The defaults are SSDP_SEARCH_RATE, SSDP_SEARCH_BURST and
+ * SSDP_MAX_PENDING_REPLIES.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_INVALID_PARAM
+ */
+UPNPLIB_API int SsdpSetSearchLimit(
+    /*! [in] Searches per second answered from one source. */
+    double rate,
+    /*! [in] Searches answered from one source at once. */
+    int burst,
+    /*! [in] Maximal number of scheduled replies. */
+    int max_pending);
+
+/*!
+ * \brief Forget the sources of searches and reset the statistic.
+ */
+UPNPLIB_API void SsdpSearchLimitClear();
 
 /// @} SSDP Device Functions
 
@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-04-22
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -43,6 +43,10 @@
 #include <VirtualDir.hpp> /* for struct VirtualDirCallbacks */
 #include <client_table.hpp>
 
+/// \cond
+#include <shared_mutex>
+/// \endcond
+
 /// MAX_INTERFACES
 #define MAX_INTERFACES 256
 
@@ -221,9 +225,14 @@ UPNPLIB_API extern unsigned gIF_IPV6_ULA_GUA_PREFIX_LENGTH;
 
 UPNPLIB_API extern unsigned gIF_INDEX;
 
+/*! \brief Protects the interface address globals gIF_* while the miniserver
+ * takes changed addresses. Other threads take it shared to read them. */
+UPNPLIB_API extern std::shared_mutex gIfAddrMutex;
+
 UPNPLIB_API extern unsigned short LOCAL_PORT_V4;
 UPNPLIB_API extern unsigned short LOCAL_PORT_V6;
 UPNPLIB_API extern unsigned short LOCAL_PORT_V6_ULA_GUA;
+UPNPLIB_API extern unsigned short LOCAL_PORT_TLS_V4;
 
 /*! NLS uuid. */
 extern Upnp_SID gUpnpSdkNLSuuid;
@@ -232,6 +241,8 @@ extern TimerThread gTimerThread;
 extern ThreadPool gRecvThreadPool;
 extern ThreadPool gSendThreadPool;
 extern ThreadPool gMiniServerThreadPool;
+/*! CPU the dedicated I/O threads are bound to, -1 for none. */
+extern int gIoThreadCpu;
 
 /// UpnpFunName
 typedef enum {
@@ -313,6 +324,27 @@ void AutoAdvertise(
     /*! [in] Information provided to the thread. */
     void* input);
 
+/*!
+ * \brief Schedule jobs that advertise all registered devices once, e.g. after
+ * the addresses of the local interface have changed.
+ */
+void ReadvertiseDevices();
+
+/*!
+ * \brief Move the description URLs of all registered devices to the current
+ * addresses of the local interface.
+ *
+ * A description URL with one of the previous addresses as host gets the
+ * current address of the same kind. Other URLs are not modified.
+ */
+void UpdateDescURLs(
+    /*! [in] Previous IPv4 address. */
+    const char* a_old_ipv4,
+    /*! [in] Previous IPv6 link-local address. */
+    const char* a_old_ipv6,
+    /*! [in] Previous IPv6 ULA or GUA address. */
+    const char* a_old_ipv6_ula_gua);
+
 /*!
  * \brief Print handle info.
  *
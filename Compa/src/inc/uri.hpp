@@ -5,7 +5,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-02-12
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -299,7 +299,9 @@ UPNPLIB_API char* resolve_rel_url(
  *
  * \returns
  *  On success: HTTP_SUCCESS\n
- *  On error: UPNP_E_INVALID_URL
+ *  On error:
+ *  - UPNP_E_INVALID_URL
+ *  - UPNP_E_TRY_AGAIN - the host name is still looked up
  */
 UPNPLIB_API int parse_uri(
     /*! [in] Character string containing uri information to be parsed. */
@@ -323,4 +325,55 @@ int parse_token(
     /*! [in] . */
     int max_size);
 
+/*!
+ * \name Host name resolver
+ * Host names of URLs are looked up by a few resolver threads so a slow name
+ * server does not stall the thread that parses the URL, and a slow host name
+ * does not stall the lookup of others. Results are cached,
+ * positive ones for RESOLVER_TTL and negative ones for RESOLVER_NEGATIVE_TTL
+ * seconds. Without a started resolver host names are looked up directly and
+ * not cached.
+ * @{
+ */
+
+/*!
+ * \brief Starts the resolver threads.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_INIT_FAILED
+ */
+UPNPLIB_API int resolver_start(
+    /*! [in] CPU the threads are bound to, -1 for none. */
+    int cpu);
+
+/*!
+ * \brief Stops the resolver threads and clears the cache.
+ */
+UPNPLIB_API void resolver_stop();
+
+/*!
+ * \brief Returns the address of a host name.
+ *
+ * If the host isn't cached it is queued for the resolver threads and waited for
+ * at most \b wait_ms milliseconds. An expired address is still returned while
+ * it is looked up again.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS with the address without port\n
+ *  On error:
+ *  - UPNP_E_INVALID_PARAM - \b host or \b addr is nullptr
+ *  - UPNP_E_INVALID_URL - the host is unknown
+ *  - UPNP_E_TRY_AGAIN - the host is still looked up, try again later
+ */
+UPNPLIB_API int resolver_lookup(
+    /*! [in] Host name. */
+    const char* host,
+    /*! [in] Maximal time to wait for the resolver threads in milliseconds. */
+    int wait_ms,
+    /*! [out] Address of the host. */
+    sockaddr_storage* addr);
+
+/// @} Host name resolver
+
 #endif /* COMPA_GENLIB_NET_URI_HPP */
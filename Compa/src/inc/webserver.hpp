@@ -5,7 +5,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -41,9 +41,17 @@
 #include <miniserver.hpp>
 #include <sock.hpp>
 
+/// \cond
+#include <mutex>
+/// \endcond
+
 /*! Global variable. A local dir which serves as webserver root. */
 inline membuffer gDocumentRootDir;
 
+/*! \brief Mutex to serialize changes of the XML document and of the virtual
+ * directories. Requests never take it. */
+inline std::mutex gWebMutex;
+
 /// \brief Send instruction
 struct SendInstruction {
     /// @{
@@ -105,7 +113,8 @@ UPNPLIB_API int web_server_init();
  *
  * \return
  * \li \c UPNP_E_SUCCESS
- * \li \c UPNP_E_OUTOF_MEMORY
+ * \li \c UPNP_E_INVALID_ARGUMENT
+ * \li \c UPNP_E_OUTOF_MEMORY, the previous alias is removed then.
  */
 UPNPLIB_API int web_server_set_alias(
     /*! [in] Webserver name of alias; created by caller and freed by caller
@@ -120,6 +129,22 @@ UPNPLIB_API int web_server_set_alias(
      */
     time_t last_modified);
 
+/*!
+ * \brief Publish the virtual directories of pVirtualDirList to the web
+ * server.
+ *
+ * Must be called after each change of the list, with gWebMutex held since
+ * before the change. Requests look up the virtual directories without
+ * locking. Requests that are already processed keep the previous
+ * directories. On error the previous directories are still served, so the
+ * caller should undo its change of the list.
+ *
+ * \return
+ * \li \c UPNP_E_SUCCESS
+ * \li \c UPNP_E_OUTOF_MEMORY
+ */
+UPNPLIB_API int web_server_update_virtual_dirs();
+
 /*!
  * \brief Assign the path to the global Document root directory.
  *
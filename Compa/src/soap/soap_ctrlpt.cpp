@@ -3,7 +3,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-02-28
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -44,9 +44,14 @@
 
 #include <httpreadwrite.hpp>
 #include <parsetools.hpp>
+#include <sock.hpp>
 #include <statcodes.hpp>
 #include <upnpapi.hpp>
 
+#include <upnplib/connection_common.hpp>
+#include <upnplib/socket.hpp> // needed for compiling on win32.
+#include <umock/sys_socket.hpp>
+
 #ifndef COMPA_INTERNAL_CONFIG_HPP
 #error "No or wrong config.hpp header file included."
 #endif
@@ -57,6 +62,18 @@
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#ifndef _WIN32
+#include <poll.h>
+#endif
 /// \endcond
 
 
@@ -218,7 +235,9 @@ const DOMString get_node_value( //
  *
  * \returns
  *  On success: **0**\n
- *  On error: **-1**
+ *  On error:
+ *  - UPNP_E_TRY_AGAIN - the host name is still looked up
+ *  - **-1** - any other error
  */
 inline int get_host_and_path( //
     char* ctrl_url,           ///< [in] URL
@@ -226,7 +245,10 @@ inline int get_host_and_path( //
     const memptr* path,       ///< [out] path string
     uri_type* url             ///< [out] URL type
 ) {
-    if (parse_uri(ctrl_url, strlen(ctrl_url), url) != HTTP_SUCCESS) {
+    const int ret_code{parse_uri(ctrl_url, strlen(ctrl_url), url)};
+    if (ret_code == UPNP_E_TRY_AGAIN)
+        return ret_code;
+    if (ret_code != HTTP_SUCCESS) {
         return -1;
     }
     /* This is done to ensure that the buffer is kept const */
@@ -483,24 +505,25 @@ error_handler:
     return err_code;
 }
 
-/// @} // Functions scope restricted to file
-} // anonymous namespace
-
-
-int SoapSendAction(char* action_url, char* service_type,
-                   IXML_Document* action_node, IXML_Document** response_node) {
-    char* action_str = NULL;
+/*!
+ * \brief Make the HTTP request message of a SOAP action.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_OUTOF_MEMORY
+ *  - UPNP_E_INVALID_ACTION
+ *  - UPNP_E_INVALID_URL
+ */
+int make_action_request(    //
+    char* action_url,       ///< [in] device contrl URL.
+    char* service_type,     ///< [in] device service type.
+    char* action_str,       ///< [in] Printed SOAP action node.
+    uri_type* url,          ///< [out] Parsed URL, points into \p action_url.
+    membuffer* request,     ///< [out] The request message.
+    membuffer* responsename ///< [out] Name of the expected response node.
+) {
     memptr name;
-    membuffer request;
-    membuffer responsename;
-    int err_code;
-    int ret_code;
-    http_parser_t response;
-    uri_type url;
-    int upnp_error_code;
-    char* upnp_error_str;
-    int got_response = 0;
-
     off_t content_length;
     const char* xml_start =
         "<s:Envelope "
@@ -513,44 +536,31 @@ int SoapSendAction(char* action_url, char* service_type,
     size_t xml_end_len;
     size_t action_str_len;
 
-    *response_node = NULL; /* init */
-
-    err_code = UPNP_E_OUTOF_MEMORY; /* default error */
-
-    UpnpPrintf(UPNP_INFO, SOAP, __FILE__, __LINE__, "Inside SoapSendAction():");
-    /* init */
-    membuffer_init(&request);
-    membuffer_init(&responsename);
-
-    /* print action */
-    action_str = ixmlPrintNode((IXML_Node*)action_node);
-    if (action_str == NULL) {
-        goto error_handler;
-    }
     /* get action name */
     if (get_action_name(action_str, &name) != 0) {
-        err_code = UPNP_E_INVALID_ACTION;
-        goto error_handler;
+        return UPNP_E_INVALID_ACTION;
     }
     /* parse url */
-    if (http_FixStrUrl(action_url, strlen(action_url), &url) != 0) {
-        err_code = UPNP_E_INVALID_URL;
-        goto error_handler;
+    const int ret_code{http_FixStrUrl(action_url, strlen(action_url), url)};
+    if (ret_code == UPNP_E_TRY_AGAIN)
+        return ret_code;
+    if (ret_code != 0) {
+        return UPNP_E_INVALID_URL;
     }
 
     UpnpPrintf(UPNP_INFO, SOAP, __FILE__, __LINE__,
-               "path=%.*s, hostport=%.*s\n", (int)url.pathquery.size,
-               url.pathquery.buff, (int)url.hostport.text.size,
-               url.hostport.text.buff);
+               "path=%.*s, hostport=%.*s\n", (int)url->pathquery.size,
+               url->pathquery.buff, (int)url->hostport.text.size,
+               url->hostport.text.buff);
 
     xml_start_len = strlen(xml_start);
     xml_end_len = strlen(xml_end);
     action_str_len = strlen(action_str);
 
     /* make request msg */
-    request.size_inc = 50;
+    request->size_inc = 50;
     content_length = (off_t)(xml_start_len + action_str_len + xml_end_len);
-    if (http_MakeMessage(&request, 1, 1,
+    if (http_MakeMessage(request, 1, 1,
                          "q"
                          "N"
                          "s"
@@ -559,11 +569,971 @@ int SoapSendAction(char* action_url, char* service_type,
                          "b"
                          "b"
                          "b",
-                         SOAPMETHOD_POST, &url, content_length,
+                         SOAPMETHOD_POST, url, content_length,
                          ContentTypeHeader, "SOAPACTION: \"", service_type, "#",
                          name.buf, name.length, "\"", xml_start, xml_start_len,
                          action_str, action_str_len, xml_end,
                          xml_end_len) != 0) {
+        return UPNP_E_OUTOF_MEMORY;
+    }
+    if (membuffer_append(responsename, name.buf, name.length) != 0 ||
+        membuffer_append_str(responsename, "Response") != 0) {
+        return UPNP_E_OUTOF_MEMORY;
+    }
+
+    return UPNP_E_SUCCESS;
+}
+
+/// @} // Functions scope restricted to file
+
+
+/*! \name Event loop for non-blocking actions
+ * @{ */
+/// \brief State of a non-blocking action.
+enum class action_state_t { connecting, sending, receiving };
+
+/*!
+ * \brief A SOAP action that is sent by the event loop.
+ */
+struct soap_action_op_t {
+    /// Control URL; url points into it.
+    std::string action_url;
+    /// Parsed control URL.
+    uri_type url{};
+    /// Host and port of the control URL, the key for the per device limit.
+    std::string host;
+    /// Request message.
+    membuffer request{};
+    /// Name of the expected response node.
+    membuffer responsename{};
+    /// Parser of the response.
+    http_parser_t response{};
+    /// Set if response must be destroyed.
+    bool response_init{false};
+    /// The response may end with closing the connection.
+    bool ok_on_close{false};
+    /// Set if the request was changed to M-POST.
+    bool mpost{false};
+    /// Connection to the device.
+    SOCKET sock{INVALID_SOCKET};
+    /// What the action waits for.
+    action_state_t state{action_state_t::connecting};
+    /// Number of bytes of the request that are sent.
+    size_t sent{};
+    /// Time when the action fails with UPNP_E_TIMEDOUT.
+    std::chrono::steady_clock::time_point deadline;
+    /// Copy of the action document, given with the completion event.
+    IXML_Document* action{nullptr};
+    /// Callback of the control point.
+    Upnp_FunPtr fun{nullptr};
+    /// Cookie of the control point.
+    void* cookie{nullptr};
+
+    soap_action_op_t() {
+        membuffer_init(&this->request);
+        membuffer_init(&this->responsename);
+    }
+    ~soap_action_op_t() {
+        this->close_connection();
+        membuffer_destroy(&this->request);
+        membuffer_destroy(&this->responsename);
+        ixmlDocument_free(this->action);
+    }
+    /// Close the connection and forget a partial response.
+    void close_connection() {
+        if (this->sock != INVALID_SOCKET)
+            sock_close(this->sock);
+        this->sock = INVALID_SOCKET;
+        if (this->response_init)
+            httpmsg_destroy(&this->response.msg);
+        this->response_init = false;
+        this->ok_on_close = false;
+        this->sent = 0;
+    }
+};
+
+/// \brief Shared data of the event loop.
+struct soap_action_loop_t {
+    /// Protects all members.
+    std::mutex mutex;
+    /// Signaled when the loop has finished.
+    std::condition_variable finished;
+    /// Set while the loop is running.
+    bool running{false};
+    /// Thread that runs the loop, outside of the thread pools.
+    DedicatedThread thread{};
+    /// Set to stop the loop.
+    bool stop{false};
+    /// Loopback datagram socket to wake up the loop.
+    SOCKET wakeup{INVALID_SOCKET};
+    /// Actions waiting to be started, per host.
+    std::unordered_map<std::string, std::deque<std::unique_ptr<soap_action_op_t>>>
+        queued;
+    /// Maximal number of actions in flight to one device.
+    int max_per_device{SOAP_ACTION_MAX_PER_DEVICE};
+    /// Maximal number of actions in flight.
+    int max_in_flight{SOAP_ACTION_MAX_IN_FLIGHT};
+} gActionLoop;
+
+/// \brief Argument of the job that calls back the control point.
+struct action_done_arg_t {
+    Upnp_FunPtr fun;
+    void* cookie;
+    UpnpActionComplete* event;
+};
+
+/// \brief Free the argument of the callback job without calling back.
+void free_action_done_arg(void* arg) {
+    action_done_arg_t* done = static_cast<action_done_arg_t*>(arg);
+    ixmlDocument_free(UpnpActionComplete_get_ActionRequest(done->event));
+    ixmlDocument_free(UpnpActionComplete_get_ActionResult(done->event));
+    UpnpActionComplete_delete(done->event);
+    delete done;
+}
+
+/// \brief Job that calls back the control point with the completed action.
+void action_done_job(void* arg) {
+    action_done_arg_t* done = static_cast<action_done_arg_t*>(arg);
+    done->fun(UPNP_CONTROL_ACTION_COMPLETE, done->event, done->cookie);
+    free_action_done_arg(done);
+}
+
+/*!
+ * \brief Complete an action and call back the control point.
+ *
+ * The callback runs on the send thread pool so the loop does not wait for the
+ * control point. The action is destroyed.
+ */
+void complete_action(
+    /*! [in] The action. */
+    std::unique_ptr<soap_action_op_t> op,
+    /*! [in] Error code for the completion event. */
+    int err_code,
+    /*! [in] Response document, or nullptr. Ownership is taken. */
+    IXML_Document* result) {
+    UpnpActionComplete* event = UpnpActionComplete_new();
+    UpnpActionComplete_set_ErrCode(event, err_code);
+    UpnpActionComplete_set_ActionRequest(event, op->action);
+    op->action = nullptr;
+    UpnpActionComplete_set_ActionResult(event, result);
+    UpnpActionComplete_strcpy_CtrlUrl(event, op->action_url.c_str());
+    action_done_arg_t* done =
+        new action_done_arg_t{op->fun, op->cookie, event};
+    op.reset();
+
+    ThreadPoolJob job;
+    memset(&job, 0, sizeof(job));
+    TPJobInit(&job, (start_routine)action_done_job, done);
+    TPJobSetLabel(&job, JOB_LABEL_SOAP);
+    TPJobSetFreeFunction(&job, (free_routine)free_action_done_arg);
+    TPJobSetPriority(&job, MED_PRIORITY);
+    if (ThreadPoolAdd(&gSendThreadPool, &job, NULL) != 0)
+        action_done_job(done);
+}
+
+/*!
+ * \brief Check if the last socket operation would have to wait.
+ */
+bool socket_would_block() {
+#ifdef _WIN32
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    return errno == EINPROGRESS || errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+}
+
+/*!
+ * \brief Start the connection of an action to the device.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_SOCKET or UPNP_E_SOCKET_CONNECT
+ */
+int start_connection(soap_action_op_t* op) {
+    const sockaddr_storage& addr = op->url.hostport.IPaddress;
+    op->sock = umock::sys_socket_h.socket(addr.ss_family, SOCK_STREAM, 0);
+    if (op->sock == INVALID_SOCKET)
+        return UPNP_E_OUTOF_SOCKET;
+    if (sock_make_no_blocking(op->sock) != 0)
+        return UPNP_E_SOCKET_CONNECT;
+    const socklen_t addr_len = addr.ss_family == AF_INET6
+                                   ? sizeof(sockaddr_in6)
+                                   : sizeof(sockaddr_in);
+    op->state = action_state_t::connecting;
+    if (umock::sys_socket_h.connect(op->sock, (const sockaddr*)&addr,
+                                    addr_len) == 0) {
+        op->state = action_state_t::sending;
+    } else if (!socket_would_block()) {
+        return UPNP_E_SOCKET_CONNECT;
+    }
+    return UPNP_E_SUCCESS;
+}
+
+/*!
+ * \brief Continue an action on an event of its socket.
+ *
+ * \returns
+ *  - 1 if the action is waiting for the next event.
+ *  - 0 if the response is complete.
+ *  - An error code of the action otherwise.
+ */
+int handle_action_io(soap_action_op_t* op) {
+    if (op->state == action_state_t::connecting) {
+        int so_error{};
+        socklen_t len{sizeof(so_error)};
+        if (umock::sys_socket_h.getsockopt(op->sock, SOL_SOCKET, SO_ERROR,
+                                           (char*)&so_error, &len) != 0 ||
+            so_error != 0)
+            return UPNP_E_SOCKET_CONNECT;
+        op->state = action_state_t::sending;
+    }
+    if (op->state == action_state_t::sending) {
+        UPNPLIB_SCOPED_NO_SIGPIPE
+        const SSIZEP_T num_written = umock::sys_socket_h.send(
+            op->sock, op->request.buf + op->sent,
+            static_cast<SIZEP_T>(op->request.length - op->sent), 0);
+        if (num_written < 0)
+            return socket_would_block() ? 1 : UPNP_E_SOCKET_WRITE;
+        op->sent += static_cast<size_t>(num_written);
+        if (op->sent < op->request.length)
+            return 1;
+        parser_response_init(&op->response, op->mpost ? HTTPMETHOD_MPOST
+                                                      : SOAPMETHOD_POST);
+        op->response_init = true;
+        op->state = action_state_t::receiving;
+        return 1;
+    }
+
+    // Receiving
+    constexpr size_t read_size{4096};
+    char* buf = parser_append_reserve(&op->response, read_size);
+    if (buf == nullptr)
+        return UPNP_E_OUTOF_MEMORY;
+    const SSIZEP_T num_read = umock::sys_socket_h.recv(
+        op->sock, buf, static_cast<SIZEP_T>(read_size), 0);
+    if (num_read < 0)
+        return socket_would_block() ? 1 : UPNP_E_SOCKET_READ;
+    if (num_read == 0)
+        return op->ok_on_close ? 0 : UPNP_E_BAD_HTTPMSG;
+    switch (parser_append_commit(&op->response, static_cast<size_t>(num_read))) {
+    case PARSE_SUCCESS:
+        return 0;
+    case PARSE_FAILURE:
+    case PARSE_NO_MATCH:
+        return UPNP_E_BAD_HTTPMSG;
+    case PARSE_INCOMPLETE_ENTITY:
+        /* read until close */
+        op->ok_on_close = true;
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+/*!
+ * \brief Evaluate the complete response of an action.
+ *
+ * \returns
+ *  - 1 if the request is sent again as M-POST.
+ *  - The error code of the action otherwise.
+ */
+int finish_action_response(soap_action_op_t* op, IXML_Document** result) {
+    /* method-not-allowed error */
+    if (op->response.msg.status_code == HTTP_METHOD_NOT_ALLOWED &&
+        !op->mpost) {
+        op->close_connection();
+        op->mpost = true;
+        int ret_code = add_man_header(&op->request); /* change to M-POST msg */
+        if (ret_code == 0)
+            ret_code = start_connection(op);
+        return ret_code == 0 ? 1 : ret_code;
+    }
+    int upnp_error_code{};
+    char* upnp_error_str{nullptr};
+    const int ret_code = get_response_value(
+        &op->response.msg, SOAP_ACTION_RESP, op->responsename.buf,
+        &upnp_error_code, (IXML_Node**)result, &upnp_error_str);
+    if (ret_code == SOAP_ACTION_RESP)
+        return UPNP_E_SUCCESS;
+    if (ret_code == SOAP_ACTION_RESP_ERROR)
+        return upnp_error_code;
+    return ret_code;
+}
+
+/*!
+ * \brief The event loop that sends non-blocking actions.
+ *
+ * It runs as persistent job on the send thread pool. All connections are
+ * driven by one poll() so there is no thread per action.
+ */
+void soap_action_loop([[maybe_unused]] void* arg) {
+    std::vector<std::unique_ptr<soap_action_op_t>> active;
+    std::unordered_map<std::string, int> per_host;
+    std::vector<pollfd> fds;
+    std::vector<std::pair<std::unique_ptr<soap_action_op_t>, int>> done;
+    SOCKET wakeup;
+
+    for (;;) {
+        // Start waiting actions within the limits.
+        {
+            std::scoped_lock lock(gActionLoop.mutex);
+            if (gActionLoop.stop)
+                break;
+            wakeup = gActionLoop.wakeup;
+            for (auto it = gActionLoop.queued.begin();
+                 it != gActionLoop.queued.end();) {
+                int& in_flight = per_host[it->first];
+                while (!it->second.empty() &&
+                       in_flight < gActionLoop.max_per_device &&
+                       active.size() <
+                           static_cast<size_t>(gActionLoop.max_in_flight)) {
+                    std::unique_ptr<soap_action_op_t> op =
+                        std::move(it->second.front());
+                    it->second.pop_front();
+                    in_flight++;
+                    const int ret_code = start_connection(op.get());
+                    if (ret_code != UPNP_E_SUCCESS)
+                        done.emplace_back(std::move(op), ret_code);
+                    else
+                        active.push_back(std::move(op));
+                }
+                if (in_flight == 0)
+                    per_host.erase(it->first);
+                if (it->second.empty())
+                    it = gActionLoop.queued.erase(it);
+                else
+                    ++it;
+            }
+        }
+
+        // Wait for events.
+        fds.clear();
+        fds.push_back({wakeup, POLLIN, 0});
+        auto now = std::chrono::steady_clock::now();
+        auto next_deadline = now + std::chrono::seconds(1);
+        for (const auto& op : active) {
+            fds.push_back({op->sock,
+                           static_cast<short>(
+                               op->state == action_state_t::receiving ? POLLIN
+                                                                      : POLLOUT),
+                           0});
+            next_deadline = std::min(next_deadline, op->deadline);
+        }
+        if (done.empty()) {
+            const auto wait_ms =
+                std::chrono::duration_cast<std::chrono::milliseconds>(
+                    next_deadline - now)
+                    .count();
+#ifdef _WIN32
+            WSAPoll(fds.data(), static_cast<ULONG>(fds.size()),
+                    static_cast<INT>(std::max<long long>(wait_ms, 0) + 1));
+#else
+            poll(fds.data(), fds.size(),
+                 static_cast<int>(std::max<long long>(wait_ms, 0) + 1));
+#endif
+        }
+        if (fds[0].revents != 0) {
+            char buf[16];
+            while (umock::sys_socket_h.recv(wakeup, buf, sizeof(buf), 0) > 0) {
+            }
+        }
+
+        // Continue the actions.
+        now = std::chrono::steady_clock::now();
+        for (size_t i{0}; i < active.size();) {
+            soap_action_op_t* op = active[i].get();
+            int ret_code{1};
+            IXML_Document* result{nullptr};
+            if (fds[i + 1].revents != 0) {
+                ret_code = handle_action_io(op);
+                if (ret_code == 0)
+                    ret_code = finish_action_response(op, &result);
+            }
+            if (ret_code == 1 && now >= op->deadline)
+                ret_code = UPNP_E_TIMEDOUT;
+            if (ret_code == 1) {
+                i++;
+                continue;
+            }
+            // The action is finished.
+            if (--per_host[op->host] == 0)
+                per_host.erase(op->host);
+            complete_action(std::move(active[i]), ret_code, result);
+            active[i] = std::move(active.back());
+            active.pop_back();
+            fds[i + 1] = fds.back();
+            fds.pop_back();
+        }
+        for (auto& [op, ret_code] : done) {
+            if (--per_host[op->host] == 0)
+                per_host.erase(op->host);
+            complete_action(std::move(op), ret_code, nullptr);
+        }
+        done.clear();
+    }
+
+    // Shutdown: complete all actions.
+    {
+        std::scoped_lock lock(gActionLoop.mutex);
+        for (auto& [host, ops] : gActionLoop.queued) {
+            for (auto& op : ops)
+                active.push_back(std::move(op));
+        }
+        gActionLoop.queued.clear();
+    }
+    for (auto& op : active)
+        complete_action(std::move(op), UPNP_E_FINISH, nullptr);
+    std::scoped_lock lock(gActionLoop.mutex);
+    sock_close(gActionLoop.wakeup);
+    gActionLoop.wakeup = INVALID_SOCKET;
+    gActionLoop.running = false;
+    gActionLoop.finished.notify_all();
+}
+
+/*!
+ * \brief Wake up the event loop.
+ *
+ * Must be called with gActionLoop.mutex locked.
+ */
+void wakeup_action_loop() {
+    if (gActionLoop.wakeup != INVALID_SOCKET)
+        umock::sys_socket_h.send(gActionLoop.wakeup, "", 1, 0);
+}
+
+/*!
+ * \brief Start the event loop if it is not running.
+ *
+ * Must be called with gActionLoop.mutex locked.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_SOCKET or UPNP_E_OUTOF_MEMORY
+ */
+int start_action_loop() {
+    if (gActionLoop.running)
+        return UPNP_E_SUCCESS;
+
+    // A datagram socket connected to itself on the loopback interface wakes
+    // up poll().
+    SOCKET wakeup = umock::sys_socket_h.socket(AF_INET, SOCK_DGRAM, 0);
+    if (wakeup == INVALID_SOCKET)
+        return UPNP_E_OUTOF_SOCKET;
+    sockaddr_in saddr{};
+    saddr.sin_family = AF_INET;
+    saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t saddr_len{sizeof(saddr)};
+    if (umock::sys_socket_h.bind(wakeup, (sockaddr*)&saddr, saddr_len) != 0 ||
+        umock::sys_socket_h.getsockname(wakeup, (sockaddr*)&saddr,
+                                        &saddr_len) != 0 ||
+        umock::sys_socket_h.connect(wakeup, (sockaddr*)&saddr, saddr_len) !=
+            0 ||
+        sock_make_no_blocking(wakeup) != 0) {
+        sock_close(wakeup);
+        return UPNP_E_OUTOF_SOCKET;
+    }
+
+    // A previous loop has already released the mutex for the last time.
+    DedicatedThreadJoin(&gActionLoop.thread);
+    if (DedicatedThreadStart(&gActionLoop.thread,
+                             (start_routine)soap_action_loop, nullptr,
+                             gIoThreadCpu) != 0) {
+        sock_close(wakeup);
+        return UPNP_E_OUTOF_MEMORY;
+    }
+    gActionLoop.wakeup = wakeup;
+    gActionLoop.stop = false;
+    gActionLoop.running = true;
+    return UPNP_E_SUCCESS;
+}
+
+/*!
+ * \brief Queue an action with complete request to the event loop.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPNP_E_OUTOF_SOCKET or UPNP_E_OUTOF_MEMORY
+ */
+int queue_action(std::unique_ptr<soap_action_op_t> op) {
+    op->host.assign(op->url.hostport.text.buff, op->url.hostport.text.size);
+    op->deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(UPNP_TIMEOUT);
+
+    std::scoped_lock lock(gActionLoop.mutex);
+    const int err_code = start_action_loop();
+    if (err_code != UPNP_E_SUCCESS)
+        return err_code;
+    gActionLoop.queued[op->host].push_back(std::move(op));
+    wakeup_action_loop();
+
+    return UPNP_E_SUCCESS;
+}
+/// @}
+
+
+/*! \name Action templates
+ * @{ */
+/*!
+ * \brief Append a string with XML special characters replaced by entities.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: UPNP_E_OUTOF_MEMORY
+ */
+int append_xml_escaped(membuffer* buf, const char* str) {
+    const char* start = str;
+    for (const char* p = str; *p != '\0'; p++) {
+        const char* entity;
+        switch (*p) {
+        case '&':
+            entity = "&amp;";
+            break;
+        case '<':
+            entity = "&lt;";
+            break;
+        case '>':
+            entity = "&gt;";
+            break;
+        case '"':
+            entity = "&quot;";
+            break;
+        case '\'':
+            entity = "&apos;";
+            break;
+        default:
+            continue;
+        }
+        if (membuffer_append(buf, start, (size_t)(p - start)) != 0 ||
+            membuffer_append_str(buf, entity) != 0)
+            return UPNP_E_OUTOF_MEMORY;
+        start = p + 1;
+    }
+    return membuffer_append_str(buf, start) == 0 ? 0 : UPNP_E_OUTOF_MEMORY;
+}
+/// @}
+
+} // anonymous namespace
+
+/*!
+ * \brief Pre-serialized request of an action, see SoapMakeActionTemplate().
+ */
+struct s_UpnpActionTemplate {
+    /// Control URL; url points into it.
+    std::string action_url;
+    /// Parsed control URL.
+    uri_type url;
+    /// Name of the expected response node.
+    std::string responsename;
+    /// Request line and headers up to the value of CONTENT-LENGTH.
+    std::string head;
+    /// Rest of the headers after the value of CONTENT-LENGTH.
+    std::string head_end;
+    /// SOAP envelope up to the first argument.
+    std::string body_start;
+    /// Start tags of the arguments.
+    std::vector<std::string> arg_start;
+    /// End tags of the arguments.
+    std::vector<std::string> arg_end;
+    /// End of the SOAP envelope after the last argument.
+    std::string body_end;
+};
+
+namespace {
+/*!
+ * \brief Fill the argument values into the template of an action.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error:
+ *  - UPNP_E_INVALID_PARAM
+ *  - UPNP_E_OUTOF_MEMORY
+ */
+int fill_action_template(
+    /*! [in] Action template. */
+    const UpnpActionTemplate* tmpl,
+    /*! [in] Values of the arguments. */
+    const char* const* arg_values,
+    /*! [out] The request message. */
+    membuffer* request) {
+    for (size_t i{0}; i < tmpl->arg_start.size(); i++) {
+        if (arg_values == nullptr || arg_values[i] == nullptr)
+            return UPNP_E_INVALID_PARAM;
+    }
+    membuffer body;
+    membuffer_init(&body);
+    int ret_code{UPNP_E_OUTOF_MEMORY};
+    if (membuffer_append(&body, tmpl->body_start.data(),
+                         tmpl->body_start.size()) != 0)
+        goto exit_function;
+    for (size_t i{0}; i < tmpl->arg_start.size(); i++) {
+        if (membuffer_append(&body, tmpl->arg_start[i].data(),
+                             tmpl->arg_start[i].size()) != 0 ||
+            append_xml_escaped(&body, arg_values[i]) != 0 ||
+            membuffer_append(&body, tmpl->arg_end[i].data(),
+                             tmpl->arg_end[i].size()) != 0)
+            goto exit_function;
+    }
+    if (membuffer_append(&body, tmpl->body_end.data(), tmpl->body_end.size()) !=
+        0)
+        goto exit_function;
+    {
+        const std::string content_length{std::to_string(body.length)};
+        request->size_inc = 50;
+        if (membuffer_set_size(request, tmpl->head.size() +
+                                            content_length.size() +
+                                            tmpl->head_end.size() +
+                                            body.length) != 0 ||
+            membuffer_append(request, tmpl->head.data(), tmpl->head.size()) !=
+                0 ||
+            membuffer_append(request, content_length.data(),
+                             content_length.size()) != 0 ||
+            membuffer_append(request, tmpl->head_end.data(),
+                             tmpl->head_end.size()) != 0 ||
+            membuffer_append(request, body.buf, body.length) != 0)
+            goto exit_function;
+    }
+    ret_code = UPNP_E_SUCCESS;
+
+exit_function:
+    membuffer_destroy(&body);
+    return ret_code;
+}
+/// @}
+
+
+/*! \name Streaming response extractor
+ * @{ */
+/// \brief A tag of an XML element found by next_xml_tag().
+struct xml_tag_t {
+    const char* start;    ///< Position of the '<'.
+    const char* name;     ///< Local name without namespace prefix.
+    size_t name_len;      ///< Length of the local name.
+    bool is_end{false};   ///< It is an end tag.
+    bool is_empty{false}; ///< It is an empty element tag.
+};
+
+/*!
+ * \brief Get the local name of a possibly prefixed XML name.
+ *
+ * \returns The name behind the namespace prefix, or the name itself.
+ */
+std::string_view xml_local_name(
+    /*! [in] XML name, e.g. "u:GetStatusResponse". */
+    std::string_view name) {
+    const size_t colon = name.find(':');
+    return colon == std::string_view::npos ? name : name.substr(colon + 1);
+}
+
+/*!
+ * \brief Find the next tag of an element.
+ *
+ * Processing instructions and comments are skipped. The text before the tag
+ * is only allowed to be white space if \p text is nullptr.
+ *
+ * \returns
+ *  On success: Pointer behind the tag\n
+ *  On error: nullptr if the XML needs a full parser.
+ */
+const char* next_xml_tag(
+    /*! [in] Current position. */
+    const char* p,
+    /*! [in] End of the buffer. */
+    const char* end,
+    /*! [out] The found tag. */
+    xml_tag_t* tag,
+    /*! [out] Start of the text before the tag, may be nullptr. */
+    const char** text = nullptr) {
+    if (text != nullptr)
+        *text = p;
+    while (p < end) {
+        if (*p != '<') {
+            if (text == nullptr && !isspace((unsigned char)*p))
+                return nullptr;
+            p++;
+            continue;
+        }
+        const std::string_view rest(p, (size_t)(end - p));
+        if (rest.compare(0, 2, "<?") == 0 || rest.compare(0, 4, "<!--") == 0) {
+            if (text != nullptr)
+                return nullptr; // mixed with the text of a value
+            const bool is_pi{p[1] == '?'};
+            const size_t close = rest.find(is_pi ? "?>" : "-->");
+            if (close == std::string_view::npos)
+                return nullptr;
+            p += close + (is_pi ? 2 : 3);
+            continue;
+        }
+        if (p + 1 >= end || p[1] == '!') // incomplete, CDATA or DOCTYPE
+            return nullptr;
+
+        tag->start = p++;
+        tag->is_end = (p < end && *p == '/');
+        if (tag->is_end)
+            p++;
+        const char* name = p;
+        while (p < end && !isspace((unsigned char)*p) && *p != '/' &&
+               *p != '>')
+            p++;
+        const char* colon = static_cast<const char*>(
+            memchr(name, ':', (size_t)(p - name)));
+        if (colon != nullptr)
+            name = colon + 1;
+        tag->name = name;
+        tag->name_len = (size_t)(p - name);
+        // Skip attributes, their values may contain '>'.
+        char quote{'\0'};
+        for (; p < end; p++) {
+            if (quote != '\0') {
+                if (*p == quote)
+                    quote = '\0';
+            } else if (*p == '"' || *p == '\'') {
+                quote = *p;
+            } else if (*p == '>') {
+                break;
+            }
+        }
+        if (p >= end || tag->name_len == 0)
+            return nullptr;
+        tag->is_empty = (p[-1] == '/' && !tag->is_end);
+        return p + 1;
+    }
+    return nullptr;
+}
+
+/*!
+ * \brief Append text with the XML entities replaced.
+ *
+ * \returns
+ *  On success: **true**\n
+ *  On error: **false** if there is an unknown entity.
+ */
+bool append_xml_unescaped(
+    /*! [in,out] String to append to. */
+    std::string& value,
+    /*! [in] Text of an element. */
+    std::string_view text) {
+    for (size_t pos = 0; pos < text.size();) {
+        const size_t amp = text.find('&', pos);
+        value.append(text.substr(pos, amp - pos));
+        if (amp == std::string_view::npos)
+            break;
+        const size_t semi = text.find(';', amp);
+        if (semi == std::string_view::npos)
+            return false;
+        const std::string_view entity = text.substr(amp + 1, semi - amp - 1);
+        pos = semi + 1;
+        if (entity == "amp") {
+            value += '&';
+        } else if (entity == "lt") {
+            value += '<';
+        } else if (entity == "gt") {
+            value += '>';
+        } else if (entity == "quot") {
+            value += '"';
+        } else if (entity == "apos") {
+            value += '\'';
+        } else if (entity.size() > 1 && entity[0] == '#') {
+            const bool hex{entity[1] == 'x'};
+            const std::string digits(entity.substr(hex ? 2 : 1));
+            char* digits_end;
+            const unsigned long cp =
+                strtoul(digits.c_str(), &digits_end, hex ? 16 : 10);
+            if (digits.empty() || *digits_end != '\0' || cp == 0 ||
+                cp > 0x10FFFF)
+                return false;
+            // Encode the code point with UTF-8.
+            if (cp < 0x80) {
+                value += (char)cp;
+            } else if (cp < 0x800) {
+                value += (char)(0xC0 | (cp >> 6));
+                value += (char)(0x80 | (cp & 0x3F));
+            } else if (cp < 0x10000) {
+                value += (char)(0xE0 | (cp >> 12));
+                value += (char)(0x80 | ((cp >> 6) & 0x3F));
+                value += (char)(0x80 | (cp & 0x3F));
+            } else {
+                value += (char)(0xF0 | (cp >> 18));
+                value += (char)(0x80 | ((cp >> 12) & 0x3F));
+                value += (char)(0x80 | ((cp >> 6) & 0x3F));
+                value += (char)(0x80 | (cp & 0x3F));
+            }
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*!
+ * \brief Extract the values of the output arguments from the entity of an
+ * action response without building a DOM document.
+ *
+ * Only the usual flat response, that is Envelope, Body and the response
+ * element with text only arguments, is handled. Anything else, e.g. a SOAP
+ * header, a fault, CDATA or nested elements, is left to the DOM parser.
+ *
+ * \returns
+ *  On success: **true**\n
+ *  On error: **false** if the full parser is needed.
+ */
+bool scan_response_args(
+    /*! [in] Entity of the HTTP response. */
+    const memptr& entity,
+    /*! [in] Name of the response node. */
+    std::string_view responsename,
+    /*! [in] Names of the wanted output arguments. */
+    const char* const* arg_names,
+    /*! [in] Number of wanted output arguments. */
+    int num_args,
+    /*! [out] Values of the wanted arguments, empty string if missing. */
+    std::vector<std::string>& values,
+    /*! [out] Which of the wanted arguments were found. */
+    std::vector<bool>& found) {
+    const char* p = entity.buf;
+    const char* const end = entity.buf + entity.length;
+    xml_tag_t tag;
+    // Tags are matched on their local names like dom_cmp_name() does.
+    responsename = xml_local_name(responsename);
+
+    values.assign((size_t)num_args, std::string());
+    found.assign((size_t)num_args, false);
+    for (const char* name : {"Envelope", "Body"}) {
+        p = next_xml_tag(p, end, &tag);
+        if (p == nullptr || tag.is_end || tag.is_empty ||
+            std::string_view(tag.name, tag.name_len) != name)
+            return false;
+    }
+    p = next_xml_tag(p, end, &tag);
+    if (p == nullptr || tag.is_end ||
+        std::string_view(tag.name, tag.name_len) != responsename)
+        return false;
+    if (tag.is_empty)
+        return true;
+
+    while (true) {
+        p = next_xml_tag(p, end, &tag);
+        if (p == nullptr)
+            return false;
+        if (tag.is_end) // end of the response node
+            return std::string_view(tag.name, tag.name_len) == responsename;
+        const std::string_view arg_name(tag.name, tag.name_len);
+        const char* text{p};
+        if (!tag.is_empty) {
+            p = next_xml_tag(p, end, &tag, &text);
+            if (p == nullptr || !tag.is_end ||
+                std::string_view(tag.name, tag.name_len) != arg_name)
+                return false;
+        }
+        for (int i{0}; i < num_args; i++) {
+            if (found[(size_t)i] || arg_name != xml_local_name(arg_names[i]))
+                continue;
+            const char* text_end = tag.is_empty ? text : tag.start;
+            if (!append_xml_unescaped(
+                    values[(size_t)i],
+                    std::string_view(text, (size_t)(text_end - text))))
+                return false;
+            found[(size_t)i] = true;
+            break;
+        }
+    }
+}
+
+/*!
+ * \brief Get the values of the output arguments from an action response.
+ *
+ * The streaming extractor is tried first. The DOM is only built if it does
+ * not handle the response.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: UPnP error code of a fault, or UPNP_E_BAD_RESPONSE,
+ *  UPNP_E_OUTOF_MEMORY
+ */
+int get_response_args(
+    /*! [in] HTTP response message. */
+    http_message_t* hmsg,
+    /*! [in] Name of the response node. */
+    const std::string& responsename,
+    /*! [in] Names of the wanted output arguments. */
+    const char* const* arg_names,
+    /*! [in] Number of wanted output arguments. */
+    int num_args,
+    /*! [out] Values of the wanted arguments, empty string if missing. */
+    std::vector<std::string>& values,
+    /*! [out] Which of the wanted arguments were found. */
+    std::vector<bool>& found) {
+    if (hmsg->status_code == HTTP_OK && has_xml_content_type(hmsg) &&
+        scan_response_args(hmsg->entity, responsename, arg_names, num_args,
+                           values, found))
+        return UPNP_E_SUCCESS;
+
+    UpnpPrintf(UPNP_INFO, SOAP, __FILE__, __LINE__,
+               "MSG1125: Parse action response with DOM.\n");
+    values.assign((size_t)num_args, std::string());
+    found.assign((size_t)num_args, false);
+    IXML_Document* doc{nullptr};
+    int upnp_error_code{};
+    char* upnp_error_str{nullptr};
+    const int ret_code = get_response_value(
+        hmsg, SOAP_ACTION_RESP, (char*)responsename.c_str(), &upnp_error_code,
+        (IXML_Node**)&doc, &upnp_error_str);
+    if (ret_code != SOAP_ACTION_RESP) {
+        ixmlDocument_free(doc);
+        return ret_code == SOAP_ACTION_RESP_ERROR ? upnp_error_code : ret_code;
+    }
+
+    IXML_Node* node = ixmlNode_getFirstChild(
+        ixmlNode_getFirstChild(reinterpret_cast<IXML_Node*>(doc)));
+    for (; node != nullptr; node = ixmlNode_getNextSibling(node)) {
+        if (ixmlNode_getNodeType(node) != eELEMENT_NODE)
+            continue;
+        for (int i{0}; i < num_args; i++) {
+            if (found[(size_t)i] || dom_cmp_name(arg_names[i], node) != 0)
+                continue;
+            const DOMString value = get_node_value(node);
+            if (value != nullptr)
+                values[(size_t)i] = value;
+            found[(size_t)i] = true;
+            break;
+        }
+    }
+    ixmlDocument_free(doc);
+    return UPNP_E_SUCCESS;
+}
+/// @}
+} // anonymous namespace
+
+
+int SoapSendAction(char* action_url, char* service_type,
+                   IXML_Document* action_node, IXML_Document** response_node) {
+    char* action_str = NULL;
+    membuffer request;
+    membuffer responsename;
+    int err_code;
+    int ret_code;
+    http_parser_t response;
+    uri_type url;
+    int upnp_error_code;
+    char* upnp_error_str;
+    int got_response = 0;
+
+    *response_node = NULL; /* init */
+
+    err_code = UPNP_E_OUTOF_MEMORY; /* default error */
+
+    UpnpPrintf(UPNP_INFO, SOAP, __FILE__, __LINE__, "Inside SoapSendAction():");
+    /* init */
+    membuffer_init(&request);
+    membuffer_init(&responsename);
+
+    /* print action */
+    action_str = ixmlPrintNode((IXML_Node*)action_node);
+    if (action_str == NULL) {
+        goto error_handler;
+    }
+    /* make request msg */
+    err_code = make_action_request(action_url, service_type, action_str, &url,
+                                   &request, &responsename);
+    if (err_code != UPNP_E_SUCCESS) {
         goto error_handler;
     }
 
@@ -574,10 +1544,6 @@ int SoapSendAction(char* action_url, char* service_type,
         goto error_handler;
     }
 
-    if (membuffer_append(&responsename, name.buf, name.length) != 0 ||
-        membuffer_append_str(&responsename, "Response") != 0) {
-        goto error_handler;
-    }
     /* get action node from the response */
     ret_code = get_response_value(&response.msg, SOAP_ACTION_RESP,
                                   responsename.buf, &upnp_error_code,
@@ -602,6 +1568,236 @@ error_handler:
     return err_code;
 }
 
+int SoapSendActionNonBlocking(const char* action_url,
+                              const char* service_type,
+                              IXML_Document* action_node, Upnp_FunPtr fun,
+                              const void* cookie) {
+    auto op = std::make_unique<soap_action_op_t>();
+    op->action_url = action_url;
+    op->fun = fun;
+    op->cookie = const_cast<void*>(cookie);
+
+    char* action_str = ixmlPrintNode((IXML_Node*)action_node);
+    if (action_str == NULL)
+        return UPNP_E_OUTOF_MEMORY;
+    int err_code = make_action_request(op->action_url.data(),
+                                       const_cast<char*>(service_type),
+                                       action_str, &op->url, &op->request,
+                                       &op->responsename);
+    if (err_code == UPNP_E_SUCCESS) {
+        /* the callback gets a copy of the action */
+        switch (ixmlParseBufferEx(action_str, &op->action)) {
+        case IXML_SUCCESS:
+            break;
+        case IXML_INSUFFICIENT_MEMORY:
+            err_code = UPNP_E_OUTOF_MEMORY;
+            break;
+        default:
+            err_code = UPNP_E_INVALID_ACTION;
+        }
+    }
+    ixmlFreeDOMString(action_str);
+    if (err_code != UPNP_E_SUCCESS)
+        return err_code;
+
+    return queue_action(std::move(op));
+}
+
+int SoapMakeActionTemplate(const char* action_url, const char* service_type,
+                           const char* action_name,
+                           const char* const* arg_names, int num_args,
+                           UpnpActionTemplate** tmpl) {
+    *tmpl = nullptr;
+    auto newtmpl = std::make_unique<UpnpActionTemplate>();
+    membuffer head;
+    membuffer head_end;
+
+    newtmpl->action_url = action_url;
+    int ret_code{http_FixStrUrl(newtmpl->action_url.data(),
+                                newtmpl->action_url.size(), &newtmpl->url)};
+    if (ret_code == UPNP_E_TRY_AGAIN)
+        return ret_code;
+    if (ret_code != 0)
+        return UPNP_E_INVALID_URL;
+    ret_code = UPNP_E_OUTOF_MEMORY;
+
+    /* make headers like SoapSendAction() */
+    membuffer_init(&head);
+    membuffer_init(&head_end);
+    if (http_MakeMessage(&head, 1, 1, "q", SOAPMETHOD_POST, &newtmpl->url) !=
+            0 ||
+        http_MakeMessage(&head_end, 1, 1,
+                         "c"
+                         "sc"
+                         "s"
+                         "sssssc"
+                         "Uc",
+                         "Accept-Ranges: bytes", ContentTypeHeader,
+                         "SOAPACTION: \"", service_type, "#", action_name,
+                         "\"") != 0)
+        goto exit_function;
+    newtmpl->head.assign(head.buf, head.length);
+    newtmpl->head += "CONTENT-LENGTH: ";
+    newtmpl->head_end.assign(head_end.buf, head_end.length);
+
+    newtmpl->body_start = "<s:Envelope "
+                          "xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" "
+                          "s:encodingStyle=\"http://schemas.xmlsoap.org/soap/"
+                          "encoding/\">\r\n"
+                          "<s:Body><u:";
+    newtmpl->body_start.append(action_name)
+        .append(" xmlns:u=\"")
+        .append(service_type)
+        .append("\">\r\n");
+    for (int i{0}; i < num_args; i++) {
+        newtmpl->arg_start.push_back(std::string("<") + arg_names[i] + ">");
+        newtmpl->arg_end.push_back(std::string("</") + arg_names[i] + ">\r\n");
+    }
+    newtmpl->body_end = std::string("</u:") + action_name +
+                        ">\r\n"
+                        "</s:Body>\r\n"
+                        "</s:Envelope>\r\n\r\n";
+    newtmpl->responsename = std::string(action_name) + "Response";
+
+    *tmpl = newtmpl.release();
+    ret_code = UPNP_E_SUCCESS;
+
+exit_function:
+    membuffer_destroy(&head);
+    membuffer_destroy(&head_end);
+    return ret_code;
+}
+
+void SoapFreeActionTemplate(UpnpActionTemplate* tmpl) { delete tmpl; }
+
+int SoapSendActionTemplate(const UpnpActionTemplate* tmpl,
+                           const char* const* arg_values,
+                           IXML_Document** response_node) {
+    membuffer request;
+    http_parser_t response;
+    uri_type url{tmpl->url};
+    int upnp_error_code;
+    char* upnp_error_str;
+    int err_code;
+    int ret_code;
+
+    *response_node = NULL; /* init */
+    membuffer_init(&request);
+    err_code = fill_action_template(tmpl, arg_values, &request);
+    if (err_code != UPNP_E_SUCCESS) {
+        membuffer_destroy(&request);
+        return err_code;
+    }
+
+    ret_code = soap_request_and_response(&request, &url, &response);
+    membuffer_destroy(&request);
+    if (ret_code != UPNP_E_SUCCESS)
+        return ret_code;
+
+    /* get action node from the response */
+    ret_code = get_response_value(
+        &response.msg, SOAP_ACTION_RESP, (char*)tmpl->responsename.c_str(),
+        &upnp_error_code, (IXML_Node**)response_node, &upnp_error_str);
+    httpmsg_destroy(&response.msg);
+
+    if (ret_code == SOAP_ACTION_RESP)
+        return UPNP_E_SUCCESS;
+    if (ret_code == SOAP_ACTION_RESP_ERROR)
+        return upnp_error_code;
+    return ret_code;
+}
+
+int SoapSendActionTemplateNonBlocking(const UpnpActionTemplate* tmpl,
+                                      const char* const* arg_values,
+                                      Upnp_FunPtr fun, const void* cookie) {
+    auto op = std::make_unique<soap_action_op_t>();
+    op->action_url = tmpl->action_url;
+    op->fun = fun;
+    op->cookie = const_cast<void*>(cookie);
+    const int ret_code{http_FixStrUrl(op->action_url.data(),
+                                      op->action_url.size(), &op->url)};
+    if (ret_code == UPNP_E_TRY_AGAIN)
+        return ret_code;
+    if (ret_code != 0)
+        return UPNP_E_INVALID_URL;
+    if (membuffer_assign(&op->responsename, tmpl->responsename.data(),
+                         tmpl->responsename.size()) != 0)
+        return UPNP_E_OUTOF_MEMORY;
+    const int err_code = fill_action_template(tmpl, arg_values, &op->request);
+    if (err_code != UPNP_E_SUCCESS)
+        return err_code;
+
+    return queue_action(std::move(op));
+}
+
+int SoapSendActionTemplateValues(const UpnpActionTemplate* tmpl,
+                                 const char* const* arg_values,
+                                 const char* const* resp_names, int num_resp,
+                                 char** resp_values) {
+    membuffer request;
+    http_parser_t response;
+    uri_type url{tmpl->url};
+    std::vector<std::string> values;
+    std::vector<bool> found;
+    int ret_code;
+
+    for (int i{0}; i < num_resp; i++)
+        resp_values[i] = NULL; /* init */
+    membuffer_init(&request);
+    ret_code = fill_action_template(tmpl, arg_values, &request);
+    if (ret_code != UPNP_E_SUCCESS) {
+        membuffer_destroy(&request);
+        return ret_code;
+    }
+
+    ret_code = soap_request_and_response(&request, &url, &response);
+    membuffer_destroy(&request);
+    if (ret_code != UPNP_E_SUCCESS)
+        return ret_code;
+
+    ret_code = get_response_args(&response.msg, tmpl->responsename, resp_names,
+                                 num_resp, values, found);
+    httpmsg_destroy(&response.msg);
+    if (ret_code != UPNP_E_SUCCESS)
+        return ret_code;
+
+    for (int i{0}; i < num_resp; i++) {
+        if (!found[(size_t)i])
+            continue;
+        resp_values[i] = strdup(values[(size_t)i].c_str());
+        if (resp_values[i] == NULL) {
+            for (int j{0}; j < i; j++) {
+                free(resp_values[j]);
+                resp_values[j] = NULL;
+            }
+            return UPNP_E_OUTOF_MEMORY;
+        }
+    }
+    return UPNP_E_SUCCESS;
+}
+
+int SoapSetActionWindow(int max_per_device, int max_in_flight) {
+    if (max_per_device <= 0 || max_in_flight <= 0)
+        return UPNP_E_INVALID_PARAM;
+    std::scoped_lock lock(gActionLoop.mutex);
+    gActionLoop.max_per_device = max_per_device;
+    gActionLoop.max_in_flight = max_in_flight;
+    wakeup_action_loop();
+
+    return UPNP_E_SUCCESS;
+}
+
+void SoapActionLoopShutdown() {
+    std::unique_lock lock(gActionLoop.mutex);
+    if (!gActionLoop.running)
+        return;
+    gActionLoop.stop = true;
+    wakeup_action_loop();
+    gActionLoop.finished.wait(lock, [] { return !gActionLoop.running; });
+    lock.unlock();
+    DedicatedThreadJoin(&gActionLoop.thread);
+}
+
 int SoapSendActionEx(char* action_url, char* service_type,
                      IXML_Document* header, IXML_Document* action_node,
                      IXML_Document** response_node) {
@@ -661,8 +1857,10 @@ int SoapSendActionEx(char* action_url, char* service_type,
         goto error_handler;
     }
     /* parse url */
-    if (http_FixStrUrl(action_url, strlen(action_url), &url) != 0) {
-        err_code = UPNP_E_INVALID_URL;
+    err_code = http_FixStrUrl(action_url, strlen(action_url), &url);
+    if (err_code != 0) {
+        if (err_code != UPNP_E_TRY_AGAIN)
+            err_code = UPNP_E_INVALID_URL;
         goto error_handler;
     }
 
@@ -779,7 +1977,10 @@ int SoapGetServiceVarStatus(char* action_url, DOMString var_name,
     *var_value = NULL; /* return NULL in case of an error */
     membuffer_init(&request);
     /* get host hdr and url path */
-    if (get_host_and_path(action_url, &host, &path, &url) == -1) {
+    ret_code = get_host_and_path(action_url, &host, &path, &url);
+    if (ret_code == UPNP_E_TRY_AGAIN)
+        return ret_code;
+    if (ret_code == -1) {
         return UPNP_E_INVALID_URL;
     }
     /* make headers */
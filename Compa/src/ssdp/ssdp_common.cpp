@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-08-01
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -55,9 +55,37 @@
 #include <upnplib/synclog.hpp>
 #include <umock/sys_socket.hpp>
 #include <umock/winsock2.hpp>
+#ifndef _WIN32
+#include <umock/ifaddrs.hpp>
+#endif
+
+/// \cond
+#include <mutex>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <net/if.h>
+#endif
+#ifdef __linux__
+#include <linux/filter.h>
+#endif
+/// \endcond
 
 
 namespace {
+/*! \name Settings of the SSDP sockets
+ * @{ */
+/// \brief Protects the settings.
+std::mutex gSsdpSettingsMutex;
+/// \brief Names of the additional interfaces, set with SsdpSetInterfaces().
+std::vector<std::string> gSsdpIfNames;
+/// \brief Attach the socket filter, set with SsdpSetFilter().
+bool gSsdpFilter{false};
+/// \brief IPv4 addresses of the served additional interfaces, set with
+/// SsdpSetIfAddrs4().
+std::vector<std::string> gSsdpIfAddrs4;
+/// @}
+
 /*! \name Functions scope restricted to file
  * @{ */
 
@@ -74,7 +102,7 @@ void free_ssdp_event_handler_data(
         http_message_t* hmsg = &data->parser.msg;
         /* free data */
         httpmsg_destroy(hmsg);
-        free(data);
+        SlabFree(data);
     }
 }
 
@@ -186,7 +214,7 @@ void ssdp_event_handler_thread(
 #endif
     } else {
 #ifdef COMPA_HAVE_DEVICE_SSDP
-        ssdp_handle_device_request(hmsg, &data->dest_addr);
+        ssdp_handle_device_request(hmsg, &data->dest_addr, data->if_ipv4);
 #endif
     }
 
@@ -207,7 +235,12 @@ void ssdp_event_handler_thread(
  */
 inline int create_ssdp_sock_v4(
     /*! [out] SSDP IPv4 socket to be created. */
-    SOCKET* ssdpSock) {
+    SOCKET* ssdpSock,
+    /*! [in] IPv4 address of the interface to join the multicast group. */
+    const char* if_ipv4,
+    /*! [in] Only receive multicast from the group joined by this socket. This
+     * is needed with more than one interface. */
+    bool only_joined = false) {
     UPNPLIB_LOGINFO "MSG1075: Executing...\n";
     int onOff;
     u_char ttl = (u_char)4;
@@ -261,6 +294,23 @@ inline int create_ssdp_sock_v4(
         ret = UPNP_E_SOCKET_BIND;
         goto error_handler;
     }
+#ifdef __linux__
+    if (only_joined) {
+        // By default Linux delivers multicast of all groups joined on the
+        // system to every socket bound to the port.
+        onOff = 0;
+        if (umock::sys_socket_h.setsockopt(*ssdpSock, IPPROTO_IP,
+                                           IP_MULTICAST_ALL, (char*)&onOff,
+                                           sizeof(onOff)) == -1) {
+            sockerrObj.catch_error();
+            UPNPLIB_LOGINFO "MSG1126: Error in setsockopt() "
+                            "IP_MULTICAST_ALL: "
+                << sockerrObj.error_str() << ".\n";
+        }
+    }
+#else
+    (void)only_joined;
+#endif
     /*
      * See: https://man7.org/linux/man-pages/man7/ip.7.html
      * Socket options, IP_ADD_MEMBERSHIP
@@ -273,7 +323,7 @@ inline int create_ssdp_sock_v4(
      * windows does not recognize the latter.
      */
     memset((void*)&ssdpMcastAddr, 0, sizeof ssdpMcastAddr);
-    inet_pton(AF_INET, gIF_IPV4, &ssdpMcastAddr.imr_interface);
+    inet_pton(AF_INET, if_ipv4, &ssdpMcastAddr.imr_interface);
     inet_pton(AF_INET, SSDP_IP, &ssdpMcastAddr.imr_multiaddr);
     ret = umock::sys_socket_h.setsockopt(
         *ssdpSock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&ssdpMcastAddr,
@@ -288,7 +338,7 @@ inline int create_ssdp_sock_v4(
     }
     /* Set multicast interface. */
     memset((void*)&addr, 0, sizeof(struct in_addr));
-    inet_pton(AF_INET, gIF_IPV4, &addr);
+    inet_pton(AF_INET, if_ipv4, &addr);
     ret = umock::sys_socket_h.setsockopt(*ssdpSock, IPPROTO_IP, IP_MULTICAST_IF,
                                          (char*)&addr, sizeof addr);
     if (ret == -1) {
@@ -574,6 +624,112 @@ error_handler:
 }
 #endif /* IPv6 */
 
+#ifndef _WIN32
+/*!
+ * \brief Get the IPv4 address of an interface.
+ *
+ * \returns
+ *  On success: **true**\n
+ *  On error: **false** if the interface has no IPv4 address.
+ */
+bool get_if_ipv4(
+    /*! [in] Name of the interface. */
+    const std::string& if_name,
+    /*! [out] IPv4 address. */
+    char (&if_ipv4)[INET_ADDRSTRLEN]) {
+    ifaddrs* ifap;
+    bool found{false};
+
+    if (umock::ifaddrs_h.getifaddrs(&ifap) != 0)
+        return false;
+    for (ifaddrs* ifa = ifap; ifa != nullptr; ifa = ifa->ifa_next) {
+        if (ifa->ifa_addr == nullptr || ifa->ifa_addr->sa_family != AF_INET ||
+            !(ifa->ifa_flags & IFF_UP) || if_name != ifa->ifa_name)
+            continue;
+        inet_ntop(AF_INET, &((sockaddr_in*)ifa->ifa_addr)->sin_addr, if_ipv4,
+                  INET_ADDRSTRLEN);
+        found = true;
+        break;
+    }
+    umock::ifaddrs_h.freeifaddrs(ifap);
+    return found;
+}
+
+/*!
+ * \brief Create the IPv4 SSDP sockets on the additional interfaces.
+ *
+ * An interface without IPv4 address is skipped with an error message. The
+ * address of each interface is noted next to its socket, so M-SEARCH requests
+ * received there are answered with the location on that interface.
+ *
+ * \returns
+ *  On success: UPNP_E_SUCCESS\n
+ *  On error: Like create_ssdp_sock_v4()
+ */
+int create_ssdp_socks_if4(
+    /*! [out] Array of SSDP sockets. */
+    MiniServerSockArray* out) {
+    std::vector<std::string> if_names;
+    {
+        std::scoped_lock lock(gSsdpSettingsMutex);
+        if_names = gSsdpIfNames;
+    }
+    size_t idx{0};
+    for (const std::string& if_name : if_names) {
+        char if_ipv4[INET_ADDRSTRLEN];
+        if (if_name == gIF_NAME) {
+            UPNPLIB_LOGINFO "MSG1127: Skip SSDP interface \"" << if_name
+                                                              << "\".\n";
+            continue;
+        }
+        if (!get_if_ipv4(if_name, if_ipv4)) {
+            UPNPLIB_LOGERR "MSG1140: SSDP interface \""
+                << if_name << "\" has no IPv4 address, not listening on it.\n";
+            continue;
+        }
+        const int ret = create_ssdp_sock_v4(&out->ssdpSockIf4[idx], if_ipv4,
+                                            true);
+        if (ret != UPNP_E_SUCCESS) {
+            while (idx > 0)
+                umock::unistd_h.CLOSE_SOCKET_P(out->ssdpSockIf4[--idx]);
+            return ret;
+        }
+        memcpy(out->ssdpIfIpv4[idx], if_ipv4, sizeof(if_ipv4));
+        UPNPLIB_LOGINFO "MSG1128: SSDP socket "
+            << out->ssdpSockIf4[idx] << " on interface \"" << if_name
+            << "\", IPv4=\"" << if_ipv4 << "\".\n";
+        idx++;
+    }
+    return UPNP_E_SUCCESS;
+}
+#endif
+
+/*!
+ * \brief Attach the socket filter if it is enabled and the socket is valid.
+ */
+void attach_filter_if_enabled(
+    /*! [in] SSDP socket. */
+    SOCKET sock) {
+    {
+        std::scoped_lock lock(gSsdpSettingsMutex);
+        if (!gSsdpFilter)
+            return;
+    }
+    if (sock != INVALID_SOCKET)
+        SsdpAttachFilter(sock);
+}
+
+/*!
+ * \brief Close an SSDP socket that will be created again.
+ */
+void renew_close(
+    /*! [in,out] Pointer to the SSDP socket, set to INVALID_SOCKET. */
+    SOCKET* sock) {
+    if (*sock != INVALID_SOCKET)
+        umock::unistd_h.CLOSE_SOCKET_P(*sock);
+    *sock = INVALID_SOCKET;
+}
+
 /// @} // Functions scope restricted to file
 } // anonymous namespace
 
@@ -687,7 +843,7 @@ int ssdp_request_type(char* cmd, SsdpEvent* Evt) {
 }
 
 
-int readFromSSDPSocket(SOCKET socket) {
+int readFromSSDPSocket(SOCKET socket, const char* if_ipv4) {
     TRACE("Executing readFromSSDPSocket()")
     char* requestBuf = NULL;
     char staticBuf[BUFSIZE];
@@ -703,7 +859,7 @@ int readFromSSDPSocket(SOCKET socket) {
     requestBuf = staticBuf;
     /* in case memory can't be allocated, still drain the socket using a
      * static buffer. */
-    data = (ssdp_thread_data*)malloc(sizeof(ssdp_thread_data));
+    data = (ssdp_thread_data*)SlabAlloc(sizeof(ssdp_thread_data));
     if (data) {
         /* initialize parser */
 #ifdef COMPA_HAVE_CTRLPT_SSDP
@@ -718,12 +874,14 @@ int readFromSSDPSocket(SOCKET socket) {
 #else  /* COMPA_HAVE_CTRLPT_SSDP */
         parser_request_init(&data->parser);
 #endif /* COMPA_HAVE_CTRLPT_SSDP */
+        /* the datagram is complete before parsing so don't copy headers */
+        data->parser.header_slices = 1;
         /* set size of parser buffer */
-        if (membuffer_set_size(&data->parser.msg.msg, BUFSIZE) == 0)
+        if (membuffer_reserve(&data->parser.msg.msg, BUFSIZE) == 0)
             /* use this as the buffer for recv */
             requestBuf = data->parser.msg.msg.buf;
         else {
-            free(data);
+            SlabFree(data);
             data = NULL;
         }
     }
@@ -760,7 +918,10 @@ int readFromSSDPSocket(SOCKET socket) {
             /* null-terminate */
             data->parser.msg.msg.buf[byteReceived] = 0;
             memcpy(&data->dest_addr, &__ss, sizeof(__ss));
+            snprintf(data->if_ipv4, sizeof(data->if_ipv4), "%s",
+                     if_ipv4 == nullptr ? "" : if_ipv4);
             TPJobInit(&job, (start_routine)ssdp_event_handler_thread, data);
+            TPJobSetLabel(&job, JOB_LABEL_SSDP);
             TPJobSetFreeFunction(&job, free_ssdp_event_handler_data);
             TPJobSetPriority(&job, MED_PRIORITY);
             if (ThreadPoolAdd(&gRecvThreadPool, &job, NULL) != 0)
@@ -806,7 +967,12 @@ int get_ssdp_sockets(MiniServerSockArray* out) {
 #endif /* COMPA_HAVE_CTRLPT_SSDP */
     /* Create the IPv4 socket for SSDP */
     if (strlen(gIF_IPV4) > (size_t)0) {
-        retVal = create_ssdp_sock_v4(&out->ssdpSock4);
+        bool more_ifs;
+        {
+            std::scoped_lock lock(gSsdpSettingsMutex);
+            more_ifs = !gSsdpIfNames.empty();
+        }
+        retVal = create_ssdp_sock_v4(&out->ssdpSock4, gIF_IPV4, more_ifs);
         if (retVal != UPNP_E_SUCCESS) {
 #ifdef COMPA_HAVE_CTRLPT_SSDP
             umock::unistd_h.CLOSE_SOCKET_P(out->ssdpReqSock4);
@@ -844,6 +1010,143 @@ int get_ssdp_sockets(MiniServerSockArray* out) {
     } else
         out->ssdpSock6UlaGua = INVALID_SOCKET;
 #endif /* UPNP_ENABLE_IPV6 */
+#ifndef _WIN32
+    /* Create the IPv4 sockets for SSDP on additional interfaces */
+    retVal = create_ssdp_socks_if4(out);
+    if (retVal != UPNP_E_SUCCESS) {
+        umock::unistd_h.CLOSE_SOCKET_P(out->ssdpSock4);
+#ifdef UPNP_ENABLE_IPV6
+        umock::unistd_h.CLOSE_SOCKET_P(out->ssdpSock6);
+        umock::unistd_h.CLOSE_SOCKET_P(out->ssdpSock6UlaGua);
+#endif
+#ifdef COMPA_HAVE_CTRLPT_SSDP
+        umock::unistd_h.CLOSE_SOCKET_P(out->ssdpReqSock4);
+        umock::unistd_h.CLOSE_SOCKET_P(out->ssdpReqSock6);
+#endif
+        return retVal;
+    }
+#endif
+    attach_filter_if_enabled(out->ssdpSock4);
+#ifdef UPNP_ENABLE_IPV6
+    attach_filter_if_enabled(out->ssdpSock6);
+    attach_filter_if_enabled(out->ssdpSock6UlaGua);
+#endif
+    for (SOCKET sock : out->ssdpSockIf4)
+        attach_filter_if_enabled(sock);
+
+    return UPNP_E_SUCCESS;
+}
+
+int ssdp_renew_sockets(MiniServerSockArray* out) {
+    UPNPLIB_LOGINFO "MSG1132: Executing...\n";
+    int retVal{UPNP_E_SUCCESS};
+    int ret;
+
+    // The sockets are bound to the wildcard address but join the multicast
+    // group on the interface address, so they must be created again.
+    renew_close(&out->ssdpSock4);
+    if (strlen(gIF_IPV4) > (size_t)0) {
+        bool more_ifs;
+        {
+            std::scoped_lock lock(gSsdpSettingsMutex);
+            more_ifs = !gSsdpIfNames.empty();
+        }
+        ret = create_ssdp_sock_v4(&out->ssdpSock4, gIF_IPV4, more_ifs);
+        if (ret == UPNP_E_SUCCESS)
+            attach_filter_if_enabled(out->ssdpSock4);
+        else {
+            out->ssdpSock4 = INVALID_SOCKET;
+            retVal = ret;
+        }
+    }
+#ifdef UPNP_ENABLE_IPV6
+    renew_close(&out->ssdpSock6);
+    if (strlen(gIF_IPV6) > (size_t)0) {
+        ret = create_ssdp_sock_v6(&out->ssdpSock6);
+        if (ret == UPNP_E_SUCCESS)
+            attach_filter_if_enabled(out->ssdpSock6);
+        else {
+            out->ssdpSock6 = INVALID_SOCKET;
+            retVal = ret;
+        }
+    }
+    renew_close(&out->ssdpSock6UlaGua);
+    if (strlen(gIF_IPV6_ULA_GUA) > (size_t)0) {
+        ret = create_ssdp_sock_v6_ula_gua(&out->ssdpSock6UlaGua);
+        if (ret == UPNP_E_SUCCESS)
+            attach_filter_if_enabled(out->ssdpSock6UlaGua);
+        else {
+            out->ssdpSock6UlaGua = INVALID_SOCKET;
+            retVal = ret;
+        }
+    }
+#endif /* UPNP_ENABLE_IPV6 */
+
+    return retVal;
+}
+
+int SsdpSetInterfaces(const char* const* if_names, int num_ifs) {
+#ifdef _WIN32
+    if (num_ifs > 0)
+        return UPNP_E_NOT_EXIST;
+#endif
+    if (num_ifs < 0 || num_ifs > SSDP_MAX_INTERFACES ||
+        (num_ifs > 0 && if_names == nullptr))
+        return UPNP_E_INVALID_PARAM;
+    std::vector<std::string> names;
+    for (int i{0}; i < num_ifs; i++) {
+        if (if_names[i] == nullptr || if_names[i][0] == '\0' ||
+            strlen(if_names[i]) >= LINE_SIZE)
+            return UPNP_E_INVALID_INTERFACE;
+        names.emplace_back(if_names[i]);
+    }
+    std::scoped_lock lock(gSsdpSettingsMutex);
+    gSsdpIfNames = std::move(names);
+    return UPNP_E_SUCCESS;
+}
+
+void SsdpSetIfAddrs4(const std::vector<std::string>& addrs) {
+    std::scoped_lock lock(gSsdpSettingsMutex);
+    gSsdpIfAddrs4 = addrs;
+}
+
+std::vector<std::string> SsdpGetIfAddrs4() {
+    std::scoped_lock lock(gSsdpSettingsMutex);
+    return gSsdpIfAddrs4;
+}
+
+int SsdpSetFilter(bool enable) {
+#ifndef __linux__
+    if (enable)
+        return UPNP_E_NOT_EXIST;
+#endif
+    std::scoped_lock lock(gSsdpSettingsMutex);
+    gSsdpFilter = enable;
+    return UPNP_E_SUCCESS;
+}
 
+int SsdpAttachFilter([[maybe_unused]] SOCKET sock) {
+#ifdef __linux__
+    // The filter sees the datagram from the UDP header on. Accept it only if
+    // the payload starts with "M-SE" or "NOTI".
+    static sock_filter code[]{
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 8),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x4D2D5345, 1, 0), // "M-SE"
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x4E4F5449, 0, 1), // "NOTI"
+        BPF_STMT(BPF_RET | BPF_K, 0xFFFFFFFF),                 // accept
+        BPF_STMT(BPF_RET | BPF_K, 0),                          // drop
+    };
+    sock_fprog prog{sizeof(code) / sizeof(code[0]), code};
+    if (umock::sys_socket_h.setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER,
+                                       (char*)&prog, sizeof(prog)) == -1) {
+        upnplib::CSocketErr sockerrObj;
+        sockerrObj.catch_error();
+        UPNPLIB_LOGERR "MSG1129: Error in setsockopt() SO_ATTACH_FILTER: "
+            << sockerrObj.error_str() << ".\n";
+        return UPNP_E_SOCKET_ERROR;
+    }
     return UPNP_E_SUCCESS;
+#else
+    return UPNP_E_NOT_EXIST;
+#endif
 }
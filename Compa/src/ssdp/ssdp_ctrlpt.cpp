@@ -6,7 +6,7 @@
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-30
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * - Redistributions of source code must retain the above copyright notice,
  * this list of conditions and the following disclaimer.
@@ -48,6 +48,15 @@
 #include <umock/sys_socket.hpp>
 #include <umock/pupnp_sock.hpp>
 
+/// \cond
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+/// \endcond
+
 #ifndef COMPA_INTERNAL_CONFIG_HPP
 #error "No or wrong config.hpp header file included."
 #endif
@@ -277,9 +286,329 @@ inline void searchExpired(
     free(arg);
 }
 
+/*!
+ * \brief M-SEARCH packets of a search that are sent in copies.
+ */
+struct SsdpSearchSendArg {
+    /// \brief Number of copies of each packet that are still to be sent.
+    int copiesLeft;
+    /// \brief IPv4 address of the interface given to UpnpInit2().
+    in_addr ifv4;
+    /// @{
+    /// \brief Request packet and its destination address.
+    char ReqBufv4[BUFSIZE];
+    sockaddr_storage destv4;
+#ifdef UPNP_ENABLE_IPV6
+    char ReqBufv6[BUFSIZE];
+    sockaddr_storage destv6LinkLocal;
+    char ReqBufv6UlaGua[BUFSIZE];
+    sockaddr_storage destv6SiteLocal;
+#endif
+    /// @}
+};
+
+/*! \brief Protects the multicast interface of gSsdpReqSocket4 while a packet
+ * is sent on it. */
+std::mutex gSsdpReqSocket4Mutex;
+
+/*!
+ * \brief Send one M-SEARCH packet without waiting.
+ *
+ * A datagram that cannot be sent is dropped. The other copies make up for
+ * it like for a datagram lost on the network.
+ */
+void send_search_packet(
+    /*! [in] Socket to send with. */
+    SOCKET a_sock,
+    /*! [in] Request packet. */
+    const char* a_packet,
+    /*! [in] Destination address. */
+    const sockaddr_storage* a_dest) {
+    UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
+               ">>> SSDP SEND M-SEARCH >>>\n%s\n", a_packet);
+    const socklen_t dest_len = (socklen_t)(a_dest->ss_family == AF_INET6
+                                                ? sizeof(sockaddr_in6)
+                                                : sizeof(sockaddr_in));
+    if (umock::sys_socket_h.sendto(a_sock, a_packet, (SIZEP_T)strlen(a_packet),
+                                   0, (const sockaddr*)a_dest,
+                                   dest_len) == SOCKET_ERROR) {
+        UPNPLIB_LOGINFO "MSG1124: failed to send M-SEARCH on socket "
+            << a_sock << ".\n";
+    }
+}
+
+/*!
+ * \brief Send the next copy of the M-SEARCH packets of a search.
+ *
+ * The copy after it is scheduled on the timer thread with a pause of
+ * SSDP_PAUSE so the caller never waits. The argument is freed with the last
+ * copy.
+ */
+void searchSendCopy(
+    /*! [in] Pointer to a SsdpSearchSendArg. */
+    void* arg) {
+    SsdpSearchSendArg* sendArg = (SsdpSearchSendArg*)arg;
+
+#ifdef UPNP_ENABLE_IPV6
+    if (gSsdpReqSocket6 != INVALID_SOCKET) {
+        send_search_packet(gSsdpReqSocket6, sendArg->ReqBufv6UlaGua,
+                           &sendArg->destv6SiteLocal);
+        send_search_packet(gSsdpReqSocket6, sendArg->ReqBufv6,
+                           &sendArg->destv6LinkLocal);
+    }
+#endif
+    if (gSsdpReqSocket4 != INVALID_SOCKET) {
+        // The search goes out on every interface. The multicast interface of
+        // the socket is switched for each packet, so the packets of
+        // concurrent searches must not interleave.
+        std::scoped_lock lock(gSsdpReqSocket4Mutex);
+        umock::sys_socket_h.setsockopt(gSsdpReqSocket4, IPPROTO_IP,
+                                       IP_MULTICAST_IF, (char*)&sendArg->ifv4,
+                                       sizeof(sendArg->ifv4));
+        send_search_packet(gSsdpReqSocket4, sendArg->ReqBufv4,
+                           &sendArg->destv4);
+        for (const std::string& if_ipv4 : SsdpGetIfAddrs4()) {
+            in_addr addrv4;
+            if (inet_pton(AF_INET, if_ipv4.c_str(), &addrv4) != 1)
+                continue;
+            umock::sys_socket_h.setsockopt(gSsdpReqSocket4, IPPROTO_IP,
+                                           IP_MULTICAST_IF, (char*)&addrv4,
+                                           sizeof(addrv4));
+            send_search_packet(gSsdpReqSocket4, sendArg->ReqBufv4,
+                               &sendArg->destv4);
+        }
+    }
+
+    if (--sendArg->copiesLeft > 0) {
+        ThreadPoolJob job;
+        memset(&job, 0, sizeof(job));
+        TPJobInit(&job, (start_routine)searchSendCopy, sendArg);
+        TPJobSetLabel(&job, JOB_LABEL_SSDP);
+        TPJobSetPriority(&job, MED_PRIORITY);
+        TPJobSetFreeFunction(&job, (free_routine)free);
+        if (TimerThreadSchedule(&gTimerThread, SSDP_PAUSE, REL_MSEC, &job,
+                                SHORT_TERM, NULL) == 0)
+            return;
+    }
+    free(sendArg);
+}
+
+/*! \name Discovery cache
+ * @{
+ */
+/*! \brief Seconds in which an equal message from a device is taken as a copy.
+ * \details Devices send each message several times within a short time. A
+ * periodic advertisement is much later and is passed on again. */
+constexpr time_t SSDP_CACHE_COPY_WINDOW{5};
+
+/// \brief Entry of the discovery cache.
+struct ssdp_cache_entry_t {
+    /// Discovery information of the last message that was passed on.
+    UpnpDiscovery* disc{nullptr};
+    /// Time when the last message was passed on.
+    time_t passed_at{};
+    /// Time when the entry expires.
+    time_t expires_at{};
+    /// false after a byebye until the entry expires.
+    bool alive{};
+    /// Timeout event ids of the searches that got a reply from the entry.
+    std::vector<int> replied_searches;
+};
+
+/// \brief Discovery cache, keyed by USN.
+std::unordered_map<std::string, ssdp_cache_entry_t> gSsdpCache;
+/// \brief Counters of the discovery cache.
+SsdpCacheStats gSsdpCacheStats{};
+/*! \brief Set while a sweep of the cache is scheduled on the timer thread.
+ * \details It is atomic because a dropped sweep job clears it without the
+ * cache mutex. */
+std::atomic<bool> gSsdpCacheSweepScheduled{false};
+/// \brief Mutex to protect the discovery cache.
+std::mutex gSsdpCacheMutex;
+
+void ssdp_cache_sweep(void* arg);
+
+/*!
+ * \brief Free function of the sweep job.
+ *
+ * It is called if the job is dropped by the thread pool or the timer thread
+ * and lets the next stored message schedule a sweep again.
+ */
+void ssdp_cache_sweep_dropped(
+    /*! [in] Pointer to gSsdpCacheSweepScheduled. */
+    void* arg) {
+    static_cast<std::atomic<bool>*>(arg)->store(false);
+}
+
+/*!
+ * \brief Schedule a sweep of the cache for the time the next entry expires.
+ *
+ * Must be called with gSsdpCacheMutex locked.
+ */
+void ssdp_cache_schedule_sweep() {
+    if (gSsdpCacheSweepScheduled || gSsdpCache.empty())
+        return;
+    auto next = std::min_element(
+        gSsdpCache.begin(), gSsdpCache.end(), [](const auto& a, const auto& b) {
+            return a.second.expires_at < b.second.expires_at;
+        });
+    const time_t delay{
+        std::max<time_t>(next->second.expires_at - time(nullptr), 1)};
+    ThreadPoolJob job;
+    memset(&job, 0, sizeof(job));
+    TPJobInit(&job, (start_routine)ssdp_cache_sweep,
+              &gSsdpCacheSweepScheduled);
+    TPJobSetLabel(&job, JOB_LABEL_SSDP);
+    TPJobSetPriority(&job, LOW_PRIORITY);
+    TPJobSetFreeFunction(&job, ssdp_cache_sweep_dropped);
+    gSsdpCacheSweepScheduled =
+        TimerThreadSchedule(&gTimerThread, delay, REL_SEC, &job, SHORT_TERM,
+                            nullptr) == 0;
+}
+
+/*!
+ * \brief Remove expired entries from the cache.
+ *
+ * This is a job on the timer thread. It schedules itself again as long as
+ * the cache is not empty.
+ */
+void ssdp_cache_sweep([[maybe_unused]] void* arg) {
+    std::vector<UpnpDiscovery*> expired;
+    {
+        const time_t now{time(nullptr)};
+        std::scoped_lock lock(gSsdpCacheMutex);
+        gSsdpCacheSweepScheduled = false;
+        for (auto it = gSsdpCache.begin(); it != gSsdpCache.end();) {
+            if (it->second.expires_at <= now) {
+                if (it->second.alive)
+                    gSsdpCacheStats.expired++;
+                expired.push_back(it->second.disc);
+                it = gSsdpCache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        gSsdpCacheStats.entries = gSsdpCache.size();
+        ssdp_cache_schedule_sweep();
+    }
+    for (UpnpDiscovery* disc : expired)
+        UpnpDiscovery_delete(disc);
+}
+
+/*!
+ * \brief Store a message of a device in the cache and check if it is new.
+ *
+ * An advertisement is new if it changes the state or location of the entry
+ * or if the last one was passed on before SSDP_CACHE_COPY_WINDOW. A search
+ * reply is new for each search. A message without USN is not cached and is
+ * always new. If the cache is full the entry that expires first is evicted.
+ *
+ * \returns
+ *  - true - the message must be passed to the control point
+ *  - false - the message is a copy of a cached one
+ */
+bool ssdp_cache_store(
+    /*! [in] Unique service name of the message, empty if it has no valid
+     * one. */
+    const std::string& a_usn,
+    /*! [in] Discovery information of the message. */
+    const UpnpDiscovery* a_disc,
+    /*! [in] false for a byebye. */
+    bool a_alive,
+    /*! [in] Timeout event id of the search for a reply, -1 for an
+     * advertisement. */
+    int a_search_id = -1) {
+    if (a_usn.empty())
+        return true;
+    const time_t now{time(nullptr)};
+    UpnpDiscovery* old_disc{nullptr};
+    UpnpDiscovery* evicted_disc{nullptr};
+    bool is_new{};
+    {
+        std::scoped_lock lock(gSsdpCacheMutex);
+        if (gSsdpCache.size() >= SSDP_CACHE_MAX_ENTRIES &&
+            gSsdpCache.find(a_usn) == gSsdpCache.end()) {
+            auto first = std::min_element(
+                gSsdpCache.begin(), gSsdpCache.end(),
+                [](const auto& a, const auto& b) {
+                    return a.second.expires_at < b.second.expires_at;
+                });
+            evicted_disc = first->second.disc;
+            gSsdpCache.erase(first);
+            gSsdpCacheStats.evicted++;
+        }
+        ssdp_cache_entry_t& entry = gSsdpCache[a_usn];
+        const bool is_equal{
+            entry.disc != nullptr && entry.expires_at > now &&
+            entry.alive == a_alive &&
+            (!a_alive ||
+             strcmp(UpnpDiscovery_get_Location_cstr(entry.disc),
+                    UpnpDiscovery_get_Location_cstr(a_disc)) == 0)};
+        if (!is_equal) {
+            old_disc = entry.disc;
+            entry.disc = UpnpDiscovery_dup(a_disc);
+            entry.alive = a_alive;
+            entry.replied_searches.clear();
+        }
+        if (a_search_id < 0) {
+            is_new = !is_equal || now - entry.passed_at > SSDP_CACHE_COPY_WINDOW;
+        } else {
+            std::vector<int>& replied = entry.replied_searches;
+            is_new = std::find(replied.begin(), replied.end(), a_search_id) ==
+                     replied.end();
+            if (is_new)
+                replied.push_back(a_search_id);
+        }
+        if (is_new)
+            entry.passed_at = now;
+        entry.expires_at =
+            now + (a_alive ? std::max(UpnpDiscovery_get_Expires(a_disc), 1)
+                           : SSDP_CACHE_COPY_WINDOW);
+        if (is_new)
+            gSsdpCacheStats.misses++;
+        else
+            gSsdpCacheStats.hits++;
+        gSsdpCacheStats.entries = gSsdpCache.size();
+        ssdp_cache_schedule_sweep();
+    }
+    UpnpDiscovery_delete(old_disc);
+    UpnpDiscovery_delete(evicted_disc);
+    return is_new;
+}
+/// @}
+
 /// @} Scope restricted to file
 } // anonymous namespace
 
+void SsdpCacheGetStats(SsdpCacheStats* stats) {
+    std::scoped_lock lock(gSsdpCacheMutex);
+    *stats = gSsdpCacheStats;
+}
+
+int SsdpCacheGetAlive(void (*visit)(const UpnpDiscovery* disc, void* cookie),
+                      void* cookie) {
+    const time_t now{time(nullptr)};
+    int count{};
+    std::scoped_lock lock(gSsdpCacheMutex);
+    for (const auto& [usn, entry] : gSsdpCache) {
+        if (entry.alive && entry.expires_at > now) {
+            visit(entry.disc, cookie);
+            count++;
+        }
+    }
+    return count;
+}
+
+void SsdpCacheClear() {
+    std::scoped_lock lock(gSsdpCacheMutex);
+    for (auto& [usn, entry] : gSsdpCache)
+        UpnpDiscovery_delete(entry.disc);
+    gSsdpCache.clear();
+    gSsdpCacheStats = {};
+    // A scheduled sweep is gone with the timer thread or finds nothing.
+    gSsdpCacheSweepScheduled = false;
+}
+
 void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
                             struct sockaddr_storage* dest_addr, int timeout) {
     int handle;
@@ -294,6 +623,7 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
     SsdpEvent event;
     int nt_found;
     int usn_found;
+    std::string usn;
     int st_found;
     char save_char;
     Upnp_EventType event_type;
@@ -347,7 +677,7 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
     }
     /* DATE */
     if (httpmsg_find_hdr(hmsg, HDR_DATE, &hdr_value) != NULL) {
-        UpnpDiscovery_strcpy_Date(param, hdr_value.buf);
+        UpnpDiscovery_strncpy_Date(param, hdr_value.buf, hdr_value.length);
     }
     /* dest addr */
     UpnpDiscovery_set_DestAddr(param, dest_addr);
@@ -380,6 +710,8 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
         save_char = hdr_value.buf[hdr_value.length];
         hdr_value.buf[hdr_value.length] = '\0';
         usn_found = (unique_service_name(hdr_value.buf, &event) == 0);
+        if (usn_found)
+            usn.assign(hdr_value.buf, hdr_value.length);
         hdr_value.buf[hdr_value.length] = save_char;
     }
     if (nt_found || usn_found) {
@@ -422,6 +754,9 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
             }
             event_type = UPNP_DISCOVERY_ADVERTISEMENT_ALIVE;
         }
+        /* suppress copies of an already passed on message */
+        if (!ssdp_cache_store(usn, param, !is_byebye))
+            goto end_ssdp_handle_ctrlpt_msg;
         /* call callback */
         for (handle = handle_start; handle < NUM_HANDLE; handle++) {
             HandleLock();
@@ -505,7 +840,9 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
                     matched = 0;
                     break;
                 }
-                if (matched) {
+                if (matched &&
+                    ssdp_cache_store(usn, param, true,
+                                     searchArg->timeoutEventId)) {
                     /* schedule call back */
                     threadData = SSDPResultData_new();
                     if (threadData != NULL) {
@@ -518,6 +855,7 @@ void ssdp_handle_ctrlpt_msg(http_message_t* hmsg,
 
                         TPJobInit(&job, (start_routine)send_search_result,
                                   threadData);
+                        TPJobSetLabel(&job, JOB_LABEL_SSDP);
                         TPJobSetPriority(&job, MED_PRIORITY);
                         TPJobSetFreeFunction(&job, (free_routine)free);
                         if (ThreadPoolAdd(&gRecvThreadPool, &job, NULL) != 0) {
@@ -540,38 +878,31 @@ end_ssdp_handle_ctrlpt_msg:
 
 
 int SearchByTarget(int Hnd, int Mx, char* St, void* Cookie) {
-    char errorBuffer[ERROR_BUFFER_LEN];
     int* id = NULL;
-    int ret = 0;
-    char ReqBufv4[BUFSIZE];
-#ifdef UPNP_ENABLE_IPV6
-    char ReqBufv6[BUFSIZE];
-    char ReqBufv6UlaGua[BUFSIZE];
-#endif
-    struct sockaddr_storage __ss_v4;
+    SsdpSearchSendArg* sendArg = NULL;
+    struct sockaddr_in* destAddr4 = NULL;
 #ifdef UPNP_ENABLE_IPV6
-    struct sockaddr_storage __ss_v6;
+    struct sockaddr_in6* destAddr6 = NULL;
 #endif
-    struct sockaddr_in* destAddr4 = (struct sockaddr_in*)&__ss_v4;
-#ifdef UPNP_ENABLE_IPV6
-    struct sockaddr_in6* destAddr6 = (struct sockaddr_in6*)&__ss_v6;
-#endif
-    fd_set wrSet;
     SsdpSearchArg* newArg = NULL;
     SsdpSearchExpArg* expArg = NULL;
     int timeTillRead = 0;
     struct Handle_Info* ctrlpt_info = NULL;
     enum SsdpSearchType requestType;
-    struct in_addr addrv4;
-    SOCKET max_fd = 0;
+    struct in_addr addrv4 {};
     int retVal;
 
     /*ThreadData *ThData; */
     ThreadPoolJob job;
 
-    if (strlen(gIF_IPV4) > (size_t)0 &&
-        !inet_pton(AF_INET, gIF_IPV4, &addrv4)) {
-        return UPNP_E_INVALID_PARAM;
+    unsigned if_index;
+    {
+        std::shared_lock if_lock(gIfAddrMutex);
+        if (strlen(gIF_IPV4) > (size_t)0 &&
+            !inet_pton(AF_INET, gIF_IPV4, &addrv4)) {
+            return UPNP_E_INVALID_PARAM;
+        }
+        if_index = gIF_INDEX;
     }
 
     memset(&job, 0, sizeof(job));
@@ -585,38 +916,53 @@ int SearchByTarget(int Hnd, int Mx, char* St, void* Cookie) {
         timeTillRead = MIN_SEARCH_TIME;
     else if (timeTillRead > MAX_SEARCH_TIME)
         timeTillRead = MAX_SEARCH_TIME;
-    retVal = CreateClientRequestPacket(ReqBufv4, sizeof(ReqBufv4), timeTillRead,
+    sendArg = (SsdpSearchSendArg*)malloc(sizeof(SsdpSearchSendArg));
+    if (sendArg == NULL)
+        return UPNP_E_OUTOF_MEMORY;
+    memset(sendArg, 0, sizeof(SsdpSearchSendArg));
+    sendArg->copiesLeft = NUM_SSDP_COPY;
+    sendArg->ifv4 = addrv4;
+    retVal = CreateClientRequestPacket(sendArg->ReqBufv4,
+                                       sizeof(sendArg->ReqBufv4), timeTillRead,
                                        St, AF_INET);
-    if (retVal != UPNP_E_SUCCESS)
-        return retVal;
 #ifdef UPNP_ENABLE_IPV6
-    retVal = CreateClientRequestPacket(ReqBufv6, sizeof(ReqBufv6), timeTillRead,
-                                       St, AF_INET6);
-    if (retVal != UPNP_E_SUCCESS)
-        return retVal;
-    retVal = CreateClientRequestPacketUlaGua(
-        ReqBufv6UlaGua, sizeof(ReqBufv6UlaGua), timeTillRead, St, AF_INET6);
-    if (retVal != UPNP_E_SUCCESS)
-        return retVal;
+    if (retVal == UPNP_E_SUCCESS)
+        retVal = CreateClientRequestPacket(sendArg->ReqBufv6,
+                                           sizeof(sendArg->ReqBufv6),
+                                           timeTillRead, St, AF_INET6);
+    if (retVal == UPNP_E_SUCCESS)
+        retVal = CreateClientRequestPacketUlaGua(
+            sendArg->ReqBufv6UlaGua, sizeof(sendArg->ReqBufv6UlaGua),
+            timeTillRead, St, AF_INET6);
 #endif
+    if (retVal != UPNP_E_SUCCESS) {
+        free(sendArg);
+        return retVal;
+    }
 
-    memset(&__ss_v4, 0, sizeof(__ss_v4));
+    destAddr4 = (struct sockaddr_in*)&sendArg->destv4;
     destAddr4->sin_family = (sa_family_t)AF_INET;
     inet_pton(AF_INET, SSDP_IP, &destAddr4->sin_addr);
     destAddr4->sin_port = htons(SSDP_PORT);
 
 #ifdef UPNP_ENABLE_IPV6
-    memset(&__ss_v6, 0, sizeof(__ss_v6));
+    destAddr6 = (struct sockaddr_in6*)&sendArg->destv6SiteLocal;
     destAddr6->sin6_family = (sa_family_t)AF_INET6;
     inet_pton(AF_INET6, SSDP_IPV6_SITELOCAL, &destAddr6->sin6_addr);
     destAddr6->sin6_port = htons(SSDP_PORT);
-    destAddr6->sin6_scope_id = gIF_INDEX;
+    destAddr6->sin6_scope_id = if_index;
+    destAddr6 = (struct sockaddr_in6*)&sendArg->destv6LinkLocal;
+    destAddr6->sin6_family = (sa_family_t)AF_INET6;
+    inet_pton(AF_INET6, SSDP_IPV6_LINKLOCAL, &destAddr6->sin6_addr);
+    destAddr6->sin6_port = htons(SSDP_PORT);
+    destAddr6->sin6_scope_id = if_index;
 #endif
 
     /* add search criteria to list */
     HandleLock();
     if (GetHandleInfo(Hnd, &ctrlpt_info) != HND_CLIENT) {
         HandleUnlock();
+        free(sendArg);
         return UPNP_E_INTERNAL_ERROR;
     }
     newArg = (SsdpSearchArg*)malloc(sizeof(SsdpSearchArg));
@@ -628,6 +974,7 @@ int SearchByTarget(int Hnd, int Mx, char* St, void* Cookie) {
     expArg->handle = Hnd;
     id = (int*)&(expArg->timeoutEventId);
     TPJobInit(&job, (start_routine)searchExpired, expArg);
+    TPJobSetLabel(&job, JOB_LABEL_SSDP);
     TPJobSetPriority(&job, MED_PRIORITY);
     TPJobSetFreeFunction(&job, (free_routine)free);
     /* Schedule a timeout event to remove search Arg */
@@ -638,76 +985,15 @@ int SearchByTarget(int Hnd, int Mx, char* St, void* Cookie) {
     HandleUnlock();
     /* End of lock */
 
-    FD_ZERO(&wrSet);
-    if (gSsdpReqSocket4 != INVALID_SOCKET) {
-        umock::sys_socket_h.setsockopt(gSsdpReqSocket4, IPPROTO_IP,
-                                       IP_MULTICAST_IF, (char*)&addrv4,
-                                       sizeof(addrv4));
-        FD_SET(gSsdpReqSocket4, &wrSet);
-        max_fd = std::max(max_fd, gSsdpReqSocket4);
-    }
 #ifdef UPNP_ENABLE_IPV6
     if (gSsdpReqSocket6 != INVALID_SOCKET) {
         umock::sys_socket_h.setsockopt(gSsdpReqSocket6, IPPROTO_IPV6,
-                                       IPV6_MULTICAST_IF, (char*)&gIF_INDEX,
-                                       sizeof(gIF_INDEX));
-        FD_SET(gSsdpReqSocket6, &wrSet);
-        max_fd = std::max(max_fd, gSsdpReqSocket6);
+                                       IPV6_MULTICAST_IF, (char*)&if_index,
+                                       sizeof(if_index));
     }
 #endif
-    ret = umock::sys_socket_h.select((int)max_fd + 1, NULL, &wrSet, NULL, NULL);
-    if (ret == -1) {
-        strerror_r(errno, errorBuffer, ERROR_BUFFER_LEN);
-        UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
-                   "SSDP_LIB: Error in select(): %s\n", errorBuffer);
-        umock::unistd_h.CLOSE_SOCKET_P(gSsdpReqSocket4);
-#ifdef UPNP_ENABLE_IPV6
-        umock::unistd_h.CLOSE_SOCKET_P(gSsdpReqSocket6);
-#endif
-        return UPNP_E_INTERNAL_ERROR;
-    }
-#ifdef UPNP_ENABLE_IPV6
-    if (gSsdpReqSocket6 != INVALID_SOCKET &&
-        FD_ISSET(gSsdpReqSocket6, &wrSet)) {
-        int NumCopy = 0;
-
-        while (NumCopy < NUM_SSDP_COPY) {
-            UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
-                       ">>> SSDP SEND M-SEARCH >>>\n%s\n", ReqBufv6UlaGua);
-            sendto(gSsdpReqSocket6, ReqBufv6UlaGua,
-                   (SIZEP_T)strlen(ReqBufv6UlaGua), 0,
-                   (struct sockaddr*)&__ss_v6,
-                   (SIZEP_T)sizeof(struct sockaddr_in6));
-            NumCopy++;
-            imillisleep(SSDP_PAUSE);
-        }
-        NumCopy = 0;
-        inet_pton(AF_INET6, SSDP_IPV6_LINKLOCAL, &destAddr6->sin6_addr);
-        while (NumCopy < NUM_SSDP_COPY) {
-            UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
-                       ">>> SSDP SEND M-SEARCH >>>\n%s\n", ReqBufv6);
-            sendto(gSsdpReqSocket6, ReqBufv6, (SIZEP_T)strlen(ReqBufv6), 0,
-                   (struct sockaddr*)&__ss_v6,
-                   (SIZEP_T)sizeof(struct sockaddr_in6));
-            NumCopy++;
-            imillisleep(SSDP_PAUSE);
-        }
-    }
-#endif /* IPv6 */
-    if (gSsdpReqSocket4 != INVALID_SOCKET &&
-        FD_ISSET(gSsdpReqSocket4, &wrSet)) {
-        int NumCopy = 0;
-        while (NumCopy < NUM_SSDP_COPY) {
-            UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
-                       ">>> SSDP SEND M-SEARCH >>>\n%s\n", ReqBufv4);
-            umock::sys_socket_h.sendto(gSsdpReqSocket4, ReqBufv4,
-                                       (SIZEP_T)strlen(ReqBufv4), 0,
-                                       (struct sockaddr*)&__ss_v4,
-                                       (SIZEP_T)sizeof(struct sockaddr_in));
-            NumCopy++;
-            imillisleep(SSDP_PAUSE);
-        }
-    }
+    /* Send the first copy now, the timer thread sends the others. */
+    searchSendCopy(sendArg);
 
     return 1;
 }
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (C) 2011-2012 France Telecom All rights reserved.
  * Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-30
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -58,6 +58,12 @@
 #include <cstdio>
 #include <cstring>
 #include <algorithm> // for std::min|max
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 /// \endcond
 
 
@@ -73,6 +79,136 @@ constexpr int MSGTYPE_REPLY{2};
 /// @}
 /// @}
 
+/*! \name Limits for search replies
+ * @{ */
+/// \brief Token bucket of a source of searches.
+struct search_bucket_t {
+    /// Number of searches that may be answered now.
+    double tokens;
+    /// Time when the tokens were last refilled.
+    std::chrono::steady_clock::time_point refilled;
+};
+
+/// \brief State to limit the replies to searches.
+struct {
+    /// Protects the state.
+    std::mutex mutex;
+    /// Searches per second that are answered from one source.
+    double rate{SSDP_SEARCH_RATE};
+    /// Number of searches that are answered from one source at once.
+    double burst{SSDP_SEARCH_BURST};
+    /// Maximal number of replies that are scheduled at the same time.
+    size_t max_pending{SSDP_MAX_PENDING_REPLIES};
+    /// Token buckets keyed by the ip address of the source.
+    std::unordered_map<std::string, search_bucket_t> buckets;
+    /// Keys of the scheduled replies, see search_reply_key().
+    std::unordered_set<std::string> pending;
+    /// Counters.
+    SsdpSearchStats stats{};
+} gSearchLimit;
+
+/// \brief Maximal number of sources with a token bucket.
+constexpr size_t SSDP_SEARCH_MAX_SOURCES{1024};
+
+/*!
+ * \brief Get the ip address of a socket address as string.
+ */
+std::string source_address(
+    /*! [in] Socket address. */
+    const sockaddr_storage& a_addr) {
+    char buf[INET6_ADDRSTRLEN]{};
+    if (a_addr.ss_family == AF_INET6)
+        inet_ntop(AF_INET6, &((const sockaddr_in6*)&a_addr)->sin6_addr, buf,
+                  sizeof(buf));
+    else
+        inet_ntop(AF_INET, &((const sockaddr_in*)&a_addr)->sin_addr, buf,
+                  sizeof(buf));
+    return buf;
+}
+
+/*!
+ * \brief Get the key of a scheduled reply.
+ *
+ * Equal searches from the same source on the same interface to the same
+ * device handle have the same key.
+ */
+std::string search_reply_key(
+    /*! [in] Reply to be scheduled. */
+    const SsdpSearchReply& a_reply) {
+    const in_port_t port =
+        a_reply.dest_addr.ss_family == AF_INET6
+            ? ((const sockaddr_in6*)&a_reply.dest_addr)->sin6_port
+            : ((const sockaddr_in*)&a_reply.dest_addr)->sin_port;
+    return source_address(a_reply.dest_addr) + '|' +
+           std::to_string(ntohs(port)) + '|' +
+           std::to_string(a_reply.handle) + '|' +
+           std::to_string((int)a_reply.event.RequestType) + '|' +
+           a_reply.event.DeviceType + '|' + a_reply.event.UDN + '|' +
+           a_reply.event.ServiceType + '|' + a_reply.if_ipv4;
+}
+
+/*!
+ * \brief Take a token from the bucket of the source of a search.
+ *
+ * Must be called with gSearchLimit.mutex locked.
+ *
+ * \returns **true** if the search may be answered, else **false**.
+ */
+bool take_search_token(
+    /*! [in] Address of the source. */
+    const std::string& a_source) {
+    const auto now = std::chrono::steady_clock::now();
+    auto it = gSearchLimit.buckets.find(a_source);
+    if (it == gSearchLimit.buckets.end()) {
+        if (gSearchLimit.buckets.size() >= SSDP_SEARCH_MAX_SOURCES) {
+            // Forget the sources whose bucket is full again.
+            for (auto it2 = gSearchLimit.buckets.begin();
+                 it2 != gSearchLimit.buckets.end();) {
+                const std::chrono::duration<double> idle =
+                    now - it2->second.refilled;
+                if (it2->second.tokens + idle.count() * gSearchLimit.rate >=
+                    gSearchLimit.burst)
+                    it2 = gSearchLimit.buckets.erase(it2);
+                else
+                    ++it2;
+            }
+            if (gSearchLimit.buckets.size() >= SSDP_SEARCH_MAX_SOURCES)
+                return false;
+        }
+        it = gSearchLimit.buckets
+                 .emplace(a_source, search_bucket_t{gSearchLimit.burst, now})
+                 .first;
+    }
+    search_bucket_t& bucket = it->second;
+    const std::chrono::duration<double> elapsed = now - bucket.refilled;
+    bucket.tokens = std::min(gSearchLimit.burst,
+                             bucket.tokens + elapsed.count() * gSearchLimit.rate);
+    bucket.refilled = now;
+    if (bucket.tokens < 1.0)
+        return false;
+    bucket.tokens -= 1.0;
+    return true;
+}
+
+/*!
+ * \brief Free a scheduled reply and remove its key from the pending replies.
+ *
+ * This is the only place where the key is removed. It is called when the
+ * reply has been sent or when its job is dropped, so an equal reply that is
+ * scheduled meanwhile keeps its key.
+ */
+void free_search_reply(
+    /*! [in] Pointer to a SsdpSearchReply. */
+    void* a_arg) {
+    SsdpSearchReply* arg = (SsdpSearchReply*)a_arg;
+    {
+        std::scoped_lock lock(gSearchLimit.mutex);
+        gSearchLimit.pending.erase(search_reply_key(*arg));
+    }
+    free(arg);
+}
+/// @}
+
 /*! \name Functions scope restricted to file
  * @{ */
 
@@ -94,7 +230,10 @@ int NewRequestHandler(
     /*! [in] Number of packet to be sent. */
     int NumPacket,
     /*! [in] */
-    char** RqPacket) {
+    char** RqPacket,
+    /*! [in] IPv4 address of an additional interface to send multicasts on,
+     * nullptr for the interface given to UpnpInit2(). */
+    const char* IfIpv4 = nullptr) {
     char errorBuffer[ERROR_BUFFER_LEN];
     SOCKET ReplySock;
     socklen_t socklen = sizeof(struct sockaddr_storage);
@@ -108,9 +247,16 @@ int NewRequestHandler(
     char buf_ntop[INET6_ADDRSTRLEN];
     int ret = UPNP_E_SUCCESS;
 
-    if (strlen(gIF_IPV4) > (size_t)0 &&
-        !inet_pton(AF_INET, gIF_IPV4, &replyAddr)) {
-        return UPNP_E_INVALID_PARAM;
+    unsigned if_index;
+    {
+        std::shared_lock if_lock(gIfAddrMutex);
+        const char* if_ipv4 =
+            IfIpv4 != nullptr && IfIpv4[0] != '\0' ? IfIpv4 : gIF_IPV4;
+        if (strlen(if_ipv4) > (size_t)0 &&
+            !inet_pton(AF_INET, if_ipv4, &replyAddr)) {
+            return UPNP_E_INVALID_PARAM;
+        }
+        if_index = gIF_INDEX;
     }
 
     ReplySock =
@@ -140,8 +286,8 @@ int NewRequestHandler(
         inet_ntop(AF_INET6, &((struct sockaddr_in6*)DestAddr)->sin6_addr,
                   buf_ntop, sizeof(buf_ntop));
         umock::sys_socket_h.setsockopt(ReplySock, IPPROTO_IPV6,
-                                       IPV6_MULTICAST_IF, (char*)&gIF_INDEX,
-                                       sizeof(gIF_INDEX));
+                                       IPV6_MULTICAST_IF, (char*)&if_index,
+                                       sizeof(if_index));
         umock::sys_socket_h.setsockopt(ReplySock, IPPROTO_IPV6,
                                        IPV6_MULTICAST_HOPS, (char*)&hops,
                                        sizeof(hops));
@@ -179,6 +325,36 @@ end_NewRequestHandler:
     return ret;
 }
 
+/*!
+ * \brief Get the location URL on an additional interface.
+ *
+ * If the host of the URL is the IPv4 address of the interface given to
+ * UpnpInit2(), it is replaced by the address of the additional interface.
+ * Other URLs, e.g. of an external web server, are returned unchanged.
+ */
+std::string location_on_if(
+    /*! [in] Location URL. */
+    const char* a_url,
+    /*! [in] IPv4 address of the additional interface, empty for the
+     * interface given to UpnpInit2(). */
+    const std::string& a_if_ipv4) {
+    std::string url{a_url};
+    if (a_if_ipv4.empty())
+        return url;
+    const size_t host_pos = url.find("://");
+    if (host_pos == std::string::npos)
+        return url;
+    const size_t host_begin = host_pos + 3;
+    const size_t host_end = url.find_first_of(":/", host_begin);
+    const size_t host_len = (host_end == std::string::npos ? url.size()
+                                                           : host_end) -
+                            host_begin;
+    std::shared_lock if_lock(gIfAddrMutex);
+    if (gIF_IPV4[0] != '\0' && url.compare(host_begin, host_len, gIF_IPV4) == 0)
+        url.replace(host_begin, host_len, a_if_ipv4);
+    return url;
+}
+
 /*!
  * \brief Extract IPv6 address.
  *
@@ -481,7 +657,8 @@ void CreateServicePacket(
 
 
 void ssdp_handle_device_request(http_message_t* hmsg,
-                                struct sockaddr_storage* dest_addr) {
+                                struct sockaddr_storage* dest_addr,
+                                const char* if_ipv4) {
     constexpr int MX_FUDGE_FACTOR{10};
     int handle, start;
     struct Handle_Info* dev_info = NULL;
@@ -517,6 +694,17 @@ void ssdp_handle_device_request(http_message_t* hmsg,
     if (ret_code == -1)
         /* bad ST header. */
         return;
+    {
+        std::scoped_lock lock(gSearchLimit.mutex);
+        gSearchLimit.stats.received++;
+        if (!take_search_token(source_address(*dest_addr))) {
+            gSearchLimit.stats.dropped_rate++;
+            UpnpPrintf(UPNP_INFO, SSDP, __FILE__, __LINE__,
+                       "Too many searches, drop search from %s\n",
+                       source_address(*dest_addr).c_str());
+            return;
+        }
+    }
 
     start = 0;
     for (;;) {
@@ -551,9 +739,28 @@ void ssdp_handle_device_request(http_message_t* hmsg,
         memcpy(&threadArg->dest_addr, dest_addr, sizeof(threadArg->dest_addr));
         threadArg->event = event;
         threadArg->MaxAge = maxAge;
+        snprintf(threadArg->if_ipv4, sizeof(threadArg->if_ipv4), "%s",
+                 if_ipv4 == nullptr ? "" : if_ipv4);
+        start = handle;
+        {
+            std::scoped_lock lock(gSearchLimit.mutex);
+            if (gSearchLimit.pending.size() >= gSearchLimit.max_pending) {
+                gSearchLimit.stats.dropped_queue++;
+                free(threadArg);
+                continue;
+            }
+            if (!gSearchLimit.pending.insert(search_reply_key(*threadArg))
+                     .second) {
+                // An equal reply is already scheduled.
+                gSearchLimit.stats.merged++;
+                free(threadArg);
+                continue;
+            }
+        }
 
         TPJobInit(&job, advertiseAndReplyThread, threadArg);
-        TPJobSetFreeFunction(&job, (free_routine)free);
+        TPJobSetLabel(&job, JOB_LABEL_SSDP);
+        TPJobSetFreeFunction(&job, free_search_reply);
 
         /* Subtract a percentage from the mx to allow for network and processing
          * delays (i.e. if search is for 30 seconds, respond
@@ -563,15 +770,39 @@ void ssdp_handle_device_request(http_message_t* hmsg,
         if (mx < 1)
             mx = 1;
         replyTime = rand() % mx;
-        TimerThreadSchedule(&gTimerThread, replyTime, REL_SEC, &job, SHORT_TERM,
-                            NULL);
-        start = handle;
+        if (TimerThreadSchedule(&gTimerThread, replyTime, REL_SEC, &job,
+                                SHORT_TERM, NULL) != 0)
+            free_search_reply(threadArg);
     }
 }
 
+void SsdpGetSearchStats(SsdpSearchStats* stats) {
+    std::scoped_lock lock(gSearchLimit.mutex);
+    *stats = gSearchLimit.stats;
+    stats->pending = gSearchLimit.pending.size();
+}
+
+int SsdpSetSearchLimit(double rate, int burst, int max_pending) {
+    if (rate <= 0.0 || burst < 1 || max_pending < 1)
+        return UPNP_E_INVALID_PARAM;
+    std::scoped_lock lock(gSearchLimit.mutex);
+    gSearchLimit.rate = rate;
+    gSearchLimit.burst = burst;
+    gSearchLimit.max_pending = (size_t)max_pending;
+    gSearchLimit.buckets.clear();
+    return UPNP_E_SUCCESS;
+}
+
+void SsdpSearchLimitClear() {
+    std::scoped_lock lock(gSearchLimit.mutex);
+    gSearchLimit.buckets.clear();
+    gSearchLimit.stats = SsdpSearchStats{};
+}
+
 int DeviceAdvertisement(char* DevType, int RootDev, char* Udn, char* Location,
                         int Duration, int AddressFamily, int PowerState,
-                        int SleepPeriod, int RegistrationState) {
+                        int SleepPeriod, int RegistrationState,
+                        const char* IfIpv4) {
     struct sockaddr_storage __ss;
     struct sockaddr_in* DestAddr4 = (struct sockaddr_in*)&__ss;
     struct sockaddr_in6* DestAddr6 = (struct sockaddr_in6*)&__ss;
@@ -632,11 +863,13 @@ int DeviceAdvertisement(char* DevType, int RootDev, char* Udn, char* Location,
     /* send packets */
     if (RootDev) {
         /* send 3 msg types */
-        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 3, &msgs[0]);
+        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 3, &msgs[0],
+                                     IfIpv4);
     } else { /* sub-device */
 
         /* send 2 msg types */
-        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 2, &msgs[1]);
+        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 2, &msgs[1],
+                                     IfIpv4);
     }
 
 error_handler:
@@ -768,7 +1001,8 @@ error_handler:
 
 int ServiceAdvertisement(char* Udn, char* ServType, char* Location,
                          int Duration, int AddressFamily, int PowerState,
-                         int SleepPeriod, int RegistrationState) {
+                         int SleepPeriod, int RegistrationState,
+                         const char* IfIpv4) {
     char Mil_Usn[LINE_SIZE];
     char* szReq[1];
     int RetVal = UPNP_E_OUTOF_MEMORY;
@@ -809,7 +1043,7 @@ int ServiceAdvertisement(char* Udn, char* ServType, char* Location,
     if (szReq[0] == NULL) {
         goto error_handler;
     }
-    RetVal = NewRequestHandler((struct sockaddr*)&__ss, 1, szReq);
+    RetVal = NewRequestHandler((struct sockaddr*)&__ss, 1, szReq, IfIpv4);
 
 error_handler:
     free(szReq[0]);
@@ -844,7 +1078,7 @@ error_handler:
 
 int ServiceShutdown(char* Udn, char* ServType, char* Location, int Duration,
                     int AddressFamily, int PowerState, int SleepPeriod,
-                    int RegistrationState) {
+                    int RegistrationState, const char* IfIpv4) {
     char Mil_Usn[LINE_SIZE];
     char* szReq[1];
     struct sockaddr_storage __ss;
@@ -885,7 +1119,7 @@ int ServiceShutdown(char* Udn, char* ServType, char* Location, int Duration,
                         RegistrationState);
     if (szReq[0] == NULL)
         goto error_handler;
-    RetVal = NewRequestHandler((struct sockaddr*)&__ss, 1, szReq);
+    RetVal = NewRequestHandler((struct sockaddr*)&__ss, 1, szReq, IfIpv4);
 
 error_handler:
     free(szReq[0]);
@@ -895,7 +1129,7 @@ error_handler:
 
 int DeviceShutdown(char* DevType, int RootDev, char* Udn, char* Location,
                    int Duration, int AddressFamily, int PowerState,
-                   int SleepPeriod, int RegistrationState) {
+                   int SleepPeriod, int RegistrationState, const char* IfIpv4) {
     struct sockaddr_storage __ss;
     struct sockaddr_in* DestAddr4 = (struct sockaddr_in*)&__ss;
     struct sockaddr_in6* DestAddr6 = (struct sockaddr_in6*)&__ss;
@@ -955,11 +1189,13 @@ int DeviceShutdown(char* DevType, int RootDev, char* Udn, char* Location,
     /* send packets */
     if (RootDev) {
         /* send 3 msg types */
-        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 3, &msgs[0]);
+        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 3, &msgs[0],
+                                     IfIpv4);
     } else {
         /* sub-device */
         /* send 2 msg types */
-        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 2, &msgs[1]);
+        ret_code = NewRequestHandler((struct sockaddr*)&__ss, 2, &msgs[1],
+                                     IfIpv4);
     }
 
 error_handler:
@@ -971,16 +1207,41 @@ error_handler:
     return ret_code;
 }
 
-int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
-                      enum SsdpSearchType SearchType, struct sockaddr* DestAddr,
-                      char* DeviceType, char* DeviceUDN, char* ServiceType,
-                      int Exp) {
+namespace {
+/*!
+ * \brief Sends SSDP advertisements, replies and shutdown messages on one
+ * interface.
+ *
+ * Must be called with the handle table read locked.
+ */
+void advertise_and_reply_on_if(
+    /*! [in] -1 = Send shutdown, 0 = send reply, 1 = Send Advertisement. */
+    int AdFlag,
+    /*! [in] Information of the device handle. */
+    Handle_Info* SInfo,
+    /*! [in] Search type for sending replies. */
+    enum SsdpSearchType SearchType,
+    /*! [in] Destination address. */
+    struct sockaddr* DestAddr,
+    /*! [in] Device type. */
+    char* DeviceType,
+    /*! [in] Device UDN. */
+    char* DeviceUDN,
+    /*! [in] Service type. */
+    char* ServiceType,
+    /*! [in] Advertisement age. */
+    int Exp,
+    /*! [in] Location URL on the interface. */
+    char* DescURL,
+    /*! [in] Location URL with lower versions on the interface. */
+    char* LowerDescURL,
+    /*! [in] IPv4 address of an additional interface, empty for the
+     * interface given to UpnpInit2(). */
+    const char* IfIpv4) {
     constexpr char SERVICELIST_STR[] = "serviceList";
-    int retVal = UPNP_E_SUCCESS;
     long unsigned int i;
     long unsigned int j;
     int defaultExp = DEFAULT_MAXAGE;
-    struct Handle_Info* SInfo = NULL;
     char UDNstr[100];
     char devType[100];
     char servType[100];
@@ -997,15 +1258,6 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
     memset(devType, 0, sizeof(devType));
     memset(servType, 0, sizeof(servType));
 
-    UpnpPrintf(UPNP_ALL, API, __FILE__, __LINE__,
-               "Inside AdvertiseAndReply with AdFlag = %d\n", AdFlag);
-
-    /* Use a read lock */
-    HandleReadLock();
-    if (GetHandleInfo(Hnd, &SInfo) != HND_DEVICE) {
-        retVal = UPNP_E_INVALID_HANDLE;
-        goto end_function;
-    }
     defaultExp = SInfo->MaxAge;
     /* parse the device list and send advertisements/replies */
     while (NumCopy == 0 || (AdFlag && NumCopy < NUM_SSDP_COPY)) {
@@ -1088,27 +1340,27 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
             if (AdFlag) {
                 /* send the device advertisement */
                 if (AdFlag == 1) {
-                    DeviceAdvertisement(devType, i == 0lu, UDNstr,
-                                        SInfo->DescURL, Exp, SInfo->DeviceAf,
-                                        SInfo->PowerState, SInfo->SleepPeriod,
-                                        SInfo->RegistrationState);
+                    DeviceAdvertisement(devType, i == 0lu, UDNstr, DescURL, Exp,
+                                        SInfo->DeviceAf, SInfo->PowerState,
+                                        SInfo->SleepPeriod,
+                                        SInfo->RegistrationState, IfIpv4);
                 } else {
                     /* AdFlag == -1 */
-                    DeviceShutdown(devType, i == 0lu, UDNstr, SInfo->DescURL,
-                                   Exp, SInfo->DeviceAf, SInfo->PowerState,
-                                   SInfo->SleepPeriod,
-                                   SInfo->RegistrationState);
+                    DeviceShutdown(devType, i == 0lu, UDNstr, DescURL, Exp,
+                                   SInfo->DeviceAf, SInfo->PowerState,
+                                   SInfo->SleepPeriod, SInfo->RegistrationState,
+                                   IfIpv4);
                 }
             } else {
                 switch (SearchType) {
                 case SSDP_ALL:
                     DeviceReply(DestAddr, devType, i == 0lu, UDNstr,
-                                SInfo->DescURL, defaultExp, SInfo->PowerState,
+                                DescURL, defaultExp, SInfo->PowerState,
                                 SInfo->SleepPeriod, SInfo->RegistrationState);
                     break;
                 case SSDP_ROOTDEVICE:
                     if (i == 0lu) {
-                        SendReply(DestAddr, devType, 1, UDNstr, SInfo->DescURL,
+                        SendReply(DestAddr, devType, 1, UDNstr, DescURL,
                                   defaultExp, 0, SInfo->PowerState,
                                   SInfo->SleepPeriod, SInfo->RegistrationState);
                     }
@@ -1124,7 +1376,7 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                             UpnpPrintf(UPNP_INFO, API, __FILE__, __LINE__,
                                 "DeviceUDN=%s and search UDN=%s MATCH\n",
                                 UDNstr, DeviceUDN);
-                            SendReply(DestAddr, devType, 0, UDNstr, SInfo->DescURL, defaultExp, 0,
+                            SendReply(DestAddr, devType, 0, UDNstr, DescURL, defaultExp, 0,
                                 SInfo->PowerState,
                                 SInfo->SleepPeriod,
                                 SInfo->RegistrationState);
@@ -1144,7 +1396,7 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                             UpnpPrintf(UPNP_INFO, API, __FILE__, __LINE__,
                                    "DeviceType=%s and search devType=%s MATCH\n",
                                    devType, DeviceType);
-                            SendReply(DestAddr, DeviceType, 0, UDNstr, SInfo->LowerDescURL,
+                            SendReply(DestAddr, DeviceType, 0, UDNstr, LowerDescURL,
                                   defaultExp, 1,
                                   SInfo->PowerState,
                                   SInfo->SleepPeriod,
@@ -1154,7 +1406,7 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                             UpnpPrintf(UPNP_INFO, API, __FILE__, __LINE__,
                                    "DeviceType=%s and search devType=%s MATCH\n",
                                    devType, DeviceType);
-                            SendReply(DestAddr, DeviceType, 0, UDNstr, SInfo->DescURL,
+                            SendReply(DestAddr, DeviceType, 0, UDNstr, DescURL,
                                   defaultExp, 1,
                                   SInfo->PowerState,
                                   SInfo->SleepPeriod,
@@ -1234,20 +1486,20 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                 if (AdFlag) {
                     if (AdFlag == 1) {
                         ServiceAdvertisement(
-                            UDNstr, servType, SInfo->DescURL, Exp,
-                            SInfo->DeviceAf, SInfo->PowerState,
-                            SInfo->SleepPeriod, SInfo->RegistrationState);
+                            UDNstr, servType, DescURL, Exp, SInfo->DeviceAf,
+                            SInfo->PowerState, SInfo->SleepPeriod,
+                            SInfo->RegistrationState, IfIpv4);
                     } else {
                         /* AdFlag == -1 */
-                        ServiceShutdown(UDNstr, servType, SInfo->DescURL, Exp,
+                        ServiceShutdown(UDNstr, servType, DescURL, Exp,
                                         SInfo->DeviceAf, SInfo->PowerState,
                                         SInfo->SleepPeriod,
-                                        SInfo->RegistrationState);
+                                        SInfo->RegistrationState, IfIpv4);
                     }
                 } else {
                     switch (SearchType) {
                     case SSDP_ALL:
-                        ServiceReply(DestAddr, servType, UDNstr, SInfo->DescURL,
+                        ServiceReply(DestAddr, servType, UDNstr, DescURL,
                                      defaultExp, SInfo->PowerState,
                                      SInfo->SleepPeriod,
                                      SInfo->RegistrationState);
@@ -1264,7 +1516,7 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                                     UpnpPrintf(UPNP_INFO, API, __FILE__, __LINE__,
                                            "ServiceType=%s and search servType=%s MATCH\n",
                                            ServiceType, servType);
-                                    SendReply(DestAddr, ServiceType, 0, UDNstr, SInfo->LowerDescURL,
+                                    SendReply(DestAddr, ServiceType, 0, UDNstr, LowerDescURL,
                                           defaultExp, 1,
                                           SInfo->PowerState,
                                           SInfo->SleepPeriod,
@@ -1274,7 +1526,7 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
                                     UpnpPrintf(UPNP_INFO, API, __FILE__, __LINE__,
                                            "ServiceType=%s and search servType=%s MATCH\n",
                                            ServiceType, servType);
-                                    SendReply(DestAddr, ServiceType, 0, UDNstr, SInfo->DescURL,
+                                    SendReply(DestAddr, ServiceType, 0, UDNstr, DescURL,
                                           defaultExp, 1,
                                           SInfo->PowerState,
                                           SInfo->SleepPeriod,
@@ -1304,14 +1556,47 @@ int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
         }
     }
 
-end_function:
     ixmlNodeList_free(tmpNodeList);
     ixmlNodeList_free(nodeList);
+}
+} // anonymous namespace
+
+int AdvertiseAndReply(int AdFlag, UpnpDevice_Handle Hnd,
+                      enum SsdpSearchType SearchType, struct sockaddr* DestAddr,
+                      char* DeviceType, char* DeviceUDN, char* ServiceType,
+                      int Exp, const char* IfIpv4) {
+    struct Handle_Info* SInfo = NULL;
+
+    UpnpPrintf(UPNP_ALL, API, __FILE__, __LINE__,
+               "Inside AdvertiseAndReply with AdFlag = %d\n", AdFlag);
+
+    /* Use a read lock */
+    HandleReadLock();
+    if (GetHandleInfo(Hnd, &SInfo) != HND_DEVICE) {
+        HandleUnlock();
+        return UPNP_E_INVALID_HANDLE;
+    }
+    // A reply has the location on the interface that got the search. An IPv4
+    // device is advertised on every interface with its own location.
+    std::vector<std::string> if_addrs{IfIpv4 == nullptr ? "" : IfIpv4};
+    if (AdFlag != 0 && SInfo->DeviceAf == AF_INET) {
+        const std::vector<std::string> more_addrs = SsdpGetIfAddrs4();
+        if_addrs.insert(if_addrs.end(), more_addrs.begin(), more_addrs.end());
+    }
+    for (const std::string& if_ipv4 : if_addrs) {
+        std::string desc_url = location_on_if(SInfo->DescURL, if_ipv4);
+        std::string lower_desc_url =
+            location_on_if(SInfo->LowerDescURL, if_ipv4);
+        advertise_and_reply_on_if(AdFlag, SInfo, SearchType, DestAddr,
+                                  DeviceType, DeviceUDN, ServiceType, Exp,
+                                  desc_url.data(), lower_desc_url.data(),
+                                  if_ipv4.c_str());
+    }
     UpnpPrintf(UPNP_ALL, API, __FILE__, __LINE__,
                "Exiting AdvertiseAndReply.\n");
     HandleUnlock();
 
-    return retVal;
+    return UPNP_E_SUCCESS;
 }
 
 void advertiseAndReplyThread(void* data) {
@@ -1319,6 +1604,8 @@ void advertiseAndReplyThread(void* data) {
 
     AdvertiseAndReply(0, arg->handle, arg->event.RequestType,
                       (struct sockaddr*)&arg->dest_addr, arg->event.DeviceType,
-                      arg->event.UDN, arg->event.ServiceType, arg->MaxAge);
-    free(arg);
+                      arg->event.UDN, arg->event.ServiceType, arg->MaxAge,
+                      arg->if_ipv4);
+    // From now on an equal search gets its own reply.
+    free_search_reply(arg);
 }
@@ -3,7 +3,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-04-24
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -43,10 +43,177 @@
 #include <umock/stdlib.hpp>
 
 /// \cond
+#include <atomic>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 /// \endcond
 
+namespace {
+
+/// \brief Payload sizes of the slab size classes.
+constexpr size_t slab_sizes[]{64, 128, 256, 512, 1024, 2048, 4096};
+/// \brief Number of size classes.
+constexpr unsigned NUM_SLAB_CLASSES{
+    sizeof(slab_sizes) / sizeof(slab_sizes[0])};
+/// \brief Size class of blocks that are bigger than all size classes.
+constexpr unsigned SLAB_LARGE{NUM_SLAB_CLASSES};
+/// \brief Maximal number of free blocks per size class a thread keeps.
+constexpr int SLAB_CACHE_SIZE{32};
+/// \brief Maximal number of free blocks per size class in the depot.
+constexpr int SLAB_DEPOT_SIZE{256};
+/// \brief Marks a block that is in use.
+constexpr std::uint32_t SLAB_USED{0x51ab05edu};
+/// \brief Marks a block that is free.
+constexpr std::uint32_t SLAB_FREE{0x51ab0f4eu};
+
+/*!
+ * \brief Header in front of every slab block.
+ * \details It keeps the payload aligned for any type.
+ */
+struct alignas(std::max_align_t) SlabHeader {
+    unsigned size_class;
+    std::uint32_t state;
+};
+
+/*!
+ * \brief Free blocks of one size class shared by all threads.
+ * \details Blocks are only pushed one chain at a time or taken all at once,
+ * so there is no ABA problem with the lock-free list.
+ */
+struct SlabDepot {
+    std::atomic<FreeListNode*> head{nullptr};
+    std::atomic<int> length{0};
+};
+
+SlabDepot gSlabDepot[NUM_SLAB_CLASSES];
+
+/// \brief Node of a free block, borrowed from its payload.
+inline FreeListNode* slab_node(SlabHeader* hdr) {
+    return reinterpret_cast<FreeListNode*>(hdr + 1);
+}
+
+/// \brief Header of a free block.
+inline SlabHeader* slab_header(FreeListNode* node) {
+    return reinterpret_cast<SlabHeader*>(node) - 1;
+}
+
+/*!
+ * \brief Push a chain of free blocks to the depot.
+ */
+void depot_push(SlabDepot* depot, FreeListNode* first, FreeListNode* last,
+                int count) {
+    FreeListNode* head{depot->head.load(std::memory_order_relaxed)};
+    do {
+        last->next = head;
+    } while (!depot->head.compare_exchange_weak(
+        head, first, std::memory_order_release, std::memory_order_relaxed));
+    depot->length.fetch_add(count, std::memory_order_relaxed);
+}
+
+/*!
+ * \brief Free list of one thread per size class.
+ * \details Its blocks go to the depot, or to the operating system if the
+ * depot is full, when the thread finishes.
+ */
+struct SlabCache {
+    FreeListNode* head[NUM_SLAB_CLASSES]{};
+    int length[NUM_SLAB_CLASSES]{};
+
+    /// \brief Return the free blocks of the thread.
+    void release(bool to_depot) {
+        for (unsigned cls{0}; cls < NUM_SLAB_CLASSES; cls++) {
+            while (this->head[cls] != nullptr) {
+                FreeListNode* node{this->head[cls]};
+                this->head[cls] = node->next;
+                if (to_depot && gSlabDepot[cls].length.load(
+                                    std::memory_order_relaxed) <
+                                    SLAB_DEPOT_SIZE)
+                    depot_push(&gSlabDepot[cls], node, node, 1);
+                else
+                    umock::stdlib_h.free(slab_header(node));
+            }
+            this->length[cls] = 0;
+        }
+    }
+
+    ~SlabCache() { this->release(true); }
+};
+
+thread_local SlabCache tSlabCache;
+
+/*!
+ * \brief Get the size class of a payload size.
+ */
+unsigned slab_class(size_t size) {
+    unsigned cls{0};
+    while (cls < NUM_SLAB_CLASSES && slab_sizes[cls] < size)
+        cls++;
+    return cls;
+}
+
+/*!
+ * \brief Refill the free list of the thread from the depot.
+ */
+void cache_refill(SlabCache* cache, unsigned cls) {
+    SlabDepot* depot{&gSlabDepot[cls]};
+    if (depot->head.load(std::memory_order_relaxed) == nullptr)
+        return;
+    FreeListNode* first{
+        depot->head.exchange(nullptr, std::memory_order_acquire)};
+    if (first == nullptr)
+        return;
+    // Keep at most half a cache and give the rest back.
+    FreeListNode* last{first};
+    int count{1};
+    while (last->next != nullptr && count < SLAB_CACHE_SIZE / 2) {
+        last = last->next;
+        count++;
+    }
+    FreeListNode* rest{last->next};
+    last->next = cache->head[cls];
+    cache->head[cls] = first;
+    cache->length[cls] += count;
+    depot->length.fetch_sub(count, std::memory_order_relaxed);
+    if (rest != nullptr) {
+        int rest_count{1};
+        FreeListNode* rest_last{rest};
+        while (rest_last->next != nullptr) {
+            rest_last = rest_last->next;
+            rest_count++;
+        }
+        depot->length.fetch_sub(rest_count, std::memory_order_relaxed);
+        depot_push(depot, rest, rest_last, rest_count);
+    }
+}
+
+/*!
+ * \brief Move half of the free list of the thread to the depot.
+ */
+void cache_flush(SlabCache* cache, unsigned cls) {
+    SlabDepot* depot{&gSlabDepot[cls]};
+    const int count{cache->length[cls] / 2};
+    FreeListNode* first{cache->head[cls]};
+    FreeListNode* last{first};
+    for (int i{1}; i < count; i++)
+        last = last->next;
+    cache->head[cls] = last->next;
+    cache->length[cls] -= count;
+    if (depot->length.load(std::memory_order_relaxed) < SLAB_DEPOT_SIZE) {
+        depot_push(depot, first, last, count);
+        return;
+    }
+    last->next = nullptr;
+    while (first != nullptr) {
+        FreeListNode* next{first->next};
+        umock::stdlib_h.free(slab_header(first));
+        first = next;
+    }
+}
+
+} // anonymous namespace
+
 int FreeListInit(FreeList* free_list, size_t elementSize,
                  int maxFreeListLength) {
     assert(free_list != NULL);
@@ -116,3 +283,66 @@ int FreeListDestroy(FreeList* free_list) {
 
     return 0;
 }
+
+void* SlabAlloc(size_t size) {
+    SlabHeader* hdr;
+    const unsigned cls{slab_class(size)};
+
+    if (cls == SLAB_LARGE) {
+        hdr = static_cast<SlabHeader*>(
+            umock::stdlib_h.malloc(sizeof(SlabHeader) + size));
+    } else {
+        SlabCache* cache{&tSlabCache};
+        if (cache->head[cls] == nullptr)
+            cache_refill(cache, cls);
+        if (cache->head[cls] != nullptr) {
+            FreeListNode* node{cache->head[cls]};
+            cache->head[cls] = node->next;
+            cache->length[cls]--;
+            hdr = slab_header(node);
+        } else {
+            hdr = static_cast<SlabHeader*>(
+                umock::stdlib_h.malloc(sizeof(SlabHeader) + slab_sizes[cls]));
+        }
+    }
+    if (hdr == nullptr)
+        return nullptr;
+    hdr->size_class = cls;
+    hdr->state = SLAB_USED;
+
+    return hdr + 1;
+}
+
+void SlabFree(void* element) {
+    if (element == nullptr)
+        return;
+    SlabHeader* hdr{static_cast<SlabHeader*>(element) - 1};
+    // Corrupting the free lists would only show up much later.
+    if (hdr->state != SLAB_USED || hdr->size_class > SLAB_LARGE)
+        std::abort();
+    hdr->state = SLAB_FREE;
+    const unsigned cls{hdr->size_class};
+    if (cls == SLAB_LARGE) {
+        umock::stdlib_h.free(hdr);
+        return;
+    }
+    SlabCache* cache{&tSlabCache};
+    FreeListNode* node{slab_node(hdr)};
+    node->next = cache->head[cls];
+    cache->head[cls] = node;
+    if (++cache->length[cls] > SLAB_CACHE_SIZE)
+        cache_flush(cache, cls);
+}
+
+void SlabTrim() {
+    tSlabCache.release(false);
+    for (SlabDepot& depot : gSlabDepot) {
+        FreeListNode* node{depot.head.exchange(nullptr)};
+        while (node != nullptr) {
+            FreeListNode* next{node->next};
+            depot.length.fetch_sub(1, std::memory_order_relaxed);
+            umock::stdlib_h.free(slab_header(node));
+            node = next;
+        }
+    }
+}
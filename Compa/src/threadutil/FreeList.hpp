@@ -5,7 +5,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-06
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -126,4 +126,44 @@ int FreeListDestroy(
     /*! [in] Must be valid, non null, pointer to a linked list. */
     FreeList* free_list);
 
+/*!
+ * \name Slab allocator
+ * Size class aware allocator for short living objects that are allocated and
+ * freed in hot paths, maybe by different threads.
+ *
+ * Every thread keeps a free list per size class without locking. It borrows
+ * and returns blocks in batches from a lock-free depot shared by all threads.
+ * Only sizes above the largest size class go directly to the operating
+ * system.
+ * @{ */
+
+/*!
+ * \brief Allocates a block of at least the given size.
+ *
+ * \returns
+ *  On success: Non nullptr, aligned for any type\n
+ *  On error: nullptr
+ */
+void* SlabAlloc(
+    /*! [in] Size of the block. */
+    size_t size);
+
+/*!
+ * \brief Returns a block to the slab allocator.
+ *
+ * The process is aborted if the block is not in use, e.g. freed twice.
+ */
+void SlabFree(
+    /*! [in] Pointer allocated by SlabAlloc() or nullptr. */
+    void* element);
+
+/*!
+ * \brief Returns the free blocks of the depot and of the calling thread to the
+ * operating system.
+ *
+ * Blocks cached by other threads are kept until the threads finish.
+ */
+void SlabTrim();
+/// @}
+
 #endif /* COMPA_FREE_LIST_HPP */
@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-06-04
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -45,14 +45,14 @@
 #include <upnplib/synclog.hpp>
 
 /// \cond
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring> /* for memset()*/
 /// \endcond
 
-/*! Size of job free list. */
-constexpr int JOBFREELISTSIZE{100};
 /*! Infinite threads. */
 constexpr int INFINITE_THREADS{-1};
 /*! Error: maximun threads. */
@@ -85,6 +85,51 @@ long DiffMillis(timeval* time1, timeval* time2) {
     return temp;
 }
 
+/*!
+ * \brief Gets the time of a monotonic clock.
+ *
+ * Unlike gettimeofday() it does not jump with adjustments of the system time
+ * so differences are real durations. Its epoch is unspecified.
+ */
+void MonotonicTime(
+    /*! [out] Time. */
+    timeval* tv) {
+    const auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                          std::chrono::steady_clock::now().time_since_epoch())
+                          .count();
+    tv->tv_sec = static_cast<decltype(tv->tv_sec)>(usec / 1000000);
+    tv->tv_usec = static_cast<decltype(tv->tv_usec)>(usec % 1000000);
+}
+
+/*!
+ * \brief Returns the difference in microseconds between two timeval
+ * structures.
+ *
+ * \returns The difference in microseconds, time1-time2, at least 0.
+ */
+long DiffMicros(timeval* time1, timeval* time2) {
+    const long diff = (long)(time1->tv_sec - time2->tv_sec) * 1000000L +
+                      (long)(time1->tv_usec - time2->tv_usec);
+    return diff < 0 ? 0 : diff;
+}
+
+/*!
+ * \brief Records a duration in a histogram.
+ */
+void HistogramAdd(
+    /*! [in,out] Histogram. */
+    ThreadPoolHistogram* hist,
+    /*! [in] Duration in microseconds. */
+    long usec) {
+    int bucket{0};
+    for (unsigned long v = (unsigned long)usec >> 1;
+         v != 0 && bucket < TP_HISTOGRAM_BUCKETS - 1; v >>= 1)
+        bucket++;
+    hist->count++;
+    hist->sum += (double)usec;
+    hist->buckets[bucket]++;
+}
+
 #if defined(STATS) || defined(DOXYGEN_RUN)
 /*!
  * \brief Initializes the statistics structure.
@@ -167,7 +212,7 @@ void CalcWaitTime(
     assert(tp != NULL);
     assert(job != NULL);
 
-    gettimeofday(&now, NULL);
+    MonotonicTime(&now);
     diff = DiffMillis(&now, &job->requestTime);
     switch (p) {
     case LOW_PRIORITY:
@@ -192,7 +237,7 @@ time_t StatsTime(
     time_t* t) {
     struct timeval tv;
 
-    gettimeofday(&tv, NULL);
+    MonotonicTime(&tv);
     if (t)
         *t = tv.tv_sec;
 
@@ -223,10 +268,10 @@ int CmpThreadPoolJob(void* jobA, void* jobB) {
  */
 void FreeThreadPoolJob(
     /*! [in] Valid, non null, pointer to ThreadPool. */
-    ThreadPool* tp,
+    [[maybe_unused]] ThreadPool* tp,
     /*! [in] Must be allocated with CreateThreadPoolJob. */
     ThreadPoolJob* tpj) {
-    FreeListFree(&tp->jobFreeList, tpj);
+    SlabFree(tpj);
 }
 
 /*!
@@ -331,7 +376,7 @@ void BumpPriority(
     long diffTime = 0;
     ThreadPoolJob* tempJob = NULL;
 
-    gettimeofday(&now, NULL);
+    MonotonicTime(&now);
     while (!done) {
         if (tp->medJobQ.size) {
             tempJob = (ThreadPoolJob*)tp->medJobQ.head.next->item;
@@ -377,6 +422,10 @@ void SetRelTimeout(
     gettimeofday(&now, NULL);
     time->tv_sec = now.tv_sec + sec;
     time->tv_nsec = (now.tv_usec / 1000 + milliSeconds) * 1000000;
+    if (time->tv_nsec >= 1000000000) {
+        time->tv_sec++;
+        time->tv_nsec -= 1000000000;
+    }
 }
 
 /*!
@@ -414,6 +463,66 @@ void SetSeed(void) {
 #endif
 }
 
+/*!
+ * \brief Updates the saturation state of the thread pool.
+ *
+ * The pool gets saturated when maxJobsTotal jobs are queued and stays so until
+ * the queues have drained to half of it.
+ *
+ * \remark The ThreadPool object mutex must be locked prior to calling this
+ * function.
+ *
+ * \returns
+ *  - true if the state has changed and NotifySaturation() must be called
+ *    after unlocking the mutex.
+ *  - false otherwise.
+ */
+bool UpdateSaturation(
+    /*! [in] Valid, non null, pointer to ThreadPool. */
+    ThreadPool* tp) {
+    long totalJobs = tp->highJobQ.size + tp->lowJobQ.size + tp->medJobQ.size;
+    int saturated;
+
+    if (totalJobs >= tp->attr.maxJobsTotal)
+        saturated = 1;
+    else if (totalJobs <= tp->attr.maxJobsTotal / 2)
+        saturated = 0;
+    else
+        return false;
+    if (saturated == tp->saturated)
+        return false;
+    tp->saturated = saturated;
+    return true;
+}
+
+/*!
+ * \brief Calls the saturation function with the current saturation state.
+ *
+ * Calls are serialized so the function always sees the last state even if
+ * two threads changed it one after the other. A state that the function has
+ * already seen is not passed again.
+ *
+ * \remark The ThreadPool object mutex must not be locked.
+ */
+void NotifySaturation(
+    /*! [in] Valid, non null, pointer to ThreadPool. */
+    ThreadPool* tp) {
+    ithread_mutex_lock(&tp->saturationMutex);
+    ithread_mutex_lock(&tp->mutex);
+    int saturated = tp->saturated;
+    saturation_routine func = tp->saturationFunc;
+    void* cookie = tp->saturationCookie;
+    ithread_mutex_unlock(&tp->mutex);
+    if (saturated != tp->notifiedSaturated) {
+        tp->notifiedSaturated = saturated;
+        if (func)
+            func(tp, saturated, cookie);
+    }
+    ithread_mutex_unlock(&tp->saturationMutex);
+}
+
+void AddWorker(ThreadPool* tp);
+
 /*!
  * \brief Implements a thread pool worker.
  *
@@ -428,6 +537,8 @@ void* WorkerThread(
 
     ThreadPoolJob* job = NULL;
     ListNode* head = NULL;
+    timeval runStart;
+    timeval runEnd;
 
     timespec timeout;
     int retCode = 0;
@@ -446,8 +557,17 @@ void* WorkerThread(
     SetSeed();
     StatsTime(&start);
     while (1) {
+        bool saturationChanged{false};
+        if (job)
+            MonotonicTime(&runEnd);
         ithread_mutex_lock(&tp->mutex);
         if (job) {
+            if (persistent == 0) {
+                long runTime = DiffMicros(&runEnd, &runStart);
+                HistogramAdd(&tp->histograms.runPriority[job->priority],
+                             runTime);
+                HistogramAdd(&tp->histograms.runLabel[job->label], runTime);
+            }
             tp->busyThreads--;
             FreeThreadPoolJob(tp, job);
             job = NULL;
@@ -504,6 +624,7 @@ void* WorkerThread(
             } else {
                 tp->stats.workerThreads++;
                 persistent = 0;
+                ThreadPriority queue;
                 /* Pick the highest priority job */
                 if (tp->highJobQ.size > 0) {
                     head = ListHead(&tp->highJobQ);
@@ -513,6 +634,7 @@ void* WorkerThread(
                     }
                     job = (ThreadPoolJob*)head->item;
                     CalcWaitTime(tp, HIGH_PRIORITY, job);
+                    queue = HIGH_PRIORITY;
                     ListDelNode(&tp->highJobQ, head, 0);
                 } else if (tp->medJobQ.size > 0) {
                     head = ListHead(&tp->medJobQ);
@@ -522,6 +644,7 @@ void* WorkerThread(
                     }
                     job = (ThreadPoolJob*)head->item;
                     CalcWaitTime(tp, MED_PRIORITY, job);
+                    queue = MED_PRIORITY;
                     ListDelNode(&tp->medJobQ, head, 0);
                 } else if (tp->lowJobQ.size > 0) {
                     head = ListHead(&tp->lowJobQ);
@@ -531,17 +654,31 @@ void* WorkerThread(
                     }
                     job = (ThreadPoolJob*)head->item;
                     CalcWaitTime(tp, LOW_PRIORITY, job);
+                    queue = LOW_PRIORITY;
                     ListDelNode(&tp->lowJobQ, head, 0);
                 } else {
                     /* Should never get here */
                     tp->stats.workerThreads--;
                     goto exit_function;
                 }
+                /* A queue slot is free now */
+                ithread_cond_signal(&tp->admission);
+                saturationChanged = UpdateSaturation(tp);
+                /* Jobs still waiting too long need another worker */
+                if (tp->attr.targetQueueWait > 0 &&
+                    tp->busyThreads + 1 >= tp->totalThreads)
+                    AddWorker(tp);
+                MonotonicTime(&runStart);
+                long waitTime = DiffMicros(&runStart, &job->requestTime);
+                HistogramAdd(&tp->histograms.waitPriority[queue], waitTime);
+                HistogramAdd(&tp->histograms.waitLabel[job->label], waitTime);
             }
         }
 
         tp->busyThreads++;
         ithread_mutex_unlock(&tp->mutex);
+        if (saturationChanged)
+            NotifySaturation(tp);
 
         /* In the future can log info */
         if (SetPriority(job->priority) != 0) {
@@ -575,19 +712,108 @@ ThreadPoolJob* CreateThreadPoolJob(
     /*! id of job. */
     int id,
     /*! [in] Valid, non null, pointer to ThreadPool. */
-    ThreadPool* tp) {
+    [[maybe_unused]] ThreadPool* tp) {
     ThreadPoolJob* newJob{nullptr};
 
-    newJob = (ThreadPoolJob*)FreeListAlloc(&tp->jobFreeList);
+    newJob = (ThreadPoolJob*)SlabAlloc(sizeof(ThreadPoolJob));
     if (newJob) {
         *newJob = *job;
         newJob->jobId = id;
-        gettimeofday(&newJob->requestTime, NULL);
+        MonotonicTime(&newJob->requestTime);
     }
 
     return newJob;
 }
 
+/*!
+ * \brief Looks for a queued job with the same function and merge key.
+ *
+ * \remark The ThreadPool object mutex must be locked prior to calling this
+ * function.
+ *
+ * \returns
+ *  On success: Pointer to the queued job\n
+ *  On error: nullptr if there is no duplicate.
+ */
+ThreadPoolJob* FindDuplicateJob(
+    /*! [in] Valid, non null, pointer to ThreadPool. */
+    ThreadPool* tp,
+    /*! [in] Job with a merge key. */
+    ThreadPoolJob* job) {
+    LinkedList* queues[]{&tp->highJobQ, &tp->medJobQ, &tp->lowJobQ};
+
+    for (LinkedList* queue : queues) {
+        for (ListNode* node = ListHead(queue); node != nullptr;
+             node = ListNext(queue, node)) {
+            ThreadPoolJob* queued = (ThreadPoolJob*)node->item;
+            if (queued->func == job->func && queued->mergeKey == job->mergeKey)
+                return queued;
+        }
+    }
+    return nullptr;
+}
+
+/*!
+ * \brief Decides with the admission policy whether a job is accepted although
+ * maxJobsTotal jobs are queued.
+ *
+ * The admission policy of the job is used, or the one of the thread pool if
+ * the job has ADMIT_DEFAULT.
+ *
+ * \remark The ThreadPool object mutex must be locked prior to calling this
+ * function. It may be released while waiting with ADMIT_BLOCK.
+ *
+ * \returns
+ *  - true if the job can be queued.
+ *  - false if the job must be refused.
+ */
+bool AdmitJob(
+    /*! [in] Valid, non null, pointer to ThreadPool. */
+    ThreadPool* tp,
+    /*! [in] Job to add. */
+    ThreadPoolJob* job,
+    /*! [out] Low priority job that was dropped for the job, nullptr if none.
+     * The caller frees it after unlocking the mutex. */
+    ThreadPoolJob** shed) {
+    long totalJobs = tp->highJobQ.size + tp->lowJobQ.size + tp->medJobQ.size;
+    timespec timeout;
+    AdmissionPolicy policy = job->admissionPolicy == ADMIT_DEFAULT
+                                 ? tp->attr.admissionPolicy
+                                 : job->admissionPolicy;
+
+    *shed = nullptr;
+    switch (policy) {
+    case ADMIT_SHED_LOW: {
+        if (job->priority == LOW_PRIORITY || tp->lowJobQ.size == 0)
+            return false;
+        ListNode* head = ListHead(&tp->lowJobQ);
+        *shed = (ThreadPoolJob*)head->item;
+        ListDelNode(&tp->lowJobQ, head, 0);
+        tp->admitStats.shed++;
+        return true;
+    }
+    case ADMIT_OVERFLOW:
+        if (totalJobs >= (long)tp->attr.maxJobsTotal + tp->attr.maxOverflowJobs)
+            return false;
+        tp->admitStats.overflowed++;
+        return true;
+    case ADMIT_BLOCK:
+        tp->admitStats.blocked++;
+        SetRelTimeout(&timeout, tp->attr.admitTimeout);
+        while (totalJobs >= tp->attr.maxJobsTotal && !tp->shutdown) {
+            int rc =
+                ithread_cond_timedwait(&tp->admission, &tp->mutex, &timeout);
+            totalJobs =
+                tp->highJobQ.size + tp->lowJobQ.size + tp->medJobQ.size;
+            if (rc != 0)
+                break;
+        }
+        return totalJobs < tp->attr.maxJobsTotal && !tp->shutdown;
+    default:
+        return false;
+    }
+}
+
 /*!
  * \brief Creates a worker thread, if the thread pool does not already have
  * max threads.
@@ -637,9 +863,35 @@ int CreateWorker(
     return rc;
 }
 
+/*!
+ * \brief Returns how long the oldest queued job has waited.
+ *
+ * \remark The ThreadPool object mutex must be locked prior to calling this
+ * function.
+ *
+ * \returns Milliseconds, 0 if no job is queued.
+ */
+long OldestQueueWait(
+    /*! [in] Valid, non null, pointer to ThreadPool. */
+    ThreadPool* tp) {
+    LinkedList* queues[]{&tp->highJobQ, &tp->medJobQ, &tp->lowJobQ};
+    timeval now;
+    long wait{0};
+
+    MonotonicTime(&now);
+    for (LinkedList* queue : queues) {
+        ListNode* head = ListHead(queue);
+        if (head != nullptr) {
+            ThreadPoolJob* job = (ThreadPoolJob*)head->item;
+            wait = std::max(wait, DiffMicros(&now, &job->requestTime) / 1000);
+        }
+    }
+    return wait;
+}
+
 /*!
  * \brief Determines whether or not a thread should be added based on the
- * jobsPerThread ratio.
+ * measured queue wait or the jobsPerThread ratio.
  *
  * Adds a thread if appropriate.
  *
@@ -654,15 +906,34 @@ void AddWorker(
 
     jobs = tp->highJobQ.size + tp->lowJobQ.size + tp->medJobQ.size;
     threads = tp->totalThreads - tp->persistentThreads;
-    while (threads == 0 || (jobs / threads) >= tp->attr.jobsPerThread ||
-           (tp->totalThreads == tp->busyThreads)) {
+    while (threads == 0 || (tp->totalThreads == tp->busyThreads) ||
+           (tp->attr.targetQueueWait > 0
+                ? jobs > 0 && OldestQueueWait(tp) >= tp->attr.targetQueueWait
+                : (jobs / threads) >= tp->attr.jobsPerThread)) {
         if (CreateWorker(tp) != 0) {
             return;
         }
         threads++;
+        if (tp->attr.targetQueueWait > 0 && tp->totalThreads > tp->busyThreads)
+            return;
     }
 }
 
+/*!
+ * \brief Entry of a dedicated thread.
+ */
+void* DedicatedThreadMain(
+    /*! arg -> is cast to (DedicatedThread *). */
+    void* arg) {
+    DedicatedThread* dt = (DedicatedThread*)arg;
+
+    ithread_initialize_thread();
+    dt->func(dt->arg);
+    ithread_cleanup_thread();
+
+    return NULL;
+}
+
 /// @} // Functions (scope restricted to file)
 } // anonymous namespace
 
@@ -677,15 +948,19 @@ int ThreadPoolInit(ThreadPool* tp, ThreadPoolAttr* attr) {
     }
 
     retCode += ithread_mutex_init(&tp->mutex, NULL);
+    retCode += ithread_mutex_init(&tp->saturationMutex, NULL);
     retCode += ithread_mutex_lock(&tp->mutex);
 
     retCode += ithread_cond_init(&tp->condition, NULL);
     retCode += ithread_cond_init(&tp->start_and_shutdown, NULL);
+    retCode += ithread_cond_init(&tp->admission, NULL);
     if (retCode) {
         ithread_mutex_unlock(&tp->mutex);
         ithread_mutex_destroy(&tp->mutex);
+        ithread_mutex_destroy(&tp->saturationMutex);
         ithread_cond_destroy(&tp->condition);
         ithread_cond_destroy(&tp->start_and_shutdown);
+        ithread_cond_destroy(&tp->admission);
         return EAGAIN;
     }
     if (attr) {
@@ -696,13 +971,13 @@ int ThreadPoolInit(ThreadPool* tp, ThreadPoolAttr* attr) {
     if (SetPolicyType(tp->attr.schedPolicy) != 0) {
         ithread_mutex_unlock(&tp->mutex);
         ithread_mutex_destroy(&tp->mutex);
+        ithread_mutex_destroy(&tp->saturationMutex);
         ithread_cond_destroy(&tp->condition);
         ithread_cond_destroy(&tp->start_and_shutdown);
+        ithread_cond_destroy(&tp->admission);
 
         return INVALID_POLICY;
     }
-    retCode +=
-        FreeListInit(&tp->jobFreeList, sizeof(ThreadPoolJob), JOBFREELISTSIZE);
     StatsInit(&tp->stats);
     retCode += ListInit(&tp->highJobQ, CmpThreadPoolJob, NULL);
     retCode += ListInit(&tp->medJobQ, CmpThreadPoolJob, NULL);
@@ -717,6 +992,12 @@ int ThreadPoolInit(ThreadPool* tp, ThreadPoolAttr* attr) {
         tp->busyThreads = 0;
         tp->persistentThreads = 0;
         tp->pendingWorkerThreadStart = 0;
+        tp->admitStats = {};
+        tp->saturated = 0;
+        tp->notifiedSaturated = 0;
+        tp->saturationFunc = nullptr;
+        tp->saturationCookie = nullptr;
+        tp->histograms = {};
         for (i = 0; i < tp->attr.minThreads; ++i) {
             retCode = CreateWorker(tp);
             if (retCode) {
@@ -735,6 +1016,51 @@ int ThreadPoolInit(ThreadPool* tp, ThreadPoolAttr* attr) {
     return retCode;
 }
 
+int DedicatedThreadStart(DedicatedThread* dt, start_routine func, void* arg,
+                         int cpu) {
+    ithread_attr_t attr;
+    int rc;
+
+    if (!dt || !func || dt->started || cpu < -1)
+        return EINVAL;
+#ifdef __linux__
+    if (cpu >= CPU_SETSIZE)
+        return EINVAL;
+#endif
+    dt->func = func;
+    dt->arg = arg;
+    ithread_attr_init(&attr);
+    rc = ithread_create(&dt->thread, &attr, DedicatedThreadMain, dt);
+    ithread_attr_destroy(&attr);
+    if (rc != 0)
+        return EAGAIN;
+    dt->started = 1;
+#ifdef __linux__
+    if (cpu >= 0) {
+        /* Best effort, the CPU may not be available to the process. */
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(dt->thread, sizeof(cpus), &cpus);
+    }
+#endif
+
+    return 0;
+}
+
+int DedicatedThreadJoin(DedicatedThread* dt) {
+    int rc;
+
+    if (!dt)
+        return EINVAL;
+    if (!dt->started)
+        return 0;
+    rc = ithread_join(dt->thread, NULL);
+    dt->started = 0;
+
+    return rc;
+}
+
 int ThreadPoolAddPersistent(ThreadPool* tp, ThreadPoolJob* job, int* jobId) {
     int ret = 0;
     int tempId = -1;
@@ -788,21 +1114,40 @@ int ThreadPoolAdd(ThreadPool* tp, ThreadPoolJob* job, int* jobId) {
     int tempId = -1;
     long totalJobs;
     ThreadPoolJob* temp = NULL;
+    ThreadPoolJob* shed = nullptr;
+    ThreadPoolJob merged;
+    bool saturationChanged{false};
 
     if (!tp || !job)
         return EINVAL;
+    if (!jobId)
+        jobId = &tempId;
+    *jobId = INVALID_JOB_ID;
 
     ithread_mutex_lock(&tp->mutex);
 
+    if (job->mergeKey) {
+        temp = FindDuplicateJob(tp, job);
+        if (temp) {
+            tp->admitStats.merged++;
+            *jobId = temp->jobId;
+            /* Free the merged job like a shed one, after unlocking. */
+            merged = *job;
+            shed = &merged;
+            rc = 0;
+            goto exit_function;
+        }
+    }
     totalJobs = tp->highJobQ.size + tp->lowJobQ.size + tp->medJobQ.size;
     if (totalJobs >= tp->attr.maxJobsTotal) {
-        fprintf(stderr, "libupnp ThreadPoolAdd too many jobs: %ld\n",
-                totalJobs);
-        goto exit_function;
+        saturationChanged = UpdateSaturation(tp);
+        if (!AdmitJob(tp, job, &shed)) {
+            tp->admitStats.rejected++;
+            fprintf(stderr, "libupnp ThreadPoolAdd too many jobs: %ld\n",
+                    totalJobs);
+            goto exit_function;
+        }
     }
-    if (!jobId)
-        jobId = &tempId;
-    *jobId = INVALID_JOB_ID;
     temp = CreateThreadPoolJob(job, tp->lastJobId, tp);
     if (!temp)
         goto exit_function;
@@ -827,9 +1172,18 @@ int ThreadPoolAdd(ThreadPool* tp, ThreadPoolJob* job, int* jobId) {
     else
         FreeThreadPoolJob(tp, temp);
     *jobId = tp->lastJobId++;
+    saturationChanged = UpdateSaturation(tp) || saturationChanged;
 
 exit_function:
     ithread_mutex_unlock(&tp->mutex);
+    if (shed) {
+        if (shed->free_func)
+            shed->free_func(shed->arg);
+        if (shed != &merged)
+            FreeThreadPoolJob(tp, shed);
+    }
+    if (saturationChanged)
+        NotifySaturation(tp);
 
     return rc;
 }
@@ -839,6 +1193,7 @@ int ThreadPoolRemove(ThreadPool* tp, int jobId, ThreadPoolJob* out) {
     ThreadPoolJob* temp = NULL;
     ListNode* tempNode = NULL;
     ThreadPoolJob dummy;
+    bool saturationChanged{false};
 
     if (!tp)
         return EINVAL;
@@ -885,7 +1240,13 @@ int ThreadPoolRemove(ThreadPool* tp, int jobId, ThreadPoolJob* out) {
     }
 
 exit_function:
+    if (ret == 0) {
+        ithread_cond_signal(&tp->admission);
+        saturationChanged = UpdateSaturation(tp);
+    }
     ithread_mutex_unlock(&tp->mutex);
+    if (saturationChanged)
+        NotifySaturation(tp);
 
     return ret;
 }
@@ -1003,6 +1364,7 @@ int ThreadPoolShutdown(ThreadPool* tp) {
     /* signal shutdown */
     tp->shutdown = 1;
     ithread_cond_broadcast(&tp->condition);
+    ithread_cond_broadcast(&tp->admission);
     /* wait for all threads to finish */
     while (tp->totalThreads > 0)
         ithread_cond_wait(&tp->start_and_shutdown, &tp->mutex);
@@ -1011,13 +1373,15 @@ int ThreadPoolShutdown(ThreadPool* tp) {
     }
     while (ithread_cond_destroy(&tp->start_and_shutdown) != 0) {
     }
-    FreeListDestroy(&tp->jobFreeList);
-
+    while (ithread_cond_destroy(&tp->admission) != 0) {
+    }
     ithread_mutex_unlock(&tp->mutex);
 
     /* destroy mutex */
     while (ithread_mutex_destroy(&tp->mutex) != 0) {
     }
+    while (ithread_mutex_destroy(&tp->saturationMutex) != 0) {
+    }
 
     return 0;
 }
@@ -1033,6 +1397,10 @@ int TPAttrInit(ThreadPoolAttr* attr) {
     attr->schedPolicy = DEFAULT_POLICY;
     attr->starvationTime = DEFAULT_STARVATION_TIME;
     attr->maxJobsTotal = DEFAULT_MAX_JOBS_TOTAL;
+    attr->admissionPolicy = DEFAULT_ADMISSION_POLICY;
+    attr->maxOverflowJobs = DEFAULT_MAX_OVERFLOW_JOBS;
+    attr->admitTimeout = DEFAULT_ADMIT_TIMEOUT;
+    attr->targetQueueWait = DEFAULT_TARGET_QUEUE_WAIT;
 
     return 0;
 }
@@ -1044,6 +1412,9 @@ int TPJobInit(ThreadPoolJob* job, start_routine func, void* arg) {
     job->arg = arg;
     job->priority = DEFAULT_PRIORITY;
     job->free_func = DEFAULT_FREE_ROUTINE;
+    job->mergeKey = nullptr;
+    job->label = JOB_LABEL_OTHER;
+    job->admissionPolicy = ADMIT_DEFAULT;
 
     return 0;
 }
@@ -1070,6 +1441,39 @@ int TPJobSetFreeFunction(ThreadPoolJob* job, free_routine func) {
     return 0;
 }
 
+int TPJobSetLabel(ThreadPoolJob* job, ThreadPoolJobLabel label) {
+    if (!job || label < JOB_LABEL_OTHER || label >= JOB_LABEL_COUNT)
+        return EINVAL;
+    job->label = label;
+
+    return 0;
+}
+
+int TPJobSetMergeKey(ThreadPoolJob* job, const void* mergeKey) {
+    if (!job)
+        return EINVAL;
+    job->mergeKey = mergeKey;
+
+    return 0;
+}
+
+int TPJobSetAdmissionPolicy(ThreadPoolJob* job,
+                            AdmissionPolicy admissionPolicy) {
+    if (!job)
+        return EINVAL;
+    switch (admissionPolicy) {
+    case ADMIT_REJECT:
+    case ADMIT_SHED_LOW:
+    case ADMIT_OVERFLOW:
+    case ADMIT_BLOCK:
+    case ADMIT_DEFAULT:
+        job->admissionPolicy = admissionPolicy;
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
 int TPAttrSetMaxThreads(ThreadPoolAttr* attr, int maxThreads) {
     if (!attr)
         return EINVAL;
@@ -1134,6 +1538,102 @@ int TPAttrSetMaxJobsTotal(ThreadPoolAttr* attr, int maxJobsTotal) {
     return 0;
 }
 
+int TPAttrSetAdmissionPolicy(ThreadPoolAttr* attr,
+                             AdmissionPolicy admissionPolicy) {
+    if (!attr)
+        return EINVAL;
+    switch (admissionPolicy) {
+    case ADMIT_REJECT:
+    case ADMIT_SHED_LOW:
+    case ADMIT_OVERFLOW:
+    case ADMIT_BLOCK:
+        attr->admissionPolicy = admissionPolicy;
+        return 0;
+    default:
+        return EINVAL;
+    }
+}
+
+int TPAttrSetMaxOverflowJobs(ThreadPoolAttr* attr, int maxOverflowJobs) {
+    if (!attr || maxOverflowJobs < 0)
+        return EINVAL;
+    attr->maxOverflowJobs = maxOverflowJobs;
+
+    return 0;
+}
+
+int TPAttrSetAdmitTimeout(ThreadPoolAttr* attr, int admitTimeout) {
+    if (!attr || admitTimeout < 0)
+        return EINVAL;
+    attr->admitTimeout = admitTimeout;
+
+    return 0;
+}
+
+int TPAttrSetTargetQueueWait(ThreadPoolAttr* attr, int targetQueueWait) {
+    if (!attr || targetQueueWait < 0)
+        return EINVAL;
+    attr->targetQueueWait = targetQueueWait;
+
+    return 0;
+}
+
+int ThreadPoolSetSaturationFunction(ThreadPool* tp, saturation_routine func,
+                                    void* cookie) {
+    if (!tp)
+        return EINVAL;
+    ithread_mutex_lock(&tp->mutex);
+    tp->saturationFunc = func;
+    tp->saturationCookie = cookie;
+    ithread_mutex_unlock(&tp->mutex);
+
+    return 0;
+}
+
+int ThreadPoolGetAdmitStats(ThreadPool* tp, ThreadPoolAdmitStats* stats) {
+    if (!tp || !stats)
+        return EINVAL;
+    ithread_mutex_lock(&tp->mutex);
+    *stats = tp->admitStats;
+    ithread_mutex_unlock(&tp->mutex);
+
+    return 0;
+}
+
+int ThreadPoolGetHistograms(ThreadPool* tp, ThreadPoolHistograms* out) {
+    if (!tp || !out)
+        return EINVAL;
+    ithread_mutex_lock(&tp->mutex);
+    *out = tp->histograms;
+    ithread_mutex_unlock(&tp->mutex);
+
+    return 0;
+}
+
+double ThreadPoolHistogramPercentile(const ThreadPoolHistogram* hist,
+                                     double fraction) {
+    if (!hist || hist->count == 0)
+        return 0.0;
+    if (fraction < 0.0)
+        fraction = 0.0;
+    if (fraction > 1.0)
+        fraction = 1.0;
+    const double rank{fraction * (double)hist->count};
+    double seen{0.0};
+    for (int i{0}; i < TP_HISTOGRAM_BUCKETS; i++) {
+        if (hist->buckets[i] == 0)
+            continue;
+        if (seen + (double)hist->buckets[i] >= rank) {
+            const double lower{i == 0 ? 0.0 : (double)(1ULL << i)};
+            const double upper{(double)(1ULL << (i + 1))};
+            return lower +
+                   (upper - lower) * (rank - seen) / (double)hist->buckets[i];
+        }
+        seen += (double)hist->buckets[i];
+    }
+    return (double)(1ULL << TP_HISTOGRAM_BUCKETS);
+}
+
 #if defined(STATS) || defined(DOXYGEN_RUN)
 void ThreadPoolPrintStats(ThreadPoolStats* stats) {
     if (!stats)
@@ -6,7 +6,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-07-31
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -75,6 +75,16 @@ enum Duration { SHORT_TERM, PERSISTENT };
 /// \brief Thread priority.
 enum ThreadPriority { LOW_PRIORITY, MED_PRIORITY, HIGH_PRIORITY };
 
+/// \brief Kind of work a job does, used to break down the statistics.
+enum ThreadPoolJobLabel {
+    JOB_LABEL_OTHER, ///< Not labeled.
+    JOB_LABEL_SSDP,  ///< Discovery.
+    JOB_LABEL_SOAP,  ///< Control.
+    JOB_LABEL_GENA,  ///< Eventing.
+    JOB_LABEL_HTTP,  ///< Web server requests and downloads.
+    JOB_LABEL_COUNT  ///< Number of labels, not a label.
+};
+
 /*! default priority used by TPJobInit */
 constexpr ThreadPriority DEFAULT_PRIORITY{MED_PRIORITY};
 
@@ -102,6 +112,38 @@ constexpr free_routine DEFAULT_FREE_ROUTINE{nullptr};
 /*! default max jobs used TPAttrInit */
 constexpr int DEFAULT_MAX_JOBS_TOTAL{100};
 
+/*! \brief What ThreadPoolAdd() does with a job when the job queues are full.
+ *
+ * A dropped job is freed like a removed one: its argument is passed to its
+ * free function. The thread pool does not know how to free the argument of a
+ * job without free function, so such a job must not own its argument if it
+ * may be dropped. */
+enum AdmissionPolicy {
+    /// Refuse the new job with EOUTOFMEM.
+    ADMIT_REJECT,
+    /// Drop the oldest queued low priority job in favour of a medium or high
+    /// priority job. A low priority job is refused.
+    ADMIT_SHED_LOW,
+    /// Queue up to maxOverflowJobs jobs beyond maxJobsTotal.
+    ADMIT_OVERFLOW,
+    /// Wait up to admitTimeout milliseconds until a worker frees a slot.
+    ADMIT_BLOCK,
+    /// Only for a job: use the admission policy of the thread pool.
+    ADMIT_DEFAULT
+};
+
+/*! default admission policy used by TPAttrInit */
+constexpr AdmissionPolicy DEFAULT_ADMISSION_POLICY{ADMIT_REJECT};
+
+/*! default overflow jobs used by TPAttrInit */
+constexpr int DEFAULT_MAX_OVERFLOW_JOBS{0};
+
+/*! default admission timeout used by TPAttrInit */
+constexpr int DEFAULT_ADMIT_TIMEOUT{100};
+
+/*! default target queue wait used by TPAttrInit, 0 uses jobsPerThread */
+constexpr int DEFAULT_TARGET_QUEUE_WAIT{0};
+
 /*!
  * \brief Statistics.
  *
@@ -141,6 +183,17 @@ struct ThreadPoolAttr {
     int starvationTime;
     /*! \brief Scheduling policy to use. */
     PolicyType schedPolicy;
+    /*! \brief What to do with a new job if maxJobsTotal is reached. */
+    AdmissionPolicy admissionPolicy;
+    /*! \brief Jobs accepted beyond maxJobsTotal with ADMIT_OVERFLOW. */
+    int maxOverflowJobs;
+    /*! \brief Time to wait for a free slot with ADMIT_BLOCK (in
+     * milliseconds). */
+    int admitTimeout;
+    /*! \brief If not 0, a thread is added when the oldest queued job has
+     * waited this long instead of using the jobsPerThread ratio (in
+     * milliseconds). */
+    int targetQueueWait;
 };
 
 /*! \brief Internal ThreadPool Job. */
@@ -151,6 +204,14 @@ struct ThreadPoolJob {
     struct timeval requestTime;
     ThreadPriority priority;
     int jobId;
+    /*! A queued job with the same function and key makes this job a
+     * duplicate that is merged into it. nullptr never merges. */
+    const void* mergeKey;
+    /*! Kind of work for the statistics. */
+    ThreadPoolJobLabel label;
+    /*! What to do with the job if the job queues are full, ADMIT_DEFAULT
+     * uses the policy of the thread pool. */
+    AdmissionPolicy admissionPolicy;
 };
 
 /*! \brief Structure to hold statistics. */
@@ -176,6 +237,58 @@ struct ThreadPoolStats {
     int currentJobsMQ;
 };
 
+/*! \brief Counters of the admission control in ThreadPoolAdd().
+ *
+ * Unlike ThreadPoolStats they are always maintained.
+ */
+struct ThreadPoolAdmitStats {
+    long rejected;   ///< Jobs refused because the queues were full.
+    long shed;       ///< Queued low priority jobs dropped for newer ones.
+    long merged;     ///< Jobs merged into an already queued duplicate.
+    long overflowed; ///< Jobs queued beyond maxJobsTotal.
+    long blocked;    ///< Callers that had to wait for a free slot.
+};
+
+/*! Number of buckets of a ThreadPoolHistogram. */
+constexpr int TP_HISTOGRAM_BUCKETS{32};
+
+/*! \brief Log-scale histogram of durations in microseconds.
+ *
+ * Bucket 0 counts durations below 2 µs, bucket i durations from 2^i to below
+ * 2^(i+1) µs. The last bucket also counts all longer durations.
+ */
+struct ThreadPoolHistogram {
+    unsigned long count; ///< Number of recorded durations.
+    double sum;          ///< Sum of the recorded durations in µs.
+    unsigned long buckets[TP_HISTOGRAM_BUCKETS]; ///< Counts per bucket.
+};
+
+/*! \brief Queue wait and run time histograms of a thread pool.
+ *
+ * The durations are taken with a monotonic clock so they do not jump with
+ * adjustments of the system time.
+ */
+struct ThreadPoolHistograms {
+    /// Time from adding a job until a worker picks it up, per priority queue.
+    ThreadPoolHistogram waitPriority[HIGH_PRIORITY + 1];
+    /// Time a worker runs a job, per job priority.
+    ThreadPoolHistogram runPriority[HIGH_PRIORITY + 1];
+    /// Time from adding a job until a worker picks it up, per job label.
+    ThreadPoolHistogram waitLabel[JOB_LABEL_COUNT];
+    /// Time a worker runs a job, per job label.
+    ThreadPoolHistogram runLabel[JOB_LABEL_COUNT];
+};
+
+struct ThreadPool;
+
+/*! \brief Function called when the job queues of a thread pool get full
+ * (**saturated** = 1) or have drained to half of maxJobsTotal (**saturated**
+ * = 0).
+ *
+ * It is called without the thread pool mutex locked and never concurrently
+ * with itself. It must not add or remove jobs of the same thread pool. */
+typedef void (*saturation_routine)(ThreadPool* tp, int saturated, void* cookie);
+
 /*!
  * \brief A thread pool.
  *
@@ -207,8 +320,6 @@ struct ThreadPool {
     int busyThreads;
     /*! number of persistent threads */
     int persistentThreads;
-    /*! free list of jobs */
-    FreeList jobFreeList;
     /*! low priority job Q */
     LinkedList lowJobQ;
     /*! med priority job Q */
@@ -221,6 +332,22 @@ struct ThreadPool {
     ThreadPoolAttr attr;
     /*! statistics */
     ThreadPoolStats stats;
+    /*! Condition variable for callers waiting with ADMIT_BLOCK. */
+    ithread_cond_t admission;
+    /*! admission control counters */
+    ThreadPoolAdmitStats admitStats;
+    /*! set while the job queues are full */
+    int saturated;
+    /*! Mutex to serialize calls of saturationFunc. */
+    ithread_mutex_t saturationMutex;
+    /*! last saturated state passed to saturationFunc */
+    int notifiedSaturated;
+    /*! called when saturated changes, may be nullptr */
+    saturation_routine saturationFunc;
+    /*! passed to saturationFunc */
+    void* saturationCookie;
+    /*! queue wait and run time histograms */
+    ThreadPoolHistograms histograms;
 };
 
 /*!
@@ -277,6 +404,54 @@ int ThreadPoolAddPersistent(
     /*! [in] Job ID */
     int* jobId);
 
+/*! \brief Thread outside of the thread pools for a long-running loop.
+ *
+ * Event loops like the miniserver and the timer run on such a thread so they
+ * neither take a slot from a thread pool nor use its mutex.
+ */
+struct DedicatedThread {
+    ithread_t thread;   ///< The thread.
+    start_routine func; ///< Loop that is run.
+    void* arg;          ///< Argument of the loop.
+    int started;        ///< Set while the thread must be joined.
+};
+
+/*!
+ * \brief Starts a loop on a dedicated thread.
+ *
+ * On Linux the thread is bound to the given CPU if possible. Other systems
+ * ignore the CPU.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error:
+ *  - EINVAL invalid argument or the thread is already started.
+ *  - EAGAIN if system can not create thread.
+ */
+int DedicatedThreadStart(
+    /*! [in,out] Thread that is not started. */
+    DedicatedThread* dt,
+    /*! [in] Loop to run. */
+    start_routine func,
+    /*! [in] Argument to pass to the loop. */
+    void* arg,
+    /*! [in] CPU number to run on, -1 for any CPU. */
+    int cpu);
+
+/*!
+ * \brief Waits until the loop of a dedicated thread has returned.
+ *
+ * Stopping the loop is up to the caller. Nothing is done if the thread is not
+ * started.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL or result of ithread_join().
+ */
+int DedicatedThreadJoin(
+    /*! [in,out] Thread. */
+    DedicatedThread* dt);
+
 /*!
  * \brief Gets the current set of attributes associated with the thread pool.
  *
@@ -309,12 +484,18 @@ int ThreadPoolSetAttr(
 /*!
  * \brief Adds a job to the thread pool.
  *
- * Job will be run as soon as possible.
+ * Job will be run as soon as possible. If maxJobsTotal jobs are already
+ * queued the admission policy of the job (see TPJobSetAdmissionPolicy()) or
+ * of the thread pool attributes decides whether the job is accepted. A job
+ * that is merged into a queued duplicate (see TPJobSetMergeKey()) is freed
+ * with its free function and its caller gets the id of the queued job and
+ * success. Free functions of merged and dropped jobs are called after the
+ * thread pool mutex is unlocked.
  *
  * \returns
  *  On success: **0**\n
  *  On error: nonzero
- *  - EOUTOFMEM if not enough memory to add job.
+ *  - EOUTOFMEM if not enough memory to add job or the job was not admitted.
  */
 int ThreadPoolAdd(
     /*! [in] Valid thread pool pointer. */
@@ -514,6 +695,170 @@ int TPAttrSetMaxJobsTotal(
     /*! [in] Maximum number of jobs. */
     int maxJobsTotal);
 
+/*!
+ * \brief Sets what ThreadPoolAdd() does with a job if the job queues are full.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On  error: EINVAL.
+ */
+int TPAttrSetAdmissionPolicy(
+    /*! [in] Must be valid thread pool attributes. */
+    ThreadPoolAttr* attr,
+    /*! [in] Admission policy. */
+    AdmissionPolicy admissionPolicy);
+
+/*!
+ * \brief Sets the number of jobs that can be queued beyond maxJobsTotal with
+ * ADMIT_OVERFLOW.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On  error: EINVAL.
+ */
+int TPAttrSetMaxOverflowJobs(
+    /*! [in] Must be valid thread pool attributes. */
+    ThreadPoolAttr* attr,
+    /*! [in] Number of overflow jobs. */
+    int maxOverflowJobs);
+
+/*!
+ * \brief Sets the time ThreadPoolAdd() waits for a free slot with
+ * ADMIT_BLOCK.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On  error: EINVAL.
+ */
+int TPAttrSetAdmitTimeout(
+    /*! [in] Must be valid thread pool attributes. */
+    ThreadPoolAttr* attr,
+    /*! [in] Milliseconds. */
+    int admitTimeout);
+
+/*!
+ * \brief Sets the queue wait after which a thread is added to the thread
+ * pool.
+ *
+ * If 0 threads are added by the jobsPerThread ratio.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On  error: EINVAL.
+ */
+int TPAttrSetTargetQueueWait(
+    /*! [in] Must be valid thread pool attributes. */
+    ThreadPoolAttr* attr,
+    /*! [in] Milliseconds. */
+    int targetQueueWait);
+
+/*!
+ * \brief Sets the key to detect duplicate jobs.
+ *
+ * If a job with the same function and key is still queued when this job is
+ * added, ThreadPoolAdd() frees this job with its free function instead of
+ * queuing it.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int TPJobSetMergeKey(
+    /*! [in] Must be valid thread pool job. */
+    ThreadPoolJob* job,
+    /*! [in] Key, nullptr disables merging. */
+    const void* mergeKey);
+
+/*!
+ * \brief Sets what ThreadPoolAdd() does with the job if the job queues are
+ * full.
+ *
+ * This way the sources of jobs that share a thread pool can be admitted
+ * differently. A new job has ADMIT_DEFAULT and uses the policy of the thread
+ * pool.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int TPJobSetAdmissionPolicy(
+    /*! [in] Must be valid thread pool job. */
+    ThreadPoolJob* job,
+    /*! [in] Admission policy. */
+    AdmissionPolicy admissionPolicy);
+
+/*!
+ * \brief Sets the kind of work of a job for the statistics.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int TPJobSetLabel(
+    /*! [in] Must be valid thread pool job. */
+    ThreadPoolJob* job,
+    /*! [in] Label. */
+    ThreadPoolJobLabel label);
+
+/*!
+ * \brief Sets a function that is called when the job queues of the thread
+ * pool get full or have drained again.
+ *
+ * A listener can use it to stop accepting new work instead of accepting and
+ * dropping it.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int ThreadPoolSetSaturationFunction(
+    /*! [in] Valid initialized threadpool. */
+    ThreadPool* tp,
+    /*! [in] Function to call, nullptr removes it. */
+    saturation_routine func,
+    /*! [in] Passed to the function. */
+    void* cookie);
+
+/*!
+ * \brief Gets the admission control counters of the thread pool.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int ThreadPoolGetAdmitStats(
+    /*! [in] Valid initialized threadpool. */
+    ThreadPool* tp,
+    /*! [out] Counters. */
+    ThreadPoolAdmitStats* stats);
+
+/*!
+ * \brief Gets a snapshot of the queue wait and run time histograms of the
+ * thread pool.
+ *
+ * \returns
+ *  On success: **0**\n
+ *  On error: EINVAL.
+ */
+int ThreadPoolGetHistograms(
+    /*! [in] Valid initialized threadpool. */
+    ThreadPool* tp,
+    /*! [out] Snapshot. */
+    ThreadPoolHistograms* out);
+
+/*!
+ * \brief Estimates a percentile of a histogram.
+ *
+ * The value is interpolated linearly within the bucket that holds it.
+ *
+ * \returns Duration in microseconds, 0 for an empty histogram.
+ */
+double ThreadPoolHistogramPercentile(
+    /*! [in] Histogram. */
+    const ThreadPoolHistogram* hist,
+    /*! [in] Percentile as fraction from 0.0 to 1.0, e.g. 0.99. */
+    double fraction);
+
 /*!
  * \brief Returns various statistics about the thread pool.
  *
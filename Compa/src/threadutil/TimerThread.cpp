@@ -4,7 +4,7 @@
  * All rights reserved.
  * Copyright (c) 2012 France Telecom All rights reserved.
  * Copyright (C) 2021+ GPL 3 and higher by Ingo Höft,  Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-06
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -44,6 +44,7 @@
 #include "TimerThread.hpp"
 
 #include <assert.h>
+#include <chrono>
 
 /// \brief Invalid event ID.
 #define INVALID_EVENT_ID (-10 & 1 << 29)
@@ -57,8 +58,8 @@ namespace {
  */
 struct TimerEvent {
     ThreadPoolJob job;
-    /*! Absolute time for event in seconds since Jan 1, 1970. */
-    time_t eventTime;
+    /*! Absolute time for event in milliseconds since Jan 1, 1970. */
+    int64_t eventTime;
     /*! Long term or short term job. */
     Duration persistent;
     /*! Id of timer event. (can be null?). */
@@ -83,8 +84,8 @@ inline TimerEvent* CreateTimerEvent(
     ThreadPoolJob* job,
     /*! [in] . */
     Duration persistent,
-    /*! [in] The absoule time of the event in seconds from Jan, 1970. */
-    time_t eventTime,
+    /*! [in] The absoule time of the event in milliseconds from Jan, 1970. */
+    int64_t eventTime,
     /*! [in] Id of job. */
     int id) {
     TimerEvent* temp = NULL;
@@ -116,6 +117,19 @@ void FreeTimerEvent(
     FreeListFree(&timer->freeEvents, event);
 }
 
+/*!
+ * \brief Get the current time of the real-time clock.
+ *
+ * This is the clock used by ithread_cond_timedwait().
+ *
+ * \returns Milliseconds since Jan 1, 1970.
+ */
+inline int64_t CurrentTimeMsec() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
 /*!
  * \brief Implements timer thread.
  *
@@ -127,8 +141,8 @@ void TimerThreadWorker(
     TimerThread* timer = (TimerThread*)arg;
     ListNode* head{nullptr};
     TimerEvent* nextEvent{nullptr};
-    time_t currentTime = 0;
-    time_t nextEventTime = 0;
+    int64_t currentTime = 0;
+    int64_t nextEventTime = 0;
     timespec timeToWait;
     int tempId;
 
@@ -155,7 +169,7 @@ void TimerThreadWorker(
             nextEvent = (TimerEvent*)head->item;
             nextEventTime = nextEvent->eventTime;
         }
-        currentTime = time(NULL);
+        currentTime = CurrentTimeMsec();
         /* If time has elapsed, schedule job. */
         if (nextEvent && currentTime >= nextEventTime) {
             if (nextEvent->persistent) {
@@ -179,8 +193,8 @@ void TimerThreadWorker(
             continue;
         }
         if (nextEvent) {
-            timeToWait.tv_nsec = 0;
-            timeToWait.tv_sec = (long)nextEvent->eventTime;
+            timeToWait.tv_sec = (time_t)(nextEventTime / 1000);
+            timeToWait.tv_nsec = (long)(nextEventTime % 1000) * 1000000;
             ithread_cond_timedwait(&timer->condition, &timer->mutex,
                                    &timeToWait);
         } else {
@@ -190,27 +204,23 @@ void TimerThreadWorker(
 }
 
 /*!
- * \brief Calculates the appropriate timeout in absolute seconds since Jan 1,
- * 1970.
+ * \brief Calculates the appropriate timeout in absolute milliseconds since
+ * Jan 1, 1970.
  *
- * \returns Always **0**
+ * \returns Absolute time of the event in milliseconds.
  */
-inline int CalculateEventTime(
-    /*! [out] Timeout. */
-    time_t* timeout,
+inline int64_t CalculateEventTime(
+    /*! [in] Timeout. */
+    time_t timeout,
     /*! [in] Timeout type. */
     TimeoutType type) {
-    time_t now;
-
-    assert(timeout != nullptr);
-
     switch (type) {
     case ABS_SEC:
-        return 0;
+        return (int64_t)timeout * 1000;
+    case REL_MSEC:
+        return CurrentTimeMsec() + timeout;
     default: /* REL_SEC) */
-        time(&now);
-        (*timeout) += now;
-        return 0;
+        return CurrentTimeMsec() + (int64_t)timeout * 1000;
     }
 }
 
@@ -218,12 +228,10 @@ inline int CalculateEventTime(
 } // anonymous namespace
 
 
-int TimerThreadInit(TimerThread* timer, ThreadPool* tp) {
+int TimerThreadInit(TimerThread* timer, ThreadPool* tp, int cpu) {
 
     int rc = 0;
 
-    ThreadPoolJob timerThreadWorker;
-
     assert(timer != NULL);
     assert(tp != NULL);
 
@@ -247,6 +255,7 @@ int TimerThreadInit(TimerThread* timer, ThreadPool* tp) {
     timer->shutdown = 0;
     timer->tp = tp;
     timer->lastEventId = 0;
+    timer->thread = {};
     rc += ListInit(&timer->eventQ, NULL, NULL);
 
     assert(rc == 0);
@@ -255,10 +264,8 @@ int TimerThreadInit(TimerThread* timer, ThreadPool* tp) {
         rc = EAGAIN;
     } else {
 
-        TPJobInit(&timerThreadWorker, TimerThreadWorker, timer);
-        TPJobSetPriority(&timerThreadWorker, HIGH_PRIORITY);
-
-        rc = ThreadPoolAddPersistent(tp, &timerThreadWorker, NULL);
+        rc = DedicatedThreadStart(&timer->thread, TimerThreadWorker, timer,
+                                  cpu);
     }
 
     ithread_mutex_unlock(&timer->mutex);
@@ -290,7 +297,7 @@ int TimerThreadSchedule(TimerThread* timer, time_t timeout, TimeoutType type,
         return EINVAL;
     }
 
-    CalculateEventTime(&timeout, type);
+    const int64_t eventTime{CalculateEventTime(timeout, type)};
     ithread_mutex_lock(&timer->mutex);
 
     if (id == NULL)
@@ -299,7 +306,7 @@ int TimerThreadSchedule(TimerThread* timer, time_t timeout, TimeoutType type,
     (*id) = INVALID_EVENT_ID;
 
     newEvent =
-        CreateTimerEvent(timer, job, duration, timeout, timer->lastEventId);
+        CreateTimerEvent(timer, job, duration, eventTime, timer->lastEventId);
 
     if (newEvent == NULL) {
         ithread_mutex_unlock(&timer->mutex);
@@ -311,7 +318,7 @@ int TimerThreadSchedule(TimerThread* timer, time_t timeout, TimeoutType type,
      * the next event. */
     while (tempNode != NULL) {
         temp = (TimerEvent*)tempNode->item;
-        if (temp->eventTime >= timeout) {
+        if (temp->eventTime >= eventTime) {
             if (ListAddBefore(&timer->eventQ, newEvent, tempNode))
                 rc = 0;
             found = 1;
@@ -407,6 +414,7 @@ int TimerThreadShutdown(TimerThread* timer) {
         ithread_cond_wait(&timer->condition, &timer->mutex);
     }
     ithread_mutex_unlock(&timer->mutex);
+    DedicatedThreadJoin(&timer->thread);
 
     /* destroy condition. */
     while (ithread_cond_destroy(&timer->condition) != 0) {
@@ -5,7 +5,7 @@
  * Copyright (c) 2000-2003 Intel Corporation
  * All rights reserved.
  * Copyright (C) 2021 GPL 3 and higher by Ingo Höft,  <Ingo@Hoeft-online.de>
- * Redistribution only with this Copyright remark. Last modified: 2024-03-06
+ * Redistribution only with this Copyright remark. Last modified: 2026-10-19
  *
  * Redistribution and use in source and binary forms, with or without
  * modification, are permitted provided that the following conditions are met:
@@ -46,7 +46,8 @@
 /*! \brief Timeout Types. */
 enum TimeoutType {
     ABS_SEC, ///< seconds from Jan 1, 1970.
-    REL_SEC  ///< seconds from current time.
+    REL_SEC, ///< seconds from current time.
+    REL_MSEC ///< milliseconds from current time.
 };
 
 /*!
@@ -66,6 +67,7 @@ struct TimerThread {
     int shutdown;             ///< [in]
     FreeList freeEvents;      ///< [in]
     ThreadPool* tp;           ///< [in]
+    DedicatedThread thread;   ///< Thread that runs the timer loop.
 };
 
 /*!
@@ -73,14 +75,17 @@ struct TimerThread {
  *
  * \returns
  *  On success: **0**\n
- *  On error: nonzero, returns error from ThreadPoolAddPersistent().
+ *  On error: nonzero, returns error from DedicatedThreadStart().
  */
 int TimerThreadInit(
     /*! [in] Valid timer thread pointer. */
     TimerThread* timer,
     /*! [in] Valid thread pool to use. Must be started. Must be valid for
      * lifetime of timer. Timer must be shutdown BEFORE thread pool. */
-    ThreadPool* tp);
+    ThreadPool* tp,
+    /*! [in] CPU number for the timer loop, -1 for any CPU. The loop runs on
+     * a dedicated thread, not in **tp**. */
+    int cpu = -1);
 
 /*!
  * \brief Schedules an event to run at a specified time.
@@ -93,11 +98,11 @@ int TimerThreadInit(
 int TimerThreadSchedule(
     /*! [in] Valid timer thread pointer. */
     TimerThread* timer,
-    /*! [in] time of event. Either in absolute seconds, or relative seconds in
-     * the future. */
+    /*! [in] time of event. Either in absolute seconds, or relative seconds
+     * or milliseconds in the future. */
     time_t timeout,
-    /*! [in] either ABS_SEC, or REL_SEC. If REL_SEC, then the event will be
-     * scheduled at the current time + REL_SEC. */
+    /*! [in] either ABS_SEC, REL_SEC or REL_MSEC. If REL_SEC or REL_MSEC, then
+     * the event will be scheduled at the current time + timeout. */
     TimeoutType type,
     /*! [in] Valid Thread pool job with following fields. */
     ThreadPoolJob* job,
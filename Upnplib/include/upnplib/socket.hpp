@@ -96,6 +96,8 @@
 #define EFAULTP WSAEFAULT
 #define ENOMEMP WSA_NOT_ENOUGH_MEMORY
 #define EINVALP WSAEINVAL
+#define ECONNRESETP WSAECONNRESET
+#define EPIPEP WSAECONNABORTED
 #else
 #define EBADFP EBADF
 #define ENOTCONNP ENOTCONN
@@ -103,6 +105,8 @@
 #define EFAULTP EFAULT
 #define ENOMEMP ENOMEM
 #define EINVALP EINVAL
+#define ECONNRESETP ECONNRESET
+#define EPIPEP EPIPE
 #endif
 /// \endcond
 
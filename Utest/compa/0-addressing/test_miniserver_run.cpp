@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-07-28
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 // All functions of the miniserver module have been covered by a gtest. Some
 // tests are skipped and must be completed when missed information is
@@ -24,6 +24,12 @@
 #include <pupnp/threadpool_init.hpp>
 
 #include <utest/utest.hpp>
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(UPNP_ENABLE_OPEN_SSL)
+#include <utest/utest_ssl.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#endif
 #include <umock/sys_socket_mock.hpp>
 #include <umock/winsock2_mock.hpp>
 
@@ -911,6 +917,43 @@ TEST_F(RunMiniServerMockFTestSuite, ssdp_read_fails) {
     EXPECT_EQ(ssdp_sockfd, INVALID_SOCKET);
 }
 
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(__linux__)
+TEST(RunMiniServerTestSuite, netlink_concerns_if) {
+    // Two netlink messages, a route and an address change, in one buffer.
+    struct {
+        nlmsghdr route_hdr;
+        rtmsg route;
+        nlmsghdr addr_hdr;
+        ifaddrmsg addr;
+    } msgs{};
+    msgs.route_hdr.nlmsg_len = NLMSG_LENGTH(sizeof(rtmsg));
+    msgs.route_hdr.nlmsg_type = RTM_NEWROUTE;
+    msgs.addr_hdr.nlmsg_len = NLMSG_LENGTH(sizeof(ifaddrmsg));
+    msgs.addr_hdr.nlmsg_type = RTM_NEWADDR;
+    msgs.addr.ifa_index = 2;
+    ASSERT_EQ(offsetof(decltype(msgs), addr_hdr),
+              NLMSG_ALIGN(msgs.route_hdr.nlmsg_len));
+
+    EXPECT_TRUE(netlink_concerns_if(&msgs, sizeof(msgs), 2));
+    EXPECT_FALSE(netlink_concerns_if(&msgs, sizeof(msgs), 3));
+    // Route messages do not concern the interface.
+    EXPECT_FALSE(netlink_concerns_if(&msgs, offsetof(decltype(msgs), addr_hdr),
+                                     2));
+    // A truncated message is ignored.
+    EXPECT_FALSE(netlink_concerns_if(&msgs, sizeof(msgs) - 1, 2));
+
+    struct {
+        nlmsghdr hdr;
+        ifinfomsg link;
+    } link_msg{};
+    link_msg.hdr.nlmsg_len = NLMSG_LENGTH(sizeof(ifinfomsg));
+    link_msg.hdr.nlmsg_type = RTM_DELLINK;
+    link_msg.link.ifi_index = 3;
+    EXPECT_TRUE(netlink_concerns_if(&link_msg, sizeof(link_msg), 3));
+    EXPECT_FALSE(netlink_concerns_if(&link_msg, sizeof(link_msg), 2));
+}
+#endif
+
 TEST_F(RunMiniServerMockFTestSuite, web_server_accept_successful) {
     // The tested units are different for old_code (pupnp) and new code (compa).
     // We have void      ::web_server_accept() and
@@ -1103,6 +1146,230 @@ TEST_F(RunMiniServerMockFTestSuite, web_server_accept_fails) {
 #endif // UPNPLIB_WITH_NATIVE_PUPNP
 }
 
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(UPNP_ENABLE_OPEN_SSL)
+// Miniserver with TLS listener mode on a listening loopback socket. Accepted
+// connections are not handled by a request job, they are just closed after
+// the TLS handshake.
+class CTlsListener {
+  public:
+    CTlsListener() {
+        TRACE("construct CTlsListener");
+        SSL_CTX* ctx = new_tls_server_ctx();
+        int ret = ::UpnpSetSslServerContext(ctx);
+        SSL_CTX_free(ctx); // The library has its own reference.
+        if (ret != UPNP_E_SUCCESS)
+            throw std::runtime_error("Failed to set server SSL Context.");
+
+        m_sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t saddr_len{sizeof(saddr)};
+        if (m_sockfd == INVALID_SOCKET ||
+            ::bind(m_sockfd, reinterpret_cast<sockaddr*>(&saddr), saddr_len) !=
+                0 ||
+            ::listen(m_sockfd, SOMAXCONN) != 0 ||
+            ::getsockname(m_sockfd, reinterpret_cast<sockaddr*>(&saddr),
+                          &saddr_len) != 0) {
+            sock_close(m_sockfd);
+            ::UpnpSetSslServerContext(nullptr);
+            throw std::runtime_error("Failed to listen on loopback.");
+        }
+        m_port = ntohs(saddr.sin_port);
+    }
+    virtual ~CTlsListener() {
+        TRACE("destruct CTlsListener");
+        tls_handshakes_abort();
+        sock_close(m_sockfd);
+        ::UpnpSetSslServerContext(nullptr);
+    }
+
+    // Connect a socket to the listener.
+    SOCKET connect() const {
+        SOCKET sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        saddr.sin_port = htons(m_port);
+        if (::connect(sockfd, reinterpret_cast<sockaddr*>(&saddr),
+                      sizeof(saddr)) != 0) {
+            sock_close(sockfd);
+            return INVALID_SOCKET;
+        }
+        return sockfd;
+    }
+
+    // Do what the miniserver loop does with the listening socket and the TLS
+    // handshakes for up to the given milliseconds. The listening socket is
+    // used as TLS listener or as plain listener.
+    void run_once(long a_timeout_ms, bool a_tls = true) {
+        fd_set rdSet;
+        fd_set wrSet;
+        FD_ZERO(&rdSet);
+        FD_ZERO(&wrSet);
+        FD_SET(m_sockfd, &rdSet);
+        SOCKET nfds{m_sockfd + 1};
+        fdset_tls_handshakes(&rdSet, &wrSet, nfds);
+        ::timeval timeout{0, a_timeout_ms * 1000};
+        if (::select(static_cast<int>(nfds), &rdSet, &wrSet, nullptr,
+                     &timeout) < 0)
+            return;
+        tls_handshakes_continue(&rdSet, &wrSet);
+        if (FD_ISSET(m_sockfd, &rdSet))
+            web_server_accept(m_sockfd, rdSet, a_tls);
+    }
+
+  private:
+    SOCKET m_sockfd{INVALID_SOCKET};
+    in_port_t m_port{};
+};
+
+// TLS client that connects to the listener and does a handshake, optionally
+// resuming a session. Returns the established session or nullptr. The client
+// SSL Context must have option SSL_OP_IGNORE_UNEXPECTED_EOF set, otherwise the
+// session isn't resumable after the server closes the connection.
+SSL_SESSION* tls_client_handshake(SSL_CTX* a_ctx, const CTlsListener& a_srv,
+                                  SSL_SESSION* a_session,
+                                  bool* a_reused = nullptr) {
+    SOCKET sockfd = a_srv.connect();
+    if (sockfd == INVALID_SOCKET)
+        return nullptr;
+    SSL* ssl = SSL_new(a_ctx);
+    SSL_set_fd(ssl, static_cast<int>(sockfd));
+    if (a_session != nullptr)
+        SSL_set_session(ssl, a_session);
+    SSL_SESSION* session{nullptr};
+    if (SSL_connect(ssl) == 1) {
+        // Receive the session ticket until the server closes the connection.
+        char buf[1];
+        SSL_read(ssl, buf, sizeof(buf));
+        session = SSL_get1_session(ssl);
+        if (a_reused != nullptr)
+            *a_reused = SSL_session_reused(ssl) == 1;
+        // Without shutdown SSL_free() makes the session not resumable.
+        SSL_shutdown(ssl);
+    }
+    SSL_free(ssl);
+    sock_close(sockfd);
+    return session;
+}
+
+TEST(RunMiniServerTestSuite, web_server_accept_tls_handshake) {
+    // No request jobs, the connection is closed after the handshake.
+    CThreadPoolInit tp(gMiniServerThreadPool,
+                       /*shutdown*/ false, /*maxJobs*/ 0);
+    CTlsListener srvObj;
+    SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(client_ctx, nullptr);
+    SSL_CTX_set_options(client_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+
+    std::atomic<bool> done{false};
+    SSL_SESSION* session{nullptr};
+    bool reused{true};
+    std::thread client([&] {
+        session = tls_client_handshake(client_ctx, srvObj, nullptr, &reused);
+        if (session != nullptr) {
+            SSL_SESSION* resumed =
+                tls_client_handshake(client_ctx, srvObj, session, &reused);
+            SSL_SESSION_free(resumed);
+        }
+        done = true;
+    });
+
+    // Test Unit
+    for (int i{0}; !done && i < 500; i++)
+        srvObj.run_once(10);
+    client.join();
+
+    ASSERT_NE(session, nullptr);
+    EXPECT_TRUE(reused);
+    EXPECT_TRUE(gTlsHandshakes.empty());
+    SSL_SESSION_free(session);
+    SSL_CTX_free(client_ctx);
+}
+
+TEST(RunMiniServerTestSuite, web_server_accept_tls_handshake_times_out) {
+    CTlsListener srvObj;
+    // Connect without doing a handshake.
+    SOCKET sockfd = srvObj.connect();
+    ASSERT_NE(sockfd, INVALID_SOCKET);
+
+    // Accepting must not wait for the handshake.
+    srvObj.run_once(1000);
+    ASSERT_EQ(gTlsHandshakes.size(), 1u);
+    EXPECT_EQ(gTlsHandshakes[0].state, SOCK_SSL_WANT_READ);
+
+    // Test Unit
+    fd_set set;
+    FD_ZERO(&set);
+    tls_handshakes_continue(&set, &set);
+    EXPECT_EQ(gTlsHandshakes.size(), 1u);
+    gTlsHandshakes[0].deadline = time(nullptr) - 1;
+    tls_handshakes_continue(&set, &set);
+    EXPECT_TRUE(gTlsHandshakes.empty());
+
+    sock_close(sockfd);
+}
+
+TEST(RunMiniServerTestSuite, web_server_accept_plain_with_ssl_context) {
+    // A server SSL context must not turn the plain listeners into TLS only
+    // listeners. No request jobs, the connection is closed.
+    CThreadPoolInit tp(gMiniServerThreadPool,
+                       /*shutdown*/ false, /*maxJobs*/ 0);
+    CTlsListener srvObj;
+    SOCKET sockfd = srvObj.connect();
+    ASSERT_NE(sockfd, INVALID_SOCKET);
+
+    // Test Unit
+    srvObj.run_once(1000, /*tls*/ false);
+    EXPECT_TRUE(gTlsHandshakes.empty());
+
+    sock_close(sockfd);
+}
+
+TEST(DISABLED_RunMiniServerBenchSuite, tls_handshakes_per_second) {
+    constexpr int handshakes{500};
+    CThreadPoolInit tp(gMiniServerThreadPool,
+                       /*shutdown*/ false, /*maxJobs*/ 0);
+    CTlsListener srvObj;
+    SSL_CTX* client_ctx = SSL_CTX_new(TLS_client_method());
+    ASSERT_NE(client_ctx, nullptr);
+    SSL_CTX_set_options(client_ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
+
+    for (bool resume : {false, true}) {
+        std::atomic<bool> done{false};
+        int count{0};
+        auto start = std::chrono::steady_clock::now();
+        std::thread client([&] {
+            SSL_SESSION* session =
+                tls_client_handshake(client_ctx, srvObj, nullptr);
+            for (int i{0}; i < handshakes && session != nullptr; i++) {
+                SSL_SESSION* next = tls_client_handshake(
+                    client_ctx, srvObj, resume ? session : nullptr);
+                if (next != nullptr)
+                    count++;
+                SSL_SESSION_free(session);
+                session = next;
+            }
+            SSL_SESSION_free(session);
+            done = true;
+        });
+        while (!done)
+            srvObj.run_once(10);
+        client.join();
+        auto elapsed = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start);
+
+        EXPECT_EQ(count, handshakes);
+        std::cout << "[ BENCH    ] " << count << " "
+                  << (resume ? "resumed" : "full") << " TLS handshakes, "
+                  << static_cast<long>(count / elapsed.count())
+                  << " handshakes per second.\n";
+    }
+    SSL_CTX_free(client_ctx);
+}
+#endif
+
 TEST_F(RunMiniServerMockFTestSuite, get_numeric_host_redirection) {
     // getNumericHostRedirection() returns the ip address with port as text
     // (e.g. "192.168.1.2:54321") that is bound to a socket.
@@ -1313,15 +1580,26 @@ TEST(RunMiniServerTestSuite, schedule_request_job) {
     }
 }
 
+// Allocate a null set request structure like schedule_request_job() does.
+mserv_request_t* new_request() {
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
+    return static_cast<mserv_request_t*>(calloc(1, sizeof(mserv_request_t)));
+#else
+    void* request = SlabAlloc(sizeof(mserv_request_t));
+    if (request != nullptr)
+        memset(request, 0, sizeof(mserv_request_t));
+    return static_cast<mserv_request_t*>(request);
+#endif
+}
+
 TEST(RunMiniServerTestSuite, free_handle_request_arg_successful) {
     // Provide null set request structure
-    mserv_request_t* request =
-        static_cast<mserv_request_t*>(calloc(1, sizeof(mserv_request_t)));
+    mserv_request_t* request = new_request();
 
     // Test Unit
     free_handle_request_arg(request);
 
-    request = static_cast<mserv_request_t*>(malloc(sizeof(mserv_request_t)));
+    request = new_request();
     memset(request, 0xAA, sizeof(mserv_request_t));
 
     // Test Unit
@@ -1330,8 +1608,7 @@ TEST(RunMiniServerTestSuite, free_handle_request_arg_successful) {
 
 TEST(RunMiniServerTestSuite, free_handle_request_arg_with_valid_socket) {
     // Provide null set request structure
-    mserv_request_t* request =
-        static_cast<mserv_request_t*>(calloc(1, sizeof(mserv_request_t)));
+    mserv_request_t* request = new_request();
     // and set a valid socket
     ASSERT_NE(request->connfd = socket(AF_INET6, SOCK_STREAM, 0),
               INVALID_SOCKET);
@@ -1355,8 +1632,7 @@ TEST(RunMiniServerTestSuite, free_handle_request_arg_with_valid_socket) {
 
 TEST(RunMiniServerTestSuite, free_handle_request_arg_with_invalid_socket) {
     // Provide null set request structure
-    mserv_request_t* request =
-        static_cast<mserv_request_t*>(calloc(1, sizeof(mserv_request_t)));
+    mserv_request_t* request = new_request();
     // and set an invalid socket
     request->connfd = INVALID_SOCKET;
 
@@ -1395,8 +1671,7 @@ TEST(RunMiniServerDeathTest, free_handle_request_arg_double_free) {
     EXPECT_DEATH(
         {
             // Provide null set request structure
-            mserv_request_t* request = static_cast<mserv_request_t*>(
-                calloc(1, sizeof(mserv_request_t)));
+            mserv_request_t* request = new_request();
 
             // Test Unit
             free_handle_request_arg(request);
@@ -1460,6 +1735,41 @@ TEST_F(RunMiniServerMockFTestSuite, handle_request_with_failing_select) {
 #endif
 }
 
+TEST(RunMiniServerTestSuite, handle_request_releases_allocated_request) {
+    // handle_request() takes over the request structure as allocated by
+    // schedule_request_job() and must release it with the matching
+    // deallocation function. A mismatch aborts or corrupts the heap.
+#ifdef _WIN32
+    GTEST_SKIP() << "Needs socketpair() that isn't available on MS Windows.";
+#else
+    CLogging logObj; // Output only with build type DEBUG.
+    if (g_dbug)
+        logObj.enable(UPNP_ALL);
+
+    int sv[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, sv), 0);
+
+    // Provide an invalid request from the remote client.
+    constexpr char request_str[]{"garbage\r\n\r\n"};
+    ASSERT_EQ(::send(sv[1], request_str, sizeof(request_str) - 1, 0),
+              static_cast<ssize_t>(sizeof(request_str) - 1));
+    ::shutdown(sv[1], SHUT_WR);
+
+    mserv_request_t* request_in = new_request();
+    ASSERT_NE(request_in, nullptr);
+    request_in->connfd = sv[0];
+
+    // Test Unit, it also closes sv[0].
+    handle_request(request_in);
+
+    // The client gets an error status response.
+    char response[256]{};
+    EXPECT_GT(::recv(sv[1], response, sizeof(response) - 1, 0), 0);
+    EXPECT_THAT(response, HasSubstr(" 400 Bad Request\r\n"));
+    ::close(sv[1]);
+#endif
+}
+
 TEST(RunMiniServerTestSuite, dispatch_request_fails) {
     // Provide resources
     SOCKINFO sockinfo{};
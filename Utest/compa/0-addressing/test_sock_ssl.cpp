@@ -1,5 +1,5 @@
 // Copyright (C) 2023+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-07-30
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 #include <upnp.hpp>
 #include <sock.hpp>
@@ -15,6 +15,10 @@
 #endif
 
 #include <utest/utest.hpp>
+#include <utest/utest_ssl.hpp>
+
+#include <string>
+#include <thread>
 
 #ifdef UPNPLIB_WITH_NATIVE_PUPNP
 UPNPLIB_EXTERN SSL_CTX* gSslCtx;
@@ -69,6 +73,69 @@ class CGsslCtx {
 };
 #endif
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// TLS server on the loopback interface with a self signed certificate. It
+// accepts the given number of connections, sends one byte on each and waits
+// until the client closes it.
+class CTlsServer {
+  public:
+    CTlsServer(int a_connections) {
+        TRACE("construct CTlsServer");
+        m_ctx = new_tls_server_ctx();
+
+        m_listen_sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t saddr_len{sizeof(saddr)};
+        if (m_listen_sock == INVALID_SOCKET ||
+            ::bind(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                   saddr_len) != 0 ||
+            ::listen(m_listen_sock, SOMAXCONN) != 0 ||
+            ::getsockname(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                          &saddr_len) != 0) {
+            CLOSE_SOCKET_P(m_listen_sock);
+            SSL_CTX_free(m_ctx);
+            throw std::runtime_error("Failed to listen on loopback.");
+        }
+        m_port = ntohs(saddr.sin_port);
+        m_thread = std::thread(&CTlsServer::run, this, a_connections);
+    }
+    virtual ~CTlsServer() {
+        TRACE("destruct CTlsServer");
+        m_thread.join();
+        CLOSE_SOCKET_P(m_listen_sock);
+        SSL_CTX_free(m_ctx);
+    }
+    in_port_t get_port() const { return m_port; }
+
+  private:
+    void run(int a_connections) {
+        for (int i{0}; i < a_connections; i++) {
+            SOCKET sockfd = ::accept(m_listen_sock, nullptr, nullptr);
+            if (sockfd == INVALID_SOCKET)
+                return;
+            SSL* ssl = SSL_new(m_ctx);
+            SSL_set_fd(ssl, static_cast<int>(sockfd));
+            if (SSL_accept(ssl) == 1) {
+                char buf[1]{'x'};
+                SSL_write(ssl, buf, sizeof(buf));
+                // Wait for close_notify from the client.
+                while (SSL_read(ssl, buf, sizeof(buf)) > 0) {
+                }
+            }
+            SSL_free(ssl);
+            CLOSE_SOCKET_P(sockfd);
+        }
+    }
+
+    SSL_CTX* m_ctx{};
+    SOCKET m_listen_sock{INVALID_SOCKET};
+    in_port_t m_port{};
+    std::thread m_thread;
+};
+#endif
+
 
 // OpenSSL TestSuite
 //==================
@@ -199,6 +266,52 @@ TEST(SockDeathTest, sock_ssl_connect_signal_broken_pipe) {
 #endif
 }
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+TEST(SockTestSuite, sock_ssl_connect_resumes_session) {
+    constexpr int connections{3};
+    CGsslCtx gSslCtxObj;
+    CTlsServer server(connections);
+    // The session is cached for the requested host, not for its address.
+    const std::string hostport{"localhost:" +
+                               std::to_string(server.get_port())};
+
+    for (int i{0}; i < connections; i++) {
+        SOCKET sockfd = ::socket(AF_INET, SOCK_STREAM, 0);
+        ASSERT_NE(sockfd, INVALID_SOCKET);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        saddr.sin_port = htons(server.get_port());
+        ASSERT_EQ(::connect(sockfd, reinterpret_cast<sockaddr*>(&saddr),
+                            sizeof(saddr)),
+                  0);
+        ::SOCKINFO info{};
+        ASSERT_EQ(sock_init(&info, sockfd), UPNP_E_SUCCESS);
+
+        // Test Unit
+        int ret_sock_ssl_connect = sock_ssl_connect(&info, hostport.c_str());
+        EXPECT_EQ(ret_sock_ssl_connect, UPNP_E_SUCCESS)
+            << errStrEx(ret_sock_ssl_connect, UPNP_E_SUCCESS);
+        EXPECT_EQ(SSL_session_reused(info.ssl), i > 0 ? 1 : 0)
+            << "connection " << i;
+
+        // Reading processes the session tickets that are sent after the
+        // handshake with TLS 1.3.
+        char buf[1]{};
+        int timeout{5};
+        EXPECT_EQ(sock_read(&info, buf, sizeof(buf), &timeout), 1);
+        EXPECT_EQ(buf[0], 'x');
+        EXPECT_EQ(sock_destroy(&info, SD_BOTH), UPNP_E_SUCCESS);
+    }
+
+    UpnpSslSessionStats stats{};
+    ::UpnpGetSslSessionStats(&stats);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, static_cast<size_t>(connections - 1));
+    EXPECT_EQ(stats.entries, 1u);
+}
+#endif
+
 } // namespace utest
 
 
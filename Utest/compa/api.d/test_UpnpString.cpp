@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-01-14
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 #include <UpnpString.hpp>
 #if defined UPNPLIB_WITH_NATIVE_PUPNP && !defined PUPNP_UPNPSTRING_HPP
@@ -19,6 +19,15 @@
 #include <umock/stdlib_mock.hpp>
 #include <umock/stringh_mock.hpp>
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+#include <UpnpDiscovery.hpp>
+/// \cond
+#include <chrono>
+#include <cstring>
+#include <vector>
+/// \endcond
+#endif
+
 using ::testing::_;
 using ::testing::Eq;
 using ::testing::ExitedWithCode;
@@ -417,6 +426,162 @@ TEST(UpnpStringDeathTest, clearUpnpString) {
     }
 }
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// Counts allocations of the umock wrappers and forwards them to the system.
+class CCountAllocs : public umock::StdlibInterface,
+                     public umock::StringhInterface {
+  public:
+    size_t allocs{};
+    void* malloc(size_t size) override {
+        allocs++;
+        return ::malloc(size);
+    }
+    void* calloc(size_t nmemb, size_t size) override {
+        allocs++;
+        return ::calloc(nmemb, size);
+    }
+    void* realloc(void* ptr, size_t size) override {
+        allocs++;
+        return ::realloc(ptr, size);
+    }
+    void free(void* ptr) override { ::free(ptr); }
+    char* strerror(int errnum) override { return ::strerror(errnum); }
+    char* strdup(const char* s) override {
+        allocs++;
+        return ::strdup(s);
+    }
+    char* strndup(const char* s, size_t n) override {
+        allocs++;
+        return ::strndup(s, n);
+    }
+};
+
+// Fields of a typical discovery of a media server.
+const char* const discovery_fields[]{
+    "uuid:4d696e69-444c-164e-9d41-b827eb54e153::urn:schemas-upnp-org:device:"
+    "MediaServer:1",
+    "urn:schemas-upnp-org:device:MediaServer:1",
+    "urn:schemas-upnp-org:service:ContentDirectory:1",
+    "1",
+    "http://192.168.1.10:8200/rootDesc.xml",
+    "Linux 6.1 DLNADOC/1.50 UPnP/1.0 MiniDLNA/1.3",
+    "Mon, 19 Oct 2026 10:00:00 GMT",
+    ""};
+
+void fill_discovery(UpnpDiscovery* d) {
+    UpnpDiscovery_strcpy_DeviceID(d, discovery_fields[0]);
+    UpnpDiscovery_strcpy_DeviceType(d, discovery_fields[1]);
+    UpnpDiscovery_strcpy_ServiceType(d, discovery_fields[2]);
+    UpnpDiscovery_strcpy_ServiceVer(d, discovery_fields[3]);
+    UpnpDiscovery_strcpy_Location(d, discovery_fields[4]);
+    UpnpDiscovery_strcpy_Os(d, discovery_fields[5]);
+    UpnpDiscovery_strcpy_Date(d, discovery_fields[6]);
+    UpnpDiscovery_strcpy_Ext(d, discovery_fields[7]);
+}
+
+TEST(UpnpStringTestSuite, inline_string_uses_its_buffer_while_it_fits) {
+    constexpr size_t capacity{8};
+    ASSERT_EQ(UpnpString_inline_size(capacity) % alignof(UpnpString), 0u);
+    std::vector<char> mem(2 * UpnpString_inline_size(capacity));
+    UpnpString* p = UpnpString_inline_init(mem.data(), capacity);
+    ASSERT_NE(p, nullptr);
+    const char* inl = reinterpret_cast<char*>(p + 1);
+    EXPECT_EQ(UpnpString_get_String(p), inl);
+    EXPECT_EQ(UpnpString_get_Length(p), 0u);
+
+    // Test Unit
+    EXPECT_EQ(UpnpString_inline_set_String(p, capacity, "1234567"), 1);
+    EXPECT_EQ(UpnpString_get_String(p), inl);
+    EXPECT_EQ(UpnpString_get_Length(p), 7u);
+
+    EXPECT_EQ(UpnpString_inline_set_String(p, capacity, "12345678"), 1);
+    EXPECT_NE(UpnpString_get_String(p), inl);
+    EXPECT_STREQ(UpnpString_get_String(p), "12345678");
+    EXPECT_EQ(UpnpString_get_Length(p), 8u);
+
+    // Back into the inline buffer, copying from the heap buffer itself.
+    EXPECT_EQ(UpnpString_inline_set_StringN(p, capacity,
+                                            UpnpString_get_String(p) + 2, 3),
+              1);
+    EXPECT_EQ(UpnpString_get_String(p), inl);
+    EXPECT_STREQ(UpnpString_get_String(p), "345");
+
+    UpnpString_clear(p);
+    EXPECT_STREQ(UpnpString_get_String(p), "");
+    EXPECT_EQ(UpnpString_inline_set_String(p, capacity, nullptr), 0);
+    EXPECT_EQ(UpnpString_inline_set_String(p, capacity, "a longer string"), 1);
+    UpnpString_inline_destroy(p);
+    EXPECT_EQ(UpnpString_get_String(p), inl);
+    EXPECT_EQ(UpnpString_get_Length(p), 0u);
+    EXPECT_EQ(UpnpString_inline_init(nullptr, capacity), nullptr);
+}
+
+TEST(UpnpStringTestSuite, discovery_needs_one_allocation) {
+    CCountAllocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+    umock::Stringh stringh_injectObj(&countObj);
+
+    // Test Unit
+    UpnpDiscovery* d = UpnpDiscovery_new();
+    ASSERT_NE(d, nullptr);
+    fill_discovery(d);
+    UpnpDiscovery* dup = UpnpDiscovery_dup(d);
+    ASSERT_NE(dup, nullptr);
+
+    EXPECT_EQ(countObj.allocs, 2u);
+    EXPECT_STREQ(UpnpDiscovery_get_Location_cstr(dup),
+                 "http://192.168.1.10:8200/rootDesc.xml");
+    EXPECT_EQ(UpnpDiscovery_get_DeviceID_Length(dup),
+              strlen(discovery_fields[0]));
+    UpnpDiscovery_delete(dup);
+    UpnpDiscovery_delete(d);
+}
+
+TEST(DISABLED_UpnpStringBenchSuite, discovery_storm) {
+    constexpr int discoveries{200000};
+    CCountAllocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+    umock::Stringh stringh_injectObj(&countObj);
+
+    // The object with eight separately allocated strings as it was built
+    // before.
+    auto start = std::chrono::steady_clock::now();
+    for (int i{0}; i < discoveries; i++) {
+        void* d = umock::stdlib_h.calloc(1, 200);
+        UpnpString* strs[8];
+        for (int j{0}; j < 8; j++) {
+            strs[j] = UpnpString_new();
+            UpnpString_set_String(strs[j], discovery_fields[j]);
+        }
+        for (int j{0}; j < 8; j++)
+            UpnpString_delete(strs[j]);
+        umock::stdlib_h.free(d);
+    }
+    auto separate_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+    const size_t separate_allocs{countObj.allocs};
+
+    countObj.allocs = 0;
+    start = std::chrono::steady_clock::now();
+    for (int i{0}; i < discoveries; i++) {
+        UpnpDiscovery* d = UpnpDiscovery_new();
+        fill_discovery(d);
+        UpnpDiscovery_delete(d);
+    }
+    auto inline_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    std::cout << "[ BENCH    ] " << discoveries
+              << " discoveries, with separate strings "
+              << separate_allocs / discoveries << " allocations and "
+              << separate_ns / discoveries << " ns, inline "
+              << countObj.allocs / discoveries << " allocations and "
+              << inline_ns / discoveries << " ns per discovery.\n";
+}
+#endif
+
 } // namespace utest
 
 int main(int argc, char** argv) {
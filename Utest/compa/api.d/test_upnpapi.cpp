@@ -1,5 +1,5 @@
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-02-28
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 #ifdef UPNPLIB_WITH_NATIVE_PUPNP
 #include <Pupnp/upnp/src/api/upnpapi.cpp>
@@ -21,6 +21,12 @@
 #include <umock/sys_socket_mock.hpp>
 #include <umock/pupnp_sock_mock.hpp>
 #include <umock/winsock2_mock.hpp>
+#include <umock/stdlib.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 
 namespace utest {
@@ -32,11 +38,16 @@ using ::pupnp::CLogging;
 
 using ::testing::_;
 using ::testing::A;
+using ::testing::DoAll;
+using ::testing::ElementsAre;
 using ::testing::ExitedWithCode;
+using ::testing::HasSubstr;
+using ::testing::InvokeWithoutArgs;
 using ::testing::NotNull;
 using ::testing::Pointee;
 using ::testing::Return;
 using ::testing::SetErrnoAndReturn;
+using ::testing::StartsWith;
 using ::testing::StrictMock;
 
 
@@ -205,9 +216,16 @@ TEST_F(UpnpapiFTestSuite, UpnpInitPreamble_successful) {
     EXPECT_TRUE(handleTable_initialized);
 
     // Check threadpool initialization
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
     EXPECT_EQ(gSendThreadPool.totalThreads, 3);
     EXPECT_EQ(gSendThreadPool.busyThreads, 1);
     EXPECT_EQ(gSendThreadPool.persistentThreads, 1);
+#else
+    // The timer thread does not take a worker from the send thread pool.
+    EXPECT_EQ(gSendThreadPool.totalThreads, 2);
+    EXPECT_EQ(gSendThreadPool.busyThreads, 0);
+    EXPECT_EQ(gSendThreadPool.persistentThreads, 0);
+#endif
 
     EXPECT_EQ(gRecvThreadPool.totalThreads, 2);
     EXPECT_EQ(gRecvThreadPool.busyThreads, 0);
@@ -558,6 +576,1103 @@ TEST_F(UpnpapiMockFTestSuite, UpnpRegisterRootDevice3_successful) {
         << errStrEx(ret_UpnpFinish, UPNP_E_SUCCESS);
 }
 
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(COMPA_HAVE_CTRLPT_SSDP)
+TEST_F(UpnpapiFTestSuite, ssdp_cache_suppresses_duplicate_advertisements) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    static std::atomic<int> alive_events;
+    static std::atomic<int> byebye_events;
+    alive_events = 0;
+    byebye_events = 0;
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    hinfo.Callback = [](Upnp_EventType EventType, const void*, void*) {
+        if (EventType == UPNP_DISCOVERY_ADVERTISEMENT_ALIVE)
+            alive_events++;
+        else if (EventType == UPNP_DISCOVERY_ADVERTISEMENT_BYEBYE)
+            byebye_events++;
+        return 0;
+    };
+    ListInit(&hinfo.SsdpSearchList, nullptr, nullptr);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+    SsdpCacheClear();
+
+    // A device sends each message several times.
+    auto notify = [](const char* a_nts) {
+        http_parser_t parser;
+        parser_request_init(&parser);
+        const std::string msg{
+            "NOTIFY * HTTP/1.1\r\n"
+            "HOST: 239.255.255.250:1900\r\n"
+            "CACHE-CONTROL: max-age=1800\r\n"
+            "LOCATION: http://192.168.99.5:50001/tvdevicedesc.xml\r\n"
+            "NT: upnp:rootdevice\r\n"
+            "NTS: " +
+            std::string(a_nts) +
+            "\r\n"
+            "USN: uuid:f3a8c2b1-0d4e-4b2a-9c1d-1e2f3a4b5c6d::upnp:rootdevice\r\n"
+            "CONTENT-LENGTH: 0\r\n"
+            "\r\n"};
+        ASSERT_EQ(membuffer_assign_str(&parser.msg.msg, msg.c_str()), 0);
+        ASSERT_EQ(parser_parse(&parser), PARSE_SUCCESS);
+        sockaddr_storage src{};
+        for (int i{0}; i < 3; i++)
+            ssdp_handle_ctrlpt_msg(&parser.msg, &src, 0);
+        httpmsg_destroy(&parser.msg);
+    };
+
+    // Test Unit
+    notify("ssdp:alive");
+    EXPECT_EQ(alive_events, 1);
+    SsdpCacheStats stats{};
+    SsdpCacheGetStats(&stats);
+    EXPECT_EQ(stats.entries, 1u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_EQ(stats.hits, 2u);
+    EXPECT_EQ(SsdpCacheGetAlive(
+                  [](const UpnpDiscovery* disc, void*) {
+                      EXPECT_STREQ(UpnpDiscovery_get_Location_cstr(disc),
+                                   "http://192.168.99.5:50001/tvdevicedesc.xml");
+                  },
+                  nullptr),
+              1);
+
+    notify("ssdp:byebye");
+    EXPECT_EQ(byebye_events, 1);
+    EXPECT_EQ(SsdpCacheGetAlive([](const UpnpDiscovery*, void*) {}, nullptr),
+              0);
+    SsdpCacheGetStats(&stats);
+    EXPECT_EQ(stats.misses, 2u);
+    EXPECT_EQ(stats.hits, 4u);
+
+    HandleLock();
+    ListDestroy(&hinfo.SsdpSearchList, 0);
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+    SsdpCacheGetStats(&stats);
+    EXPECT_EQ(stats.entries, 0u);
+}
+
+TEST_F(UpnpapiFTestSuite, ssdp_cache_evicts_entries_when_full) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    static std::atomic<int> alive_events;
+    alive_events = 0;
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    hinfo.Callback = [](Upnp_EventType EventType, const void*, void*) {
+        if (EventType == UPNP_DISCOVERY_ADVERTISEMENT_ALIVE)
+            alive_events++;
+        return 0;
+    };
+    ListInit(&hinfo.SsdpSearchList, nullptr, nullptr);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+    SsdpCacheClear();
+
+    // Advertisement of another device for each number. The first device
+    // expires first.
+    auto notify = [](int a_device) {
+        char uuid[40];
+        snprintf(uuid, sizeof(uuid), "f3a8c2b1-0d4e-4b2a-9c1d-1e2f3a4b%04x",
+                 a_device);
+        http_parser_t parser;
+        parser_request_init(&parser);
+        const std::string msg{
+            "NOTIFY * HTTP/1.1\r\n"
+            "HOST: 239.255.255.250:1900\r\n"
+            "CACHE-CONTROL: max-age=" +
+            std::to_string(1800 + a_device) +
+            "\r\n"
+            "LOCATION: http://192.168.99.5:50001/tvdevicedesc.xml\r\n"
+            "NT: upnp:rootdevice\r\n"
+            "NTS: ssdp:alive\r\n"
+            "USN: uuid:" +
+            std::string(uuid) +
+            "::upnp:rootdevice\r\n"
+            "CONTENT-LENGTH: 0\r\n"
+            "\r\n"};
+        ASSERT_EQ(membuffer_assign_str(&parser.msg.msg, msg.c_str()), 0);
+        ASSERT_EQ(parser_parse(&parser), PARSE_SUCCESS);
+        sockaddr_storage src{};
+        ssdp_handle_ctrlpt_msg(&parser.msg, &src, 0);
+        httpmsg_destroy(&parser.msg);
+    };
+
+    // Test Unit
+    for (int i{0}; i < SSDP_CACHE_MAX_ENTRIES + 2; i++)
+        notify(i);
+    EXPECT_EQ(alive_events, SSDP_CACHE_MAX_ENTRIES + 2);
+    SsdpCacheStats stats{};
+    SsdpCacheGetStats(&stats);
+    EXPECT_EQ(stats.entries, static_cast<size_t>(SSDP_CACHE_MAX_ENTRIES));
+    EXPECT_EQ(stats.evicted, 2u);
+
+    // The evicted device is new again, the last one is still cached.
+    notify(0);
+    EXPECT_EQ(alive_events, SSDP_CACHE_MAX_ENTRIES + 3);
+    notify(SSDP_CACHE_MAX_ENTRIES + 1);
+    EXPECT_EQ(alive_events, SSDP_CACHE_MAX_ENTRIES + 3);
+    SsdpCacheGetStats(&stats);
+    EXPECT_EQ(stats.entries, static_cast<size_t>(SSDP_CACHE_MAX_ENTRIES));
+    EXPECT_EQ(stats.evicted, 3u);
+
+    HandleLock();
+    ListDestroy(&hinfo.SsdpSearchList, 0);
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+
+#ifdef __linux__
+TEST(UpnpapiTestSuite, ssdp_filter_drops_other_datagrams) {
+    SOCKET rsock = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(rsock, INVALID_SOCKET);
+    ::sockaddr_in saddr{};
+    saddr.sin_family = AF_INET;
+    saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t saddr_len{sizeof(saddr)};
+    ASSERT_EQ(::bind(rsock, reinterpret_cast<sockaddr*>(&saddr), saddr_len),
+              0);
+    ASSERT_EQ(::getsockname(rsock, reinterpret_cast<sockaddr*>(&saddr),
+                            &saddr_len),
+              0);
+    SOCKET ssock = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(ssock, INVALID_SOCKET);
+
+    // Test Unit
+    ASSERT_EQ(SsdpAttachFilter(rsock), UPNP_E_SUCCESS);
+
+    for (const char* msg :
+         {"HTTP/1.1 200 OK\r\n\r\n", "NOTIFY * HTTP/1.1\r\n\r\n", "M-S",
+          "GET / HTTP/1.1\r\n\r\n", "M-SEARCH * HTTP/1.1\r\n\r\n"}) {
+        ASSERT_GT(::sendto(ssock, msg, strlen(msg), 0,
+                           reinterpret_cast<sockaddr*>(&saddr), saddr_len),
+                  0);
+    }
+    std::vector<std::string> received;
+    char buf[128];
+    while (true) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(rsock, &fds);
+        timeval tv{0, 100000};
+        if (::select(static_cast<int>(rsock) + 1, &fds, nullptr, nullptr,
+                     &tv) <= 0)
+            break;
+        SSIZEP_T len = ::recv(rsock, buf, sizeof(buf), 0);
+        ASSERT_GT(len, 0);
+        received.emplace_back(buf, static_cast<size_t>(len));
+    }
+    EXPECT_THAT(received, ElementsAre("NOTIFY * HTTP/1.1\r\n\r\n",
+                                      "M-SEARCH * HTTP/1.1\r\n\r\n"));
+
+    CLOSE_SOCKET_P(ssock);
+    CLOSE_SOCKET_P(rsock);
+}
+
+TEST(UpnpapiTestSuite, ssdp_sockets_on_additional_interfaces) {
+    const char* too_many[SSDP_MAX_INTERFACES + 1]{};
+    const char* empty_name[]{""};
+    const char* if_names[]{"lo"};
+
+    // Test Unit
+    EXPECT_EQ(UpnpSetSsdpInterfaces(nullptr, 1), UPNP_E_INVALID_PARAM);
+    EXPECT_EQ(UpnpSetSsdpInterfaces(too_many, SSDP_MAX_INTERFACES + 1),
+              UPNP_E_INVALID_PARAM);
+    EXPECT_EQ(UpnpSetSsdpInterfaces(empty_name, 1), UPNP_E_INVALID_INTERFACE);
+    ASSERT_EQ(UpnpSetSsdpInterfaces(if_names, 1), UPNP_E_SUCCESS);
+    ASSERT_EQ(UpnpSetSsdpFilter(1), UPNP_E_SUCCESS);
+
+    // Only the additional interface, no sockets on the primary interface.
+    strcpy(gIF_NAME, "eth0");
+    gIF_IPV4[0] = '\0';
+    gIF_IPV6[0] = '\0';
+    gIF_IPV6_ULA_GUA[0] = '\0';
+    MiniServerSockArray out{};
+    out.ssdpSock4 = INVALID_SOCKET;
+    out.ssdpSock6 = INVALID_SOCKET;
+    out.ssdpSock6UlaGua = INVALID_SOCKET;
+    for (SOCKET& sock : out.ssdpSockIf4)
+        sock = INVALID_SOCKET;
+    const int ret_get_ssdp_sockets = get_ssdp_sockets(&out);
+
+    EXPECT_EQ(UpnpSetSsdpInterfaces(nullptr, 0), UPNP_E_SUCCESS);
+    EXPECT_EQ(UpnpSetSsdpFilter(0), UPNP_E_SUCCESS);
+    ASSERT_EQ(ret_get_ssdp_sockets, UPNP_E_SUCCESS)
+        << errStrEx(ret_get_ssdp_sockets, UPNP_E_SUCCESS);
+    EXPECT_EQ(out.ssdpSock4, INVALID_SOCKET);
+    ASSERT_NE(out.ssdpSockIf4[0], INVALID_SOCKET);
+    EXPECT_EQ(out.ssdpSockIf4[1], INVALID_SOCKET);
+    // The address of the interface is noted for its location URL.
+    EXPECT_STREQ(out.ssdpIfIpv4[0], "127.0.0.1");
+
+    // The socket is bound to the SSDP port.
+    ::sockaddr_in saddr{};
+    socklen_t saddr_len{sizeof(saddr)};
+    ASSERT_EQ(::getsockname(out.ssdpSockIf4[0],
+                            reinterpret_cast<sockaddr*>(&saddr), &saddr_len),
+              0);
+    EXPECT_EQ(ntohs(saddr.sin_port), SSDP_PORT);
+    int multicast_all{1};
+    socklen_t optlen{sizeof(multicast_all)};
+    ASSERT_EQ(::getsockopt(out.ssdpSockIf4[0], IPPROTO_IP, IP_MULTICAST_ALL,
+                           &multicast_all, &optlen),
+              0);
+    EXPECT_EQ(multicast_all, 0);
+    // The filter is attached, SO_GET_FILTER returns its number of
+    // instructions.
+    socklen_t filter_len{0};
+    ASSERT_EQ(::getsockopt(out.ssdpSockIf4[0], SOL_SOCKET, SO_GET_FILTER,
+                           nullptr, &filter_len),
+              0);
+    EXPECT_EQ(filter_len, 5u);
+
+    CLOSE_SOCKET_P(out.ssdpSockIf4[0]);
+#ifdef COMPA_HAVE_CTRLPT_SSDP
+    CLOSE_SOCKET_P(out.ssdpReqSock4);
+    CLOSE_SOCKET_P(out.ssdpReqSock6);
+#endif
+}
+#endif // __linux__
+#endif
+
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(COMPA_HAVE_DEVICE_SSDP)
+TEST_F(UpnpapiFTestSuite, address_change_moves_description_urls) {
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo1{};
+    hinfo1.HType = HND_DEVICE;
+    strcpy(hinfo1.DescURL, "http://192.168.99.3:50001/tvdevicedesc.xml");
+    strcpy(hinfo1.LowerDescURL, "http://[2001:db8::3]:50002/tvdevicedesc.xml");
+    Handle_Info hinfo2{};
+    hinfo2.HType = HND_DEVICE;
+    strcpy(hinfo2.DescURL, "http://tvdevice.local:50001/tvdevicedesc.xml");
+    strcpy(hinfo2.LowerDescURL, "http://192.168.99.30/tvdevicedesc.xml");
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo1;
+    HandleTable[2] = &hinfo2;
+    HandleUnlock();
+
+    // The interface got new addresses.
+    strcpy(gIF_IPV4, "192.168.99.4");
+    gIF_IPV6[0] = '\0';
+    strcpy(gIF_IPV6_ULA_GUA, "2001:db8::4");
+
+    // Test Unit
+    UpdateDescURLs("192.168.99.3", "fe80::3", "2001:db8::3");
+
+    // The locations published by SSDP use the new addresses.
+    EXPECT_STREQ(hinfo1.DescURL, "http://192.168.99.4:50001/tvdevicedesc.xml");
+    EXPECT_STREQ(hinfo1.LowerDescURL,
+                 "http://[2001:db8::4]:50002/tvdevicedesc.xml");
+    // Other hosts are not modified.
+    EXPECT_STREQ(hinfo2.DescURL,
+                 "http://tvdevice.local:50001/tvdevicedesc.xml");
+    EXPECT_STREQ(hinfo2.LowerDescURL, "http://192.168.99.30/tvdevicedesc.xml");
+
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleTable[2] = nullptr;
+    HandleUnlock();
+    gIF_IPV4[0] = '\0';
+    gIF_IPV6_ULA_GUA[0] = '\0';
+}
+
+TEST_F(UpnpapiFTestSuite, ssdp_search_replies_are_limited) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_DEVICE;
+    hinfo.DeviceAf = AF_INET;
+    hinfo.MaxAge = 100;
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    UpnpSdkDeviceRegisteredV4 = 1;
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+    SsdpSearchLimitClear();
+
+    http_parser_t parser;
+    parser_request_init(&parser);
+    const std::string msearch{"M-SEARCH * HTTP/1.1\r\n"
+                              "HOST: 239.255.255.250:1900\r\n"
+                              "MAN: \"ssdp:discover\"\r\n"
+                              "MX: 120\r\n"
+                              "ST: ssdp:all\r\n\r\n"};
+    ASSERT_EQ(parser_append(&parser, msearch.data(), msearch.size()),
+              PARSE_SUCCESS);
+    auto source = [](const char* a_addr) {
+        sockaddr_storage ss{};
+        sockaddr_in* sa4 = reinterpret_cast<sockaddr_in*>(&ss);
+        sa4->sin_family = AF_INET;
+        sa4->sin_port = htons(50000);
+        inet_pton(AF_INET, a_addr, &sa4->sin_addr);
+        return ss;
+    };
+    // The replies must not be sent while testing. MX 120 gives a reply time
+    // of rand() % 108 seconds.
+    unsigned int seed{1};
+    for (;; seed++) {
+        srand(seed);
+        if (rand() % 108 > 1 && rand() % 108 > 1)
+            break;
+    }
+    srand(seed);
+
+    // Test Unit
+    EXPECT_EQ(SsdpSetSearchLimit(0.001, 0, 2), UPNP_E_INVALID_PARAM);
+    ASSERT_EQ(SsdpSetSearchLimit(0.001, 3, 2), UPNP_E_SUCCESS);
+    sockaddr_storage saddr{source("192.168.1.10")};
+    for (int i{0}; i < 5; i++)
+        ssdp_handle_device_request(&parser.msg, &saddr);
+    SsdpSearchStats stats;
+    SsdpGetSearchStats(&stats);
+    EXPECT_EQ(stats.received, 5u);
+    EXPECT_EQ(stats.merged, 2u);
+    EXPECT_EQ(stats.dropped_rate, 2u);
+    EXPECT_EQ(stats.pending, 1u);
+
+    // Another source gets its own bucket, but only two replies are pending.
+    saddr = source("192.168.1.11");
+    ssdp_handle_device_request(&parser.msg, &saddr);
+    saddr = source("192.168.1.12");
+    ssdp_handle_device_request(&parser.msg, &saddr);
+    SsdpGetSearchStats(&stats);
+    EXPECT_EQ(stats.received, 7u);
+    EXPECT_EQ(stats.dropped_queue, 1u);
+    EXPECT_EQ(stats.pending, 2u);
+
+    httpmsg_destroy(&parser.msg);
+    EXPECT_EQ(SsdpSetSearchLimit(SSDP_SEARCH_RATE, SSDP_SEARCH_BURST,
+                                 SSDP_MAX_PENDING_REPLIES),
+              UPNP_E_SUCCESS);
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+    UpnpSdkDeviceRegisteredV4 = 0;
+
+    // Shutdown of the timer thread frees the scheduled replies.
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+    SsdpGetSearchStats(&stats);
+    EXPECT_EQ(stats.pending, 0u);
+    EXPECT_EQ(stats.received, 0u);
+}
+
+TEST_F(UpnpapiFTestSuite, ssdp_reply_has_location_on_additional_interface) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    IXML_Document* desc_doc{nullptr};
+    ASSERT_EQ(ixmlParseBufferEx(
+                  "<root><device>"
+                  "<deviceType>urn:schemas-upnp-org:device:Basic:1</deviceType>"
+                  "<UDN>uuid:ssdp-if-test</UDN>"
+                  "</device></root>",
+                  &desc_doc),
+              IXML_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_DEVICE;
+    hinfo.DeviceAf = AF_INET;
+    hinfo.MaxAge = 100;
+    hinfo.DeviceList = ixmlDocument_getElementsByTagName(desc_doc, "device");
+    strcpy(hinfo.DescURL, "http://192.168.99.4:50001/desc.xml");
+    strcpy(hinfo.LowerDescURL, hinfo.DescURL);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    strcpy(gIF_IPV4, "192.168.99.4");
+
+    // The reply is sent on loopback to a socket like the one of a control
+    // point.
+    SSockaddr saObj;
+    saObj = "127.0.0.1:0";
+    SOCKET rx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(rx, INVALID_SOCKET);
+    ASSERT_EQ(::bind(rx, &saObj.sa, sizeof(saObj.sin)), 0);
+    socklen_t len{sizeof(saObj.ss)};
+    ASSERT_EQ(::getsockname(rx, &saObj.sa, &len), 0);
+    ::timeval timeout{2, 0};
+    ::setsockopt(rx, SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+    auto reply = [rx] {
+        char buf[BUFSIZE]{};
+        return ::recv(rx, buf, sizeof(buf) - 1, 0) > 0 ? std::string(buf)
+                                                       : std::string();
+    };
+
+    // Test Unit
+    EXPECT_EQ(AdvertiseAndReply(0, 1, SSDP_ROOTDEVICE, &saObj.sa, nullptr,
+                                nullptr, nullptr, 100, "10.0.9.1"),
+              UPNP_E_SUCCESS);
+    EXPECT_THAT(reply(),
+                HasSubstr("LOCATION: http://10.0.9.1:50001/desc.xml\r\n"));
+
+    // The interface given to UpnpInit2() keeps the description URL.
+    EXPECT_EQ(AdvertiseAndReply(0, 1, SSDP_ROOTDEVICE, &saObj.sa, nullptr,
+                                nullptr, nullptr, 100),
+              UPNP_E_SUCCESS);
+    EXPECT_THAT(reply(),
+                HasSubstr("LOCATION: http://192.168.99.4:50001/desc.xml\r\n"));
+
+    // A description URL on another host is not changed.
+    strcpy(hinfo.DescURL, "http://192.168.99.7:8080/desc.xml");
+    EXPECT_EQ(AdvertiseAndReply(0, 1, SSDP_ROOTDEVICE, &saObj.sa, nullptr,
+                                nullptr, nullptr, 100, "10.0.9.1"),
+              UPNP_E_SUCCESS);
+    EXPECT_THAT(reply(),
+                HasSubstr("LOCATION: http://192.168.99.7:8080/desc.xml\r\n"));
+
+    sock_close(rx);
+    gIF_IPV4[0] = '\0';
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+    ixmlNodeList_free(hinfo.DeviceList);
+    ixmlDocument_free(desc_doc);
+}
+#endif
+
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+TEST_F(UpnpapiFTestSuite, download_xml_docs_once_per_unique_url) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    struct Result {
+        std::mutex mutex;
+        std::vector<std::string> urls;
+        int docs{};
+    } result;
+    auto callback = [](const char* url, int errCode, IXML_Document* xmlDoc,
+                       void* cookie) {
+        // Nothing listens on port 1 so every download fails.
+        EXPECT_NE(errCode, UPNP_E_SUCCESS);
+        auto res = static_cast<Result*>(cookie);
+        std::scoped_lock lock(res->mutex);
+        res->urls.emplace_back(url);
+        if (xmlDoc != nullptr)
+            res->docs++;
+    };
+    const char* urls[]{"http://127.0.0.1:1/desc.xml",
+                       "http://127.0.0.1:1/other.xml",
+                       "http://127.0.0.1:1/desc.xml"};
+
+    // Test Unit
+    EXPECT_EQ(UpnpDownloadXmlDocs(urls, 3, 0, callback, &result),
+              UPNP_E_INVALID_PARAM);
+    EXPECT_EQ(UpnpDownloadXmlDocs(urls, 3, 2, nullptr, &result),
+              UPNP_E_INVALID_PARAM);
+    EXPECT_EQ(UpnpDownloadXmlDocs(urls, 3, 2, callback, &result),
+              UPNP_E_SUCCESS);
+
+    for (int i{0}; i < 200; i++) {
+        {
+            std::scoped_lock lock(result.mutex);
+            if (result.urls.size() >= 2)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+
+    std::sort(result.urls.begin(), result.urls.end());
+    EXPECT_THAT(result.urls, ElementsAre("http://127.0.0.1:1/desc.xml",
+                                         "http://127.0.0.1:1/other.xml"));
+    EXPECT_EQ(result.docs, 0);
+    EXPECT_EQ(UpnpDownloadXmlDocs(urls, 3, 2, callback, &result),
+              UPNP_E_FINISH);
+}
+#endif
+
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// Counts the allocations of all threads that go to the operating system.
+class CCountMallocs : public umock::StdlibInterface {
+  public:
+    std::atomic<size_t> allocs{};
+    void* malloc(size_t size) override {
+        allocs++;
+        return ::malloc(size);
+    }
+    void* calloc(size_t nmemb, size_t size) override {
+        allocs++;
+        return ::calloc(nmemb, size);
+    }
+    void* realloc(void* ptr, size_t size) override {
+        allocs++;
+        return ::realloc(ptr, size);
+    }
+    void free(void* ptr) override { ::free(ptr); }
+};
+
+#if defined(COMPA_HAVE_CTRLPT_SSDP) || defined(COMPA_HAVE_DEVICE_SSDP)
+TEST(DISABLED_UpnpapiBenchSuite, ssdp_datagram_load) {
+    constexpr int datagrams{20000};
+    constexpr char msearch[]{"M-SEARCH * HTTP/1.1\r\n"
+                             "HOST: 239.255.255.250:1900\r\n"
+                             "MAN: \"ssdp:discover\"\r\n"
+                             "MX: 1\r\n"
+                             "ST: ssdp:all\r\n\r\n"};
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool, gIoThreadCpu),
+              UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    // Datagrams are sent on loopback to a socket like the SSDP socket.
+    SSockaddr saObj;
+    saObj = "127.0.0.1:0";
+    SOCKET rx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(rx, INVALID_SOCKET);
+    ASSERT_EQ(::bind(rx, &saObj.sa, sizeof(saObj.sin)), 0);
+    socklen_t len{sizeof(saObj.ss)};
+    ASSERT_EQ(::getsockname(rx, &saObj.sa, &len), 0);
+    SOCKET tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    ASSERT_NE(tx, INVALID_SOCKET);
+
+    CCountMallocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+    std::chrono::nanoseconds reading{};
+    for (int i{0}; i < datagrams; i++) {
+        ASSERT_EQ(::sendto(tx, msearch, sizeof(msearch) - 1, 0, &saObj.sa,
+                           sizeof(saObj.sin)),
+                  static_cast<ssize_t>(sizeof(msearch) - 1));
+        auto start = std::chrono::steady_clock::now();
+        readFromSSDPSocket(rx);
+        reading += std::chrono::steady_clock::now() - start;
+    }
+    sock_close(tx);
+    sock_close(rx);
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+
+    std::cout << "[ BENCH    ] " << datagrams << " SSDP datagrams, "
+              << static_cast<double>(countObj.allocs) / datagrams
+              << " slab allocations per datagram, "
+              << reading.count() / datagrams << " ns per datagram.\n";
+}
+#endif
+#endif
+
+
+#if !defined(UPNPLIB_WITH_NATIVE_PUPNP) && defined(COMPA_HAVE_CTRLPT_SOAP)
+// SOAP server on the loopback interface. It holds all connections until no
+// new one comes in, then answers them together. So it sees how many actions
+// are in flight at the same time. With a_immediate it answers each request at
+// once.
+class CSoapServer {
+  public:
+    CSoapServer(bool a_immediate = false) : m_immediate(a_immediate) {
+        m_listen_sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t saddr_len{sizeof(saddr)};
+        if (m_listen_sock == INVALID_SOCKET ||
+            ::bind(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                   saddr_len) != 0 ||
+            ::listen(m_listen_sock, SOMAXCONN) != 0 ||
+            ::getsockname(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                          &saddr_len) != 0) {
+            CLOSE_SOCKET_P(m_listen_sock);
+            throw std::runtime_error("Failed to listen on loopback.");
+        }
+        m_port = ntohs(saddr.sin_port);
+        m_thread = std::thread(&CSoapServer::run, this);
+    }
+    ~CSoapServer() {
+        m_stop = true;
+        m_thread.join();
+        CLOSE_SOCKET_P(m_listen_sock);
+    }
+    std::string get_url() const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + "/control";
+    }
+    // Maximal number of connections that were open at the same time.
+    int max_open() const { return m_max_open; }
+    // The last request that was received.
+    std::string last_request() {
+        std::scoped_lock lock(m_mutex);
+        return m_last_request;
+    }
+    // Set the status and the SOAP envelope of the next responses.
+    void set_response(const std::string& a_status, const std::string& a_body) {
+        std::scoped_lock lock(m_mutex);
+        m_status = a_status;
+        m_body = a_body;
+    }
+
+  private:
+    void run() {
+        std::vector<SOCKET> open;
+        while (!m_stop) {
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET(m_listen_sock, &fds);
+            timeval tv{0, 100000};
+            if (::select(static_cast<int>(m_listen_sock) + 1, &fds, nullptr,
+                         nullptr, &tv) > 0) {
+                SOCKET sockfd = ::accept(m_listen_sock, nullptr, nullptr);
+                if (sockfd == INVALID_SOCKET)
+                    continue;
+                read_request(sockfd);
+                if (m_immediate) {
+                    send_response(sockfd);
+                    continue;
+                }
+                open.push_back(sockfd);
+                m_max_open = std::max(m_max_open.load(),
+                                      static_cast<int>(open.size()));
+                continue;
+            }
+            // No new connection within the timeout.
+            for (SOCKET sockfd : open)
+                send_response(sockfd);
+            open.clear();
+        }
+        for (SOCKET sockfd : open)
+            CLOSE_SOCKET_P(sockfd);
+    }
+    // Send the response to GetVolume and close the connection.
+    void send_response(SOCKET a_sockfd) {
+        std::string response;
+        {
+            std::scoped_lock lock(m_mutex);
+            response = "HTTP/1.1 " + m_status +
+                       "\r\n"
+                       "CONTENT-TYPE: text/xml; charset=\"utf-8\"\r\n"
+                       "CONTENT-LENGTH: " +
+                       std::to_string(m_body.size()) + "\r\n\r\n" + m_body;
+        }
+        ::send(a_sockfd, response.data(), response.size(), 0);
+        CLOSE_SOCKET_P(a_sockfd);
+    }
+    // Read the request header and its entity.
+    void read_request(SOCKET a_sockfd) {
+        std::string request;
+        char buf[1024];
+        size_t header_end{std::string::npos};
+        size_t content_length{};
+        while (header_end == std::string::npos ||
+               request.size() < header_end + 4 + content_length) {
+            SSIZEP_T len = ::recv(a_sockfd, buf, sizeof(buf), 0);
+            if (len <= 0)
+                return;
+            request.append(buf, static_cast<size_t>(len));
+            if (header_end == std::string::npos) {
+                header_end = request.find("\r\n\r\n");
+                const size_t pos = request.find("CONTENT-LENGTH: ");
+                if (pos != std::string::npos)
+                    content_length = std::stoul(request.substr(pos + 16));
+            }
+        }
+        std::scoped_lock lock(m_mutex);
+        m_last_request = request;
+    }
+
+    SOCKET m_listen_sock{INVALID_SOCKET};
+    in_port_t m_port{};
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<int> m_max_open{0};
+    const bool m_immediate;
+    std::mutex m_mutex;
+    std::string m_last_request;
+    std::string m_status{"200 OK"};
+    std::string m_body{
+        "<s:Envelope "
+        "xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\">"
+        "<s:Body><u:GetVolumeResponse "
+        "xmlns:u=\"urn:schemas-upnp-org:service:"
+        "RenderingControl:1\"><CurrentVolume>7</CurrentVolume>"
+        "</u:GetVolumeResponse></s:Body></s:Envelope>"};
+};
+
+TEST_F(UpnpapiFTestSuite, send_action_non_blocking_limits_actions_per_device) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    struct Result {
+        std::atomic<int> completed{};
+        std::atomic<int> succeeded{};
+    } result;
+    auto callback = [](Upnp_EventType EventType, const void* Event,
+                       void* Cookie) {
+        auto res = static_cast<Result*>(Cookie);
+        const UpnpActionComplete* evt =
+            static_cast<const UpnpActionComplete*>(Event);
+        if (EventType == UPNP_CONTROL_ACTION_COMPLETE &&
+            UpnpActionComplete_get_ErrCode(evt) == UPNP_E_SUCCESS &&
+            UpnpActionComplete_get_ActionResult(evt) != nullptr)
+            res->succeeded++;
+        res->completed++;
+        return 0;
+    };
+    constexpr char service_type[]{
+        "urn:schemas-upnp-org:service:RenderingControl:1"};
+    IXML_Document* action = ixmlParseBuffer(
+        "<u:GetVolume xmlns:u=\"urn:schemas-upnp-org:service:"
+        "RenderingControl:1\"><InstanceID>0</InstanceID></u:GetVolume>");
+    ASSERT_NE(action, nullptr);
+
+    {
+        CSoapServer server;
+        const std::string url{server.get_url()};
+        constexpr int actions{10};
+
+        // Test Unit
+        EXPECT_EQ(UpnpSetActionWindow(0, 10), UPNP_E_INVALID_PARAM);
+        EXPECT_EQ(UpnpSetActionWindow(2, 100), UPNP_E_SUCCESS);
+        EXPECT_EQ(UpnpSendActionNonBlocking(2, url.c_str(), service_type,
+                                            nullptr, action, callback, &result),
+                  UPNP_E_INVALID_HANDLE);
+        for (int i{0}; i < actions; i++)
+            ASSERT_EQ(UpnpSendActionNonBlocking(1, url.c_str(), service_type,
+                                                nullptr, action, callback,
+                                                &result),
+                      UPNP_E_SUCCESS);
+
+        for (int i{0}; result.completed < actions && i < 500; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        EXPECT_EQ(result.completed, actions);
+        EXPECT_EQ(result.succeeded, actions);
+        EXPECT_EQ(server.max_open(), 2);
+    }
+
+    // Nothing listens on port 1.
+    result.completed = 0;
+    EXPECT_EQ(UpnpSendActionNonBlocking(1, "http://127.0.0.1:1/control",
+                                        service_type, nullptr, action, callback,
+                                        &result),
+              UPNP_E_SUCCESS);
+    for (int i{0}; result.completed < 1 && i < 500; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(result.completed, 1);
+
+    ixmlDocument_free(action);
+    EXPECT_EQ(UpnpSetActionWindow(SOAP_ACTION_MAX_PER_DEVICE,
+                                  SOAP_ACTION_MAX_IN_FLIGHT),
+              UPNP_E_SUCCESS);
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+
+TEST_F(UpnpapiFTestSuite, send_action_template_fills_in_argument_values) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    CSoapServer server(true);
+    const std::string url{server.get_url()};
+    const char* arg_names[]{"InstanceID", "Channel"};
+    UpnpActionTemplate* tmpl{nullptr};
+
+    // Test Unit
+    EXPECT_EQ(UpnpActionTemplate_new(url.c_str(),
+                                     "urn:schemas-upnp-org:service:"
+                                     "RenderingControl:1",
+                                     "GetVolume", nullptr, 2, &tmpl),
+              UPNP_E_INVALID_PARAM);
+    ASSERT_EQ(UpnpActionTemplate_new(url.c_str(),
+                                     "urn:schemas-upnp-org:service:"
+                                     "RenderingControl:1",
+                                     "GetVolume", arg_names, 2, &tmpl),
+              UPNP_E_SUCCESS);
+    ASSERT_NE(tmpl, nullptr);
+
+    const char* arg_values[]{"0", "a&b<c>"};
+    IXML_Document* resp{nullptr};
+    EXPECT_EQ(UpnpSendActionTemplate(2, tmpl, arg_values, &resp),
+              UPNP_E_INVALID_HANDLE);
+    const char* null_values[]{"0", nullptr};
+    EXPECT_EQ(UpnpSendActionTemplate(1, tmpl, null_values, &resp),
+              UPNP_E_INVALID_PARAM);
+    ASSERT_EQ(UpnpSendActionTemplate(1, tmpl, arg_values, &resp),
+              UPNP_E_SUCCESS);
+    ASSERT_NE(resp, nullptr);
+    DOMString resp_str = ixmlPrintNode(reinterpret_cast<IXML_Node*>(resp));
+    EXPECT_THAT(resp_str, HasSubstr("<CurrentVolume>7</CurrentVolume>"));
+    ixmlFreeDOMString(resp_str);
+    ixmlDocument_free(resp);
+
+    const std::string request{server.last_request()};
+    EXPECT_THAT(request, StartsWith("POST /control HTTP/1.1\r\n"));
+    EXPECT_THAT(request, HasSubstr("SOAPACTION: \"urn:schemas-upnp-org:"
+                                   "service:RenderingControl:1#GetVolume\""));
+    EXPECT_THAT(request, HasSubstr("<InstanceID>0</InstanceID>\r\n"
+                                   "<Channel>a&amp;b&lt;c&gt;</Channel>"));
+    const size_t header_end{request.find("\r\n\r\n")};
+    ASSERT_NE(header_end, std::string::npos);
+    EXPECT_THAT(request, HasSubstr("CONTENT-LENGTH: " +
+                                   std::to_string(request.size() -
+                                                  header_end - 4) +
+                                   "\r\n"));
+
+    struct Result {
+        std::atomic<int> completed{};
+        std::atomic<int> succeeded{};
+    } result;
+    auto callback = [](Upnp_EventType EventType, const void* Event,
+                       void* Cookie) {
+        auto res = static_cast<Result*>(Cookie);
+        const UpnpActionComplete* evt =
+            static_cast<const UpnpActionComplete*>(Event);
+        if (EventType == UPNP_CONTROL_ACTION_COMPLETE &&
+            UpnpActionComplete_get_ErrCode(evt) == UPNP_E_SUCCESS &&
+            UpnpActionComplete_get_ActionResult(evt) != nullptr)
+            res->succeeded++;
+        res->completed++;
+        return 0;
+    };
+    EXPECT_EQ(UpnpSendActionTemplateNonBlocking(1, tmpl, arg_values, callback,
+                                                &result),
+              UPNP_E_SUCCESS);
+    for (int i{0}; result.completed < 1 && i < 500; i++)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(result.completed, 1);
+    EXPECT_EQ(result.succeeded, 1);
+
+    UpnpActionTemplate_delete(tmpl);
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+
+TEST_F(UpnpapiFTestSuite, send_action_template_values_without_dom) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    CSoapServer server(true);
+    const std::string url{server.get_url()};
+    const char* arg_names[]{"InstanceID", "Channel"};
+    const char* arg_values[]{"0", "Master"};
+    UpnpActionTemplate* tmpl{nullptr};
+    ASSERT_EQ(UpnpActionTemplate_new(url.c_str(),
+                                     "urn:schemas-upnp-org:service:"
+                                     "RenderingControl:1",
+                                     "GetVolume", arg_names, 2, &tmpl),
+              UPNP_E_SUCCESS);
+    const char* resp_names[]{"CurrentVolume", "Unknown"};
+    char* resp_values[2]{};
+    const std::string envelope_start{
+        "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\">"
+        "<s:Body>"};
+
+    // Test Unit
+    EXPECT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, nullptr, 2,
+                                           resp_values),
+              UPNP_E_INVALID_PARAM);
+    ASSERT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, resp_names, 2,
+                                           resp_values),
+              UPNP_E_SUCCESS);
+    EXPECT_STREQ(resp_values[0], "7");
+    EXPECT_EQ(resp_values[1], nullptr);
+    free(resp_values[0]);
+
+    // Entities, empty elements and an XML declaration.
+    server.set_response(
+        "200 OK", "<?xml version=\"1.0\"?>\r\n" + envelope_start +
+                      "<u:GetVolumeResponse xmlns:u=\"urn:schemas-upnp-org:"
+                      "service:RenderingControl:1\">\r\n"
+                      "<Other attr=\"a>b\">1</Other>\r\n"
+                      "<CurrentVolume>a&amp;b&lt;&#65;&#xe9;</CurrentVolume>"
+                      "<Unknown/></u:GetVolumeResponse></s:Body></s:Envelope>");
+    ASSERT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, resp_names, 2,
+                                           resp_values),
+              UPNP_E_SUCCESS);
+    EXPECT_STREQ(resp_values[0], "a&b<A\xc3\xa9");
+    EXPECT_STREQ(resp_values[1], "");
+    free(resp_values[0]);
+    free(resp_values[1]);
+
+    // Prefixed elements are matched on their local names.
+    server.set_response(
+        "200 OK", envelope_start +
+                      "<u:GetVolumeResponse xmlns:u=\"urn:schemas-upnp-org:"
+                      "service:RenderingControl:1\">"
+                      "<u:CurrentVolume>5</u:CurrentVolume>"
+                      "</u:GetVolumeResponse></s:Body></s:Envelope>");
+    ASSERT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, resp_names, 2,
+                                           resp_values),
+              UPNP_E_SUCCESS);
+    EXPECT_STREQ(resp_values[0], "5");
+    EXPECT_EQ(resp_values[1], nullptr);
+    free(resp_values[0]);
+
+    // A SOAP header needs the DOM.
+    server.set_response(
+        "200 OK",
+        "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\">"
+        "<s:Header/><s:Body><u:GetVolumeResponse xmlns:u=\"urn:"
+        "schemas-upnp-org:service:RenderingControl:1\">"
+        "<CurrentVolume>9</CurrentVolume>"
+        "</u:GetVolumeResponse></s:Body></s:Envelope>");
+    ASSERT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, resp_names, 2,
+                                           resp_values),
+              UPNP_E_SUCCESS);
+    EXPECT_STREQ(resp_values[0], "9");
+    EXPECT_EQ(resp_values[1], nullptr);
+    free(resp_values[0]);
+
+    // A fault returns the UPnP error code.
+    server.set_response(
+        "500 Internal Server Error",
+        envelope_start +
+            "<s:Fault><faultcode>s:Client</faultcode>"
+            "<faultstring>UPnPError</faultstring><detail>"
+            "<UPnPError xmlns=\"urn:schemas-upnp-org:control-1-0\">"
+            "<errorCode>402</errorCode>"
+            "<errorDescription>Invalid Args</errorDescription>"
+            "</UPnPError></detail></s:Fault></s:Body></s:Envelope>");
+    EXPECT_EQ(UpnpSendActionTemplateValues(1, tmpl, arg_values, resp_names, 2,
+                                           resp_values),
+              402);
+    EXPECT_EQ(resp_values[0], nullptr);
+    EXPECT_EQ(resp_values[1], nullptr);
+
+    UpnpActionTemplate_delete(tmpl);
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+
+TEST(DISABLED_UpnpapiBenchSuite, send_action_template_vs_dom) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    Handle_Info hinfo{};
+    hinfo.HType = HND_CLIENT;
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleTable[1] = &hinfo;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    CSoapServer server(true);
+    const std::string url{server.get_url()};
+    constexpr char service_type[]{
+        "urn:schemas-upnp-org:service:RenderingControl:1"};
+    constexpr int actions{2000};
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i{0}; i < actions; i++) {
+        IXML_Document* action{nullptr};
+        ASSERT_EQ(UpnpAddToAction(&action, "GetVolume", service_type,
+                                  "InstanceID", "0"),
+                  UPNP_E_SUCCESS);
+        ASSERT_EQ(UpnpAddToAction(&action, "GetVolume", service_type,
+                                  "Channel", "Master"),
+                  UPNP_E_SUCCESS);
+        IXML_Document* resp{nullptr};
+        ASSERT_EQ(UpnpSendAction(1, url.c_str(), service_type, nullptr,
+                                 action, &resp),
+                  UPNP_E_SUCCESS);
+        ixmlDocument_free(resp);
+        ixmlDocument_free(action);
+    }
+    auto dom_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                      std::chrono::steady_clock::now() - start)
+                      .count();
+
+    const char* arg_names[]{"InstanceID", "Channel"};
+    const char* arg_values[]{"0", "Master"};
+    UpnpActionTemplate* tmpl{nullptr};
+    ASSERT_EQ(UpnpActionTemplate_new(url.c_str(), service_type, "GetVolume",
+                                     arg_names, 2, &tmpl),
+              UPNP_E_SUCCESS);
+    start = std::chrono::steady_clock::now();
+    for (int i{0}; i < actions; i++) {
+        IXML_Document* resp{nullptr};
+        ASSERT_EQ(UpnpSendActionTemplate(1, tmpl, arg_values, &resp),
+                  UPNP_E_SUCCESS);
+        ixmlDocument_free(resp);
+    }
+    auto tmpl_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+    UpnpActionTemplate_delete(tmpl);
+
+    std::cout << "[ BENCH    ] UpnpSendAction: "
+              << actions * 1000000LL / std::max<long long>(dom_us, 1)
+              << " actions/s, UpnpSendActionTemplate: "
+              << actions * 1000000LL / std::max<long long>(tmpl_us, 1)
+              << " actions/s.\n";
+
+    HandleLock();
+    HandleTable[1] = nullptr;
+    HandleUnlock();
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+#endif
+
 #if 0
 
 TEST_F(UpnpapiFTestSuite, get_free_handle_successful) {
@@ -0,0 +1,136 @@
+// Copyright (C) 2026+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
+
+#include <Compa/src/gena/gena_ctrlpt.cpp>
+
+#include <upnplib/global.hpp>
+
+#include <utest/utest.hpp>
+
+
+namespace utest {
+
+// Automatic renewals of subscriptions
+// ===================================
+TEST(GenaCtrlptTestSuite, renew_host_from_publisher_url) {
+    EXPECT_EQ(renew_host("http://192.168.1.2:49152/event"),
+              "192.168.1.2:49152");
+    EXPECT_EQ(renew_host("http://[fe80::1]:49152/a/b"), "[fe80::1]:49152");
+    EXPECT_EQ(renew_host("192.168.1.2:49152"), "192.168.1.2:49152");
+    EXPECT_EQ(renew_host(nullptr), "");
+}
+
+TEST(GenaCtrlptTestSuite, renewals_of_a_host_form_a_batch) {
+    constexpr time_t now{1700000000};
+
+    // Test Unit
+    const time_t renew_at =
+        renew_time("http://192.168.1.2:49152/event1", 1800, now);
+    EXPECT_EQ(renew_time("http://192.168.1.2:49152/event2", 1800, now),
+              renew_at);
+    EXPECT_EQ(renew_at % AUTO_RENEW_BATCH_WINDOW, 0);
+    // A subscription made a second later joins the batch or the next one.
+    const time_t later_at =
+        renew_time("http://192.168.1.2:49152/event3", 1800, now + 1);
+    EXPECT_TRUE(later_at == renew_at ||
+                later_at == renew_at + AUTO_RENEW_BATCH_WINDOW);
+}
+
+TEST(GenaCtrlptTestSuite, renewal_jitter_is_bounded) {
+    constexpr time_t now{1700000000};
+
+    // Test Unit
+    for (int timeout : {AUTO_RENEW_TIME + 1, AUTO_RENEW_TIME + 20, 300, 1800}) {
+        const time_t delay{timeout - AUTO_RENEW_TIME};
+        const time_t max_jitter{std::min<time_t>(AUTO_RENEW_JITTER, delay / 4)};
+        for (int i{0}; i < 64; i++) {
+            const std::string url{"http://192.168.1." + std::to_string(i) +
+                                  ":49152/event"};
+            const time_t renew_at = renew_time(url.c_str(), timeout, now);
+            // Never after the subscription is renewed without jitter and
+            // never before now.
+            EXPECT_LE(renew_at, std::max(now + delay, now + 1)) << url;
+            EXPECT_GT(renew_at, now) << url;
+            EXPECT_GE(renew_at,
+                      now + delay - max_jitter - (AUTO_RENEW_BATCH_WINDOW - 1))
+                << url;
+        }
+    }
+}
+
+TEST(GenaCtrlptTestSuite, renewal_of_short_timeout_from_device) {
+    constexpr time_t now{1700000000};
+
+    // Test Unit
+    // The device may answer with a time out shorter than AUTO_RENEW_TIME.
+    for (int timeout{0}; timeout <= AUTO_RENEW_TIME + 4; timeout++) {
+        const time_t renew_at =
+            renew_time("http://192.168.1.2:49152/event", timeout, now);
+        EXPECT_GT(renew_at, now) << "timeout " << timeout;
+        EXPECT_LE(renew_at, now + std::max(timeout - AUTO_RENEW_TIME, 1))
+            << "timeout " << timeout;
+    }
+}
+
+TEST(GenaCtrlptTestSuite, cancel_renewal_while_its_batch_is_pending) {
+    ASSERT_EQ(ThreadPoolInit(&gSendThreadPool, nullptr), 0);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), 0);
+
+    GenlibClientSubscription* sub1 = GenlibClientSubscription_new();
+    GenlibClientSubscription* sub2 = GenlibClientSubscription_new();
+    GenlibClientSubscription_strcpy_EventURL(sub1,
+                                             "http://192.168.1.2:49152/event1");
+    GenlibClientSubscription_strcpy_EventURL(sub2,
+                                             "http://192.168.1.2:49152/event2");
+
+    // Test Unit
+    ASSERT_EQ(ScheduleGenaAutoRenew(1, 1800, sub1), GENA_SUCCESS);
+    ASSERT_EQ(ScheduleGenaAutoRenew(1, 1800, sub2), GENA_SUCCESS);
+    const int id1 = GenlibClientSubscription_get_RenewEventId(sub1);
+    const int id2 = GenlibClientSubscription_get_RenewEventId(sub2);
+    EXPECT_NE(id1, id2);
+
+    // Cancelling one renewal of the batch does not touch the other one.
+    ThreadPoolJob job1;
+    ASSERT_EQ(TimerThreadRemove(&gTimerThread, id1, &job1), 0);
+    EXPECT_NE(TimerThreadRemove(&gTimerThread, id1, &job1), 0);
+    ThreadPoolJob job2;
+    ASSERT_EQ(TimerThreadRemove(&gTimerThread, id2, &job2), 0);
+    EXPECT_EQ(static_cast<job_arg*>(job1.arg)->renewAt,
+              static_cast<job_arg*>(job2.arg)->renewAt);
+    job1.free_func(job1.arg);
+    job2.free_func(job2.arg);
+
+    GenlibClientSubscription_delete(sub2);
+    GenlibClientSubscription_delete(sub1);
+    EXPECT_EQ(TimerThreadShutdown(&gTimerThread), 0);
+    EXPECT_EQ(ThreadPoolShutdown(&gSendThreadPool), 0);
+}
+
+TEST(GenaCtrlptTestSuite, renewal_is_handed_over_to_sender_of_host) {
+    job_arg* arg = (job_arg*)calloc(1, sizeof(job_arg));
+    ASSERT_NE(arg, nullptr);
+    arg->Event = UpnpEventSubscribe_new();
+    UpnpEventSubscribe_strcpy_PublisherUrl((UpnpEventSubscribe*)arg->Event,
+                                           "http://192.168.1.2:49152/event");
+    // A job sends renewals to the host.
+    gRenewQueues.hosts["192.168.1.2:49152"];
+
+    // Test Unit
+    // The renewal is queued for it instead of being sent in parallel.
+    GenaAutoRenewSubscription(arg);
+    ASSERT_EQ(gRenewQueues.hosts["192.168.1.2:49152"].size(), 1u);
+    EXPECT_EQ(gRenewQueues.hosts["192.168.1.2:49152"].front(), arg);
+
+    free_subscribe_arg(arg);
+    gRenewQueues.hosts.clear();
+}
+
+} // namespace utest
+
+
+int main(int argc, char** argv) {
+    ::testing::InitGoogleMock(&argc, argv);
+#include <utest/utest_main.inc>
+    return gtest_return_code; // managed in gtest_main.inc
+}
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-08-04
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 // Include source code for testing. So we have also direct access to static
 // functions which need to be tested.
@@ -20,6 +20,12 @@
 #include <umock/sys_socket_mock.hpp>
 #include <umock/stdio_mock.hpp>
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+#include <atomic>
+#include <chrono>
+#include <thread>
+#endif
+
 
 namespace utest {
 
@@ -477,6 +483,54 @@ TEST_F(HttpBasicFTestSuite, make_message_get_sdk_info_system_info_fails) {
 }
 #endif
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+TEST_F(HttpBasicFTestSuite, make_message_allocates_new_message_exactly) {
+    // Test Unit
+    EXPECT_EQ(http_MakeMessage(&m_request, 1, 1, "RTNc", HTTP_OK,
+                               "text/xml", (off_t)1234),
+              0);
+
+    const std::string result{"HTTP/1.1 200 OK\r\nCONTENT-TYPE: text/xml\r\n"
+                             "CONTENT-LENGTH: 1234\r\nAccept-Ranges: bytes\r\n"
+                             "\r\n"};
+    EXPECT_EQ(std::string(m_request.buf), result);
+    EXPECT_EQ(m_request.length, result.size());
+    EXPECT_EQ(m_request.capacity, result.size());
+
+    // Appending keeps the message.
+    EXPECT_EQ(http_MakeMessage(&m_request, 1, 1, "s", "body"), 0);
+    EXPECT_EQ(std::string(m_request.buf), result + "body");
+}
+
+TEST_F(HttpBasicFTestSuite, make_message_takes_server_info_once) {
+    // Provide structure for 'uname()' with system info
+    utsname sysinf{};
+    strncpy(sysinf.sysname, "Linux", sizeof(sysinf.sysname) - 1);
+    strncpy(sysinf.release, "5.10.0-20-amd64", sizeof(sysinf.release) - 1);
+
+    // Mock uname system info and current time.
+    umock::SysinfoMock sysinfoObj;
+    umock::Sysinfo sysinfo_injectObj(&sysinfoObj);
+    EXPECT_CALL(sysinfoObj, uname(_))
+        .WillOnce(DoAll(StructCpyToArg<0>(&sysinf), Return(0)));
+    EXPECT_CALL(sysinfoObj, time(nullptr))
+        .Times(2)
+        .WillRepeatedly(Return(1675628181));
+    http_InitSdkInfo();
+
+    // Test Unit
+    for (int i{0}; i < 2; i++) {
+        EXPECT_EQ(http_MakeMessage(&m_request, 1, 1, "SD"), 0);
+        EXPECT_EQ(std::string(m_request.buf),
+                  "SERVER: Linux/5.10.0-20-amd64, UPnP/1.0, Portable SDK for "
+                  "UPnP devices/" PUPNP_VERSION_STRING
+                  "\r\nDATE: Sun, 05 Feb 2023 20:16:21 GMT\r\n");
+        membuffer_destroy(&m_request);
+    }
+    http_ClearSdkInfo();
+}
+#endif
+
 
 // Testsuite for http_SendMessage()
 // ================================
@@ -676,6 +730,247 @@ TEST_F(HttpMockFTestSuite, http_Download_successful) {
         << errStrEx(ret_http_Download, UPNP_E_SUCCESS);
 }
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// Testsuite for the client connection pool of http_RequestAndResponse()
+// =====================================================================
+// HTTP/1.1 server on the loopback interface. It serves one connection after
+// the other and answers each request with a small entity.
+class CKeepAliveServer {
+  public:
+    enum Mode {
+        KEEP_ALIVE,       // Keep the connection open.
+        CONNECTION_CLOSE, // Send "Connection: close" and close.
+        SILENT_CLOSE      // Close after the response without telling.
+    };
+
+    CKeepAliveServer(Mode a_mode) : m_mode(a_mode) {
+        TRACE("construct CKeepAliveServer");
+        m_listen_sock = ::socket(AF_INET, SOCK_STREAM, 0);
+        ::sockaddr_in saddr{};
+        saddr.sin_family = AF_INET;
+        saddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t saddr_len{sizeof(saddr)};
+        if (m_listen_sock == INVALID_SOCKET ||
+            ::bind(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                   saddr_len) != 0 ||
+            ::listen(m_listen_sock, SOMAXCONN) != 0 ||
+            ::getsockname(m_listen_sock, reinterpret_cast<sockaddr*>(&saddr),
+                          &saddr_len) != 0) {
+            CLOSE_SOCKET_P(m_listen_sock);
+            throw std::runtime_error("Failed to listen on loopback.");
+        }
+        m_port = ntohs(saddr.sin_port);
+        m_thread = std::thread(&CKeepAliveServer::run, this);
+    }
+    virtual ~CKeepAliveServer() {
+        TRACE("destruct CKeepAliveServer");
+        // Idle connections of the pool would block the server.
+        ::http_ClearConnPool();
+        m_stop = true;
+        ::shutdown(m_listen_sock, SD_BOTH);
+        m_thread.join();
+        CLOSE_SOCKET_P(m_listen_sock);
+    }
+    std::string get_url() const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + "/";
+    }
+    // Number of accepted connections.
+    int accepted() const { return m_accepted; }
+    // Close the connection on the next request without answering it.
+    void drop_next_request() { m_drop_next = true; }
+    // Neither answer nor close on the next request.
+    void stall_next_request() { m_stall_next = true; }
+
+  private:
+    void run() {
+        while (!m_stop) {
+            SOCKET sockfd = ::accept(m_listen_sock, nullptr, nullptr);
+            if (sockfd == INVALID_SOCKET)
+                return;
+            m_accepted++;
+            while (read_request(sockfd) && !m_drop_next.exchange(false)) {
+                if (m_stall_next.exchange(false))
+                    continue;
+                std::string response{"HTTP/1.1 200 OK\r\n"
+                                     "CONTENT-LENGTH: 2\r\n"};
+                if (m_mode == CONNECTION_CLOSE)
+                    response += "CONNECTION: close\r\n";
+                response += "\r\nOK";
+                ::send(sockfd, response.data(), response.size(), 0);
+                if (m_mode != KEEP_ALIVE)
+                    break;
+            }
+            CLOSE_SOCKET_P(sockfd);
+        }
+    }
+    // Read up to the empty line that finishes the request header.
+    bool read_request(SOCKET a_sockfd) {
+        std::string request;
+        char buf[256];
+        while (request.find("\r\n\r\n") == std::string::npos) {
+            SSIZEP_T len = ::recv(a_sockfd, buf, sizeof(buf), 0);
+            if (len <= 0)
+                return false;
+            request.append(buf, static_cast<size_t>(len));
+        }
+        return true;
+    }
+
+    const Mode m_mode;
+    SOCKET m_listen_sock{INVALID_SOCKET};
+    in_port_t m_port{};
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::atomic<bool> m_drop_next{false};
+    std::atomic<bool> m_stall_next{false};
+    std::atomic<int> m_accepted{0};
+};
+
+class HttpConnPoolFTestSuite : public ::testing::Test {
+  protected:
+    HttpConnPoolStats m_stats0{};
+
+    HttpConnPoolFTestSuite() { http_GetConnPoolStats(&m_stats0); }
+
+    // Send a request to the url and return the result.
+    int request(const std::string& a_url, http_method_t a_method,
+                int a_timeout, http_parser_t* a_response) {
+        uri_type url;
+        EXPECT_EQ(http_FixStrUrl(a_url.c_str(), a_url.size(), &url),
+                  UPNP_E_SUCCESS);
+        const std::string request{
+            std::string(a_method == HTTPMETHOD_POST ? "POST" : "GET") +
+            " / HTTP/1.1\r\nHOST: 127.0.0.1\r\nCONTENT-LENGTH: 0\r\n\r\n"};
+        return http_RequestAndResponse(&url, request.data(), request.size(),
+                                       a_method, a_timeout, a_response);
+    }
+
+    // Send a GET request to the url and check the response.
+    void get(const std::string& a_url) {
+        http_parser_t response;
+        int ret_http_RequestAndResponse = this->request(
+            a_url, HTTPMETHOD_GET, HTTP_DEFAULT_TIMEOUT, &response);
+        EXPECT_EQ(ret_http_RequestAndResponse, UPNP_E_SUCCESS)
+            << errStrEx(ret_http_RequestAndResponse, UPNP_E_SUCCESS);
+        EXPECT_EQ(response.msg.status_code, HTTP_OK);
+        EXPECT_EQ(std::string(response.msg.entity.buf,
+                              response.msg.entity.length),
+                  "OK");
+        httpmsg_destroy(&response.msg);
+    }
+
+    // Get the pool statistic relative to the start of the test.
+    HttpConnPoolStats stats() {
+        HttpConnPoolStats stats;
+        http_GetConnPoolStats(&stats);
+        stats.opened -= m_stats0.opened;
+        stats.reused -= m_stats0.reused;
+        stats.retried -= m_stats0.retried;
+        stats.evicted -= m_stats0.evicted;
+        return stats;
+    }
+};
+
+TEST_F(HttpConnPoolFTestSuite, keep_alive_connection_is_reused) {
+    CKeepAliveServer serverObj(CKeepAliveServer::KEEP_ALIVE);
+
+    this->get(serverObj.get_url());
+    this->get(serverObj.get_url());
+    this->get(serverObj.get_url());
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.opened, 1u);
+    EXPECT_EQ(stats.reused, 2u);
+    EXPECT_EQ(stats.retried, 0u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_EQ(serverObj.accepted(), 1);
+}
+
+TEST_F(HttpConnPoolFTestSuite, request_on_dropped_connection_is_retried) {
+    CKeepAliveServer serverObj(CKeepAliveServer::KEEP_ALIVE);
+
+    this->get(serverObj.get_url());
+    // The server closes the pooled connection when the request arrives.
+    serverObj.drop_next_request();
+    this->get(serverObj.get_url());
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.opened, 2u);
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.retried, 1u);
+    EXPECT_EQ(stats.idle, 1u);
+    EXPECT_EQ(serverObj.accepted(), 2);
+}
+
+TEST_F(HttpConnPoolFTestSuite, post_on_dropped_connection_is_not_retried) {
+    CKeepAliveServer serverObj(CKeepAliveServer::KEEP_ALIVE);
+
+    this->get(serverObj.get_url());
+    // The server may have processed the request before it closed the
+    // connection, so a non-idempotent request must not be repeated.
+    serverObj.drop_next_request();
+    http_parser_t response;
+    int ret_http_RequestAndResponse = this->request(
+        serverObj.get_url(), HTTPMETHOD_POST, HTTP_DEFAULT_TIMEOUT, &response);
+    EXPECT_EQ(ret_http_RequestAndResponse, UPNP_E_BAD_HTTPMSG)
+        << errStrEx(ret_http_RequestAndResponse, UPNP_E_BAD_HTTPMSG);
+    httpmsg_destroy(&response.msg);
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.retried, 0u);
+    EXPECT_EQ(serverObj.accepted(), 1);
+}
+
+TEST_F(HttpConnPoolFTestSuite, timeout_on_pooled_connection_is_not_retried) {
+    CKeepAliveServer serverObj(CKeepAliveServer::KEEP_ALIVE);
+
+    this->get(serverObj.get_url());
+    serverObj.stall_next_request();
+    http_parser_t response;
+    int ret_http_RequestAndResponse =
+        this->request(serverObj.get_url(), HTTPMETHOD_GET, 1, &response);
+    EXPECT_EQ(ret_http_RequestAndResponse, UPNP_E_TIMEDOUT)
+        << errStrEx(ret_http_RequestAndResponse, UPNP_E_TIMEDOUT);
+    httpmsg_destroy(&response.msg);
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.reused, 1u);
+    EXPECT_EQ(stats.retried, 0u);
+    EXPECT_EQ(serverObj.accepted(), 1);
+}
+
+TEST_F(HttpConnPoolFTestSuite, connection_closed_while_idle_is_evicted) {
+    CKeepAliveServer serverObj(CKeepAliveServer::SILENT_CLOSE);
+
+    this->get(serverObj.get_url());
+    // Give the close of the server time to arrive.
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    this->get(serverObj.get_url());
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.opened, 2u);
+    EXPECT_EQ(stats.reused, 0u);
+    EXPECT_EQ(stats.retried, 0u);
+    EXPECT_EQ(stats.evicted, 1u);
+    EXPECT_EQ(serverObj.accepted(), 2);
+}
+
+TEST_F(HttpConnPoolFTestSuite, connection_close_is_not_pooled) {
+    CKeepAliveServer serverObj(CKeepAliveServer::CONNECTION_CLOSE);
+
+    this->get(serverObj.get_url());
+    this->get(serverObj.get_url());
+
+    HttpConnPoolStats stats = this->stats();
+    EXPECT_EQ(stats.opened, 2u);
+    EXPECT_EQ(stats.reused, 0u);
+    EXPECT_EQ(stats.idle, 0u);
+    EXPECT_EQ(serverObj.accepted(), 2);
+}
+#endif
+
+
 } // namespace utest
 
 
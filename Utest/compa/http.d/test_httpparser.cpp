@@ -1,5 +1,5 @@
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-03-04
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 #ifdef UPNPLIB_WITH_NATIVE_PUPNP
 #include <Pupnp/upnp/src/genlib/net/http/httpparser.cpp>
@@ -11,6 +11,10 @@
 
 #include <utest/utest.hpp>
 
+/// \cond
+#include <chrono>
+/// \endcond
+
 
 namespace utest {
 
@@ -313,6 +317,434 @@ TEST(HttpparserTestSuite, parser_response_init_a_nullptr) {
     }
 }
 
+
+// Captured messages to test the scanner
+// -------------------------------------
+// clang-format off
+constexpr char ssdp_msearch[]{
+    "M-SEARCH * HTTP/1.1\r\n"
+    "HOST: 239.255.255.250:1900\r\n"
+    "MAN: \"ssdp:discover\"\r\n"
+    "MX: 2\r\n"
+    "ST: urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+    "USER-AGENT: Linux/6.1 UPnP/2.0 UPnPlib/0.1.0\r\n"
+    "\r\n"};
+
+constexpr char ssdp_search_response[]{
+    "HTTP/1.1 200 OK\r\n"
+    "CACHE-CONTROL: max-age=1800\r\n"
+    "DATE: Mon, 19 Oct 2026 10:12:43 GMT\r\n"
+    "EXT:\r\n"
+    "LOCATION: http://192.168.178.21:49152/description.xml\r\n"
+    "SERVER: Linux/6.1 UPnP/1.0 Portable SDK for UPnP devices/1.14.19\r\n"
+    "X-User-Agent: redsonic\r\n"
+    "ST: urn:schemas-upnp-org:device:MediaRenderer:1\r\n"
+    "USN: uuid:5d724fc2-5fd1-4e8d-b1da-3a1b9e8a0a3c::urn:schemas-upnp-org:"
+        "device:MediaRenderer:1\r\n"
+    "\r\n"};
+
+constexpr char soap_response[]{
+    "HTTP/1.1 200 OK\r\n"
+    "CONTENT-LENGTH: 302\r\n"
+    "CONTENT-TYPE: text/xml; charset=\"utf-8\"\r\n"
+    "DATE: Mon, 19 Oct 2026 10:12:44 GMT\r\n"
+    "EXT:\r\n"
+    "SERVER: Linux/6.1 UPnP/1.0 Portable SDK for UPnP devices/1.14.19\r\n"
+    "\r\n"
+    "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\" "
+    "s:encodingStyle=\"http://schemas.xmlsoap.org/soap/encoding/\">\r\n"
+    "<s:Body>\r\n"
+    "<u:GetVolumeResponse xmlns:u=\"urn:schemas-upnp-org:service:"
+    "RenderingControl:1\">\r\n"
+    "<CurrentVolume>42</CurrentVolume>\r\n"
+    "</u:GetVolumeResponse>\r\n"
+    "</s:Body>\r\n"
+    "</s:Envelope>\r\n"};
+// clang-format on
+
+std::string hdr_str(http_message_t* a_msg, int a_hdr_id) {
+    memptr value{};
+    if (::httpmsg_find_hdr(a_msg, a_hdr_id, &value) == nullptr)
+        return "<not found>";
+    return std::string(value.buf, value.length);
+}
+
+TEST(HttpparserTestSuite, parse_ssdp_msearch_request) {
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, ssdp_msearch, sizeof(ssdp_msearch) - 1),
+              PARSE_SUCCESS);
+
+    EXPECT_EQ(parser.msg.method, HTTPMETHOD_MSEARCH);
+    EXPECT_EQ(parser.msg.major_version, 1);
+    EXPECT_EQ(parser.msg.minor_version, 1);
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_HOST), "239.255.255.250:1900");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_MAN), "\"ssdp:discover\"");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_MX), "2");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_ST),
+              "urn:schemas-upnp-org:device:MediaRenderer:1");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_USER_AGENT),
+              "Linux/6.1 UPnP/2.0 UPnPlib/0.1.0");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_ssdp_search_response) {
+    http_parser_t parser;
+    ::parser_response_init(&parser, HTTPMETHOD_MSEARCH);
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, ssdp_search_response,
+                              sizeof(ssdp_search_response) - 1),
+              PARSE_SUCCESS);
+
+    EXPECT_EQ(parser.msg.status_code, 200);
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_CACHE_CONTROL), "max-age=1800");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_LOCATION),
+              "http://192.168.178.21:49152/description.xml");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_USN),
+              "uuid:5d724fc2-5fd1-4e8d-b1da-3a1b9e8a0a3c::urn:schemas-upnp-"
+              "org:device:MediaRenderer:1");
+    http_header_t* hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-User-Agent");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length), "redsonic");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_soap_response_with_entity) {
+    http_parser_t parser;
+    ::parser_response_init(&parser, SOAPMETHOD_POST);
+
+    // Test Unit
+    EXPECT_EQ(
+        ::parser_append(&parser, soap_response, sizeof(soap_response) - 1),
+        PARSE_SUCCESS);
+
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_CONTENT_TYPE),
+              "text/xml; charset=\"utf-8\"");
+    ASSERT_EQ(parser.msg.entity.length, 302u);
+    EXPECT_EQ(std::string(parser.msg.entity.buf, 12), "<s:Envelope ");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_header_values_with_special_octets) {
+    // Header values longer than a scanner block with rare identifier
+    // characters, a quoted string spanning a line and octets >= 0x80.
+    constexpr char msg[]{
+        "NOTIFY /event/RenderingControl HTTP/1.1\r\n"
+        "HOST: 192.168.178.21:49152\r\n"
+        "X-Rare-Token#1: ~abc!def$ghi%jkl&mno'pqr*stu+vwx^yz`{|}\r\n"
+        "X-Quoted: \"quoted \xc3\xa4\xc3\xb6\xc3\xbc\r\n continued\" tail\r\n"
+        "X-Folded: first-line-of-the-value\r\n"
+        "\tsecond-line-of-the-value\r\n"
+        "CONTENT-LENGTH: 0\r\n"
+        "\r\n"};
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, msg, sizeof(msg) - 1), PARSE_SUCCESS);
+
+    http_header_t* hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Rare-Token#1");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length),
+              "~abc!def$ghi%jkl&mno'pqr*stu+vwx^yz`{|}");
+    hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Quoted");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length),
+              "\"quoted \xc3\xa4\xc3\xb6\xc3\xbc\r\n continued\" tail");
+    hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Folded");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length),
+              "first-line-of-the-value\r\n\tsecond-line-of-the-value");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_high_octet_outside_quoted_string_fails) {
+    constexpr char msg[]{"NOTIFY /event HTTP/1.1\r\n"
+                         "X-Bad: 0123456789abcdef\xc3\xa4\r\n"
+                         "\r\n"};
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, msg, sizeof(msg) - 1), PARSE_FAILURE);
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_message_split_at_every_position) {
+    // The result must not depend on where a message is split into segments.
+    constexpr size_t msg_len{sizeof(ssdp_search_response) - 1};
+
+    for (size_t split{1}; split < msg_len; split++) {
+        http_parser_t parser;
+        ::parser_response_init(&parser, HTTPMETHOD_MSEARCH);
+
+        // Test Unit
+        parse_status_t status =
+            ::parser_append(&parser, ssdp_search_response, split);
+        ASSERT_EQ(status, PARSE_INCOMPLETE) << "split at " << split;
+        status = ::parser_append(&parser, ssdp_search_response + split,
+                                 msg_len - split);
+        ASSERT_EQ(status, PARSE_SUCCESS) << "split at " << split;
+        EXPECT_EQ(hdr_str(&parser.msg, HDR_LOCATION),
+                  "http://192.168.178.21:49152/description.xml")
+            << "split at " << split;
+
+        ::httpmsg_destroy(&parser.msg);
+    }
+}
+
+TEST(HttpparserTestSuite, parse_message_one_byte_at_a_time) {
+    constexpr size_t msg_len{sizeof(soap_response) - 1};
+    http_parser_t parser;
+    ::parser_response_init(&parser, SOAPMETHOD_POST);
+
+    // Test Unit
+    parse_status_t status{PARSE_INCOMPLETE};
+    for (size_t i{0}; i < msg_len; i++) {
+        status = ::parser_append(&parser, soap_response + i, 1);
+        if (i < msg_len - 1)
+            ASSERT_EQ(status, PARSE_INCOMPLETE) << "at byte " << i;
+    }
+    ASSERT_EQ(status, PARSE_SUCCESS);
+
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_CONTENT_TYPE),
+              "text/xml; charset=\"utf-8\"");
+    EXPECT_EQ(parser.msg.status_code, 200);
+    ASSERT_EQ(parser.msg.entity.length, 302u);
+    EXPECT_EQ(std::string(parser.msg.entity.buf, 12), "<s:Envelope ");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_chunked_message_one_byte_at_a_time) {
+    constexpr char msg[]{"HTTP/1.1 200 OK\r\n"
+                         "TRANSFER-ENCODING: chunked\r\n"
+                         "X-Folded: first\r\n"
+                         " second\r\n"
+                         "\r\n"
+                         "5;ext=1\r\n"
+                         "Hello\r\n"
+                         "7\r\n"
+                         ", World\r\n"
+                         "0\r\n"
+                         "X-Trailer: done\r\n"
+                         "\r\n"};
+    constexpr size_t msg_len{sizeof(msg) - 1};
+    http_parser_t parser;
+    ::parser_response_init(&parser, HTTPMETHOD_GET);
+
+    // Test Unit
+    parse_status_t status{PARSE_INCOMPLETE};
+    for (size_t i{0}; i < msg_len; i++) {
+        status = ::parser_append(&parser, msg + i, 1);
+        if (i < msg_len - 1)
+            ASSERT_EQ(status, PARSE_INCOMPLETE) << "at byte " << i;
+    }
+    ASSERT_EQ(status, PARSE_SUCCESS);
+
+    http_header_t* hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Folded");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length),
+              "first\r\n second");
+    hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Trailer");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(std::string(hdr->value.buf, hdr->value.length), "done");
+    ASSERT_EQ(parser.msg.entity.length, 12u);
+    EXPECT_EQ(std::string(parser.msg.entity.buf, 12), "Hello, World");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_bad_line_one_byte_at_a_time_fails) {
+    constexpr char msg[]{"NOTIFY /event HTTP/1.1\r\n"
+                         "X-Bad: 0123456789abcdef\xc3\xa4\r\n"
+                         "\r\n"};
+    constexpr size_t msg_len{sizeof(msg) - 1};
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+
+    // Test Unit
+    parse_status_t status{PARSE_INCOMPLETE};
+    for (size_t i{0}; i < msg_len && status == PARSE_INCOMPLETE; i++) {
+        status = ::parser_append(&parser, msg + i, 1);
+    }
+    EXPECT_EQ(status, PARSE_FAILURE);
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+TEST(HttpparserTestSuite, parser_append_reserve_and_commit) {
+    constexpr size_t msg_len{sizeof(soap_response) - 1};
+    http_parser_t parser;
+    ::parser_response_init(&parser, SOAPMETHOD_POST);
+
+    // Test Unit with reading different segment sizes into the message.
+    parse_status_t status{PARSE_INCOMPLETE};
+    size_t pos{0};
+    for (size_t seg_len{1}; pos < msg_len; seg_len = seg_len * 2 + 1) {
+        size_t len = std::min(seg_len, msg_len - pos);
+        char* buf = ::parser_append_reserve(&parser, seg_len);
+        ASSERT_NE(buf, nullptr);
+        memcpy(buf, soap_response + pos, len);
+        status = ::parser_append_commit(&parser, len);
+        pos += len;
+        if (pos < msg_len)
+            ASSERT_EQ(status, PARSE_INCOMPLETE) << "at byte " << pos;
+    }
+    ASSERT_EQ(status, PARSE_SUCCESS);
+    EXPECT_EQ(parser.msg.msg.length, msg_len);
+    EXPECT_EQ(parser.msg.msg.buf[msg_len], '\0');
+    ASSERT_EQ(parser.msg.entity.length, 302u);
+    EXPECT_EQ(std::string(parser.msg.entity.buf, 12), "<s:Envelope ");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parser_append_commit_without_reserve_fails) {
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+
+    // Test Unit
+    EXPECT_EQ(::parser_append_commit(&parser, 1), PARSE_FAILURE);
+    EXPECT_EQ(parser.http_error_code, HTTP_INTERNAL_SERVER_ERROR);
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+bool is_in_msg(http_message_t* a_msg, const char* a_ptr) {
+    return a_ptr >= a_msg->msg.buf && a_ptr < a_msg->msg.buf + a_msg->msg.length;
+}
+
+TEST(HttpparserTestSuite, parse_headers_as_slices) {
+    http_parser_t parser;
+    ::parser_response_init(&parser, HTTPMETHOD_MSEARCH);
+    parser.header_slices = 1;
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, ssdp_search_response,
+                              sizeof(ssdp_search_response) - 1),
+              PARSE_SUCCESS);
+
+    memptr value{};
+    http_header_t* hdr = ::httpmsg_find_hdr(&parser.msg, HDR_LOCATION, &value);
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(hdr->is_slice, 1);
+    EXPECT_TRUE(is_in_msg(&parser.msg, hdr->name.buf));
+    EXPECT_TRUE(is_in_msg(&parser.msg, value.buf));
+    EXPECT_EQ(std::string(hdr->name.buf, hdr->name.length), "LOCATION");
+    EXPECT_EQ(std::string(value.buf, value.length),
+              "http://192.168.178.21:49152/description.xml");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_USN),
+              "uuid:5d724fc2-5fd1-4e8d-b1da-3a1b9e8a0a3c::urn:schemas-upnp-"
+              "org:device:MediaRenderer:1");
+
+    // Empty values are always copied.
+    hdr = ::httpmsg_find_hdr(&parser.msg, HDR_EXT, &value);
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(hdr->is_slice, 0);
+    EXPECT_FALSE(is_in_msg(&parser.msg, value.buf));
+
+    // Copy on demand.
+    EXPECT_EQ(::httpmsg_copy_header_slices(&parser.msg), UPNP_E_SUCCESS);
+    hdr = ::httpmsg_find_hdr(&parser.msg, HDR_LOCATION, &value);
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(hdr->is_slice, 0);
+    EXPECT_FALSE(is_in_msg(&parser.msg, hdr->name.buf));
+    EXPECT_FALSE(is_in_msg(&parser.msg, value.buf));
+    EXPECT_STREQ(value.buf, "http://192.168.178.21:49152/description.xml");
+    EXPECT_STREQ(hdr->name.buf, "LOCATION");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_repeated_header_as_slice) {
+    constexpr char msg[]{"NOTIFY /event HTTP/1.1\r\n"
+                         "X-Repeated: first\r\n"
+                         "X-Repeated: second\r\n"
+                         "CONTENT-LENGTH: 0\r\n"
+                         "\r\n"};
+    http_parser_t parser;
+    ::parser_request_init(&parser);
+    parser.header_slices = 1;
+
+    // Test Unit
+    EXPECT_EQ(::parser_append(&parser, msg, sizeof(msg) - 1), PARSE_SUCCESS);
+
+    http_header_t* hdr = ::httpmsg_find_hdr_str(&parser.msg, "X-Repeated");
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(hdr->is_slice, 0);
+    EXPECT_STREQ(hdr->value.buf, "first, second");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_CONTENT_LENGTH), "0");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+
+TEST(HttpparserTestSuite, parse_slices_survive_moving_message) {
+    // Appending segments reallocates the raw message buffer.
+    constexpr size_t msg_len{sizeof(ssdp_search_response) - 1};
+    http_parser_t parser;
+    ::parser_response_init(&parser, HTTPMETHOD_MSEARCH);
+    parser.header_slices = 1;
+
+    // Test Unit
+    parse_status_t status{PARSE_INCOMPLETE};
+    for (size_t i{0}; i < msg_len; i += 7) {
+        status = ::parser_append(&parser, ssdp_search_response + i,
+                                 std::min<size_t>(7, msg_len - i));
+    }
+    ASSERT_EQ(status, PARSE_SUCCESS);
+
+    memptr value{};
+    http_header_t* hdr = ::httpmsg_find_hdr(&parser.msg, HDR_ST, &value);
+    ASSERT_NE(hdr, nullptr);
+    EXPECT_EQ(hdr->is_slice, 1);
+    EXPECT_TRUE(is_in_msg(&parser.msg, value.buf));
+    EXPECT_EQ(std::string(hdr->name.buf, hdr->name.length), "ST");
+    EXPECT_EQ(std::string(value.buf, value.length),
+              "urn:schemas-upnp-org:device:MediaRenderer:1");
+    EXPECT_EQ(hdr_str(&parser.msg, HDR_CACHE_CONTROL), "max-age=1800");
+
+    ::httpmsg_destroy(&parser.msg);
+}
+#endif
+
+// Benchmark of the parser with captured messages. It is disabled by default
+// and can be run with option --gtest_also_run_disabled_tests.
+TEST(DISABLED_HttpparserBenchSuite, parse_captured_messages) {
+    constexpr int loops{100000};
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i{0}; i < loops; i++) {
+        http_parser_t parser;
+        ::parser_request_init(&parser);
+        ::parser_append(&parser, ssdp_msearch, sizeof(ssdp_msearch) - 1);
+        ::httpmsg_destroy(&parser.msg);
+
+        ::parser_response_init(&parser, HTTPMETHOD_MSEARCH);
+        ::parser_append(&parser, ssdp_search_response,
+                        sizeof(ssdp_search_response) - 1);
+        ::httpmsg_destroy(&parser.msg);
+
+        ::parser_response_init(&parser, SOAPMETHOD_POST);
+        ::parser_append(&parser, soap_response, sizeof(soap_response) - 1);
+        ::httpmsg_destroy(&parser.msg);
+    }
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    std::cout << "[ BENCH    ] " << loops * 3 << " messages parsed, "
+              << elapsed.count() / (loops * 3) << " ns per message.\n";
+}
+
 } // namespace utest
 
 
@@ -1,5 +1,5 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-06-04
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 // Include source code for testing. So we have also direct access to static
 // functions which need to be tested.
@@ -49,25 +49,6 @@ static UPNP_INLINE int is_valid_alias(); // Will become method is_valid().
 static void alias_release();             // Will become method release().
 #endif
 
-#ifndef UPNPLIB_WITH_NATIVE_PUPNP
-namespace {
-/*!
- * \brief Check for the validity of the XML object buffer.
- *
- * \returns **true** if valid alias, **false** otherwise.
- */
-UPNP_INLINE bool is_valid_alias(
-    /*! [in] XML alias object. */
-    const xml_alias_t* alias) {
-    TRACE("Executing is_valid_alias()")
-    if (alias == nullptr)
-        return false;
-    return alias->is_valid();
-}
-
-} // anonymous namespace
-#endif
-
 namespace utest {
 
 using ::testing::_;
@@ -86,6 +67,7 @@ class CEnableTrace {
 
 // Little helper
 // =============
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
 class CgWebMutex {
     // There are some Units with mutex locks and unlocks that will throw
     // exceptions on WIN32 if not initialized. I need this class in conjunction
@@ -95,6 +77,7 @@ class CgWebMutex {
     CgWebMutex() { pthread_mutex_init(&gWebMutex, NULL); }
     ~CgWebMutex() { pthread_mutex_destroy(&gWebMutex); }
 };
+#endif
 
 class CUpnpFileInfo {
     // Use this simple helper class to ensure to always free an allocated
@@ -144,10 +127,14 @@ TEST(WebServerTestSuite, init_and_destroy) {
     EXPECT_EQ(gDocumentRootDir.size_inc, (size_t)5);
 
     // Check if the global alias document is initialized
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
     EXPECT_EQ(gAliasDoc.doc.buf, nullptr);
     EXPECT_EQ(gAliasDoc.name.buf, nullptr);
     EXPECT_EQ(gAliasDoc.ct, nullptr);
     EXPECT_EQ(gAliasDoc.last_modified, 0);
+#else
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+#endif
 
     // Check if the virtual directory callback list is initialized
     EXPECT_EQ(pVirtualDirList, nullptr);
@@ -384,6 +371,7 @@ TEST(MediaListDeathTest, get_content_type_with_no_fileinfo) {
     }
 }
 
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
 class XMLaliasFTestSuite : public ::testing::Test {
   protected:
     XMLaliasFTestSuite() {
@@ -411,9 +399,7 @@ class XMLaliasFTestSuite : public ::testing::Test {
         while (is_valid_alias(&gAliasDoc)) {
             alias_release(&gAliasDoc);
         }
-#ifdef UPNPLIB_WITH_NATIVE_PUPNP
         memset(&::gAliasDoc, 0xAA, sizeof(::gAliasDoc));
-#endif
 
         pthread_mutex_destroy(&gWebMutex);
     }
@@ -433,11 +419,7 @@ TEST(XMLaliasTestSuite, glob_alias_init_and_release) {
     // With new code the structure is initialized with its constructor, no
     // need to call an initialization function but we do it also for
     // compatibility.
-#ifdef UPNPLIB_WITH_NATIVE_PUPNP
     memset(&::gAliasDoc, 0xAA, sizeof(::gAliasDoc));
-#else
-    gAliasDoc.clear();
-#endif
 
     // Test Unit init.
     glob_alias_init();
@@ -1209,6 +1191,297 @@ TEST_F(XMLaliasFDeathTest, alias_grab_nullptr) {
         alias_grab(nullptr);
     }
 }
+#else // UPNPLIB_WITH_NATIVE_PUPNP
+
+// The XML document is only kept in the snapshot that is served to requests.
+class XMLaliasFTestSuite : public ::testing::Test {
+  protected:
+    XMLaliasFTestSuite() { glob_alias_init(); }
+
+    // This frees the document that is left by the test.
+    ~XMLaliasFTestSuite() override { glob_alias_init(); }
+};
+
+TEST_F(XMLaliasFTestSuite, glob_alias_init_frees_document) {
+    const char content[]{"Test for a valid alias"};
+    char* alias_content = (char*)malloc(sizeof(content));
+    strcpy(alias_content, content);
+    ASSERT_EQ(web_server_set_alias("alias_name", alias_content,
+                                   sizeof(content) - 1, 0),
+              0);
+
+    StdlibMock mock_stdlibObj;
+    umock::Stdlib stdlib_injectObj(&mock_stdlibObj);
+    EXPECT_CALL(mock_stdlibObj, free(alias_content))
+        .WillOnce([](void* ptr) { ::free(ptr); });
+
+    // Test Unit
+    glob_alias_init();
+
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+}
+
+TEST_F(XMLaliasFTestSuite, alias_snapshot_valid_structure) {
+    char alias_name[]{"is_valid_alias"};            // length = 14
+    const char content[]{"Test for a valid alias"}; // length = 22
+    char* alias_content = (char*)malloc(sizeof(content));
+    strcpy(alias_content, content);
+
+    // Test Unit
+    // time_t 1668095500 sec is 2022-11-10T16:51:40
+    EXPECT_EQ(web_server_set_alias(alias_name, alias_content,
+                                   sizeof(content) - 1, 1668095500),
+              0);
+
+    std::shared_ptr<const alias_snapshot_t> snapshot = gAliasSnapshot.load();
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->name, "/is_valid_alias");
+    EXPECT_EQ(snapshot->doc, "Test for a valid alias");
+    // The document is taken over, not copied.
+    EXPECT_EQ(snapshot->doc.data(), alias_content);
+    EXPECT_EQ(snapshot->last_modified, 1668095500);
+}
+
+TEST_F(XMLaliasFTestSuite, alias_snapshot_empty_structure) {
+    // An empty alias is provided by the fixture.
+
+    // Test Unit
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+}
+
+TEST_F(XMLaliasFTestSuite, set_and_remove_alias) {
+    const char content[]{"This is an alias content"};
+    char* alias_content = (char*)malloc(sizeof(content));
+    strcpy(alias_content, content);
+    ASSERT_EQ(web_server_set_alias("alias_name", alias_content,
+                                   sizeof(content) - 1, 1668095500),
+              0);
+
+    // Test Unit remove alias with setting alias name to nullptr.
+    EXPECT_EQ(web_server_set_alias(nullptr, alias_content, sizeof(content) - 1,
+                                   1668095500),
+              0);
+
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+}
+
+TEST_F(XMLaliasFTestSuite, set_alias_with_nullptr_to_alias_content) {
+    int ret_set_alias{UPNP_E_INTERNAL_ERROR};
+
+    // Test Unit
+    ret_set_alias = web_server_set_alias("alias_Name", nullptr, 0, 0);
+    EXPECT_EQ(ret_set_alias, UPNP_E_INVALID_ARGUMENT)
+        << errStrEx(ret_set_alias, UPNP_E_INVALID_ARGUMENT);
+    ret_set_alias = web_server_set_alias("alias_with_length", nullptr, 1, 0);
+    EXPECT_EQ(ret_set_alias, UPNP_E_INVALID_ARGUMENT)
+        << errStrEx(ret_set_alias, UPNP_E_INVALID_ARGUMENT);
+
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+}
+
+TEST_F(XMLaliasFTestSuite, set_alias_with_content_length) {
+    // alias_content_length should only truncate the alias_content but never
+    // exceed its length even if it is set greater.
+    const char content[]{"XML Dokument string"}; // length = 19
+    const size_t lengths[]{0, 1, 19, 20};
+
+    for (size_t length : lengths) {
+        char* alias_content = (char*)malloc(sizeof(content));
+        strcpy(alias_content, content);
+
+        // Test Unit
+        ASSERT_EQ(
+            web_server_set_alias("valid_alias_name", alias_content, length, 0),
+            0);
+
+        std::shared_ptr<const alias_snapshot_t> snapshot =
+            gAliasSnapshot.load();
+        ASSERT_NE(snapshot, nullptr);
+        EXPECT_EQ(snapshot->name, "/valid_alias_name");
+        EXPECT_EQ(snapshot->doc,
+                  std::string_view(content, length < 19 ? length : 19));
+        // The document is still a C string.
+        EXPECT_EQ(snapshot->doc.data()[snapshot->doc.size()], '\0');
+    }
+}
+
+TEST_F(XMLaliasFTestSuite, set_alias_with_modified_date) {
+    const char content[]{"Some valid content"};
+
+    const time_t dates[]{0, -1};
+
+    for (time_t last_modified : dates) {
+        char* alias_content = (char*)malloc(sizeof(content));
+        strcpy(alias_content, content);
+
+        // Test Unit
+        ASSERT_EQ(web_server_set_alias("valid_alias_name", alias_content,
+                                       sizeof(content) - 1, last_modified),
+                  0);
+
+        EXPECT_EQ(gAliasSnapshot.load()->last_modified, last_modified);
+    }
+}
+
+TEST_F(XMLaliasFTestSuite, set_alias_two_times_with_same_content) {
+    const char alias_name[]{"valid_alias_name"};
+    const char content[]{"Some valid content"};
+    char* alias_content = (char*)malloc(sizeof(content));
+    strcpy(alias_content, content);
+
+    ASSERT_EQ(web_server_set_alias(alias_name, alias_content,
+                                   sizeof(content) - 1, 4),
+              0);
+
+    // Test Unit with the document that is already served.
+    int ret_set_alias{UPNP_E_INTERNAL_ERROR};
+    ret_set_alias = web_server_set_alias(alias_name, alias_content,
+                                         sizeof(content) - 1, 5);
+    EXPECT_EQ(ret_set_alias, UPNP_E_INVALID_ARGUMENT)
+        << errStrEx(ret_set_alias, UPNP_E_INVALID_ARGUMENT);
+
+    // The wrong setting attempt hasn't changed the valid setting.
+    ASSERT_NE(gAliasSnapshot.load(), nullptr);
+    EXPECT_EQ(gAliasSnapshot.load()->last_modified, 4);
+    EXPECT_EQ(gAliasSnapshot.load()->doc, "Some valid content");
+}
+
+TEST_F(XMLaliasFTestSuite, alias_snapshot_survives_new_alias) {
+    char alias_name[]{"alias_name"};
+    const char content1[]{"First XML document"};
+    char* alias_content1 = (char*)malloc(sizeof(content1));
+    strcpy(alias_content1, content1);
+    const char content2[]{"Second XML document"};
+    char* alias_content2 = (char*)malloc(sizeof(content2));
+    strcpy(alias_content2, content2);
+
+    ASSERT_EQ(web_server_set_alias(alias_name, alias_content1,
+                                   sizeof(content1) - 1, 1),
+              0);
+    // A request is sending the first document.
+    std::shared_ptr<const alias_snapshot_t> snapshot = gAliasSnapshot.load();
+
+    // Test Unit
+    ASSERT_EQ(web_server_set_alias(alias_name, alias_content2,
+                                   sizeof(content2) - 1, 2),
+              0);
+
+    // The first document is still valid for the running request.
+    ASSERT_NE(snapshot, nullptr);
+    EXPECT_EQ(snapshot->doc, "First XML document");
+    EXPECT_EQ(snapshot->last_modified, 1);
+    // New requests get the second document.
+    EXPECT_EQ(gAliasSnapshot.load()->doc, "Second XML document");
+
+    // Test Unit remove alias
+    ASSERT_EQ(web_server_set_alias(nullptr, alias_content2,
+                                   sizeof(content2) - 1, 3),
+              0);
+    EXPECT_EQ(gAliasSnapshot.load(), nullptr);
+    EXPECT_EQ(snapshot->doc, "First XML document");
+
+    // The first document is freed with the last request that sends it.
+    StdlibMock mock_stdlibObj;
+    umock::Stdlib stdlib_injectObj(&mock_stdlibObj);
+    EXPECT_CALL(mock_stdlibObj, free(alias_content1))
+        .WillOnce([](void* ptr) { ::free(ptr); });
+    snapshot.reset();
+}
+
+// Tests for the lookup of virtual directories
+// ===========================================
+class VirtualDirFTestSuite : public ::testing::Test {
+  protected:
+    virtualDirList m_dirs[4]{};
+    int m_cookies[4]{};
+
+    // Provide a list of virtual directories in the given order.
+    void set_dirs(std::initializer_list<const char*> a_names) {
+        std::scoped_lock lock(gWebMutex);
+        virtualDirList* prev{nullptr};
+        size_t i{0};
+        pVirtualDirList = nullptr;
+        for (const char* name : a_names) {
+            strncpy(m_dirs[i].dirName, name, sizeof(m_dirs[i].dirName) - 1);
+            m_dirs[i].cookie = &m_cookies[i];
+            m_dirs[i].next = nullptr;
+            if (prev == nullptr)
+                pVirtualDirList = &m_dirs[i];
+            else
+                prev->next = &m_dirs[i];
+            prev = &m_dirs[i++];
+        }
+        ASSERT_EQ(web_server_update_virtual_dirs(), UPNP_E_SUCCESS);
+    }
+
+    ~VirtualDirFTestSuite() override {
+        std::scoped_lock lock(gWebMutex);
+        pVirtualDirList = nullptr;
+        web_server_update_virtual_dirs();
+    }
+};
+
+TEST_F(VirtualDirFTestSuite, no_virtual_dirs) {
+    char path[]{"/upnp/desc.xml"};
+    const void* cookie{&cookie};
+    set_dirs({});
+
+    // Test Unit
+    EXPECT_EQ(isFileInVirtualDir(path, &cookie), 0);
+    EXPECT_EQ(cookie, &cookie);
+}
+
+TEST_F(VirtualDirFTestSuite, match_directory_without_slash) {
+    char path1[]{"/upnp/desc.xml"};
+    char path2[]{"/upnp"};
+    char path3[]{"/upnp?query"};
+    char path4[]{"/upnpx/desc.xml"};
+    char path5[]{"/upn"};
+    const void* cookie{};
+    set_dirs({"/upnp"});
+
+    // Test Unit
+    EXPECT_EQ(isFileInVirtualDir(path1, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[0]);
+    EXPECT_EQ(isFileInVirtualDir(path2, nullptr), 1);
+    EXPECT_EQ(isFileInVirtualDir(path3, nullptr), 1);
+    EXPECT_EQ(isFileInVirtualDir(path4, nullptr), 0);
+    EXPECT_EQ(isFileInVirtualDir(path5, nullptr), 0);
+}
+
+TEST_F(VirtualDirFTestSuite, match_directory_with_slash) {
+    char path1[]{"/upnp/desc.xml"};
+    char path2[]{"/upnp"};
+    const void* cookie{};
+    set_dirs({"/upnp/"});
+
+    // Test Unit
+    EXPECT_EQ(isFileInVirtualDir(path1, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[0]);
+    EXPECT_EQ(isFileInVirtualDir(path2, nullptr), 0);
+}
+
+TEST_F(VirtualDirFTestSuite, first_directory_in_list_wins) {
+    char path1[]{"/upnp/media/song.mp3"};
+    char path2[]{"/upnp/desc.xml"};
+    char path3[]{"/web/index.html"};
+    const void* cookie{};
+    set_dirs({"/upnp/media", "/upnp", "/web/"});
+
+    // Test Unit
+    EXPECT_EQ(isFileInVirtualDir(path1, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[0]);
+    EXPECT_EQ(isFileInVirtualDir(path2, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[1]);
+    EXPECT_EQ(isFileInVirtualDir(path3, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[2]);
+
+    // The shorter directory comes first now.
+    set_dirs({"/upnp", "/upnp/media"});
+    EXPECT_EQ(isFileInVirtualDir(path1, &cookie), 1);
+    EXPECT_EQ(cookie, &m_cookies[0]);
+}
+#endif // UPNPLIB_WITH_NATIVE_PUPNP
 
 } // namespace utest
 
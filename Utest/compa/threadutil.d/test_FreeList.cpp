@@ -1,11 +1,16 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2023-12-06
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 #include <FreeList.hpp>
 
 #include <upnplib/global.hpp>
 #include <umock/stdlib_mock.hpp>
 
+/// \cond
+#include <atomic>
+#include <thread>
+/// \endcond
+
 
 // A Freelist works together with a linked list. If we add or delete nodes on a
 // linked list normaly memory allocation and freeing is used. This is expensive.
@@ -246,6 +251,69 @@ TEST(FreeListDeathTest, freelist_destroy_a_nullptr) {
 }
 #endif
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// ###############################
+//  Slab allocator               #
+// ###############################
+
+// Counts the allocations of all threads that go to the operating system.
+class CCountMallocs : public umock::StdlibInterface {
+  public:
+    std::atomic<size_t> allocs{};
+    void* malloc(size_t size) override {
+        allocs++;
+        return ::malloc(size);
+    }
+    void* calloc(size_t nmemb, size_t size) override {
+        allocs++;
+        return ::calloc(nmemb, size);
+    }
+    void* realloc(void* ptr, size_t size) override {
+        allocs++;
+        return ::realloc(ptr, size);
+    }
+    void free(void* ptr) override { ::free(ptr); }
+};
+
+TEST(SlabTestSuite, reuses_blocks_freed_by_other_threads) {
+    CCountMallocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+
+    void* block = SlabAlloc(1000);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % alignof(std::max_align_t),
+              0u);
+    // The finishing thread gives its cached block to the depot.
+    std::thread([block] { SlabFree(block); }).join();
+    const size_t allocs{countObj.allocs};
+
+    // Test Unit
+    block = SlabAlloc(1000);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(countObj.allocs, allocs);
+    SlabFree(block);
+
+    // Big blocks go directly to the operating system.
+    block = SlabAlloc(100000);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(countObj.allocs, allocs + 1);
+    SlabFree(block);
+    SlabFree(nullptr);
+}
+
+TEST(SlabDeathTest, aborts_on_double_free) {
+    GTEST_FLAG_SET(death_test_style, "threadsafe");
+    EXPECT_DEATH(
+        {
+            void* block = SlabAlloc(64);
+            SlabFree(block);
+            // This should abort.
+            SlabFree(block);
+        },
+        "");
+}
+#endif // UPNPLIB_WITH_NATIVE_PUPNP
+
 } // namespace utest
 
 
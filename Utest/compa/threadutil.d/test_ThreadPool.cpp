@@ -1,5 +1,5 @@
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2023-12-06
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
 // Note
 // -------------
@@ -17,6 +17,12 @@
 // ./utest/build/test_ThreadPool_old  --gtest_brief=1 --gtest_repeat=10000
 // --gtest_filter=ThreadPoolNormalTestSuite.init_and_shutdown_threadpool --Ingo
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// Include source code for testing. So we have also direct access to the thread
+// pools of the SDK.
+#include <Compa/src/api/upnpapi.cpp>
+#endif
+
 #include <pupnp/ThreadPool.hpp>
 #include <pupnp/threadpool_init.hpp>
 
@@ -25,13 +31,22 @@
 #include <upnplib/global.hpp>
 #include <utest/utest.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
 
 namespace utest {
 
 using ::pupnp::CThreadPool;
 using ::pupnp::CThreadPoolInit;
 
+using ::testing::HasSubstr;
+using ::testing::Not;
 
+
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
 // ###############################
 //  ThreadPool Testsuite         #
 // ###############################
@@ -770,6 +785,248 @@ TEST(ThreadPoolInitTestSuite, threadpool_init_with_invalid_settings) {
     }
 }
 
+
+#else // UPNPLIB_WITH_NATIVE_PUPNP
+// ###############################
+//  Compatible ThreadPool        #
+// ###############################
+
+TEST(ThreadPoolCompaTestSuite, admission_policies) {
+    // One worker is kept busy so that added jobs stay queued.
+    ThreadPoolAttr attr;
+    TPAttrInit(&attr);
+    TPAttrSetMinThreads(&attr, 1);
+    TPAttrSetMaxThreads(&attr, 1);
+    TPAttrSetMaxJobsTotal(&attr, 2);
+    TPAttrSetAdmissionPolicy(&attr, ADMIT_REJECT);
+    EXPECT_EQ(TPAttrSetAdmissionPolicy(nullptr, ADMIT_BLOCK), EINVAL);
+    EXPECT_EQ(TPAttrSetAdmissionPolicy(&attr, ADMIT_DEFAULT), EINVAL);
+    EXPECT_EQ(TPJobSetAdmissionPolicy(nullptr, ADMIT_BLOCK), EINVAL);
+    ThreadPool tp{};
+    ASSERT_EQ(ThreadPoolInit(&tp, &attr), 0);
+
+    // The saturation function is never called concurrently with itself.
+    std::vector<int> saturation;
+    ThreadPoolSetSaturationFunction(
+        &tp,
+        [](ThreadPool* a_tp, int saturated, void* cookie) {
+            // The pool mutex is not locked.
+            ThreadPoolAdmitStats stats;
+            ThreadPoolGetAdmitStats(a_tp, &stats);
+            static_cast<std::vector<int>*>(cookie)->push_back(saturated);
+        },
+        &saturation);
+
+    std::atomic<bool> gate{false};
+    std::atomic<int> freed{0};
+    auto block = [](void* arg) {
+        while (!*static_cast<std::atomic<bool>*>(arg))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    };
+    auto noop = [](void*) {};
+    auto count_free = [](void* arg) { ++*static_cast<std::atomic<int>*>(arg); };
+    auto add = [&](start_routine func, ThreadPriority priority,
+                   const void* key = nullptr, int* jobId = nullptr,
+                   AdmissionPolicy policy = ADMIT_DEFAULT) {
+        ThreadPoolJob job;
+        TPJobInit(&job, func, &freed);
+        TPJobSetPriority(&job, priority);
+        TPJobSetFreeFunction(&job, count_free);
+        TPJobSetMergeKey(&job, key);
+        TPJobSetAdmissionPolicy(&job, policy);
+        return ThreadPoolAdd(&tp, &job, jobId);
+    };
+    ThreadPoolAdmitStats stats{};
+
+    ThreadPoolJob blocker;
+    TPJobInit(&blocker, block, &gate);
+    ASSERT_EQ(ThreadPoolAdd(&tp, &blocker, nullptr), 0);
+    for (int i{0}; i < 200; i++) {
+        ithread_mutex_lock(&tp.mutex);
+        const bool busy{tp.busyThreads == 1};
+        ithread_mutex_unlock(&tp.mutex);
+        if (busy)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // Test Unit
+    // A job with its own policy sheds the oldest low priority job although
+    // the pool rejects.
+    const int key{};
+    int queuedId{INVALID_JOB_ID};
+    EXPECT_EQ(add(noop, LOW_PRIORITY), 0);
+    EXPECT_EQ(add(noop, LOW_PRIORITY), 0);
+    EXPECT_EQ(add(noop, LOW_PRIORITY, nullptr, nullptr, ADMIT_SHED_LOW),
+              EOUTOFMEM);
+    EXPECT_EQ(add(noop, MED_PRIORITY), EOUTOFMEM);
+    EXPECT_EQ(add(noop, MED_PRIORITY, &key, &queuedId, ADMIT_SHED_LOW), 0);
+    EXPECT_EQ(freed, 1);
+
+    // A duplicate is merged although the queues are full.
+    int mergedId{INVALID_JOB_ID};
+    EXPECT_EQ(add(noop, MED_PRIORITY, &key, &mergedId), 0);
+    EXPECT_EQ(mergedId, queuedId);
+    EXPECT_EQ(freed, 2);
+
+    // Queue beyond the limit.
+    TPAttrSetAdmissionPolicy(&attr, ADMIT_OVERFLOW);
+    TPAttrSetMaxOverflowJobs(&attr, 1);
+    ASSERT_EQ(ThreadPoolSetAttr(&tp, &attr), 0);
+    EXPECT_EQ(add(noop, MED_PRIORITY), 0);
+    EXPECT_EQ(add(noop, MED_PRIORITY), EOUTOFMEM);
+
+    // Wait for a free slot, first in vain then successful.
+    TPAttrSetAdmissionPolicy(&attr, ADMIT_BLOCK);
+    TPAttrSetAdmitTimeout(&attr, 20);
+    ASSERT_EQ(ThreadPoolSetAttr(&tp, &attr), 0);
+    EXPECT_EQ(add(noop, HIGH_PRIORITY), EOUTOFMEM);
+    TPAttrSetAdmitTimeout(&attr, 5000);
+    ASSERT_EQ(ThreadPoolSetAttr(&tp, &attr), 0);
+    std::thread release([&gate] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        gate = true;
+    });
+    EXPECT_EQ(add(noop, HIGH_PRIORITY), 0);
+    release.join();
+
+    ASSERT_EQ(ThreadPoolGetAdmitStats(&tp, &stats), 0);
+    EXPECT_EQ(stats.rejected, 4);
+    EXPECT_EQ(stats.shed, 1);
+    EXPECT_EQ(stats.merged, 1);
+    EXPECT_EQ(stats.overflowed, 1);
+    EXPECT_EQ(stats.blocked, 2);
+
+    for (int i{0}; i < 200; i++) {
+        ithread_mutex_lock(&tp.mutex);
+        const bool drained{!tp.saturated};
+        ithread_mutex_unlock(&tp.mutex);
+        if (drained)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(ThreadPoolShutdown(&tp), 0);
+    // Quick changes may be passed as the latest state only, but the states
+    // always alternate and end drained.
+    ASSERT_GE(saturation.size(), 2u);
+    EXPECT_EQ(saturation.front(), 1);
+    EXPECT_EQ(saturation.back(), 0);
+    for (size_t i{1}; i < saturation.size(); i++)
+        EXPECT_NE(saturation[i], saturation[i - 1]);
+    EXPECT_EQ(freed, 2);
+}
+
+TEST(ThreadPoolCompaTestSuite, histogram_percentiles) {
+    ThreadPoolHistogram hist{};
+    EXPECT_EQ(ThreadPoolHistogramPercentile(&hist, 0.5), 0.0);
+
+    // 90 durations from 8 to below 16 µs and 10 from 1024 to below 2048 µs.
+    hist.count = 100;
+    hist.buckets[3] = 90;
+    hist.buckets[10] = 10;
+
+    // Test Unit
+    EXPECT_DOUBLE_EQ(ThreadPoolHistogramPercentile(&hist, 0.45), 12.0);
+    EXPECT_DOUBLE_EQ(ThreadPoolHistogramPercentile(&hist, 0.9), 16.0);
+    EXPECT_DOUBLE_EQ(ThreadPoolHistogramPercentile(&hist, 0.95), 1536.0);
+    EXPECT_DOUBLE_EQ(ThreadPoolHistogramPercentile(&hist, 1.0), 2048.0);
+}
+
+TEST(ThreadPoolCompaTestSuite, stats_per_job_label) {
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleUnlock();
+    char buf[4096];
+    EXPECT_EQ(UpnpGetThreadPoolStats(buf, sizeof(buf)), UPNP_E_FINISH);
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool), UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+
+    std::atomic<bool> done{false};
+    ThreadPoolJob job;
+    TPJobInit(
+        &job,
+        [](void* arg) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            *static_cast<std::atomic<bool>*>(arg) = true;
+        },
+        &done);
+    TPJobSetLabel(&job, JOB_LABEL_HTTP);
+    EXPECT_EQ(TPJobSetLabel(&job, JOB_LABEL_COUNT), EINVAL);
+    ASSERT_EQ(ThreadPoolAdd(&gSendThreadPool, &job, nullptr), 0);
+
+    // The run time is recorded when the worker looks for its next job.
+    ThreadPoolHistograms hists{};
+    for (int i{0}; i < 200; i++) {
+        ASSERT_EQ(ThreadPoolGetHistograms(&gSendThreadPool, &hists), 0);
+        if (done && hists.runLabel[JOB_LABEL_HTTP].count > 0)
+            break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    // Test Unit
+    EXPECT_EQ(hists.waitLabel[JOB_LABEL_HTTP].count, 1u);
+    EXPECT_EQ(hists.runLabel[JOB_LABEL_HTTP].count, 1u);
+    EXPECT_GE(hists.runLabel[JOB_LABEL_HTTP].sum, 2000.0);
+    EXPECT_EQ(hists.runPriority[MED_PRIORITY].count, 1u);
+    EXPECT_EQ(hists.runLabel[JOB_LABEL_SSDP].count, 0u);
+
+    EXPECT_EQ(UpnpGetThreadPoolStats(nullptr, sizeof(buf)),
+              UPNP_E_INVALID_PARAM);
+    EXPECT_EQ(UpnpGetThreadPoolStats(buf, 16), UPNP_E_BUFFER_TOO_SMALL);
+    ASSERT_EQ(UpnpGetThreadPoolStats(buf, sizeof(buf)), UPNP_E_SUCCESS);
+    EXPECT_THAT(buf, HasSubstr("upnp_threadpool_run_us{pool=\"send\",job="
+                               "\"http\",quantile=\"0.99\"} "));
+    EXPECT_THAT(buf, HasSubstr("upnp_threadpool_run_us_count{pool=\"send\","
+                               "job=\"http\"} 1\n"));
+    EXPECT_THAT(buf, Not(HasSubstr("job=\"ssdp\"")));
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+}
+
+TEST(ThreadPoolCompaTestSuite, io_threads_run_outside_of_thread_pools) {
+    EXPECT_EQ(UpnpSetIoThreadCpu(-2), UPNP_E_INVALID_PARAM);
+    ASSERT_EQ(UpnpSetIoThreadCpu(0), UPNP_E_SUCCESS);
+    // Doing needed initializations like in UpnpFinish_successful.
+    ASSERT_EQ(UpnpInitMutexes(), UPNP_E_SUCCESS);
+    HandleLock();
+    for (int i = 0; i < NUM_HANDLE; ++i)
+        HandleTable[i] = nullptr;
+    HandleUnlock();
+    ASSERT_EQ(UpnpInitThreadPools(), UPNP_E_SUCCESS);
+    EXPECT_EQ(gSendThreadPool.attr.targetQueueWait, TARGET_QUEUE_WAIT);
+
+    // Test Unit
+    ASSERT_EQ(TimerThreadInit(&gTimerThread, &gSendThreadPool, gIoThreadCpu),
+              UPNP_E_SUCCESS);
+    UpnpSdkInit = 1;
+    EXPECT_EQ(UpnpSetIoThreadCpu(1), UPNP_E_INIT);
+    ThreadPoolStats stats{};
+    ASSERT_EQ(ThreadPoolGetStats(&gSendThreadPool, &stats), 0);
+    EXPECT_EQ(stats.persistentThreads, 0);
+
+    std::atomic<int> runs{0};
+    DedicatedThread dt{};
+    auto count = [](void* arg) { ++*static_cast<std::atomic<int>*>(arg); };
+    EXPECT_EQ(DedicatedThreadJoin(&dt), 0);
+    EXPECT_EQ(DedicatedThreadStart(&dt, count, &runs, -2), EINVAL);
+    ASSERT_EQ(DedicatedThreadStart(&dt, count, &runs, 0), 0);
+    EXPECT_EQ(DedicatedThreadStart(&dt, count, &runs, 0), EINVAL);
+    EXPECT_EQ(DedicatedThreadJoin(&dt), 0);
+    EXPECT_EQ(runs, 1);
+    // It can be started again after it was joined.
+    ASSERT_EQ(DedicatedThreadStart(&dt, count, &runs, -1), 0);
+    EXPECT_EQ(DedicatedThreadJoin(&dt), 0);
+    EXPECT_EQ(runs, 2);
+
+    EXPECT_EQ(UpnpFinish(), UPNP_E_SUCCESS);
+    EXPECT_EQ(UpnpSetIoThreadCpu(IO_THREAD_CPU), UPNP_E_SUCCESS);
+}
+#endif // UPNPLIB_WITH_NATIVE_PUPNP
+
 } // namespace utest
 
 int main(int argc, char** argv) {
@@ -1,22 +1,32 @@
 // Copyright (C) 2022+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// redistribution only with this copyright remark. last modified: 2024-01-24
+// redistribution only with this copyright remark. last modified: 2026-10-19
 
 // Helpful link for ip address structures:
 // https://stackoverflow.com/a/16010670/5014688
 
 // Include source code for testing. So we have also direct access to static
 // functions which need to be tested.
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
 #include <Pupnp/upnp/src/genlib/net/uri/uri.cpp>
+#else
+#include <Compa/src/genlib/net/uri/uri.cpp>
+#endif
 
 #include <upnplib/global.hpp>
 #include <upnplib/uri.hpp>
 #include <utest/utest.hpp>
 #include <umock/netdb_mock.hpp>
 
+/// \cond
+#include <thread>
+/// \endcond
+
 using ::testing::_;
 using ::testing::DoAll;
+using ::testing::InvokeWithoutArgs;
 using ::testing::Return;
 using ::testing::SetArgPointee;
+using ::testing::StrEq;
 
 using ::upnplib::Curi;
 
@@ -909,6 +919,100 @@ TEST(UriIp4TestSuite, free_URL_list) {
            "created together with it.";
 }
 
+#ifndef UPNPLIB_WITH_NATIVE_PUPNP
+// Host name resolver: tests from the compatible uri module
+// ========================================================
+TEST(ResolverTestSuite, caches_host_names) {
+    Mock_netv4info netdbObj;
+    umock::Netdb netdb_injectObj(&netdbObj);
+    addrinfo* res = netdbObj.set("192.168.1.10", 0);
+    EXPECT_CALL(netdbObj, getaddrinfo(StrEq("media.local"), _, _, _))
+        .WillOnce(DoAll(SetArgPointee<3>(res), Return(0)));
+    EXPECT_CALL(netdbObj, getaddrinfo(StrEq("unknown.local"), _, _, _))
+        .WillOnce(Return(EAI_NONAME));
+    EXPECT_CALL(netdbObj, freeaddrinfo(res)).Times(1);
+    ASSERT_EQ(resolver_start(-1), UPNP_E_SUCCESS);
+
+    // Test Unit
+    for (int i{0}; i < 2; i++) {
+        uri_type uri;
+        constexpr char url[]{"http://media.local:8200/rootDesc.xml"};
+        ASSERT_EQ(parse_uri(url, sizeof(url) - 1, &uri), HTTP_SUCCESS);
+        const auto sa = reinterpret_cast<sockaddr_in*>(&uri.hostport.IPaddress);
+        EXPECT_EQ(sa->sin_family, AF_INET);
+        EXPECT_EQ(sa->sin_port, htons(8200));
+        EXPECT_EQ(sa->sin_addr.s_addr, inet_addr("192.168.1.10"));
+
+        constexpr char bad_url[]{"http://unknown.local/rootDesc.xml"};
+        EXPECT_EQ(parse_uri(bad_url, sizeof(bad_url) - 1, &uri),
+                  UPNP_E_INVALID_URL);
+    }
+    sockaddr_storage addr{};
+    EXPECT_EQ(resolver_lookup(nullptr, 0, &addr), UPNP_E_INVALID_PARAM);
+    resolver_stop();
+}
+
+TEST(ResolverTestSuite, does_not_block_on_slow_lookup) {
+    Mock_netv4info netdbObj;
+    umock::Netdb netdb_injectObj(&netdbObj);
+    addrinfo* res = netdbObj.set("192.168.1.11", 0);
+    EXPECT_CALL(netdbObj, getaddrinfo(_, _, _, _))
+        .WillOnce(DoAll(InvokeWithoutArgs([] {
+                            std::this_thread::sleep_for(
+                                std::chrono::milliseconds(300));
+                        }),
+                        SetArgPointee<3>(res), Return(0)));
+    EXPECT_CALL(netdbObj, freeaddrinfo(res)).Times(1);
+    ASSERT_EQ(resolver_start(-1), UPNP_E_SUCCESS);
+
+    // Test Unit
+    sockaddr_storage addr{};
+    auto start = std::chrono::steady_clock::now();
+    // Not known yet, but that is no invalid URL.
+    EXPECT_EQ(resolver_lookup("slow.local", 0, &addr), UPNP_E_TRY_AGAIN);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(100));
+    // The lookup goes on in the background and is found later.
+    EXPECT_EQ(resolver_lookup("slow.local", 2000, &addr), UPNP_E_SUCCESS);
+    EXPECT_EQ(reinterpret_cast<sockaddr_in*>(&addr)->sin_addr.s_addr,
+              inet_addr("192.168.1.11"));
+    resolver_stop();
+}
+
+TEST(ResolverTestSuite, slow_host_does_not_block_other_hosts) {
+    Mock_netv4info netdbObj;
+    umock::Netdb netdb_injectObj(&netdbObj);
+    addrinfo* res = netdbObj.set("192.168.1.12", 0);
+    EXPECT_CALL(netdbObj, getaddrinfo(StrEq("slow.local"), _, _, _))
+        .WillOnce(DoAll(InvokeWithoutArgs([] {
+                            std::this_thread::sleep_for(
+                                std::chrono::milliseconds(1000));
+                        }),
+                        Return(EAI_AGAIN)));
+    EXPECT_CALL(netdbObj, getaddrinfo(StrEq("fast.local"), _, _, _))
+        .WillOnce(DoAll(SetArgPointee<3>(res), Return(0)));
+    EXPECT_CALL(netdbObj, freeaddrinfo(res)).Times(1);
+    ASSERT_EQ(resolver_start(-1), UPNP_E_SUCCESS);
+
+    // Test Unit
+    uri_type uri;
+    constexpr char slow_url[]{"http://slow.local:8200/rootDesc.xml"};
+    EXPECT_EQ(parse_uri(slow_url, sizeof(slow_url) - 1, &uri),
+              UPNP_E_TRY_AGAIN);
+    // The slow host is looked up only once while it is pending.
+    sockaddr_storage addr{};
+    EXPECT_EQ(resolver_lookup("slow.local", 0, &addr), UPNP_E_TRY_AGAIN);
+
+    auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(resolver_lookup("fast.local", 500, &addr), UPNP_E_SUCCESS);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::milliseconds(500));
+    EXPECT_EQ(reinterpret_cast<sockaddr_in*>(&addr)->sin_addr.s_addr,
+              inet_addr("192.168.1.12"));
+    resolver_stop();
+}
+#endif // UPNPLIB_WITH_NATIVE_PUPNP
+
 } // namespace utest
 
 int main(int argc, char** argv) {
@@ -1,12 +1,21 @@
 // Copyright (C) 2021+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
-// Redistribution only with this Copyright remark. Last modified: 2024-05-16
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
 
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
 #include <Pupnp/upnp/src/genlib/util/membuffer.cpp>
+#else
+#include <Compa/src/genlib/util/membuffer.cpp>
+#endif
 
 #include <upnplib/global.hpp>
 #include <utest/utest.hpp>
 #include <umock/stdlib_mock.hpp>
 
+/// \cond
+#include <atomic>
+#include <chrono>
+/// \endcond
+
 using ::testing::_;
 using ::testing::ExitedWithCode;
 using ::testing::Return;
@@ -88,9 +97,31 @@ class Cmembuffer : Imembuffer {
 };
 // clang-format on
 
+// Counts the allocations from the operating system.
+class CCountAllocs : public umock::StdlibInterface {
+  public:
+    std::atomic<size_t> allocs{};
+    void* malloc(size_t size) override {
+        allocs++;
+        return ::malloc(size);
+    }
+    void* calloc(size_t nmemb, size_t size) override {
+        allocs++;
+        return ::calloc(nmemb, size);
+    }
+    void* realloc(void* ptr, size_t size) override {
+        allocs++;
+        return ::realloc(ptr, size);
+    }
+    void free(void* ptr) override { ::free(ptr); }
+};
+
 
 // Testsuite for the membuffer module
 // ==================================
+#ifdef UPNPLIB_WITH_NATIVE_PUPNP
+// These tests document the behavior of the pupnp membuffer. The compatible
+// membuffer grows geometrically and is tested below.
 TEST(MembufferTestSuite, init_and_destroy) {
     membuffer mbuf{};
 
@@ -1191,6 +1222,173 @@ TEST(MembufferTestSuite, membuffer_attach_empty_str_buffer_but_buffer_length) {
     EXPECT_STREQ(mem.buffer.buf, "");
 }
 
+#else // UPNPLIB_WITH_NATIVE_PUPNP
+
+TEST(MembufferTestSuite, append_grows_capacity_geometrically) {
+    CCountAllocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+
+    // Test Unit
+    for (int i{0}; i < 10000; i++)
+        ASSERT_EQ(mem.membuffer_append(&mem.buffer, "x", 1), UPNP_E_SUCCESS);
+
+    EXPECT_EQ(mem.buffer.length, (size_t)10000);
+    EXPECT_EQ(strlen(mem.buffer.buf), (size_t)10000);
+    EXPECT_GE(mem.buffer.capacity, mem.buffer.length);
+    EXPECT_LT(mem.buffer.capacity, 2 * mem.buffer.length);
+    // One small block and about log2(10000 / 64) reallocations.
+    EXPECT_LE(countObj.allocs, (size_t)12);
+}
+
+TEST(MembufferTestSuite, small_contents_are_not_on_the_heap) {
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+    // Get a small block into the cache of this thread.
+    ASSERT_EQ(mem.membuffer_assign_str(&mem.buffer, "warm up"), 0);
+    mem.membuffer_destroy(&mem.buffer);
+
+    CCountAllocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+
+    // Test Unit
+    ASSERT_EQ(mem.membuffer_assign_str(&mem.buffer, "CONTENT-LENGTH"), 0);
+    ASSERT_EQ(mem.membuffer_append_str(&mem.buffer, ": 1234"), 0);
+
+    EXPECT_TRUE(mem.buffer.small);
+    EXPECT_STREQ(mem.buffer.buf, "CONTENT-LENGTH: 1234");
+    EXPECT_EQ(mem.buffer.length, (size_t)20);
+    // The capacity is the same as with a heap buffer.
+    EXPECT_EQ(mem.buffer.capacity, (size_t)28);
+    mem.membuffer_destroy(&mem.buffer);
+    EXPECT_EQ(countObj.allocs, (size_t)0);
+}
+
+TEST(MembufferTestSuite, small_contents_move_to_the_heap_when_growing) {
+    const std::string str(100, 'z');
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+    ASSERT_EQ(mem.membuffer_assign_str(&mem.buffer, "short"), 0);
+    ASSERT_TRUE(mem.buffer.small);
+
+    // Test Unit
+    ASSERT_EQ(mem.membuffer_append_str(&mem.buffer, str.c_str()), 0);
+
+    EXPECT_FALSE(mem.buffer.small);
+    EXPECT_EQ(mem.buffer.length, (size_t)105);
+    EXPECT_EQ(std::string(mem.buffer.buf), "short" + str);
+
+    // Shrinking keeps the heap buffer.
+    mem.membuffer_delete(&mem.buffer, 5, 100);
+    EXPECT_FALSE(mem.buffer.small);
+    EXPECT_STREQ(mem.buffer.buf, "short");
+}
+
+TEST(MembufferTestSuite, detach_small_contents) {
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+    ASSERT_EQ(mem.membuffer_assign_str(&mem.buffer, "detach me"), 0);
+    ASSERT_TRUE(mem.buffer.small);
+    // Pointers into the contents must stay valid, e.g. to the entity.
+    const char* me = mem.buffer.buf + 7;
+
+    // Test Unit
+    char* buf = mem.membuffer_detach(&mem.buffer);
+
+    ASSERT_NE(buf, nullptr);
+    EXPECT_EQ(buf + 7, me);
+    EXPECT_STREQ(me, "me");
+    EXPECT_STREQ(buf, "detach me");
+    EXPECT_EQ(mem.buffer.buf, nullptr);
+    EXPECT_FALSE(mem.buffer.small);
+    // Must be freeable with free().
+    free(buf);
+}
+
+TEST(MembufferTestSuite, reserve_allocates_exactly) {
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+    ASSERT_EQ(mem.membuffer_assign_str(&mem.buffer, "head"), 0);
+
+    // Test Unit
+    EXPECT_EQ(membuffer_reserve(&mem.buffer, 1000), UPNP_E_SUCCESS);
+
+    EXPECT_EQ(mem.buffer.capacity, (size_t)1000);
+    EXPECT_EQ(mem.buffer.length, (size_t)4);
+    EXPECT_STREQ(mem.buffer.buf, "head");
+
+    // A smaller reservation does nothing.
+    char* buf = mem.buffer.buf;
+    EXPECT_EQ(membuffer_reserve(&mem.buffer, 10), UPNP_E_SUCCESS);
+    EXPECT_EQ(mem.buffer.capacity, (size_t)1000);
+    EXPECT_EQ(mem.buffer.buf, buf);
+
+    // Appending within the reserved memory doesn't move the buffer.
+    const std::string str(996, 'b');
+    ASSERT_EQ(mem.membuffer_append_str(&mem.buffer, str.c_str()), 0);
+    EXPECT_EQ(mem.buffer.buf, buf);
+}
+
+TEST(MembufferTestSuite, reserve_with_failing_allocation) {
+    umock::StdlibMock stdlibObj;
+    umock::Stdlib stdlib_injectObj(&stdlibObj);
+    EXPECT_CALL(stdlibObj, realloc(nullptr, 1001)).WillOnce(Return(nullptr));
+    Cmembuffer mem;
+    mem.membuffer_init(&mem.buffer);
+
+    // Test Unit
+    EXPECT_EQ(membuffer_reserve(&mem.buffer, 1000), UPNP_E_OUTOF_MEMORY);
+
+    EXPECT_EQ(mem.buffer.buf, nullptr);
+    EXPECT_EQ(mem.buffer.capacity, (size_t)0);
+}
+#endif // UPNPLIB_WITH_NATIVE_PUPNP
+
+
+TEST(DISABLED_MembufferBenchSuite, append_body_in_pieces) {
+    // Appends a 1 MiB description in 64 byte pieces.
+    constexpr size_t piece_size{64};
+    constexpr size_t body_size{1024 * 1024};
+    constexpr int rounds{50};
+    const std::string piece(piece_size, 'p');
+    CCountAllocs countObj;
+    umock::Stdlib stdlib_injectObj(&countObj);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i{0}; i < rounds; i++) {
+        membuffer mbuf;
+        membuffer_init(&mbuf);
+        for (size_t len{0}; len < body_size; len += piece_size)
+            ASSERT_EQ(membuffer_append(&mbuf, piece.data(), piece_size), 0);
+        membuffer_destroy(&mbuf);
+    }
+    const std::chrono::nanoseconds elapsed{std::chrono::steady_clock::now() -
+                                           start};
+
+    std::cout << "[ BENCH    ] 1 MiB appended in " << piece_size
+              << " byte pieces, " << countObj.allocs / rounds
+              << " allocations, " << elapsed.count() / rounds / 1000
+              << " us per body.\n";
+}
+
+TEST(DISABLED_MembufferBenchSuite, short_header_values) {
+    constexpr int values{1000000};
+    membuffer mbuf;
+    membuffer_init(&mbuf);
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i{0}; i < values; i++) {
+        ASSERT_EQ(membuffer_assign_str(&mbuf, "max-age=1800"), 0);
+        membuffer_destroy(&mbuf);
+    }
+    const std::chrono::nanoseconds elapsed{std::chrono::steady_clock::now() -
+                                           start};
+
+    std::cout << "[ BENCH    ] " << values << " short values assigned, "
+              << elapsed.count() / values << " ns per value.\n";
+}
+
 } // namespace utest
 
 int main(int argc, char** argv) {
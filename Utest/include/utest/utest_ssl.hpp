@@ -0,0 +1,48 @@
+#ifndef UPNPLIB_UTEST_SSL_HPP
+#define UPNPLIB_UTEST_SSL_HPP
+// Copyright (C) 2026+ GPL 3 and higher by Ingo Höft, <Ingo@Hoeft-online.de>
+// Redistribution only with this Copyright remark. Last modified: 2026-10-19
+
+// Helper for tests with TLS connections. Only usable with OpenSSL compiled in.
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <stdexcept>
+
+
+namespace utest {
+
+// Create an SSL Context for a TLS server with a self signed certificate for
+// "localhost". It must be freed with SSL_CTX_free().
+inline SSL_CTX* new_tls_server_ctx() {
+    SSL_CTX* ctx = SSL_CTX_new(TLS_server_method());
+    if (ctx == nullptr)
+        throw std::runtime_error("Failed to create server SSL Context.");
+    EVP_PKEY* pkey = EVP_EC_gen("P-256");
+    X509* x509 = X509_new();
+    ASN1_INTEGER_set(X509_get_serialNumber(x509), 1);
+    X509_gmtime_adj(X509_getm_notBefore(x509), 0);
+    X509_gmtime_adj(X509_getm_notAfter(x509), 3600);
+    X509_set_pubkey(x509, pkey);
+    X509_NAME* name = X509_get_subject_name(x509);
+    X509_NAME_add_entry_by_txt(
+        name, "CN", MBSTRING_ASC,
+        reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+    X509_set_issuer_name(x509, name);
+    X509_sign(x509, pkey, EVP_sha256());
+    bool ok = SSL_CTX_use_certificate(ctx, x509) == 1 &&
+              SSL_CTX_use_PrivateKey(ctx, pkey) == 1;
+    X509_free(x509);
+    EVP_PKEY_free(pkey);
+    if (!ok) {
+        SSL_CTX_free(ctx);
+        throw std::runtime_error("Failed to set server certificate.");
+    }
+    return ctx;
+}
+
+} // namespace utest
+
+#endif // UPNPLIB_UTEST_SSL_HPP